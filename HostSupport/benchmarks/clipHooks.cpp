@@ -0,0 +1,203 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+  Times reading the live properties of a clip instance through the property suite,
+  the way a plugin does on every render, with the get hooks switching on a property
+  id against the chain of string compares they used to do.
+
+  usage : clipHooks [nIterations]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+#include "ofxProperty.h"
+
+#include "ofxhPropertySuite.h"
+#include "ofxhClip.h"
+
+using namespace OFX::Host;
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  /// a clip with fixed answers to everything
+  class BenchClip : public ImageEffect::ClipInstance {
+  public :
+    explicit BenchClip(ImageEffect::ClipDescriptor &desc)
+      : ImageEffect::ClipInstance(0, desc)
+    {
+      setPixelDepth(kOfxBitDepthFloat);
+      setComponents(kOfxImageComponentRGBA);
+    }
+
+    const std::string &getUnmappedBitDepth() const {static const std::string v(kOfxBitDepthFloat); return v;}
+    const std::string &getUnmappedComponents() const {static const std::string v(kOfxImageComponentRGBA); return v;}
+    const std::string &getPremult() const {static const std::string v(kOfxImagePreMultiplied); return v;}
+    double getAspectRatio() const {return 1.0;}
+    double getFrameRate() const {return 24.0;}
+    void getFrameRange(double &startFrame, double &endFrame) const {startFrame = 0; endFrame = 100;}
+    const std::string &getFieldOrder() const {static const std::string v(kOfxImageFieldNone); return v;}
+    bool getConnected() const {return true;}
+    double getUnmappedFrameRate() const {return 24.0;}
+    void getUnmappedFrameRange(double &startFrame, double &endFrame) const {startFrame = 0; endFrame = 100;}
+    bool getContinuousSamples() const {return false;}
+    ImageEffect::Image *getImage(OfxTime, const OfxRectD *) {return 0;}
+#   ifdef OFX_SUPPORTS_OPENGLRENDER
+    ImageEffect::Texture *loadTexture(OfxTime, const char *, const OfxRectD *) {return 0;}
+#   endif
+    OfxRectD getRegionOfDefinition(OfxTime) const {OfxRectD rod = {0, 0, 1920, 1080}; return rod;}
+  };
+
+  /// the same clip, with the hooks written the way they used to be
+  class ChainClip : public BenchClip {
+  public :
+    explicit ChainClip(ImageEffect::ClipDescriptor &desc) : BenchClip(desc) {}
+
+    double getDoubleProperty(const std::string &name, int n) const
+    {
+      if(name==kOfxImagePropPixelAspectRatio)
+        return getAspectRatio();
+      else if(name==kOfxImageEffectPropFrameRate)
+        return getFrameRate();
+      else if(name==kOfxImageEffectPropFrameRange) {
+        double range[2];
+        getFrameRange(range[0], range[1]);
+        return range[n];
+      }
+      else if(name==kOfxImageEffectPropUnmappedFrameRate)
+        return getUnmappedFrameRate();
+      else if(name==kOfxImageEffectPropUnmappedFrameRange) {
+        double range[2];
+        getUnmappedFrameRange(range[0], range[1]);
+        return range[n];
+      }
+      throw Property::Exception(kOfxStatErrValue);
+    }
+
+    void getDoublePropertyN(const std::string &name, double *values, int n) const
+    {
+      for(int i = 0; i < n; ++i)
+        values[i] = getDoubleProperty(name, i);
+    }
+
+    int getIntProperty(const std::string &name, int) const
+    {
+      if(name==kOfxImageClipPropConnected)
+        return getConnected();
+      else if(name==kOfxImageClipPropContinuousSamples)
+        return getContinuousSamples();
+      throw Property::Exception(kOfxStatErrValue);
+    }
+
+    const std::string &getStringProperty(const std::string &name, int) const
+    {
+      if(name==kOfxImageEffectPropPixelDepth)
+        return getPixelDepth();
+      else if(name==kOfxImageEffectPropComponents)
+        return getComponents();
+      else if(name==kOfxImageClipPropUnmappedComponents)
+        return getUnmappedComponents();
+      else if(name==kOfxImageClipPropUnmappedPixelDepth)
+        return getUnmappedBitDepth();
+      else if(name==kOfxImageEffectPropPreMultiplication)
+        return getPremult();
+      else if(name==kOfxImageClipPropFieldOrder)
+        return getFieldOrder();
+      throw Property::Exception(kOfxStatErrValue);
+    }
+  };
+
+  /// what a plugin typically asks its source clip for at the start of a render
+  long readClip(const OfxPropertySuiteV1 *suite, OfxPropertySetHandle h)
+  {
+    long sum = 0;
+    char *s;
+    double d[2];
+    int i;
+    suite->propGetString(h, kOfxImageEffectPropPixelDepth, 0, &s); sum += s[0];
+    suite->propGetString(h, kOfxImageEffectPropComponents, 0, &s); sum += s[0];
+    suite->propGetString(h, kOfxImageEffectPropPreMultiplication, 0, &s); sum += s[0];
+    suite->propGetString(h, kOfxImageClipPropFieldOrder, 0, &s); sum += s[0];
+    suite->propGetDouble(h, kOfxImagePropPixelAspectRatio, 0, d); sum += long(d[0]);
+    suite->propGetDoubleN(h, kOfxImageEffectPropFrameRange, 2, d); sum += long(d[1]);
+    suite->propGetDouble(h, kOfxImageEffectPropFrameRate, 0, d); sum += long(d[0]);
+    suite->propGetInt(h, kOfxImageClipPropConnected, 0, &i); sum += i;
+    return sum;
+  }
+  const int nReads = 8;
+
+  /// the same reads, straight into the hooks, which is what changed
+  long readHooks(const ImageEffect::ClipInstance &clip)
+  {
+    static const std::string pixelDepth(kOfxImageEffectPropPixelDepth);
+    static const std::string components(kOfxImageEffectPropComponents);
+    static const std::string premult(kOfxImageEffectPropPreMultiplication);
+    static const std::string fieldOrder(kOfxImageClipPropFieldOrder);
+    static const std::string par(kOfxImagePropPixelAspectRatio);
+    static const std::string frameRange(kOfxImageEffectPropFrameRange);
+    static const std::string frameRate(kOfxImageEffectPropFrameRate);
+    static const std::string connected(kOfxImageClipPropConnected);
+
+    long sum = 0;
+    double d[2];
+    sum += clip.getStringProperty(pixelDepth, 0)[0];
+    sum += clip.getStringProperty(components, 0)[0];
+    sum += clip.getStringProperty(premult, 0)[0];
+    sum += clip.getStringProperty(fieldOrder, 0)[0];
+    sum += long(clip.getDoubleProperty(par, 0));
+    clip.getDoublePropertyN(frameRange, d, 2); sum += long(d[1]);
+    sum += long(clip.getDoubleProperty(frameRate, 0));
+    sum += clip.getIntProperty(connected, 0);
+    return sum;
+  }
+
+  double nsPer(Clock::time_point start, long n)
+  {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+  }
+
+  double timeSuite(const OfxPropertySuiteV1 *suite, OfxPropertySetHandle h, long nIterations, long &sum)
+  {
+    Clock::time_point start = Clock::now();
+    for(long i = 0; i < nIterations; ++i)
+      sum += readClip(suite, h);
+    return nsPer(start, nIterations * nReads);
+  }
+
+  double timeHooks(const ImageEffect::ClipInstance &clip, long nIterations, long &sum)
+  {
+    Clock::time_point start = Clock::now();
+    for(long i = 0; i < nIterations; ++i)
+      sum += readHooks(clip);
+    return nsPer(start, nIterations * nReads);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  long nIterations = argc > 1 ? atol(argv[1]) : 1000000;
+
+  ImageEffect::ClipDescriptor desc(kOfxImageEffectSimpleSourceClipName);
+  BenchClip clip(desc);
+  ChainClip chainClip(desc);
+
+  const OfxPropertySuiteV1 *suite = static_cast<const OfxPropertySuiteV1 *>(Property::GetSuite(1));
+
+  long sum = 0;
+  double chainHookNs = timeHooks(chainClip, nIterations, sum);
+  double tableHookNs = timeHooks(clip, nIterations, sum);
+  double chainSuiteNs = timeSuite(suite, chainClip.getPropHandle(), nIterations, sum);
+  double tableSuiteNs = timeSuite(suite, clip.getPropHandle(), nIterations, sum);
+
+  printf("%ld reads of each of %d clip properties\n", nIterations, nReads);
+  printf("%-24s %7.2f ns per hook call, %7.2f ns per suite read\n", "string compare chain", chainHookNs, chainSuiteNs);
+  printf("%-24s %7.2f ns per hook call, %7.2f ns per suite read\n", "property id switch", tableHookNs, tableSuiteNs);
+  return sum == 0;
+}
@@ -0,0 +1,138 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+  Times looking up properties in an OFX::Host::Property::Set, the way a plugin does
+  through the property suite, against the std::map<std::string, Property*> look up
+  that Set used to do.
+
+  usage : propertyLookup [nIterations]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+#include "ofxProperty.h"
+
+#include "ofxhPropertySuite.h"
+
+using namespace OFX::Host;
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  // roughly what an effect instance carries
+  const Property::PropSpec instanceStuff[] = {
+    { kOfxPropType, Property::eString, 1, true, kOfxTypeImageEffectInstance },
+    { kOfxPropName, Property::eString, 1, false, "" },
+    { kOfxPropLabel, Property::eString, 1, false, "" },
+    { kOfxPropShortLabel, Property::eString, 1, false, "" },
+    { kOfxPropLongLabel, Property::eString, 1, false, "" },
+    { kOfxPropVersion, Property::eInt, 0, false, "0" },
+    { kOfxPropVersionLabel, Property::eString, 1, false, "" },
+    { kOfxPropPluginDescription, Property::eString, 1, false, "" },
+    { kOfxImageEffectPropSupportedContexts, Property::eString, 0, false, "" },
+    { kOfxImageEffectPluginPropGrouping, Property::eString, 1, false, "" },
+    { kOfxImageEffectPluginPropSingleInstance, Property::eInt, 1, false, "0" },
+    { kOfxImageEffectPluginRenderThreadSafety, Property::eString, 1, false, kOfxImageEffectRenderInstanceSafe },
+    { kOfxImageEffectPluginPropHostFrameThreading, Property::eInt, 1, false, "1" },
+    { kOfxImageEffectPropSupportsMultiResolution, Property::eInt, 1, false, "1" },
+    { kOfxImageEffectPropSupportsTiles, Property::eInt, 1, false, "1" },
+    { kOfxImageEffectPropTemporalClipAccess, Property::eInt, 1, false, "0" },
+    { kOfxImageEffectPropSupportedPixelDepths, Property::eString, 0, false, "" },
+    { kOfxImageEffectPluginPropFieldRenderTwiceAlways, Property::eInt, 1, false, "1" },
+    { kOfxImageEffectPropSupportsMultipleClipDepths, Property::eInt, 1, false, "0" },
+    { kOfxImageEffectPropSupportsMultipleClipPARs, Property::eInt, 1, false, "0" },
+    { kOfxImageEffectPropClipPreferencesSlaveParam, Property::eString, 0, false, "" },
+    { kOfxImageEffectInstancePropSequentialRender, Property::eInt, 1, false, "0" },
+    { kOfxPluginPropFilePath, Property::eString, 1, true, "" },
+    { kOfxImageEffectPropContext, Property::eString, 1, true, "" },
+    { kOfxPropInstanceData, Property::ePointer, 1, false, NULL },
+    { kOfxImageEffectPropPluginHandle, Property::ePointer, 1, true, NULL },
+    { kOfxImageEffectPropProjectSize, Property::eDouble, 2, true, "0" },
+    { kOfxImageEffectPropProjectOffset, Property::eDouble, 2, true, "0" },
+    { kOfxImageEffectPropProjectExtent, Property::eDouble, 2, true, "0" },
+    { kOfxImagePropPixelAspectRatio, Property::eDouble, 1, true, "1" },
+    { kOfxImageEffectInstancePropEffectDuration, Property::eDouble, 1, true, "0" },
+    { kOfxImageEffectPropFrameRate, Property::eDouble, 1, true, "24" },
+    { kOfxPropIsInteractive, Property::eInt, 1, true, "0" },
+    { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "1" },
+    { kOfxImageEffectPropRenderWindow, Property::eInt, 4, true, "0" },
+    { kOfxImageEffectPropFieldToRender, Property::eString, 1, true, "" },
+    { kOfxPropTime, Property::eDouble, 1, true, "0" },
+    Property::propSpecEnd
+  };
+
+  // what a render typically asks for
+  const char *lookups[] = {
+    kOfxPropTime,
+    kOfxImageEffectPropRenderWindow,
+    kOfxImageEffectPropRenderScale,
+    kOfxImageEffectPropFieldToRender,
+    kOfxImagePropPixelAspectRatio,
+    kOfxImageEffectPropProjectSize,
+    kOfxPropInstanceData,
+    kOfxImageEffectPropContext,
+  };
+  const int nLookups = sizeof(lookups) / sizeof(lookups[0]);
+
+  double nsPer(Clock::time_point start, long n)
+  {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  long nIterations = argc > 1 ? atol(argv[1]) : 2000000;
+  long n = nIterations * nLookups;
+
+  Property::Set set(instanceStuff);
+
+  // the old storage, a map keyed on std::string
+  std::map<std::string, Property::Property *> map(set.getProperties().begin(), set.getProperties().end());
+
+  const OfxPropertySuiteV1 *suite = static_cast<const OfxPropertySuiteV1 *>(Property::GetSuite(1));
+  OfxPropertySetHandle handle = set.getHandle();
+
+  size_t found = 0;
+
+  Clock::time_point start = Clock::now();
+  for(long i = 0; i < nIterations; ++i)
+    for(int l = 0; l < nLookups; ++l)
+      found += map.find(lookups[l]) != map.end();
+  double mapNs = nsPer(start, n);
+
+  start = Clock::now();
+  for(long i = 0; i < nIterations; ++i)
+    for(int l = 0; l < nLookups; ++l)
+      found += set.fetchProperty(lookups[l]) != 0;
+  double setNs = nsPer(start, n);
+
+  start = Clock::now();
+  for(long i = 0; i < nIterations; ++i)
+    for(int l = 0; l < nLookups; ++l)
+      found += set.fetchProperty(std::string(lookups[l])) != 0;
+  double setStringNs = nsPer(start, n);
+
+  start = Clock::now();
+  double d;
+  for(long i = 0; i < nIterations; ++i) {
+    suite->propGetDouble(handle, kOfxPropTime, 0, &d);
+    found += d == 0;
+  }
+  double suiteNs = nsPer(start, nIterations);
+
+  printf("%d properties, %ld look ups each\n", int(map.size()), n);
+  printf("%-32s %7.2f ns per look up\n", "std::map<std::string>", mapNs);
+  printf("%-32s %7.2f ns per look up\n", "Set::fetchProperty(const char*)", setNs);
+  printf("%-32s %7.2f ns per look up\n", "Set::fetchProperty(std::string)", setStringNs);
+  printf("%-32s %7.2f ns per call\n", "propGetDouble", suiteNs);
+  return found == 0;
+}
@@ -0,0 +1,713 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+  Renders frames of image effect plugins in process with the hostDemo host, and reports
+  how long each action took, the throughput and the allocations made, as JSON.
+
+  Without --plugin or --bundle the standard workloads are rendered, which are the example
+  plugins built with the C++ support library, Basic, Invert, Noise, Retimer, CrossFade and
+  Field, found on OFX_PLUGIN_PATH. With --bundle the bundle's directory is searched as
+  well, and if no --plugin is given, every plugin in that bundle is rendered.
+
+  Each workload renders the frames once to warm up and then the given number of times,
+  with the actions a host makes for each frame, region of definition, region of interest,
+  frames needed and is identity, followed by the render through a RenderScheduler.
+
+  Allocations are counted through the global operator new, so they include those made by
+  the plugin, but not those made with malloc.
+
+  With --tile-mb the frames are rendered one at a time through a TiledRender instead, as
+  tiles whose images fit in that many megabytes, the inputs being fetched for each tile's
+  regions of interest only. Before the measured renders, each frame is rendered whole and
+  then as tiles, and the report says whether they came out the same. Effects whose output
+  depends on the window rendered, like Noise, which seeds its generator from the first row
+  of each window, are expected to differ.
+
+  The report is written once every workload is done, use --output to keep it apart from
+  anything the plugins print.
+
+  usage : renderBench [--bundle path] [--plugin id]... [--width n] [--height n]
+                      [--depth byte|short|float] [--components rgba|rgb|alpha]
+                      [--threads n] [--frames n] [--iterations n] [--warmup n]
+                      [--cache-mb n] [--tile-mb n] [--output file]
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <set>
+#include <string>
+#include <vector>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+#include "ofxPixels.h"
+
+// ofx host
+#include "ofxhBinary.h"
+#include "ofxhPropertySuite.h"
+#include "ofxhClip.h"
+#include "ofxhParam.h"
+#include "ofxhParamAnimation.h"
+#include "ofxhMemory.h"
+#include "ofxhImageEffect.h"
+#include "ofxhPluginAPICache.h"
+#include "ofxhPluginCache.h"
+#include "ofxhHost.h"
+#include "ofxhImageEffectAPI.h"
+#include "ofxhImageCache.h"
+#include "ofxhRenderScheduler.h"
+#include "ofxhTiledRender.h"
+
+// the hostDemo host
+#include "hostDemoHostDescriptor.h"
+#include "hostDemoEffectInstance.h"
+#include "hostDemoClipInstance.h"
+
+namespace {
+
+  std::atomic<unsigned long long> gAllocations(0);
+  std::atomic<unsigned long long> gAllocatedBytes(0);
+
+  void *countedAllocate(size_t nBytes)
+  {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    gAllocatedBytes.fetch_add(nBytes, std::memory_order_relaxed);
+    if(void *p = malloc(nBytes ? nBytes : 1))
+      return p;
+    throw std::bad_alloc();
+  }
+
+}
+
+void *operator new(size_t nBytes) {return countedAllocate(nBytes);}
+void *operator new[](size_t nBytes) {return countedAllocate(nBytes);}
+void operator delete(void *p) noexcept {free(p);}
+void operator delete[](void *p) noexcept {free(p);}
+void operator delete(void *p, size_t) noexcept {free(p);}
+void operator delete[](void *p, size_t) noexcept {free(p);}
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  double msSince(Clock::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+  /// the times each action took, in milliseconds, over all the instances rendering
+  class ActionTimes {
+  public :
+    ActionTimes() : _recording(false) {}
+
+    void setRecording(bool recording) {_recording = recording;}
+
+    void add(const char *action, double ms)
+    {
+      if(!_recording)
+        return;
+      std::lock_guard<std::mutex> guard(_mutex);
+      _times[action].push_back(ms);
+    }
+
+    void clear()
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      _times.clear();
+    }
+
+    std::map<std::string, std::vector<double> > get()
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      return _times;
+    }
+
+  protected :
+    std::mutex _mutex;
+    std::map<std::string, std::vector<double> > _times;
+    std::atomic<bool> _recording;
+  };
+
+  ActionTimes gActionTimes;
+
+  /// times the scope it is in as a call to the action
+  class ActionTimer {
+  public :
+    explicit ActionTimer(const char *action) : _action(action), _start(Clock::now()) {}
+    ~ActionTimer() {gActionTimes.add(_action, msSince(_start));}
+
+  protected :
+    const char        *_action;
+    Clock::time_point  _start;
+  };
+
+  /// the hostDemo effect, timing its actions and giving its params their default values
+  class BenchEffectInstance : public MyHost::MyEffectInstance {
+  public :
+    BenchEffectInstance(OFX::Host::ImageEffect::ImageEffectPlugin* plugin,
+                        OFX::Host::ImageEffect::Descriptor& desc,
+                        const std::string& context)
+      : MyHost::MyEffectInstance(plugin, desc, context)
+    {
+    }
+
+    virtual OFX::Host::Param::Instance* newParam(const std::string& name, OFX::Host::Param::Descriptor& descriptor)
+    {
+      using namespace OFX::Host::Param;
+      const std::string &type = descriptor.getType();
+      if(type == kOfxParamTypeDouble)
+        return new AnimatedDoubleInstance(descriptor, this);
+      else if(type == kOfxParamTypeDouble2D)
+        return new AnimatedDouble2DInstance(descriptor, this);
+      else if(type == kOfxParamTypeDouble3D)
+        return new AnimatedDouble3DInstance(descriptor, this);
+      else if(type == kOfxParamTypeInteger)
+        return new AnimatedIntegerInstance(descriptor, this);
+      else if(type == kOfxParamTypeInteger2D)
+        return new AnimatedInteger2DInstance(descriptor, this);
+      else if(type == kOfxParamTypeInteger3D)
+        return new AnimatedInteger3DInstance(descriptor, this);
+      else if(type == kOfxParamTypeRGB)
+        return new AnimatedRGBInstance(descriptor, this);
+      else if(type == kOfxParamTypeRGBA)
+        return new AnimatedRGBAInstance(descriptor, this);
+      return MyHost::MyEffectInstance::newParam(name, descriptor);
+    }
+
+    virtual OfxStatus beginRenderAction(OfxTime startFrame, OfxTime endFrame, OfxTime step, bool interactive,
+                                        OfxPointD renderScale, bool sequentialRender, bool interactiveRender)
+    {
+      ActionTimer timer(kOfxImageEffectActionBeginSequenceRender);
+      return MyHost::MyEffectInstance::beginRenderAction(startFrame, endFrame, step, interactive,
+                                                         renderScale, sequentialRender, interactiveRender);
+    }
+
+    virtual OfxStatus renderAction(OfxTime time, const std::string &field, const OfxRectI &renderRoI,
+                                   OfxPointD renderScale, bool sequentialRender, bool interactiveRender,
+                                   bool draftRender)
+    {
+      ActionTimer timer(kOfxImageEffectActionRender);
+      return MyHost::MyEffectInstance::renderAction(time, field, renderRoI, renderScale,
+                                                    sequentialRender, interactiveRender, draftRender);
+    }
+
+    virtual OfxStatus endRenderAction(OfxTime startFrame, OfxTime endFrame, OfxTime step, bool interactive,
+                                      OfxPointD renderScale, bool sequentialRender, bool interactiveRender)
+    {
+      ActionTimer timer(kOfxImageEffectActionEndSequenceRender);
+      return MyHost::MyEffectInstance::endRenderAction(startFrame, endFrame, step, interactive,
+                                                       renderScale, sequentialRender, interactiveRender);
+    }
+
+    virtual OfxStatus getRegionOfDefinitionAction(OfxTime time, OfxPointD renderScale, OfxRectD &rod)
+    {
+      ActionTimer timer(kOfxImageEffectActionGetRegionOfDefinition);
+      return MyHost::MyEffectInstance::getRegionOfDefinitionAction(time, renderScale, rod);
+    }
+
+    virtual OfxStatus getRegionOfInterestAction(OfxTime time, OfxPointD renderScale, const OfxRectD &roi,
+                                                std::map<OFX::Host::ImageEffect::ClipInstance *, OfxRectD> &rois)
+    {
+      ActionTimer timer(kOfxImageEffectActionGetRegionsOfInterest);
+      return MyHost::MyEffectInstance::getRegionOfInterestAction(time, renderScale, roi, rois);
+    }
+
+    virtual OfxStatus getFrameNeededAction(OfxTime time, OFX::Host::ImageEffect::RangeMap &rangeMap)
+    {
+      ActionTimer timer(kOfxImageEffectActionGetFramesNeeded);
+      return MyHost::MyEffectInstance::getFrameNeededAction(time, rangeMap);
+    }
+
+    virtual OfxStatus isIdentityAction(OfxTime &time, const std::string &field, const OfxRectI &renderRoI,
+                                       OfxPointD renderScale, std::string &clip)
+    {
+      ActionTimer timer(kOfxImageEffectActionIsIdentity);
+      return MyHost::MyEffectInstance::isIdentityAction(time, field, renderRoI, renderScale, clip);
+    }
+  };
+
+  /// the hostDemo host, making BenchEffectInstances
+  class BenchHost : public MyHost::Host {
+  public :
+    virtual OFX::Host::ImageEffect::Instance* newInstance(void* /*clientData*/,
+                                                          OFX::Host::ImageEffect::ImageEffectPlugin* plugin,
+                                                          OFX::Host::ImageEffect::Descriptor& desc,
+                                                          const std::string& context)
+    {
+      return new BenchEffectInstance(plugin, desc, context);
+    }
+  };
+
+  /// hand the output image of a rendered frame back, as a host would once it has displayed
+  /// or written it, returning its pixels if they are wanted
+  void releaseOutputImage(OFX::Host::ImageEffect::Instance &instance, OfxTime time,
+                          std::vector<unsigned char> *pixels = 0)
+  {
+    MyHost::MyClipInstance *outputClip = dynamic_cast<MyHost::MyClipInstance *>(instance.getClip(kOfxImageEffectOutputClipName));
+    if(!outputClip)
+      return;
+    if(pixels) {
+      pixels->clear();
+      if(MyHost::MyImage *image = outputClip->getOutputImage(time)) {
+        OfxRectI bounds = image->getBounds();
+        const unsigned char *data = static_cast<const unsigned char *>(image->pixelAddress(bounds.x1, bounds.y1));
+        if(data)
+          pixels->assign(data, data + size_t(image->getIntProperty(kOfxImagePropRowBytes)) * size_t(bounds.y2 - bounds.y1));
+      }
+    }
+    outputClip->releaseOutputImage(time);
+  }
+
+  /// hands each output image back once its frame is rendered
+  class BenchRenderScheduler : public OFX::Host::ImageEffect::RenderScheduler {
+  public :
+    BenchRenderScheduler(OFX::Host::ImageEffect::Instance &instance, unsigned int maxThreads)
+      : OFX::Host::ImageEffect::RenderScheduler(instance, maxThreads)
+    {
+    }
+
+    virtual void frameRendered(OFX::Host::ImageEffect::Instance &instance, OfxTime time)
+    {
+      releaseOutputImage(instance, time);
+    }
+  };
+
+  /// what to render
+  struct Options {
+    std::vector<std::string> plugins;
+    std::string              bundle;
+    int                      width;
+    int                      height;
+    std::string              depth;
+    std::string              components;
+    unsigned int             threads;
+    int                      frames;
+    int                      iterations;
+    int                      warmup;
+    size_t                   cacheMB;
+    size_t                   tileMB;     ///< 0 to render whole frames
+    std::string              output;
+
+    Options()
+      : width(1920)
+      , height(1080)
+      , depth("float")
+      , components("rgba")
+      , threads(0)
+      , frames(10)
+      , iterations(5)
+      , warmup(1)
+      , cacheMB(1024)
+      , tileMB(0)
+    {
+    }
+  };
+
+  /// the example plugins built with the C++ support library
+  const char *const kStandardWorkloads[] = {
+    "net.sf.openfx.basicPlugin",
+    "net.sf.openfx.invertPlugin",
+    "net.sf.openfx.noisePlugin",
+    "net.sf.openfx.retimer",
+    "net.sf.openfx.crossFade",
+    "net.sf.openfx.fieldPlugin",
+  };
+
+  /// the contexts we will render in, the first a plugin supports being used
+  const char *const kContexts[] = {
+    kOfxImageEffectContextFilter,
+    kOfxImageEffectContextGenerator,
+    kOfxImageEffectContextTransition,
+    kOfxImageEffectContextGeneral,
+  };
+
+  void usage(const char *argv0)
+  {
+    fprintf(stderr,
+            "usage : %s [--bundle path] [--plugin id]... [--width n] [--height n]\n"
+            "          [--depth byte|short|float] [--components rgba|rgb|alpha]\n"
+            "          [--threads n] [--frames n] [--iterations n] [--warmup n]\n"
+            "          [--cache-mb n] [--tile-mb n] [--output file]\n", argv0);
+    exit(1);
+  }
+
+  bool parseOptions(int argc, char **argv, Options &options)
+  {
+    for(int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if(i + 1 >= argc)
+        return false;
+      const char *value = argv[++i];
+      if(arg == "--bundle") options.bundle = value;
+      else if(arg == "--plugin") options.plugins.push_back(value);
+      else if(arg == "--width") options.width = atoi(value);
+      else if(arg == "--height") options.height = atoi(value);
+      else if(arg == "--depth") options.depth = value;
+      else if(arg == "--components") options.components = value;
+      else if(arg == "--threads") options.threads = (unsigned int) atoi(value);
+      else if(arg == "--frames") options.frames = atoi(value);
+      else if(arg == "--iterations") options.iterations = atoi(value);
+      else if(arg == "--warmup") options.warmup = atoi(value);
+      else if(arg == "--cache-mb") options.cacheMB = (size_t) atol(value);
+      else if(arg == "--tile-mb") options.tileMB = (size_t) atol(value);
+      else if(arg == "--output") options.output = value;
+      else
+        return false;
+    }
+    return options.width > 0 && options.height > 0 && options.frames > 0 && options.iterations > 0 && options.warmup >= 0;
+  }
+
+  /// set the clips of the hostDemo host to the options, false if they make no sense
+  bool setClipFormat(const Options &options)
+  {
+    MyHost::ClipFormat &format = MyHost::getClipFormat();
+    format.width = options.width;
+    format.height = options.height;
+    format.pixelAspect = 1.0;
+    format.startFrame = 0;
+    format.endFrame = options.frames;
+
+    if(options.depth == "byte") format.bitDepth = kOfxBitDepthByte;
+    else if(options.depth == "short") format.bitDepth = kOfxBitDepthShort;
+    else if(options.depth == "float") format.bitDepth = kOfxBitDepthFloat;
+    else return false;
+
+    if(options.components == "rgba") format.components = kOfxImageComponentRGBA;
+    else if(options.components == "rgb") format.components = kOfxImageComponentRGB;
+    else if(options.components == "alpha") format.components = kOfxImageComponentAlpha;
+    else return false;
+    return true;
+  }
+
+  /// a string as a JSON string
+  std::string quote(const std::string &s)
+  {
+    std::string r("\"");
+    for(size_t i = 0; i < s.size(); ++i) {
+      unsigned char c = s[i];
+      if(c == '"' || c == '\\') {
+        r += '\\';
+        r += c;
+      }
+      else if(c < 0x20) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", c);
+        r += buf;
+      }
+      else
+        r += c;
+    }
+    return r + "\"";
+  }
+
+  /// the nearest rank percentile of sorted times
+  double percentile(const std::vector<double> &sorted, double p)
+  {
+    size_t rank = (size_t) ceil(p / 100.0 * sorted.size());
+    return sorted[rank ? rank - 1 : 0];
+  }
+
+  /// what rendering a workload came to
+  struct Result {
+    std::string plugin;
+    std::string context;
+    std::string status;
+    double      seconds;
+    unsigned long long allocations;
+    unsigned long long allocatedBytes;
+    OFX::Host::Memory::Pool::Stats poolStats;
+    OFX::Host::ImageEffect::ImageCacheStats cacheStats;
+    std::map<std::string, std::vector<double> > actionTimes;
+    size_t      tilesPerFrame;
+    bool        tilesMatch;  ///< whether the frames rendered as tiles were the same as whole ones
+
+    Result() : seconds(0), allocations(0), allocatedBytes(0), tilesPerFrame(0), tilesMatch(true) {memset(&poolStats, 0, sizeof(poolStats));}
+  };
+
+  /// render the frames one after another, each as tiles
+  OfxStatus renderTiles(OFX::Host::ImageEffect::Instance &instance, OFX::Host::ImageEffect::TiledRender &tiled,
+                        const Options &options, const std::string &field)
+  {
+    OfxPointD renderScale = {1.0, 1.0};
+    OfxRectI renderWindow = {0, 0, options.width, options.height};
+
+    OfxStatus stat = instance.beginRenderAction(0, options.frames - 1, 1.0, false, renderScale, false, false);
+    if(stat != kOfxStatOK && stat != kOfxStatReplyDefault)
+      return stat;
+
+    stat = kOfxStatOK;
+    for(int f = 0; f < options.frames && stat == kOfxStatOK; ++f) {
+      stat = tiled.render(f, renderWindow, renderScale, field);
+      releaseOutputImage(instance, f);
+    }
+
+    instance.endRenderAction(0, options.frames - 1, 1.0, false, renderScale, false, false);
+    return stat;
+  }
+
+  /// Render each frame whole and then as tiles, purging the image cache in between so that
+  /// the tiles fetch their own regions of the inputs, and compare the two.
+  OfxStatus checkTiles(OFX::Host::ImageEffect::Instance &instance, OFX::Host::ImageEffect::TiledRender &tiled,
+                       BenchHost &host, const Options &options, const std::string &field, Result &result)
+  {
+    OfxPointD renderScale = {1.0, 1.0};
+    OfxRectI renderWindow = {0, 0, options.width, options.height};
+
+    OfxStatus stat = instance.beginRenderAction(0, options.frames - 1, 1.0, false, renderScale, false, false);
+    if(stat != kOfxStatOK && stat != kOfxStatReplyDefault)
+      return stat;
+
+    std::vector<OFX::Host::ImageEffect::RenderTile> tiles;
+    stat = tiled.plan(0, renderWindow, renderScale, tiles);
+    result.tilesPerFrame = tiles.size();
+
+    std::vector<unsigned char> whole, tiledPixels;
+    for(int f = 0; f < options.frames && stat == kOfxStatOK; ++f) {
+      host.getImageCache().purge(&instance);
+      stat = instance.renderAction(f, field, renderWindow, renderScale, false, false, false);
+      releaseOutputImage(instance, f, &whole);
+      if(stat != kOfxStatOK)
+        break;
+
+      host.getImageCache().purge(&instance);
+      stat = tiled.render(f, renderWindow, renderScale, field);
+      releaseOutputImage(instance, f, &tiledPixels);
+      if(stat == kOfxStatOK && whole != tiledPixels)
+        result.tilesMatch = false;
+    }
+
+    instance.endRenderAction(0, options.frames - 1, 1.0, false, renderScale, false, false);
+    return stat;
+  }
+
+  /// run the per frame actions and render the frames once, as tiles if tiled is not NULL
+  OfxStatus renderFrames(OFX::Host::ImageEffect::Instance &instance, BenchRenderScheduler &scheduler,
+                         OFX::Host::ImageEffect::TiledRender *tiled, const Options &options, const std::string &field)
+  {
+    OfxPointD renderScale = {1.0, 1.0};
+    OfxRectI renderWindow = {0, 0, options.width, options.height};
+    OfxRectD roi = {0, 0, double(options.width), double(options.height)};
+
+    for(int f = 0; f < options.frames; ++f) {
+      OfxTime time = f;
+      OfxRectD rod;
+      instance.getRegionOfDefinitionAction(time, renderScale, rod);
+
+      std::map<OFX::Host::ImageEffect::ClipInstance *, OfxRectD> rois;
+      instance.getRegionOfInterestAction(time, renderScale, roi, rois);
+
+      if(instance.temporalAccess()) {
+        OFX::Host::ImageEffect::RangeMap rangeMap;
+        instance.getFrameNeededAction(time, rangeMap);
+      }
+
+      OfxTime identityTime = time;
+      std::string identityClip;
+      instance.isIdentityAction(identityTime, field, renderWindow, renderScale, identityClip);
+    }
+
+    if(tiled)
+      return renderTiles(instance, *tiled, options, field);
+    return scheduler.render(0, options.frames - 1, 1.0, renderWindow, renderScale, field);
+  }
+
+  Result runWorkload(OFX::Host::ImageEffect::ImageEffectPlugin &plugin, BenchHost &host, const Options &options)
+  {
+    Result result;
+    result.plugin = plugin.getRawIdentifier();
+
+    const std::set<std::string> &contexts = plugin.getContexts();
+    for(size_t i = 0; i < sizeof(kContexts) / sizeof(kContexts[0]) && result.context.empty(); ++i)
+      if(contexts.count(kContexts[i]))
+        result.context = kContexts[i];
+    if(result.context.empty()) {
+      result.status = "no supported context";
+      return result;
+    }
+
+    std::unique_ptr<OFX::Host::ImageEffect::Instance> instance(plugin.createInstance(result.context, NULL));
+    if(!instance) {
+      result.status = "could not create instance";
+      return result;
+    }
+    OfxStatus stat = instance->createInstanceAction();
+    if(stat != kOfxStatOK && stat != kOfxStatReplyDefault) {
+      result.status = "create instance action failed";
+      return result;
+    }
+    instance->getClipPreferences();
+
+    // the clips take no components the plugin cannot map ours to
+    for(int i = 0; i < instance->getNClips(); ++i) {
+      if(instance->getNthClip(i)->getComponents() == kOfxImageComponentNone) {
+        result.status = "components not supported";
+        return result;
+      }
+    }
+
+    const std::string field = kOfxImageFieldNone;
+    BenchRenderScheduler scheduler(*instance, options.threads);
+    std::unique_ptr<OFX::Host::ImageEffect::TiledRender> tiled;
+    if(options.tileMB) {
+      tiled.reset(new OFX::Host::ImageEffect::TiledRender(*instance, options.tileMB * 1024 * 1024, options.threads));
+      stat = checkTiles(*instance, *tiled, host, options, field, result);
+      if(stat != kOfxStatOK) {
+        result.status = "render failed";
+        return result;
+      }
+      if(!result.tilesMatch)
+        fprintf(stderr, "%s : the frames rendered as tiles differ from those rendered whole\n", result.plugin.c_str());
+    }
+
+    for(int i = 0; i < options.warmup; ++i) {
+      stat = renderFrames(*instance, scheduler, tiled.get(), options, field);
+      if(stat != kOfxStatOK) {
+        result.status = "render failed";
+        return result;
+      }
+    }
+
+    // the stats for the measured renders only
+    host.getImageCache().resetStats();
+    OFX::Host::Memory::Pool::getDefault().resetStats();
+    gActionTimes.clear();
+    gActionTimes.setRecording(true);
+    unsigned long long allocations = gAllocations.load();
+    unsigned long long allocatedBytes = gAllocatedBytes.load();
+    Clock::time_point start = Clock::now();
+
+    for(int i = 0; i < options.iterations && stat == kOfxStatOK; ++i)
+      stat = renderFrames(*instance, scheduler, tiled.get(), options, field);
+
+    result.seconds = msSince(start) / 1000.0;
+    gActionTimes.setRecording(false);
+    result.allocations = gAllocations.load() - allocations;
+    result.allocatedBytes = gAllocatedBytes.load() - allocatedBytes;
+    result.poolStats = OFX::Host::Memory::Pool::getDefault().getStats();
+    result.cacheStats = host.getImageCache().getStats();
+    result.actionTimes = gActionTimes.get();
+    result.status = stat == kOfxStatOK ? "ok" : "render failed";
+
+    // the frames of this instance are no use to the next
+    host.getImageCache().purge(instance.get());
+    return result;
+  }
+
+  void writeResult(FILE *f, const Result &result, const Options &options)
+  {
+    fprintf(f, "    {\n      \"plugin\": %s,\n      \"context\": %s,\n      \"status\": %s",
+            quote(result.plugin).c_str(), quote(result.context).c_str(), quote(result.status).c_str());
+    if(result.status != "ok") {
+      fprintf(f, "\n    }");
+      return;
+    }
+
+    double nFrames = double(options.frames) * options.iterations;
+    fprintf(f, ",\n      \"seconds\": %.6f,\n      \"fps\": %.3f,\n      \"mpixPerSecond\": %.3f,\n",
+            result.seconds, nFrames / result.seconds,
+            nFrames * options.width * options.height / result.seconds / 1.0e6);
+    fprintf(f, "      \"allocations\": {\"count\": %llu, \"bytes\": %llu, \"perFrame\": %.2f},\n",
+            result.allocations, result.allocatedBytes, result.allocations / nFrames);
+    fprintf(f, "      \"memoryPool\": {\"hits\": %zu, \"misses\": %zu, \"evictions\": %zu, \"peakBytes\": %zu},\n",
+            result.poolStats.hits, result.poolStats.misses, result.poolStats.evictions, result.poolStats.peakBytes);
+    fprintf(f, "      \"imageCache\": {\"hits\": %llu, \"misses\": %llu, \"insertions\": %llu, \"evictions\": %llu, \"peakBytes\": %zu},\n",
+            result.cacheStats.hits, result.cacheStats.misses, result.cacheStats.insertions,
+            result.cacheStats.evictions, result.cacheStats.peakBytes);
+    if(options.tileMB)
+      fprintf(f, "      \"tiles\": {\"perFrame\": %zu, \"matchWholeFrames\": %s},\n",
+              result.tilesPerFrame, result.tilesMatch ? "true" : "false");
+
+    fprintf(f, "      \"actions\": {");
+    const char *separator = "\n";
+    for(std::map<std::string, std::vector<double> >::const_iterator i = result.actionTimes.begin(); i != result.actionTimes.end(); ++i) {
+      std::vector<double> times = i->second;
+      std::sort(times.begin(), times.end());
+      double sum = 0;
+      for(size_t j = 0; j < times.size(); ++j)
+        sum += times[j];
+      fprintf(f, "%s        %s: {\"calls\": %zu, \"minMs\": %.6f, \"meanMs\": %.6f, \"p50Ms\": %.6f, \"p90Ms\": %.6f, \"p99Ms\": %.6f, \"maxMs\": %.6f}",
+              separator, quote(i->first).c_str(), times.size(), times.front(), sum / times.size(),
+              percentile(times, 50), percentile(times, 90), percentile(times, 99), times.back());
+      separator = ",\n";
+    }
+    fprintf(f, "\n      }\n    }");
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if(!parseOptions(argc, argv, options) || !setClipFormat(options))
+    usage(argv[0]);
+
+  OFX::Host::PluginCache::getPluginCache()->setCacheVersion("renderBenchV1");
+  BenchHost host;
+  host.getImageCache().setMemoryBudget(options.cacheMB * 1024 * 1024);
+
+  OFX::Host::ImageEffect::PluginCache imageEffectPluginCache(host);
+  imageEffectPluginCache.registerInCache(*OFX::Host::PluginCache::getPluginCache());
+
+  // search the directory the bundle is in as well
+  std::string bundle = options.bundle;
+  while(bundle.size() > 1 && bundle[bundle.size() - 1] == '/')
+    bundle.erase(bundle.size() - 1);
+  if(!bundle.empty()) {
+    size_t slash = bundle.rfind('/');
+    OFX::Host::PluginCache::getPluginCache()->addFileToPath(slash == std::string::npos ? "." : bundle.substr(0, slash), false);
+  }
+  OFX::Host::PluginCache::getPluginCache()->scanPluginFiles();
+
+  // the plugins asked for, else those in the bundle, else the standard workloads
+  std::vector<std::string> ids = options.plugins;
+  if(ids.empty() && !bundle.empty()) {
+    const std::map<std::string, OFX::Host::ImageEffect::ImageEffectPlugin *> &plugins = imageEffectPluginCache.getPluginsByID();
+    for(std::map<std::string, OFX::Host::ImageEffect::ImageEffectPlugin *>::const_iterator i = plugins.begin(); i != plugins.end(); ++i)
+      if(i->second->getBinary()->getBundlePath() == bundle)
+        ids.push_back(i->second->getRawIdentifier());
+  }
+  if(ids.empty() && bundle.empty())
+    ids.assign(kStandardWorkloads, kStandardWorkloads + sizeof(kStandardWorkloads) / sizeof(kStandardWorkloads[0]));
+
+  std::vector<Result> results(ids.size());
+  for(size_t i = 0; i < ids.size(); ++i) {
+    if(OFX::Host::ImageEffect::ImageEffectPlugin *plugin = imageEffectPluginCache.getPluginById(ids[i]))
+      results[i] = runWorkload(*plugin, host, options);
+    else {
+      results[i].plugin = ids[i];
+      results[i].status = "not found";
+    }
+  }
+
+  FILE *f = options.output.empty() ? stdout : fopen(options.output.c_str(), "w");
+  if(!f) {
+    fprintf(stderr, "could not open %s\n", options.output.c_str());
+    return 1;
+  }
+
+  fprintf(f, "{\n  \"width\": %d,\n  \"height\": %d,\n  \"depth\": %s,\n  \"components\": %s,\n"
+          "  \"threads\": %u,\n  \"frames\": %d,\n  \"iterations\": %d,\n  \"tileMB\": %zu,\n  \"workloads\": [",
+          options.width, options.height, quote(options.depth).c_str(), quote(options.components).c_str(),
+          options.threads, options.frames, options.iterations, options.tileMB);
+  for(size_t i = 0; i < results.size(); ++i) {
+    fprintf(f, "%s\n", i ? "," : "");
+    writeResult(f, results[i], options);
+  }
+  fprintf(f, "\n  ]\n}\n");
+
+  if(f != stdout)
+    fclose(f);
+  OFX::Host::PluginCache::clearPluginCache();
+  return 0;
+}
@@ -0,0 +1,598 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+  Times the calls a plugin makes most, through the real C API, as a baseline for work on
+  look ups and dispatch. Covered are,
+    - the property suite gets, on a property in the set itself, on one in the set it is
+      chained to, and on one answered by a get hook,
+    - the parameter suite gets, of a param with a fixed value and of one with keys,
+    - the support library's main entry, which mainEntryStr dispatches to the action.
+
+  The support library side runs in process against this host, with a plugin that does
+  nothing but what the library does for it. It is loaded and described, and an instance
+  made, on a descriptor carrying the properties the library reads off an instance, which
+  lets the actions run without a plugin binary.
+
+  Each benchmark is run with more iterations till it takes the minimum time, and the time
+  per call printed, in the manner of Google Benchmark.
+
+  usage : suiteCalls [--filter text] [--min-time seconds]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+#include "ofxParam.h"
+#include "ofxProperty.h"
+
+#include "ofxhBinary.h"
+#include "ofxhPropertySuite.h"
+#include "ofxhClip.h"
+#include "ofxhParam.h"
+#include "ofxhParamAnimation.h"
+#include "ofxhImageEffect.h"
+#include "ofxhPluginAPICache.h"
+#include "ofxhPluginCache.h"
+#include "ofxhHost.h"
+#include "ofxhImageEffectAPI.h"
+
+#include "ofxsImageEffect.h"
+
+using namespace OFX::Host;
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  /// what the benchmarks fold their results into, so the calls are not optimised away
+  volatile double gSink;
+
+  //
+  // property sets
+  //
+
+  /// what an image carries, looked up on the set itself
+  const Property::PropSpec imageStuff[] = {
+    { kOfxPropType, Property::eString, 1, true, kOfxTypeImage },
+    { kOfxImageEffectPropPixelDepth, Property::eString, 1, true, kOfxBitDepthFloat },
+    { kOfxImageEffectPropComponents, Property::eString, 1, true, kOfxImageComponentRGBA },
+    { kOfxImageEffectPropPreMultiplication, Property::eString, 1, true, kOfxImagePreMultiplied },
+    { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "1.0" },
+    { kOfxImagePropPixelAspectRatio, Property::eDouble, 1, true, "1.0" },
+    { kOfxImagePropData, Property::ePointer, 1, true, NULL },
+    { kOfxImagePropBounds, Property::eInt, 4, true, "0" },
+    { kOfxImagePropRegionOfDefinition, Property::eInt, 4, true, "0" },
+    { kOfxImagePropRowBytes, Property::eInt, 1, true, "0" },
+    { kOfxImagePropField, Property::eString, 1, true, kOfxImageFieldNone },
+    { kOfxImagePropUniqueIdentifier, Property::eString, 1, true, "" },
+    Property::propSpecEnd
+  };
+
+  /// what an effect descriptor carries, chained to from the instance
+  const Property::PropSpec descriptorStuff[] = {
+    { kOfxPropType, Property::eString, 1, true, kOfxTypeImageEffect },
+    { kOfxPropLabel, Property::eString, 1, false, "" },
+    { kOfxPropShortLabel, Property::eString, 1, false, "" },
+    { kOfxPropLongLabel, Property::eString, 1, false, "" },
+    { kOfxPropVersion, Property::eInt, 0, false, "0" },
+    { kOfxPropVersionLabel, Property::eString, 1, false, "" },
+    { kOfxPropPluginDescription, Property::eString, 1, false, "" },
+    { kOfxImageEffectPropSupportedContexts, Property::eString, 0, false, "" },
+    { kOfxImageEffectPluginPropGrouping, Property::eString, 1, false, "" },
+    { kOfxImageEffectPluginPropSingleInstance, Property::eInt, 1, false, "0" },
+    { kOfxImageEffectPluginRenderThreadSafety, Property::eString, 1, false, kOfxImageEffectRenderInstanceSafe },
+    { kOfxImageEffectPluginPropHostFrameThreading, Property::eInt, 1, false, "1" },
+    { kOfxImageEffectPropSupportsMultiResolution, Property::eInt, 1, false, "1" },
+    { kOfxImageEffectPropSupportsTiles, Property::eInt, 1, false, "1" },
+    { kOfxImageEffectPropTemporalClipAccess, Property::eInt, 1, false, "0" },
+    { kOfxImageEffectPropSupportedPixelDepths, Property::eString, 0, false, "" },
+    Property::propSpecEnd
+  };
+
+  /// what an effect instance carries of its own
+  const Property::PropSpec instanceStuff[] = {
+    { kOfxImageEffectPropContext, Property::eString, 1, true, kOfxImageEffectContextFilter },
+    { kOfxPropIsInteractive, Property::eInt, 1, true, "0" },
+    { kOfxPropInstanceData, Property::ePointer, 1, false, NULL },
+    { kOfxImageEffectPropProjectSize, Property::eDouble, 2, true, "0" },
+    { kOfxImageEffectPropProjectOffset, Property::eDouble, 2, true, "0" },
+    { kOfxImageEffectPropProjectExtent, Property::eDouble, 2, true, "0" },
+    { kOfxImageEffectPropProjectPixelAspectRatio, Property::eDouble, 1, true, "1.0" },
+    { kOfxImageEffectInstancePropEffectDuration, Property::eDouble, 1, true, "1.0" },
+    { kOfxImageEffectInstancePropSequentialRender, Property::eInt, 1, false, "0" },
+    { kOfxImageEffectPropFrameRate, Property::eDouble, 1, true, "25.0" },
+    Property::propSpecEnd
+  };
+
+  /// what a clip answers through its get hooks
+  const Property::PropSpec hookedStuff[] = {
+    { kOfxImageEffectPropPixelDepth, Property::eString, 1, true, "" },
+    { kOfxImagePropPixelAspectRatio, Property::eDouble, 1, true, "0" },
+    { kOfxImageEffectPropFrameRange, Property::eDouble, 2, true, "0" },
+    { kOfxImageClipPropConnected, Property::eInt, 1, true, "0" },
+    Property::propSpecEnd
+  };
+
+  /// answers the hooked properties with fixed values
+  class BenchHook : public Property::GetHook {
+  public :
+    const std::string &getStringProperty(const std::string &, int) const {static const std::string v(kOfxBitDepthFloat); return v;}
+    int getIntProperty(const std::string &, int) const {return 1;}
+    double getDoubleProperty(const std::string &, int index) const {return index;}
+    void getDoublePropertyN(const std::string &, double *values, int count) const
+    {
+      for(int i = 0; i < count; ++i)
+        values[i] = i;
+    }
+    int getDimension(const std::string &name) const {return name == kOfxImageEffectPropFrameRange ? 2 : 1;}
+  };
+
+  //
+  // params
+  //
+
+  /// a double param with a fixed value, so only the suite is timed
+  class FixedDoubleInstance : public Param::DoubleInstance {
+  public :
+    explicit FixedDoubleInstance(Param::Descriptor &descriptor) : Param::DoubleInstance(descriptor) {}
+    OfxStatus get(double &v) {v = 0.5; return kOfxStatOK;}
+    OfxStatus get(OfxTime, double &v) {v = 0.5; return kOfxStatOK;}
+    OfxStatus set(double) {return kOfxStatErrMissingHostFeature;}
+    OfxStatus set(OfxTime, double) {return kOfxStatErrMissingHostFeature;}
+    OfxStatus derive(OfxTime, double &) {return kOfxStatErrMissingHostFeature;}
+    OfxStatus integrate(OfxTime, OfxTime, double &) {return kOfxStatErrMissingHostFeature;}
+  };
+
+  //
+  // the host and plugin
+  //
+
+  /// a host that makes descriptors, but no instances
+  class BenchHost : public ImageEffect::Host {
+  public :
+    ImageEffect::Instance *newInstance(void *, ImageEffect::ImageEffectPlugin *, ImageEffect::Descriptor &, const std::string &) {return 0;}
+    ImageEffect::Descriptor *makeDescriptor(ImageEffect::ImageEffectPlugin *plugin) {return new ImageEffect::Descriptor(plugin);}
+    ImageEffect::Descriptor *makeDescriptor(const ImageEffect::Descriptor &rootContext, ImageEffect::ImageEffectPlugin *plugin) {return new ImageEffect::Descriptor(rootContext, plugin);}
+    ImageEffect::Descriptor *makeDescriptor(const std::string &bundlePath, ImageEffect::ImageEffectPlugin *plugin) {return new ImageEffect::Descriptor(bundlePath, plugin);}
+    OfxStatus vmessage(const char *, const char *, const char *, va_list) {return kOfxStatOK;}
+    OfxStatus setPersistentMessage(const char *, const char *, const char *, va_list) {return kOfxStatOK;}
+    OfxStatus clearPersistentMessage() {return kOfxStatOK;}
+#   ifdef OFX_SUPPORTS_OPENGLRENDER
+    OfxStatus flushOpenGLResources() const {return kOfxStatFailed;}
+#   endif
+  };
+
+  /// an effect that leaves everything to the support library
+  class BenchEffect : public OFX::ImageEffect {
+  public :
+    explicit BenchEffect(OfxImageEffectHandle handle) : OFX::ImageEffect(handle) {}
+    void render(const OFX::RenderArguments &) {}
+  };
+
+}
+
+mDeclarePluginFactory(BenchEffectFactory, {}, {});
+
+void BenchEffectFactory::describe(OFX::ImageEffectDescriptor &desc)
+{
+  desc.setLabels("Bench", "Bench", "Bench");
+  desc.addSupportedContext(OFX::eContextFilter);
+  desc.addSupportedBitDepth(OFX::eBitDepthFloat);
+}
+
+void BenchEffectFactory::describeInContext(OFX::ImageEffectDescriptor &, OFX::ContextEnum)
+{
+}
+
+OFX::ImageEffect *BenchEffectFactory::createInstance(OfxImageEffectHandle handle, OFX::ContextEnum)
+{
+  return new BenchEffect(handle);
+}
+
+namespace OFX {
+  namespace Plugin {
+    void getPluginIDs(OFX::PluginFactoryArray &ids)
+    {
+      static BenchEffectFactory p("org.openeffects.suiteCallsBench", 1, 0);
+      ids.push_back(&p);
+    }
+  }
+}
+
+namespace {
+
+  /// everything the benchmarks call on, made once
+  struct Fixture {
+    const OfxPropertySuiteV1  *propSuite;
+    const OfxParameterSuiteV1 *paramSuite;
+
+    Property::Set image;
+    Property::Set descriptor;
+    Property::Set instance;
+    Property::Set hooked;
+    BenchHook     hook;
+
+    Param::Descriptor             doubleDescriptor;
+    FixedDoubleInstance           fixedDouble;
+    Param::AnimatedDoubleInstance animatedDouble;
+
+    OfxPlugin               *plugin;
+    ImageEffect::Descriptor *effectDescriptor;
+    ImageEffect::Descriptor *effectInstance;
+    Property::Set            identityInArgs;
+    Property::Set            identityOutArgs;
+    Property::Set            rodInArgs;
+    Property::Set            rodOutArgs;
+
+    Fixture();
+    ~Fixture();
+  };
+
+  Fixture *gFixture = 0;
+
+  const Property::PropSpec identityInArgStuff[] = {
+    { kOfxPropTime, Property::eDouble, 1, true, "0" },
+    { kOfxImageEffectPropFieldToRender, Property::eString, 1, true, kOfxImageFieldNone },
+    { kOfxImageEffectPropRenderWindow, Property::eInt, 4, true, "0" },
+    { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "1" },
+    Property::propSpecEnd
+  };
+
+  const Property::PropSpec identityOutArgStuff[] = {
+    { kOfxPropName, Property::eString, 1, false, "" },
+    { kOfxPropTime, Property::eDouble, 1, false, "0" },
+    Property::propSpecEnd
+  };
+
+  const Property::PropSpec rodInArgStuff[] = {
+    { kOfxPropTime, Property::eDouble, 1, true, "0" },
+    { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "1" },
+    Property::propSpecEnd
+  };
+
+  const Property::PropSpec rodOutArgStuff[] = {
+    { kOfxImageEffectPropRegionOfDefinition, Property::eDouble, 4, false, "0" },
+    Property::propSpecEnd
+  };
+
+  Fixture::Fixture()
+    : propSuite(static_cast<const OfxPropertySuiteV1 *>(Property::GetSuite(1)))
+    , paramSuite(static_cast<const OfxParameterSuiteV1 *>(Param::GetSuite(1)))
+    , image(imageStuff)
+    , descriptor(descriptorStuff)
+    , instance(instanceStuff)
+    , hooked(hookedStuff)
+    , doubleDescriptor(kOfxParamTypeDouble, "value")
+    , fixedDouble(doubleDescriptor)
+    , animatedDouble(doubleDescriptor)
+    , plugin(0)
+    , effectDescriptor(0)
+    , effectInstance(0)
+    , identityInArgs(identityInArgStuff)
+    , identityOutArgs(identityOutArgStuff)
+    , rodInArgs(rodInArgStuff)
+    , rodOutArgs(rodOutArgStuff)
+  {
+    instance.setChainedSet(&descriptor);
+    for(int i = 0; hookedStuff[i].name; ++i)
+      hooked.setGetHook(hookedStuff[i].name, &hook);
+
+    // a key every ten frames
+    for(int i = 0; i <= 10; ++i)
+      animatedDouble.set(OfxTime(i * 10), double(i * i));
+  }
+
+  Fixture::~Fixture()
+  {
+    delete effectInstance;
+    delete effectDescriptor;
+  }
+
+  /// load, describe and make an instance of the plugin, false if that failed
+  bool setUpPlugin(BenchHost &host, Fixture &fixture)
+  {
+    fixture.plugin = OfxGetPlugin(0);
+    if(!fixture.plugin)
+      return false;
+    fixture.plugin->setHost(host.getHandle());
+    if(fixture.plugin->mainEntry(kOfxActionLoad, 0, 0, 0) != kOfxStatOK)
+      return false;
+
+    fixture.effectDescriptor = host.makeDescriptor("", 0);
+    if(fixture.plugin->mainEntry(kOfxActionDescribe, fixture.effectDescriptor->getHandle(), 0, 0) != kOfxStatOK)
+      return false;
+
+    fixture.effectInstance = host.makeDescriptor("", 0);
+    fixture.effectInstance->getProps().addProperties(instanceStuff);
+    fixture.effectInstance->getProps().setChainedSet(&fixture.effectDescriptor->getProps());
+    return fixture.plugin->mainEntry(kOfxActionCreateInstance, fixture.effectInstance->getHandle(), 0, 0) == kOfxStatOK;
+  }
+
+  void tearDownPlugin(Fixture &fixture)
+  {
+    if(!fixture.plugin)
+      return;
+    if(fixture.effectInstance)
+      fixture.plugin->mainEntry(kOfxActionDestroyInstance, fixture.effectInstance->getHandle(), 0, 0);
+    fixture.plugin->mainEntry(kOfxActionUnload, 0, 0, 0);
+  }
+
+  //
+  // the benchmarks
+  //
+
+  void propGetIntLocal(long n)
+  {
+    OfxPropertySetHandle h = gFixture->image.getHandle();
+    int v = 0, sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->propSuite->propGetInt(h, kOfxImagePropRowBytes, 0, &v);
+      sum += v;
+    }
+    gSink = sum;
+  }
+
+  void propGetDoubleLocal(long n)
+  {
+    OfxPropertySetHandle h = gFixture->image.getHandle();
+    double v = 0, sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->propSuite->propGetDouble(h, kOfxImagePropPixelAspectRatio, 0, &v);
+      sum += v;
+    }
+    gSink = sum;
+  }
+
+  void propGetStringLocal(long n)
+  {
+    OfxPropertySetHandle h = gFixture->image.getHandle();
+    char *v = 0;
+    double sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->propSuite->propGetString(h, kOfxImageEffectPropPixelDepth, 0, &v);
+      sum += v[0];
+    }
+    gSink = sum;
+  }
+
+  void propGetIntNLocal(long n)
+  {
+    OfxPropertySetHandle h = gFixture->image.getHandle();
+    int v[4];
+    double sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->propSuite->propGetIntN(h, kOfxImagePropBounds, 4, v);
+      sum += v[3];
+    }
+    gSink = sum;
+  }
+
+  void propGetDoubleNLocal(long n)
+  {
+    OfxPropertySetHandle h = gFixture->image.getHandle();
+    double v[2], sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->propSuite->propGetDoubleN(h, kOfxImageEffectPropRenderScale, 2, v);
+      sum += v[1];
+    }
+    gSink = sum;
+  }
+
+  void propGetIntChained(long n)
+  {
+    OfxPropertySetHandle h = gFixture->instance.getHandle();
+    int v = 0, sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->propSuite->propGetInt(h, kOfxImageEffectPropSupportsTiles, 0, &v);
+      sum += v;
+    }
+    gSink = sum;
+  }
+
+  void propGetStringChained(long n)
+  {
+    OfxPropertySetHandle h = gFixture->instance.getHandle();
+    char *v = 0;
+    double sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->propSuite->propGetString(h, kOfxImageEffectPluginRenderThreadSafety, 0, &v);
+      sum += v[0];
+    }
+    gSink = sum;
+  }
+
+  void propGetIntHook(long n)
+  {
+    OfxPropertySetHandle h = gFixture->hooked.getHandle();
+    int v = 0, sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->propSuite->propGetInt(h, kOfxImageClipPropConnected, 0, &v);
+      sum += v;
+    }
+    gSink = sum;
+  }
+
+  void propGetStringHook(long n)
+  {
+    OfxPropertySetHandle h = gFixture->hooked.getHandle();
+    char *v = 0;
+    double sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->propSuite->propGetString(h, kOfxImageEffectPropPixelDepth, 0, &v);
+      sum += v[0];
+    }
+    gSink = sum;
+  }
+
+  void propGetDoubleNHook(long n)
+  {
+    OfxPropertySetHandle h = gFixture->hooked.getHandle();
+    double v[2], sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->propSuite->propGetDoubleN(h, kOfxImageEffectPropFrameRange, 2, v);
+      sum += v[1];
+    }
+    gSink = sum;
+  }
+
+  void paramGetValueFixed(long n)
+  {
+    OfxParamHandle h = gFixture->fixedDouble.getHandle();
+    double v = 0, sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->paramSuite->paramGetValue(h, &v);
+      sum += v;
+    }
+    gSink = sum;
+  }
+
+  void paramGetValueAtTimeFixed(long n)
+  {
+    OfxParamHandle h = gFixture->fixedDouble.getHandle();
+    double v = 0, sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->paramSuite->paramGetValueAtTime(h, OfxTime(i % 100), &v);
+      sum += v;
+    }
+    gSink = sum;
+  }
+
+  void paramGetValueAtTimeAnimated(long n)
+  {
+    OfxParamHandle h = gFixture->animatedDouble.getHandle();
+    double v = 0, sum = 0;
+    for(long i = 0; i < n; ++i) {
+      gFixture->paramSuite->paramGetValueAtTime(h, OfxTime(i % 100) + 0.5, &v);
+      sum += v;
+    }
+    gSink = sum;
+  }
+
+  void mainEntryUnknown(long n)
+  {
+    OfxImageEffectHandle h = gFixture->effectInstance->getHandle();
+    double sum = 0;
+    for(long i = 0; i < n; ++i)
+      sum += gFixture->plugin->mainEntry("org.openeffects.suiteCallsBench.custom", h, 0, 0);
+    gSink = sum;
+  }
+
+  void mainEntryPurgeCaches(long n)
+  {
+    OfxImageEffectHandle h = gFixture->effectInstance->getHandle();
+    double sum = 0;
+    for(long i = 0; i < n; ++i)
+      sum += gFixture->plugin->mainEntry(kOfxActionPurgeCaches, h, 0, 0);
+    gSink = sum;
+  }
+
+  void mainEntryIsIdentity(long n)
+  {
+    OfxImageEffectHandle h = gFixture->effectInstance->getHandle();
+    OfxPropertySetHandle inArgs = gFixture->identityInArgs.getHandle();
+    OfxPropertySetHandle outArgs = gFixture->identityOutArgs.getHandle();
+    double sum = 0;
+    for(long i = 0; i < n; ++i)
+      sum += gFixture->plugin->mainEntry(kOfxImageEffectActionIsIdentity, h, inArgs, outArgs);
+    gSink = sum;
+  }
+
+  void mainEntryGetRegionOfDefinition(long n)
+  {
+    OfxImageEffectHandle h = gFixture->effectInstance->getHandle();
+    OfxPropertySetHandle inArgs = gFixture->rodInArgs.getHandle();
+    OfxPropertySetHandle outArgs = gFixture->rodOutArgs.getHandle();
+    double sum = 0;
+    for(long i = 0; i < n; ++i)
+      sum += gFixture->plugin->mainEntry(kOfxImageEffectActionGetRegionOfDefinition, h, inArgs, outArgs);
+    gSink = sum;
+  }
+
+  struct Benchmark {
+    const char *name;
+    void      (*run)(long nIterations);
+    bool        needsPlugin;
+  };
+
+  const Benchmark kBenchmarks[] = {
+    { "propGetInt/local", propGetIntLocal, false },
+    { "propGetDouble/local", propGetDoubleLocal, false },
+    { "propGetString/local", propGetStringLocal, false },
+    { "propGetIntN/local/4", propGetIntNLocal, false },
+    { "propGetDoubleN/local/2", propGetDoubleNLocal, false },
+    { "propGetInt/chained", propGetIntChained, false },
+    { "propGetString/chained", propGetStringChained, false },
+    { "propGetInt/hook", propGetIntHook, false },
+    { "propGetString/hook", propGetStringHook, false },
+    { "propGetDoubleN/hook/2", propGetDoubleNHook, false },
+    { "paramGetValue/fixed", paramGetValueFixed, false },
+    { "paramGetValueAtTime/fixed", paramGetValueAtTimeFixed, false },
+    { "paramGetValueAtTime/animated/11keys", paramGetValueAtTimeAnimated, false },
+    { "mainEntry/unknownAction", mainEntryUnknown, true },
+    { "mainEntry/purgeCaches", mainEntryPurgeCaches, true },
+    { "mainEntry/isIdentity", mainEntryIsIdentity, true },
+    { "mainEntry/getRegionOfDefinition", mainEntryGetRegionOfDefinition, true },
+  };
+
+  /// run the benchmark with more iterations till it takes minTime seconds, returning the
+  /// ns per iteration, and the iterations it took in nIterations
+  double runBenchmark(const Benchmark &benchmark, double minTime, long &nIterations)
+  {
+    nIterations = 1;
+    for(;;) {
+      Clock::time_point start = Clock::now();
+      benchmark.run(nIterations);
+      double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      if(seconds >= minTime || nIterations >= 1000000000L)
+        return seconds * 1.0e9 / nIterations;
+
+      // aim a little past the minimum, growing by at most 10 times each go
+      double scale = seconds > 0 ? 1.4 * minTime / seconds : 10.0;
+      if(scale > 10.0) scale = 10.0;
+      if(scale < 2.0) scale = 2.0;
+      nIterations = long(nIterations * scale);
+    }
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  const char *filter = "";
+  double minTime = 0.5;
+  for(int i = 1; i + 1 < argc; i += 2) {
+    if(strcmp(argv[i], "--filter") == 0)
+      filter = argv[i + 1];
+    else if(strcmp(argv[i], "--min-time") == 0)
+      minTime = atof(argv[i + 1]);
+  }
+
+  BenchHost host;
+  ImageEffect::PluginCache imageEffectPluginCache(host);
+
+  Fixture fixture;
+  gFixture = &fixture;
+  bool pluginOK = setUpPlugin(host, fixture);
+  if(!pluginOK)
+    fprintf(stderr, "could not load the plugin, skipping the mainEntry benchmarks\n");
+
+  printf("%-40s %12s %12s\n", "Benchmark", "Time", "Iterations");
+  printf("------------------------------------------------------------------\n");
+  for(size_t i = 0; i < sizeof(kBenchmarks) / sizeof(kBenchmarks[0]); ++i) {
+    const Benchmark &benchmark = kBenchmarks[i];
+    if(!strstr(benchmark.name, filter) || (benchmark.needsPlugin && !pluginOK))
+      continue;
+    long nIterations;
+    double ns = runBenchmark(benchmark, minTime, nIterations);
+    printf("%-40s %9.2f ns %12ld\n", benchmark.name, ns, nIterations);
+  }
+
+  tearDownPlugin(fixture);
+  return 0;
+}
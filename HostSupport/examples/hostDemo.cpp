@@ -22,6 +22,7 @@
 #include "ofxhPluginCache.h"
 #include "ofxhHost.h"
 #include "ofxhImageEffectAPI.h"
+#include "ofxhRenderScheduler.h"
 
 // my host
 #include "hostDemoHostDescriptor.h"
@@ -67,6 +68,30 @@ void exportToPPM(const std::string& fname, MyHost::MyImage* im)
   }
 }
 
+/// renders frames, writing each to a PPM file as it is done
+class PPMRenderScheduler : public OFX::Host::ImageEffect::RenderScheduler {
+public :
+  explicit PPMRenderScheduler(OFX::Host::ImageEffect::Instance &instance)
+    : OFX::Host::ImageEffect::RenderScheduler(instance)
+  {
+  }
+
+  virtual void frameRendered(OFX::Host::ImageEffect::Instance &instance, OfxTime time)
+  {
+    // get the output image buffer of the instance that rendered the frame
+    MyHost::MyClipInstance* outputClip = dynamic_cast<MyHost::MyClipInstance*>(instance.getClip("Output"));
+    assert(outputClip);
+    MyHost::MyImage *outputImage = outputClip->getOutputImage(time);
+
+    std::ostringstream ss;
+    ss << "Output." << time << ".ppm";
+    exportToPPM(ss.str(), outputImage);
+
+    // done with it, so it can be reused for a later frame
+    outputClip->releaseOutputImage(time);
+  }
+};
+
 int main(int argc, char **argv) 
 {
   //_CrtSetBreakAlloc(3168);
@@ -81,6 +106,10 @@ int main(int argc, char **argv)
   // as a description of the host application
   MyHost::Host myHost;
 
+  // keep up to 64MB of the input frames fetched, so fetching one again
+  // does not draw it again
+  myHost.getImageCache().setMemoryBudget(64 * 1024 * 1024);
+
   // make an image effect plugin cache. This is what knows about
   // all the plugins.
   OFX::Host::ImageEffect::PluginCache imageEffectPluginCache(myHost);
@@ -88,19 +117,23 @@ int main(int argc, char **argv)
   // register the image effect cache with the global plugin cache
   imageEffectPluginCache.registerInCache(*OFX::Host::PluginCache::getPluginCache());
 
-  // try to read an old cache
-  std::ifstream ifs("hostDemoPluginCache.xml");
-  OFX::Host::PluginCache::getPluginCache()->readCache(ifs);
+  // try to read an old cache, the binary one if we can, the XML one otherwise
+  if(!OFX::Host::PluginCache::getPluginCache()->readBinaryCache("hostDemoPluginCache.bin")) {
+    std::ifstream ifs("hostDemoPluginCache.xml");
+    OFX::Host::PluginCache::getPluginCache()->readCache(ifs);
+    ifs.close();
+  }
   OFX::Host::PluginCache::getPluginCache()->scanPluginFiles();
-  ifs.close();
 
-  /// flush out the current cache
+  /// flush out the current cache, the XML version is for people to read
+  OFX::Host::PluginCache::getPluginCache()->writeBinaryCache("hostDemoPluginCache.bin");
+
   std::ofstream of("hostDemoPluginCache.xml");
   OFX::Host::PluginCache::getPluginCache()->writePluginCache(of);
   of.close();
 
   // get the invert example plugin which uses the OFX C++ support code
-  OFX::Host::ImageEffect::ImageEffectPlugin* plugin = imageEffectPluginCache.getPluginById("net.sf.openfx:invertPlugin");
+  OFX::Host::ImageEffect::ImageEffectPlugin* plugin = imageEffectPluginCache.getPluginById("net.sf.openfx.invertPlugin");
 
   imageEffectPluginCache.dumpToStdOut();
 
@@ -144,15 +177,6 @@ int main(int argc, char **argv)
       
       int numFramesToRender = OFXHOSTDEMOCLIPLENGTH;
 
-      // say we are about to render a bunch of frames 
-      stat = instance->beginRenderAction(0, numFramesToRender, 1.0, false, renderScale, /*sequential=*/true, /*interactive=*/false
-                                         );
-      assert(stat == kOfxStatOK || stat == kOfxStatReplyDefault);
-
-      // get the output clip
-      MyHost::MyClipInstance* outputClip = dynamic_cast<MyHost::MyClipInstance*>(instance->getClip("Output"));
-      assert(outputClip);
-
       for(int t = 0; t <= numFramesToRender; ++t) 
       {
         // call get region of interest on each of the inputs
@@ -168,21 +192,21 @@ int main(int argc, char **argv)
         stat = instance->getRegionOfInterestAction(frame, renderScale,
                                                    regionOfInterest, rois);
         assert(stat == kOfxStatOK || stat == kOfxStatReplyDefault);
-
-        // render a frame
-        stat = instance->renderAction(t,kOfxImageFieldBoth,renderWindow, renderScale, /*sequential=*/true, /*interactive=*/false, /*draft=*/false);
-        assert(stat == kOfxStatOK);
-
-        // get the output image buffer
-        MyHost::MyImage *outputImage = outputClip->getOutputImage();
-
-        std::ostringstream ss;
-        ss << "Output." << t << ".ppm";
-        exportToPPM(ss.str(), outputImage);
       }
 
-      instance->endRenderAction(0, numFramesToRender, 1.0, false, renderScale, /*sequential=*/true, /*interactive=*/false
-                                );
+      // render the frames, as many at once as the plugin's thread safety allows. The
+      // scheduler calls the begin and end render actions for us, and as the invert
+      // plugin is instance safe, makes more instances of it to render on, each of
+      // which has its own output clip and image. Each frame is written out by
+      // frameRendered as soon as it is done.
+      PPMRenderScheduler scheduler(*instance);
+      stat = scheduler.render(0, numFramesToRender, 1.0, renderWindow, renderScale, kOfxImageFieldBoth);
+      assert(stat == kOfxStatOK);
+
+      OFX::Host::ImageEffect::ImageCacheStats stats = myHost.getImageCache().getStats();
+      std::cout << "image cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+                << stats.evictions << " evictions, " << stats.nImages << " images in "
+                << stats.bytes << " bytes" << std::endl;
     }
   }
   OFX::Host::PluginCache::clearPluginCache();
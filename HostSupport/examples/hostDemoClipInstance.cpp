@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <cmath>
 #include <ctime>
+#include <cstring>
 
 // ofx
 #include "ofxCore.h"
@@ -23,6 +24,7 @@
 #include "ofxhPluginCache.h"
 #include "ofxhHost.h"
 #include "ofxhImageEffectAPI.h"
+#include "ofxhTiledRender.h"
 
 // my host
 #include "hostDemoHostDescriptor.h"
@@ -35,8 +37,66 @@ namespace MyHost {
   const double    kPalPixelAspect = double(768)/double(720);
   const int       kPalSizeXPixels = 720;
   const int       kPalSizeYPixels = 576;
-  const OfxRectI  kPalRegionPixels = {0, 0, kPalSizeXPixels, kPalSizeYPixels};
-  //const OfxRectD  kPalRegionCanon = {0,0, kPalSizeXPixels * kPalPixelAspect ,kPalSizeYPixels};
+
+  ClipFormat::ClipFormat()
+    : width(kPalSizeXPixels)
+    , height(kPalSizeYPixels)
+    , pixelAspect(kPalPixelAspect)
+    , bitDepth(kOfxBitDepthByte)
+    , components(kOfxImageComponentRGBA)
+    , frameRate(25.0)
+    , startFrame(0)
+    , endFrame(25)
+  {
+  }
+
+  ClipFormat &getClipFormat()
+  {
+    static ClipFormat format;
+    return format;
+  }
+
+  /// the pixels of the whole frame
+  static OfxRectI getFrameBounds()
+  {
+    const ClipFormat &format = getClipFormat();
+    OfxRectI bounds = {0, 0, format.width, format.height};
+    return bounds;
+  }
+
+  static int getComponentCount(const std::string &components)
+  {
+    if(components == kOfxImageComponentRGBA)
+      return 4;
+    if(components == kOfxImageComponentRGB)
+      return 3;
+    return 1;
+  }
+
+  static int getBytesPerComponent(const std::string &depth)
+  {
+    if(depth == kOfxBitDepthFloat)
+      return 4;
+    if(depth == kOfxBitDepthShort || depth == kOfxBitDepthHalf)
+      return 2;
+    return 1;
+  }
+
+  /// the bytes of an opaque pixel of grey level v, from 0 to 1, halves being left black
+  static void makePixel(unsigned char *pix, const std::string &depth, const std::string &components, float v)
+  {
+    int nComps = getComponentCount(components);
+    memset(pix, 0, nComps * getBytesPerComponent(depth));
+    for(int c = 0; c < nComps; ++c) {
+      float value = (nComps == 4 && c == 3) ? 1.0f : v;
+      if(depth == kOfxBitDepthByte)
+        pix[c] = (unsigned char)(value * 255.0f + 0.5f);
+      else if(depth == kOfxBitDepthShort)
+        reinterpret_cast<unsigned short *>(pix)[c] = (unsigned short)(value * 65535.0f + 0.5f);
+      else if(depth == kOfxBitDepthFloat)
+        reinterpret_cast<float *>(pix)[c] = value;
+    }
+  }
 
   // 5x3 bitmaps for digits 0..9 and period
   const char digits[11][5][3] = {
@@ -97,10 +157,14 @@ namespace MyHost {
       {0,1,0} }
   };
 
-  // draw digit d at x,y int the width*height image pointed to by data
-  static void drawDigit(OfxRGBAColourB* data, int width, int height, int d, int x, int y , int scale, OfxRGBAColourB color) {
-    assert(0 <= x && x+3*scale < width);
-    assert(0 <= y && y+5*scale < height);
+  // draw digit d at x,y of the frame, into the part of it in bounds pointed to by data, whose
+  // pixels are bytesPerPixel long, leaving out digits that do not fit in the frame
+  static void drawDigit(unsigned char* data, const OfxRectI &bounds, int bytesPerPixel, int d, int x, int y , int scale, const unsigned char *color) {
+    const ClipFormat &format = getClipFormat();
+    if(x < 0 || x+3*scale >= format.width || y < 0 || y+5*scale >= format.height)
+      return;
+
+    size_t rowBytes = size_t(bounds.x2 - bounds.x1) * bytesPerPixel;
 
     for (int j = 0; j < 5; ++j) {
       for (int i = 0; i < 3; ++i) {
@@ -109,7 +173,8 @@ namespace MyHost {
             for (int ii = 0; ii < scale; ++ii) {
               int x1 = x + i*scale + ii;
               int y1 = y + j*scale + jj;
-              data[x1+y1*width] = color;
+              if(x1 >= bounds.x1 && x1 < bounds.x2 && y1 >= bounds.y1 && y1 < bounds.y2)
+                memcpy(data + size_t(y1 - bounds.y1)*rowBytes + size_t(x1 - bounds.x1)*bytesPerPixel, color, bytesPerPixel);
             }
           }
         }
@@ -117,108 +182,165 @@ namespace MyHost {
     }
   }
 
-  /// images are always SD PAL progressive full res images for the purpose of this example only
-  MyImage::MyImage(MyClipInstance &clip, OfxTime time, int view)
+  /// images are parts of frames of the clip format, SD PAL progressive unless it was changed
+  MyImage::MyImage(MyClipInstance &clip, const OfxRectI &bounds)
     : OFX::Host::ImageEffect::Image(clip) /// this ctor will set basic props on the image
     , _data(NULL)
+    , _dataBytes(0)
+    , _bytesPerPixel(0)
   {
-    // make some memory
-    _data = new OfxRGBAColourB[kPalSizeXPixels * kPalSizeYPixels] ; /// PAL SD RGBA
-    
+    // render scale x and y of 1.0
+    setDoubleProperty(kOfxImageEffectPropRenderScale, 1.0, 0);
+    setDoubleProperty(kOfxImageEffectPropRenderScale, 1.0, 1); 
+
+    // the rod is the whole frame
+    OfxRectI rod = getFrameBounds();
+    setIntProperty(kOfxImagePropRegionOfDefinition, rod.x1, 0);
+    setIntProperty(kOfxImagePropRegionOfDefinition, rod.y1, 1);
+    setIntProperty(kOfxImagePropRegionOfDefinition, rod.x2, 2);
+    setIntProperty(kOfxImagePropRegionOfDefinition, rod.y2, 3);        
+
+    setBounds(bounds);
+  }
+
+  void MyImage::setBounds(const OfxRectI &bounds)
+  {
+    _bytesPerPixel = getComponentCount(getStringProperty(kOfxImageEffectPropComponents)) *
+      getBytesPerComponent(getStringProperty(kOfxImageEffectPropPixelDepth));
+
+    // make some memory, if what we have is too small
+    int width = std::max(0, bounds.x2 - bounds.x1);
+    int height = std::max(0, bounds.y2 - bounds.y1);
+    size_t bytes = size_t(width) * size_t(height) * _bytesPerPixel;
+    if(bytes > _dataBytes || !_data) {
+      delete [] _data;
+      _data = new unsigned char[bytes];
+      _dataBytes = bytes;
+    }
+
+    // data ptr
+    setPointerProperty(kOfxImagePropData,_data);
+
+    // bounds
+    setIntProperty(kOfxImagePropBounds, bounds.x1, 0);
+    setIntProperty(kOfxImagePropBounds, bounds.y1, 1);
+    setIntProperty(kOfxImagePropBounds, bounds.x1 + width, 2);
+    setIntProperty(kOfxImagePropBounds, bounds.y1 + height, 3);
+
+    // row bytes
+    setIntProperty(kOfxImagePropRowBytes, width * _bytesPerPixel);
+  }
+
+  /// draw the part of the frame for the given time that we hold into our memory
+  void MyImage::fill(OfxTime time, int view)
+  {
+    OfxRectI bounds = getBounds();
+    int width = bounds.x2 - bounds.x1;
+    int height = bounds.y2 - bounds.y1;
+    if(width <= 0 || height <= 0)
+      return;
+    std::string depth = getStringProperty(kOfxImageEffectPropPixelDepth);
+    std::string components = getStringProperty(kOfxImageEffectPropComponents);
+
     int fillValue = (int)(floor(255.0 * (time/OFXHOSTDEMOCLIPLENGTH))) & 0xff;
-    OfxRGBAColourB color;
-    color.r = color.g = color.b = fillValue;
-    color.a = 255;
+    unsigned char color[16];
+    makePixel(color, depth, components, fillValue / 255.0f);
+
+    // fill the first row a pixel at a time, and copy it to the rest
+    size_t rowBytes = size_t(width) * _bytesPerPixel;
+    for (int x = 0; x < width; ++x)
+      memcpy(_data + size_t(x) * _bytesPerPixel, color, _bytesPerPixel);
+    for (int y = 1; y < height; ++y)
+      memcpy(_data + y * rowBytes, _data, rowBytes);
 
-    std::fill(_data, _data + kPalSizeXPixels * kPalSizeYPixels, color);
     // draw the time and the view number in reverse color
     const int scale = 5;
     const int charwidth = 4*scale;
-    color.r = color.g = color.b = 255-fillValue;
+    makePixel(color, depth, components, (255 - fillValue) / 255.0f);
     int xx = 50;
     int yy = 50;
     int d;
     d = (int(time)/10)%10;
-    drawDigit(_data, kPalSizeXPixels, kPalSizeYPixels, d, xx, yy, scale, color);
+    drawDigit(_data, bounds, _bytesPerPixel, d, xx, yy, scale, color);
     xx += charwidth;
     d = int(time)%10;
-    drawDigit(_data, kPalSizeXPixels, kPalSizeYPixels, d, xx, yy, scale, color);
+    drawDigit(_data, bounds, _bytesPerPixel, d, xx, yy, scale, color);
     xx += charwidth;
     d = 10;
-    drawDigit(_data, kPalSizeXPixels, kPalSizeYPixels, d, xx, yy, scale, color);
+    drawDigit(_data, bounds, _bytesPerPixel, d, xx, yy, scale, color);
     xx += charwidth;
     d = int(time*10)%10;
-    drawDigit(_data, kPalSizeXPixels, kPalSizeYPixels, d, xx, yy, scale, color);
+    drawDigit(_data, bounds, _bytesPerPixel, d, xx, yy, scale, color);
     xx = 50;
     yy += 8*scale;
     d = int(view)%10;
-    drawDigit(_data, kPalSizeXPixels, kPalSizeYPixels, d, xx, yy, scale, color);
-
-    // render scale x and y of 1.0
-    setDoubleProperty(kOfxImageEffectPropRenderScale, 1.0, 0);
-    setDoubleProperty(kOfxImageEffectPropRenderScale, 1.0, 1); 
-
-    // data ptr
-    setPointerProperty(kOfxImagePropData,_data);
-
-    // bounds and rod
-    setIntProperty(kOfxImagePropBounds, kPalRegionPixels.x1, 0);
-    setIntProperty(kOfxImagePropBounds, kPalRegionPixels.y1, 1);
-    setIntProperty(kOfxImagePropBounds, kPalRegionPixels.x2, 2);
-    setIntProperty(kOfxImagePropBounds, kPalRegionPixels.y2, 3);
-    
-    setIntProperty(kOfxImagePropRegionOfDefinition, kPalRegionPixels.x1, 0);
-    setIntProperty(kOfxImagePropRegionOfDefinition, kPalRegionPixels.y1, 1);
-    setIntProperty(kOfxImagePropRegionOfDefinition, kPalRegionPixels.x2, 2);
-    setIntProperty(kOfxImagePropRegionOfDefinition, kPalRegionPixels.y2, 3);        
-
-    // row bytes
-    setIntProperty(kOfxImagePropRowBytes, kPalSizeXPixels * sizeof(OfxRGBAColourB));
+    drawDigit(_data, bounds, _bytesPerPixel, d, xx, yy, scale, color);
   }
 
-  OfxRGBAColourB* MyImage::pixel(int x, int y) const
+  void* MyImage::pixelAddress(int x, int y) const
   {
     OfxRectI bounds = getBounds();
     if ((x >= bounds.x1) && ( x< bounds.x2) && ( y >= bounds.y1) && ( y < bounds.y2) )
     {
       int rowBytes = getIntProperty(kOfxImagePropRowBytes);
-      int offset = (y - bounds.y1) * rowBytes + (x - bounds.x1) * sizeof(OfxRGBAColourB);
-      return reinterpret_cast<OfxRGBAColourB*>(&(reinterpret_cast<char*>(_data)[offset]));
+      size_t offset = size_t(y - bounds.y1) * rowBytes + size_t(x - bounds.x1) * _bytesPerPixel;
+      return _data + offset;
     }
     return 0;
   }
 
+  OfxRGBAColourB* MyImage::pixel(int x, int y) const
+  {
+    if(_bytesPerPixel != sizeof(OfxRGBAColourB) || getStringProperty(kOfxImageEffectPropPixelDepth) != kOfxBitDepthByte)
+      return 0;
+    return reinterpret_cast<OfxRGBAColourB*>(pixelAddress(x, y));
+  }
+
   MyImage::~MyImage() 
   {
-    delete _data;
+    delete [] _data;
   }
 
   MyClipInstance::MyClipInstance(MyEffectInstance* effect, OFX::Host::ImageEffect::ClipDescriptor *desc)
     : OFX::Host::ImageEffect::ClipInstance(effect, *desc)
     , _effect(effect)
     , _name(desc->getName())
-    , _outputImage(NULL)
   {
   }
 
   MyClipInstance::~MyClipInstance()
   {
-    if(_outputImage)
-      _outputImage->releaseReference();
+    for(std::map<OfxTime, MyImage *>::iterator i = _outputImages.begin(); i != _outputImages.end(); ++i)
+      i->second->releaseReference();
+  }
+
+  MyImage* MyClipInstance::getOutputImage(OfxTime time)
+  {
+    std::lock_guard<std::mutex> guard(_outputMutex);
+    std::map<OfxTime, MyImage *>::iterator i = _outputImages.find(time);
+    return i != _outputImages.end() ? i->second : NULL;
+  }
+
+  void MyClipInstance::releaseOutputImage(OfxTime time)
+  {
+    std::lock_guard<std::mutex> guard(_outputMutex);
+    std::map<OfxTime, MyImage *>::iterator i = _outputImages.find(time);
+    if(i != _outputImages.end()) {
+      i->second->releaseReference();
+      _outputImages.erase(i);
+    }
   }
    
-  /// Get the Raw Unmapped Pixel Depth from the host. We are always 8 bits in our example
+  /// Get the Raw Unmapped Pixel Depth from the host. 8 bits unless the clip format was changed
   const std::string &MyClipInstance::getUnmappedBitDepth() const
   {
-    static const std::string v(kOfxBitDepthByte);
-    return v;
+    return getClipFormat().bitDepth;
   }
     
-  /// Get the Raw Unmapped Components from the host. In our example we are always RGBA
+  /// Get the Raw Unmapped Components from the host. RGBA unless the clip format was changed
   const std::string &MyClipInstance::getUnmappedComponents() const
   {
-    static const std::string v(kOfxImageComponentRGBA);
-    return v;
+    return getClipFormat().components;
   }
 
   // PreMultiplication -
@@ -237,15 +359,15 @@ namespace MyHost {
   //  The pixel aspect ratio of a clip or image.
   double MyClipInstance::getAspectRatio() const
   {
-    /// our clip is pretending to be progressive PAL SD, so return 1.06666
-    return kPalPixelAspect;
+    /// our clip is pretending to be progressive PAL SD unless changed, so 1.06666
+    return getClipFormat().pixelAspect;
   }
   
   // Frame Rate -
   double MyClipInstance::getFrameRate() const
   {
-    /// our clip is pretending to be progressive PAL SD, so return 25
-    return 25.0;
+    /// our clip is pretending to be progressive PAL SD unless changed, so 25
+    return getClipFormat().frameRate;
   }
   
   // Frame Range (startFrame, endFrame) -
@@ -253,9 +375,9 @@ namespace MyHost {
   //  The frame range over which a clip has images.
   void MyClipInstance::getFrameRange(double &startFrame, double &endFrame) const
   {
-    // pretend we have a second's worth of PAL SD
-    startFrame = 0;
-    endFrame = 25;
+    // pretend we have a second's worth of PAL SD, unless changed
+    startFrame = getClipFormat().startFrame;
+    endFrame = getClipFormat().endFrame;
   }
 
   /// Field Order - Which spatial field occurs temporally first in a frame.
@@ -283,8 +405,8 @@ namespace MyHost {
   //  The unmaped frame range over which an output clip has images.
   double MyClipInstance::getUnmappedFrameRate() const
   {
-    /// our clip is pretending to be progressive PAL SD, so return 25
-    return 25;
+    /// our clip is pretending to be progressive PAL SD unless changed, so 25
+    return getClipFormat().frameRate;
   }
   
   // Unmapped Frame Range -
@@ -293,9 +415,9 @@ namespace MyHost {
   // this is applicable only to hosts and plugins that allow a plugin to change frame rates
   void MyClipInstance::getUnmappedFrameRange(double &unmappedStartFrame, double &unmappedEndFrame) const
   {
-    // pretend we have a second's worth of PAL SD
-    unmappedStartFrame = 0;
-    unmappedEndFrame = 25;
+    // pretend we have a second's worth of PAL SD, unless changed
+    unmappedStartFrame = getClipFormat().startFrame;
+    unmappedEndFrame = getClipFormat().endFrame;
   }
 
   // Continuous Samples -
@@ -311,14 +433,40 @@ namespace MyHost {
   /// override this to return the rod on the clip canonical coords!
   OfxRectD MyClipInstance::getRegionOfDefinition(OfxTime time) const
   {
-    /// our clip is pretending to be progressive PAL SD, so return 0<=x<768, 0<=y<576 
+    /// our clip is pretending to be progressive PAL SD unless changed, so 0<=x<768, 0<=y<576 
+    const ClipFormat &format = getClipFormat();
     OfxRectD v;
     v.x1 = v.y1 = 0;
-    v.x2 = 768;
-    v.y2 = 576;
+    v.x2 = format.width * format.pixelAspect;
+    v.y2 = format.height;
     return v;
   }
   
+  /// the pixels of the region of interest on us of the tile being rendered on this thread,
+  /// the whole frame if no tile is being rendered or the tile needs nothing from us
+  OfxRectI MyClipInstance::getTileBounds() const
+  {
+    OfxRectI frame = getFrameBounds();
+    const OFX::Host::ImageEffect::RenderTile *tile = OFX::Host::ImageEffect::TiledRender::getCurrentTile();
+    if(!tile)
+      return frame;
+    std::map<OFX::Host::ImageEffect::ClipInstance *, OfxRectD>::const_iterator roi =
+      tile->rois.find(const_cast<MyClipInstance *>(this));
+    if(roi == tile->rois.end())
+      return frame;
+
+    // canonical to pixels at a render scale of 1, taking in any pixel the region touches
+    double par = getAspectRatio();
+    OfxRectI bounds;
+    bounds.x1 = std::max(frame.x1, (int) floor(roi->second.x1 / par));
+    bounds.y1 = std::max(frame.y1, (int) floor(roi->second.y1));
+    bounds.x2 = std::min(frame.x2, (int) ceil(roi->second.x2 / par));
+    bounds.y2 = std::min(frame.y2, (int) ceil(roi->second.y2));
+    bounds.x2 = std::max(bounds.x1, bounds.x2);
+    bounds.y2 = std::max(bounds.y1, bounds.y2);
+    return bounds;
+  }
+
   /// override this to fill in the image at the given time.
   /// The bounds of the image on the image plane should be 
   /// 'appropriate', typically the value returned in getRegionsOfInterest
@@ -328,28 +476,59 @@ namespace MyHost {
   OFX::Host::ImageEffect::Image* MyClipInstance::getImage(OfxTime time, const OfxRectD *optionalBounds)
   {
     if(_name == "Output") {
-      if(!_outputImage) {
-        // make a new ref counted image
-        _outputImage = new MyImage(*this, 0);
+      // keep an image for each time, so that frames rendered at once each
+      // have their own
+      std::lock_guard<std::mutex> guard(_outputMutex);
+      MyImage *&image = _outputImages[time];
+      if(!image) {
+        // off our free list if the plugin is done with an earlier one,
+        // else a new ref counted image
+        image = static_cast<MyImage *>(getRecycledImage());
+        if(image)
+          image->setBounds(getFrameBounds());
+        else {
+          image = new MyImage(*this, getFrameBounds());
+          setRecyclable(image);
+        }
       }
      
-      // add another reference to the member image for this fetch
-      // as we have a ref count of 1 due to construction, this will
-      // cause the output image never to delete by the plugin
-      // when it releases the image
-      _outputImage->addReference();
+      // add another reference to the image for this fetch, the one we
+      // hold keeps it from the plugin till releaseOutputImage
+      image->addReference();
 
       // return it
-      return _outputImage;
+      return image;
     }
     else {
-      // Fetch on demand for the input clip.
-      // It does get deleted after the plugin is done with it as we
-      // have not incremented the auto ref
+      // Fetch on demand for the input clip, from the host's image
+      // cache if this frame has been fetched before and not been
+      // evicted since. Otherwise draw it into an image off the clip's
+      // free list, which is where it goes when the plugin is done
+      // with it and the cache has dropped it, or a new image.
       // 
+      // While a TiledRender is rendering a tile on this thread, only
+      // the tile's region of interest on this clip is fetched, else
+      // the whole frame is.
+      //
       // You should do somewhat more sophisticated image management
       // than this.
-      MyImage *image = new MyImage(*this, time);
+      OfxRectI bounds = getTileBounds();
+      OfxPointD scale;
+      scale.x = scale.y = 1.0;
+      OFX::Host::ImageEffect::ImageCache &cache = OFX::Host::ImageEffect::gImageEffectHost->getImageCache();
+      OFX::Host::ImageEffect::ImageCacheKey key(*_effect, *this, time, scale, bounds);
+      if(OFX::Host::ImageEffect::Image *cached = cache.find(key))
+        return cached;
+
+      MyImage *image = static_cast<MyImage *>(getRecycledImage());
+      if(image)
+        image->setBounds(bounds);
+      else {
+        image = new MyImage(*this, bounds);
+        setRecyclable(image);
+      }
+      image->fill(time);
+      cache.insert(key, image);
       return image;
     }
   }
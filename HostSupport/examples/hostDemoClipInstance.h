@@ -4,6 +4,10 @@
 #ifndef HOST_DEMO_CLIP_INSTANCE_H
 #define HOST_DEMO_CLIP_INSTANCE_H
 
+#include <map>
+#include <mutex>
+#include <string>
+
 #define OFXHOSTDEMOCLIPLENGTH 1.0
 
 namespace MyHost {
@@ -11,13 +15,48 @@ namespace MyHost {
   // forward
   class MyClipInstance;
 
+  /// What the clips of our host hold, progressive PAL SD 8 bit RGBA unless changed.
+  /// Set it before making any instances.
+  struct ClipFormat {
+    int         width;       ///< in pixels
+    int         height;      ///< in pixels
+    double      pixelAspect;
+    std::string bitDepth;    ///< kOfxBitDepthByte, kOfxBitDepthShort or kOfxBitDepthFloat
+    std::string components;  ///< kOfxImageComponentRGBA, kOfxImageComponentRGB or kOfxImageComponentAlpha
+    double      frameRate;
+    double      startFrame;
+    double      endFrame;
+
+    ClipFormat();
+  };
+
+  /// the format of all our clips
+  ClipFormat &getClipFormat();
+
   /// make an image up
   class MyImage : public OFX::Host::ImageEffect::Image 
   {
   protected :
-    OfxRGBAColourB   *_data; // where we are keeping our image data
+    unsigned char    *_data; // where we are keeping our image data
+    size_t            _dataBytes; // how many bytes _data holds
+    int               _bytesPerPixel;
   public :
-    explicit MyImage(MyClipInstance &clip, OfxTime t, int view = 0);
+    /// an image of the clip's depth and components holding the given pixels of the frame,
+    /// holding whatever was in memory
+    MyImage(MyClipInstance &clip, const OfxRectI &bounds);
+
+    /// hold the given pixels of the frame instead, in the clip's current depth and
+    /// components, for an image off the clip's free list, keeping its memory if it is
+    /// big enough
+    void setBounds(const OfxRectI &bounds);
+
+    /// draw the part of the frame for the time that the image holds
+    void fill(OfxTime t, int view = 0);
+
+    /// the address of a pixel, NULL if it is outside the bounds
+    void* pixelAddress(int x, int y) const;
+
+    /// the pixel, NULL if it is outside the bounds or the image is not 8 bit RGBA
     OfxRGBAColourB* pixel(int x, int y) const;
     ~MyImage();
   };
@@ -26,13 +65,24 @@ namespace MyHost {
   protected:
     MyEffectInstance *_effect;
     std::string       _name;
-    MyImage          *_outputImage; ///< only set for output clips
+    std::mutex                   _outputMutex;
+    std::map<OfxTime, MyImage *> _outputImages; ///< by time, only set for output clips
+
+    /// the pixels of the frame an input image is fetched for on this thread
+    OfxRectI getTileBounds() const;
 
   public:
     MyClipInstance(MyEffectInstance* effect, OFX::Host::ImageEffect::ClipDescriptor* desc);
 
     virtual ~MyClipInstance();
-    MyImage* getOutputImage() { return _outputImage; }
+
+    /// the output image the plugin rendered the time into, NULL if none
+    MyImage* getOutputImage(OfxTime time);
+
+    /// Done with the output image for the time, it goes back on our free list when the
+    /// plugin has released it as well. Call this once a rendered frame has been used,
+    /// else we keep an image for every time rendered.
+    void releaseOutputImage(OfxTime time);
 
     /// Get the Raw Unmapped Pixel Depth from the host
     ///
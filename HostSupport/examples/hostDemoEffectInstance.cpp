@@ -14,6 +14,7 @@
 #include "ofxhPropertySuite.h"
 #include "ofxhClip.h"
 #include "ofxhParam.h"
+#include "ofxhParamAnimation.h"
 #include "ofxhMemory.h"
 #include "ofxhImageEffect.h"
 #include "ofxhPluginAPICache.h"
@@ -84,8 +85,8 @@ namespace MyHost {
   // get the project size in CANONICAL pixels, so PAL SD return 768, 576
   void MyEffectInstance::getProjectSize(double& xSize, double& ySize) const
   {
-    xSize = 768; 
-    ySize = 576;
+    xSize = getClipFormat().width * getClipFormat().pixelAspect; 
+    ySize = getClipFormat().height;
   }
 
   // get the project offset in CANONICAL pixels, we are at 0,0
@@ -98,26 +99,26 @@ namespace MyHost {
   // get the project extent in CANONICAL pixels, so PAL SD return 768, 576
   void MyEffectInstance::getProjectExtent(double& xSize, double& ySize) const
   {
-    xSize = 768; 
-    ySize = 576;
+    xSize = getClipFormat().width * getClipFormat().pixelAspect; 
+    ySize = getClipFormat().height;
   }
 
   // get the PAR, SD PAL is 1.0666
   double MyEffectInstance::getProjectPixelAspectRatio() const
   {
-    return double(768)/double(720);
+    return getClipFormat().pixelAspect;
   }
 
-  // we are only 25 frames
+  // we are only 25 frames, unless the clip format was changed
   double MyEffectInstance::getEffectDuration() const
   {
-    return 25.0;
+    return getClipFormat().endFrame - getClipFormat().startFrame;
   }
 
   // get frame rate, so progressive PAL SD return 25
   double MyEffectInstance::getFrameRate() const
   {
-    return 25.0;
+    return getClipFormat().frameRate;
   }
 
   /// This is called whenever a param is changed by the plugin so that
@@ -154,6 +155,8 @@ namespace MyHost {
       return new MyDouble2DInstance(this,name,descriptor);
     else if(descriptor.getType()==kOfxParamTypeInteger2D)
       return new MyInteger2DInstance(this,name,descriptor);
+    else if(descriptor.getType()==kOfxParamTypeBytes)
+      return new OFX::Host::Param::AnimatedBytesInstance(descriptor,this);
     else if(descriptor.getType()==kOfxParamTypePushButton)
       return new MyPushbuttonInstance(this,name,descriptor);
     else if(descriptor.getType()==kOfxParamTypeGroup)
@@ -206,8 +209,8 @@ namespace MyHost {
   /// get the first and last times available on the effect's timeline
   void  MyEffectInstance::timeLineGetBounds(double &t1, double &t2)
   {
-    t1 = 0;
-    t2 = 25;
+    t1 = getClipFormat().startFrame;
+    t2 = getClipFormat().endFrame;
   }
 
 }
@@ -1,6 +1,7 @@
 // Copyright OpenFX and contributors to the OpenFX project.
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <string.h>
 #include <iostream>
 #include <fstream>
 
@@ -0,0 +1,204 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef OFX_BINARY_CACHE_H
+#define OFX_BINARY_CACHE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace OFX {
+
+  namespace Host {
+
+    /// Support for the binary flavour of the plugin cache.
+    ///
+    /// The file starts with a header and an index with one entry per plugin binary,
+    /// giving its path, the mtime and size it had when described, and where its
+    /// plugin records live in the file. Each plugin record carries the fields of
+    /// the XML <plugin> element followed by a length prefixed blob owned by the API
+    /// handler, which for image effects holds the descriptor's property set.
+    ///
+    /// The file is memory mapped and only the index is read up front. The plugin
+    /// records of binaries that have changed on disk are never touched, and the API
+    /// blobs are handed to the API handlers still encoded, so they can decode them
+    /// the first time they are needed.
+    ///
+    /// Values are written in the host's byte order, a cache written on a machine of
+    /// the other order is rejected and the host falls back to describing plugins.
+    namespace BinaryCache {
+
+      /// magic number at the start of a binary cache file
+      static const char kMagic[8] = {'O', 'F', 'X', 'C', 'A', 'C', 'H', 'E'};
+
+      /// version of the layout, bump this on any change to what gets written
+      static const uint32_t kFormatVersion = 1;
+
+      /// written as is, so a file from a machine of the other byte order reads back as something else
+      static const uint32_t kByteOrderMark = 0x01020304;
+
+      /// a read only view of a whole file, memory mapped where we can, read into memory otherwise.
+      /// On Windows it is always read, as a mapped file there can't be replaced.
+      class Mapping {
+      public :
+        /// map the file, check isValid() to see if that worked
+        explicit Mapping(const std::string &path);
+
+        /// dtor, unmaps the file
+        ~Mapping();
+
+        /// did we get at the contents
+        bool isValid() const {return _data != 0;}
+
+        /// the contents of the file
+        const char *getData() const {return _data;}
+
+        /// size of the file in bytes
+        size_t getSize() const {return _size;}
+
+      private :
+        /// hide copying
+        Mapping(const Mapping &);
+        void operator=(const Mapping &);
+
+        const char        *_data;
+        size_t             _size;
+        bool               _mapped;  ///< true if _data is a mapping rather than points into _buffer
+        std::vector<char>  _buffer;  ///< the contents, if we could not map the file
+      };
+
+      /// move a file over another, so that anyone who has the old one mapped is unaffected,
+      /// on failure from is deleted and false returned
+      bool replaceFile(const std::string &from, const std::string &to);
+
+      /// an encoded chunk of a cache file, which keeps the file mapped for as long as it is held
+      struct Blob {
+        std::shared_ptr<const Mapping> mapping;
+        const char *data;
+        size_t      size;
+
+        Blob() : data(0), size(0) {}
+
+        Blob(const std::shared_ptr<const Mapping> &m, const char *d, size_t s)
+          : mapping(m)
+          , data(d)
+          , size(s)
+        {
+        }
+
+        /// is there anything to decode
+        bool isEmpty() const {return data == 0;}
+
+        /// drop the data, and with it our hold on the file
+        void clear() {mapping.reset(); data = 0; size = 0;}
+      };
+
+      /// appends values to a buffer in the cache's encoding
+      class Writer {
+        std::string _buffer;
+
+      public :
+        void putU8(uint8_t v)         {putRaw(&v, sizeof(v));}
+        void putU32(uint32_t v)       {putRaw(&v, sizeof(v));}
+        void putI32(int32_t v)        {putRaw(&v, sizeof(v));}
+        void putU64(uint64_t v)       {putRaw(&v, sizeof(v));}
+        void putI64(int64_t v)        {putRaw(&v, sizeof(v));}
+        void putDouble(double v)      {putRaw(&v, sizeof(v));}
+
+        /// put a length prefixed string
+        void putString(const std::string &v) {
+          putU32(uint32_t(v.size()));
+          putRaw(v.data(), v.size());
+        }
+
+        /// put bytes as they are
+        void putRaw(const void *data, size_t size) {
+          _buffer.append(static_cast<const char *>(data), size);
+        }
+
+        /// put a placeholder u64 to fill in later with patchU64, returns its offset
+        size_t reserveU64() {
+          size_t offset = _buffer.size();
+          putU64(0);
+          return offset;
+        }
+
+        /// overwrite a u8 put earlier
+        void patchU8(size_t offset, uint8_t v) {
+          _buffer[offset] = char(v);
+        }
+
+        /// overwrite a u64 put earlier
+        void patchU64(size_t offset, uint64_t v) {
+          _buffer.replace(offset, sizeof(v), reinterpret_cast<const char *>(&v), sizeof(v));
+        }
+
+        /// number of bytes put so far
+        size_t getSize() const {return _buffer.size();}
+
+        /// what has been put so far
+        const std::string &getBuffer() const {return _buffer;}
+      };
+
+      /// reads values back out of a chunk of a cache file.
+      ///
+      /// Running off the end of the chunk makes the reader bad and every read after
+      /// that returns zero, so a truncated or corrupt file can be checked for once at
+      /// the end with isGood() rather than after every read.
+      class Reader {
+        const char *_pos;
+        const char *_end;
+        bool        _good;
+
+      public :
+        Reader(const char *data, size_t size)
+          : _pos(data)
+          , _end(data + size)
+          , _good(true)
+        {
+        }
+
+        explicit Reader(const Blob &blob)
+          : _pos(blob.data)
+          , _end(blob.data + blob.size)
+          , _good(true)
+        {
+        }
+
+        /// has every read so far been in bounds
+        bool isGood() const {return _good;}
+
+        /// bytes left to read
+        size_t getRemaining() const {return size_t(_end - _pos);}
+
+        /// current read position
+        const char *getPos() const {return _pos;}
+
+        uint8_t  getU8()     {uint8_t v = 0;  getRaw(&v, sizeof(v)); return v;}
+        uint32_t getU32()    {uint32_t v = 0; getRaw(&v, sizeof(v)); return v;}
+        int32_t  getI32()    {int32_t v = 0;  getRaw(&v, sizeof(v)); return v;}
+        uint64_t getU64()    {uint64_t v = 0; getRaw(&v, sizeof(v)); return v;}
+        int64_t  getI64()    {int64_t v = 0;  getRaw(&v, sizeof(v)); return v;}
+        double   getDouble() {double v = 0;   getRaw(&v, sizeof(v)); return v;}
+
+        /// get a length prefixed string
+        std::string getString();
+
+        /// skip size bytes, returning where they start, or 0 if there are not that many left
+        const char *skip(size_t size);
+
+        /// copy size bytes out
+        void getRaw(void *dst, size_t size);
+      };
+
+    } // BinaryCache
+
+  } // Host
+
+} // OFX
+
+#endif // OFX_BINARY_CACHE_H
@@ -5,6 +5,9 @@
 #ifndef OFX_CLIP_H
 #define OFX_CLIP_H
 
+#include <atomic>
+#include <memory>
+
 #include "ofxImageEffect.h"
 #include "ofxhUtilities.h"
 
@@ -15,6 +18,7 @@ namespace OFX {
     namespace ImageEffect {
       // forward declarations
       class Image;
+      class ImagePool;
       class Instance;
 #   ifdef OFX_SUPPORTS_OPENGLRENDER
       class Texture;
@@ -108,9 +112,16 @@ namespace OFX {
         bool  _isOutput;                         ///< are we the output clip
         std::string             _pixelDepth;     ///< what is the bit depth we is at. Set during the clip preferences action.
         std::string             _components;     ///< what components do we have.  Set during the clip preferences action.
+        std::shared_ptr<ImagePool> _imagePool;   ///< images released by the plugin, kept for getRecycledImage
+
+        /// the value of one of the string properties served by our get hook
+        const std::string &getHookedString(const std::string &name) const;
         
       public:
         ClipInstance(ImageEffect::Instance* effectInstance, ClipDescriptor& desc);
+
+        /// dtor, frees any images waiting to be recycled
+        virtual ~ClipInstance();
         
         /// is the clip an output clip
         bool isOutput() const {return  _isOutput;}
@@ -256,6 +267,19 @@ namespace OFX {
         /// be 'appropriate' for the.
         /// If bounds is not null, fetch the indicated section of the canonical image plane.
         virtual ImageEffect::Image* getImage(OfxTime time, const OfxRectD *optionalBounds) = 0;
+
+        /// Have an image go back on this clip's free list when its last reference is
+        /// released, rather than be deleted. Call this from getImage on images you make.
+        void setRecyclable(ImageEffect::Image *image);
+
+        /// Take an image released by the plugin off this clip's free list, for getImage to
+        /// hand out again rather than build a new one. This saves rebuilding its property
+        /// set, and anything the host's Image class holds, such as its pixels.
+        ///
+        /// The image comes back with a single reference and the clip's current pixel depth,
+        /// components, premultiplication and aspect ratio. Every other property keeps the
+        /// value it had, for the host to overwrite. Returns NULL if the list is empty.
+        ImageEffect::Image *getRecycledImage();
                              
 #     ifdef OFX_SUPPORTS_OPENGLRENDER
         /// override this to fill in the OpenGL texture at the given time.
@@ -278,10 +302,29 @@ namespace OFX {
       
       /// instance of an image inside an image effect
       class ImageBase : public Property::Set {
+        friend class ClipInstance;
+
       protected :
         /// called during ctors to get bits from the clip props into ours
         void getClipBits(ClipInstance& instance);
-        int _referenceCount; ///< reference count on this image
+
+        /// look up our property slots, called during ctors
+        void bindProperties();
+
+        std::atomic<int> _referenceCount; ///< reference count on this image, images are released from plugin threads
+        std::shared_ptr<ImagePool> _pool; ///< where we go when the last reference is released, if anywhere
+
+        /// our properties, looked up once rather than by name on each use
+        Property::String *_pixelDepthProp;
+        Property::String *_componentsProp;
+        Property::String *_premultProp;
+        Property::Double *_renderScaleProp;
+        Property::Double *_pixelAspectRatioProp;
+        Property::Int    *_boundsProp;
+        Property::Int    *_rodProp;
+        Property::Int    *_rowBytesProp;
+        Property::String *_fieldProp;
+        Property::String *_uniqueIdentifierProp;
 
       public:
         // default constructor
@@ -348,11 +391,11 @@ namespace OFX {
         /// get the full region of this image
         OfxRectI getROD() const;
 
-        /// release the reference count, which, if zero, deletes this
+        /// release the reference count, which, if zero, deletes this or puts it on its clip's free list
         void releaseReference();
 
         /// add a reference to this image
-        void addReference() {_referenceCount++;}
+        void addReference() {_referenceCount.fetch_add(1, std::memory_order_relaxed);}
       };
 
       /// instance of an image inside an image effect
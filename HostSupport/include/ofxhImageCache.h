@@ -0,0 +1,156 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef OFX_IMAGE_CACHE_H
+#define OFX_IMAGE_CACHE_H
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      // forward declare
+      class ClipInstance;
+      class Image;
+      class Instance;
+
+      /// what an image in an ImageCache is filed under
+      struct ImageCacheKey {
+        const Instance     *instance;    ///< the effect that rendered the image
+        const ClipInstance *clip;        ///< the clip of that effect it came from, usually its output
+        OfxTime             time;
+        OfxPointD           renderScale;
+        OfxRectI            bounds;      ///< the pixels the image holds
+        unsigned long long  stateHash;   ///< changes whenever the params or clips of the effect do
+
+        ImageCacheKey();
+
+        /// A key for an image of the given clip of an effect, the hash being the effect's
+        /// state generation. A host may set the hash to the effect's Param::SetInstance
+        /// value hash over the frames the image depends on instead, mixed with whatever
+        /// identifies its inputs, so going back to earlier values finds the earlier images.
+        ImageCacheKey(const Instance &instance,
+                      const ClipInstance &clip,
+                      OfxTime time,
+                      OfxPointD renderScale,
+                      const OfxRectI &bounds);
+
+        /// orders by everything but the bounds first, so that images that differ only in
+        /// their bounds are next to each other
+        bool operator<(const ImageCacheKey &other) const;
+
+        /// a string that is the same for equal keys, to use as kOfxImagePropUniqueIdentifier
+        std::string getUniqueIdentifier() const;
+      };
+
+      /// counts of what an ImageCache has done
+      struct ImageCacheStats {
+        unsigned long long hits;       ///< finds that returned an image
+        unsigned long long misses;     ///< finds that did not
+        unsigned long long insertions; ///< images added
+        unsigned long long evictions;  ///< images dropped to keep within the budget
+        unsigned long long purges;     ///< images dropped by purge
+        size_t             bytes;      ///< bytes of the images held now
+        size_t             peakBytes;  ///< most bytes of images held at once since the stats were reset
+        size_t             nImages;    ///< images held now
+
+        ImageCacheStats();
+      };
+
+      /// A thread safe cache of rendered images, holding a reference to each, which drops the
+      /// least recently used images when they take more than its memory budget.
+      ///
+      /// A host puts an image in with the key it was rendered for, and looks for one before
+      /// rendering again, say when another effect fetches the same frame of an upstream
+      /// effect. An image holding more than the bounds asked for will do, so a whole frame
+      /// can serve a tile of it. As the key holds the effect's state hash, changing a param
+      /// makes the images it rendered before unreachable, and they age out.
+      ///
+      /// Images handed out by the cache may be handed out to others at once, so must not be
+      /// written to, only read.
+      ///
+      /// The host's own cache, from Host::getImageCache, has the images of an instance
+      /// purged when kOfxActionPurgeCaches is called on it, and when it is destroyed.
+      class ImageCache {
+      public :
+        /// ctor, a memory budget of 0 bytes holds nothing
+        explicit ImageCache(size_t memoryBudget = 0);
+
+        /// dtor, releases the images held
+        virtual ~ImageCache();
+
+        /// the budget, in bytes
+        size_t getMemoryBudget() const;
+
+        /// set the budget, dropping images till they fit in it
+        void setMemoryBudget(size_t memoryBudget);
+
+        /// Look for an image filed under the key, or one that differs only in holding more
+        /// than its bounds. Returns a new reference to it, which the caller must release,
+        /// or NULL if there is none.
+        Image *find(const ImageCacheKey &key);
+
+        /// Add an image under the key, which must be no more than its bounds, the cache
+        /// taking a reference of its own, and replacing any image already under the key.
+        /// The image's kOfxImagePropUniqueIdentifier is set to that of the key. Images
+        /// bigger than the whole budget are not added.
+        void insert(const ImageCacheKey &key, Image *image);
+
+        /// drop the images rendered by the instance
+        void purge(const Instance *instance);
+
+        /// drop all the images
+        void purge();
+
+        /// what the cache has done
+        ImageCacheStats getStats() const;
+
+        /// zero the counts of hits, misses, insertions, evictions and purges, and the peak
+        void resetStats();
+
+        /// the bytes an image takes up
+        static size_t getImageBytes(const Image &image);
+
+      protected :
+        struct Entry {
+          ImageCacheKey key;
+          Image        *image;
+          size_t        bytes;
+        };
+
+        typedef std::list<Entry> EntryList;
+        typedef std::map<ImageCacheKey, EntryList::iterator> EntryMap;
+
+        /// hide copying
+        ImageCache(const ImageCache &);
+        void operator=(const ImageCache &);
+
+        /// drop the entry, the mutex must be held
+        void erase(EntryMap::iterator i);
+
+        /// drop the least recently used till we are in budget, the mutex must be held
+        void evict();
+
+        mutable std::mutex _mutex;
+        size_t             _memoryBudget;
+        EntryList          _entries;      ///< most recently used first
+        EntryMap           _index;        ///< into _entries
+        ImageCacheStats    _stats;
+      };
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
+
+#endif // OFX_IMAGE_CACHE_H
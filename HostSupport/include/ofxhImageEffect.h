@@ -5,6 +5,9 @@
 #ifndef OFX_IMAGE_EFFECT_H
 #define OFX_IMAGE_EFFECT_H
 
+#include <atomic>
+#include <memory>
+
 #include "ofxCore.h"
 #include "ofxImageEffect.h"
 
@@ -14,7 +17,9 @@
 #include "ofxhTimeLine.h"
 #include "ofxhParam.h"
 #include "ofxhMemory.h"
+#include "ofxhMultiThread.h"
 #include "ofxhInteract.h"
+#include "ofxhImageCache.h"
 
 #ifdef _MSC_VER
 //Use visual studio extension
@@ -86,38 +91,43 @@ namespace OFX {
         /// created.
         virtual void initDescriptor(Descriptor* desc);
 
-#ifdef OFX_SUPPORTS_MULTITHREAD
-        // these functions must be implemented if the host supports OfxMultiThreadSuiteV1
-        // all the following functions are described in ofxMultiThread.h
+        // these functions implement OfxMultiThreadSuiteV1, all of them are described in ofxMultiThread.h
+        // the default versions run on a thread pool owned by the host and may be overridden
         //
 
         /// @see OfxMultiThreadSuiteV1.multiThread()
-        virtual OfxStatus multiThread(OfxThreadFunctionV1 func,unsigned int nThreads, void *customArg) = 0;
+        virtual OfxStatus multiThread(OfxThreadFunctionV1 func,unsigned int nThreads, void *customArg);
           
         /// @see OfxMultiThreadSuiteV1.multiThreadNumCPUS()
-        virtual OfxStatus multiThreadNumCPUS(unsigned int *nCPUs) const = 0;
+        virtual OfxStatus multiThreadNumCPUS(unsigned int *nCPUs) const;
 
         /// @see OfxMultiThreadSuiteV1.multiThreadIndex()
-        virtual OfxStatus multiThreadIndex(unsigned int *threadIndex) const = 0;
+        virtual OfxStatus multiThreadIndex(unsigned int *threadIndex) const;
           
         /// @see OfxMultiThreadSuiteV1.multiThreadIsSpawnedThread()
-        virtual int multiThreadIsSpawnedThread() const = 0;
+        virtual int multiThreadIsSpawnedThread() const;
           
         /// @see OfxMultiThreadSuiteV1.mutexCreate()
-        virtual OfxStatus mutexCreate(OfxMutexHandle *mutex, int lockCount) = 0;
+        virtual OfxStatus mutexCreate(OfxMutexHandle *mutex, int lockCount);
           
         /// @see OfxMultiThreadSuiteV1.mutexDestroy()
-        virtual OfxStatus mutexDestroy(const OfxMutexHandle mutex) = 0;
+        virtual OfxStatus mutexDestroy(const OfxMutexHandle mutex);
 
         /// @see OfxMultiThreadSuiteV1.mutexLock()
-        virtual OfxStatus mutexLock(const OfxMutexHandle mutex) = 0;
+        virtual OfxStatus mutexLock(const OfxMutexHandle mutex);
           
         /// @see OfxMultiThreadSuiteV1.mutexUnLock()
-        virtual OfxStatus mutexUnLock(const OfxMutexHandle mutex) = 0;
+        virtual OfxStatus mutexUnLock(const OfxMutexHandle mutex);
           
         /// @see OfxMultiThreadSuiteV1.mutexTryLock()
-        virtual OfxStatus mutexTryLock(const OfxMutexHandle mutex) = 0;
-#endif // OFX_SUPPORTS_MULTITHREAD
+        virtual OfxStatus mutexTryLock(const OfxMutexHandle mutex);
+
+        /// the thread pool used by the default multiThread
+        MultiThread::ThreadPool &getThreadPool() {return _threadPool;}
+
+        /// the cache of rendered images, holding nothing till given a memory budget, the
+        /// images of an instance are purged from it by its purge caches action and dtor
+        ImageCache &getImageCache() {return _imageCache;}
 
 #     ifdef OFX_SUPPORTS_OPENGLRENDER
         /// @see OfxImageEffectOpenGLRenderSuiteV1.flushResources()
@@ -129,6 +139,10 @@ namespace OFX {
 
         // return an memory::instance calls makeMemoryInstance that can be overridden
         Memory::Instance* imageMemoryAlloc(size_t nBytes);
+
+      protected :
+        MultiThread::ThreadPool _threadPool; ///< runs the default multiThread, its threads start on first use
+        ImageCache              _imageCache; ///< rendered images, for the host to reuse
       };
 
       /// our global host object, set when the plugin cache is created
@@ -273,6 +287,51 @@ namespace OFX {
       /// a map used to specify needed frame ranges on set of clips
       typedef std::map<ClipInstance *, std::vector<OfxRangeD> > RangeMap;
 
+      /// A property set used to pass arguments to an action, which an effect instance keeps
+      /// so that it can refill the values on each call rather than build a new set.
+      ///
+      /// Properties are fetched by their index in the PropSpec array the set was made
+      /// from, which skips the look up by name. Only one thread at a time may fill in and
+      /// pass the set, which it claims with tryAcquire.
+      ///
+      /// Anything Instance::setCustomInArgs or setCustomOutArgs added to the set on the last
+      /// call is thrown away by tryAcquire, so each call starts from the PropSpec array alone.
+      class ActionArgs {
+        const Property::PropSpec         *_spec;
+        std::unique_ptr<Property::Set>    _set;
+        std::vector<Property::Property *> _props; ///< the properties, in the order of the PropSpec array
+        std::atomic<bool>                 _inUse;
+
+        /// make the set and fetch its properties from _spec
+        void build();
+
+        /// hide copying
+        ActionArgs(const ActionArgs &);
+        void operator=(const ActionArgs &);
+
+      public :
+        /// make the set from a PropSpec array terminated by Property::propSpecEnd
+        explicit ActionArgs(const Property::PropSpec *spec);
+
+        /// the set to pass to the action
+        Property::Set &getSet() {return *_set;}
+
+        /// the int property made from the index'th PropSpec
+        Property::Int &getInt(int index) {return static_cast<Property::Int &>(*_props[index]);}
+
+        /// the double property made from the index'th PropSpec
+        Property::Double &getDouble(int index) {return static_cast<Property::Double &>(*_props[index]);}
+
+        /// the string property made from the index'th PropSpec
+        Property::String &getString(int index) {return static_cast<Property::String &>(*_props[index]);}
+
+        /// claim the set, returns false if another thread is using it
+        bool tryAcquire();
+
+        /// hand the set back
+        void release() {_inUse.store(false, std::memory_order_release);}
+      };
+
       /// an image effect plugin instance.
       ///
       /// Client code needs to filling the pure virtuals in this.
@@ -298,6 +357,19 @@ namespace OFX {
         std::string                                   _outputFielding;  ///< set by clip prefs
         double                                        _outputFrameRate; ///< set by clip prefs
 
+        ActionArgs                                    _beginRenderArgs; ///< in args of the begin sequence render action
+        ActionArgs                                    _renderArgs;      ///< in args of the render action
+        ActionArgs                                    _endRenderArgs;   ///< in args of the end sequence render action
+        ActionArgs                                    _roiInArgs;       ///< in args of the get regions of interest action
+        ActionArgs                                   *_roiOutArgs;      ///< out args of the get regions of interest action, made by populate
+        std::vector<std::string>                      _roiOutNames;     ///< names of the RoI out args, one per input clip
+        std::vector<Property::PropSpec>               _roiOutSpec;      ///< what _roiOutArgs was made from
+        std::vector<ClipInstance *>                   _roiOutClips;     ///< the clip each RoI out arg is for
+
+        struct ActionCache;
+        std::unique_ptr<ActionCache>                  _actionCache;     ///< results of the cached actions, if caching is on
+        std::atomic<unsigned int>                     _stateGeneration; ///< bumped whenever a param or clip changes
+
       public:        
         /// constructor based on clip descriptor
         Instance(ImageEffectPlugin* plugin,
@@ -360,6 +432,29 @@ namespace OFX {
         /// are all the non optional clips connected
         bool checkClipConnectionStatus() const;
 
+        /// Turn caching of the results of the region of definition, regions of interest,
+        /// frames needed and is identity actions on or off, it starts off. Do this before
+        /// any of those actions are called.
+        ///
+        /// Results are kept by the arguments of the action and are thrown away when the
+        /// state generation changes, which it does when the generation of any param does,
+        /// when the plugin or the host changes a param through paramChangedByPlugin or
+        /// paramInstanceChangedAction, when a clip changes through clipInstanceChangedAction
+        /// and when the clip preferences are fetched. A host must call invalidateActionCache
+        /// itself for anything else the answers depend on, such as the effects upstream of
+        /// this one changing.
+        void setActionCaching(bool on);
+
+        /// is action caching on
+        bool getActionCaching() const {return _actionCache != 0;}
+
+        /// bump the state generation, so that no cached action results are used again
+        void invalidateActionCache();
+
+        /// changes each time the params or clips of the instance change, or the host says so,
+        /// being our own generation plus that of our param set
+        unsigned int getStateGeneration() const {return _stateGeneration + Param::SetInstance::getGeneration();}
+
         /// can this this instance render images at arbitrary times, not just frame boundaries
         /// set by getClipPreferenceAction()
         bool continuousSamples() const {return _continuousSamples;}
@@ -5,10 +5,13 @@
 #ifndef OFXH_IMAGE_EFFECT_API_H
 #define OFXH_IMAGE_EFFECT_API_H
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <map>
 #include <set>
 #include <memory>
+#include <mutex>
 
 #include "ofxCore.h"
 #include "ofxImageEffect.h"
@@ -41,8 +44,30 @@ namespace OFX {
 
         std::unique_ptr<PluginHandle> _pluginHandle;
 
+        /// number of live instances of this plugin
+        std::atomic<int> _nInstances;
+
+        /// steady clock time the plugin was last in use, that is when it was loaded or its last instance went away
+        std::atomic<std::chrono::steady_clock::rep> _lastUsed;
+
+        /// held while the binary is loaded or unloaded and while instances come and go, so an idle plugin
+        /// cannot be unloaded under an instance being made. Recursive, as instances are made with it held.
+        std::recursive_mutex _loadMutex;
+
+        /// the descriptor's properties as read from a binary cache, not yet decoded into _baseDescriptor
+        mutable BinaryCache::Blob _cacheBlob;
+
+        /// set while _cacheBlob holds something to decode, so getDescriptor need not lock once it has been
+        mutable std::atomic<bool> _cacheBlobPending;
+
+        /// guards _cacheBlob and the decode of it, as the first threads to look at the descriptor may do so at once
+        mutable std::mutex _cacheBlobMutex;
+
         void addContextInternal(const std::string &context) const;
 
+        /// decode _cacheBlob into the base descriptor, if there is one
+        void decodeCacheBlob() const;
+
       public:
 			  ImageEffectPlugin(PluginCache &pc, PluginBinary *pb, int pi, OfxPlugin *pl);
 
@@ -76,12 +101,30 @@ namespace OFX {
 
         virtual void saveXML(std::ostream &os);
 
+        /// write the base descriptor's properties to a binary cache
+        void saveBinary(BinaryCache::Writer &w) const;
+
+        /// take the base descriptor's properties from a binary cache, they are decoded on the first call to getDescriptor()
+        void setCacheBlob(const BinaryCache::Blob &blob);
+
         const std::set<std::string>& getContexts() const;
 
         PluginHandle *getPluginHandle();
 
         void unload();
 
+        /// called by ImageEffect::Instance as instances of this plugin are made and destroyed, these take
+        /// the same lock as unloadIfIdle
+        void instanceCreated();
+        void instanceDestroyed();
+
+        /// if the plugin is loaded but has had no instances for at least idleSeconds, send it the unload
+        /// action and let go of its binary, which is unloaded once no other plugin in it is loaded.
+        /// Context descriptors are thrown away too, as they may point into the binary, and are
+        /// described again the next time an instance is made. The check and the unload are done under one
+        /// lock, which createInstance also holds. Returns true if the plugin was unloaded.
+        bool unloadIfIdle(double idleSeconds);
+
         /// this is called to make an instance of the effect
         /// the client data ptr is what is passed back to the client creation function
         ImageEffect::Instance* createInstance(const std::string &context, void *clientDataPtr);
@@ -191,6 +234,10 @@ namespace OFX {
         
         virtual void saveXML(Plugin *ip, std::ostream &os) const;
 
+        virtual bool saveBinary(Plugin *ip, BinaryCache::Writer &w) const;
+
+        virtual bool loadBinary(Plugin *ip, const BinaryCache::Blob &blob);
+
         void confirmPlugin(Plugin *p);
 
         virtual bool pluginSupported(Plugin *p, std::string &reason) const;
@@ -208,6 +255,11 @@ namespace OFX {
                           int pluginMajorVersion,
                           int pluginMinorVersion);
 
+        /// unload the plugins that have had no instances for at least idleSeconds, see
+        /// ImageEffectPlugin::unloadIfIdle. Hosts can call this when memory runs short.
+        /// Returns the number of plugins unloaded.
+        int unloadIdlePlugins(double idleSeconds);
+
         void dumpToStdOut();
       };
     
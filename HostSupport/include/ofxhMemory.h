@@ -1,21 +1,106 @@
-
 // Copyright OpenFX and contributors to the OpenFX project.
 // SPDX-License-Identifier: BSD-3-Clause
 
 #ifndef OFX_MEMORY_H
 #define OFX_MEMORY_H
 
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+
 namespace OFX {
 
   namespace Host {
 
     namespace Memory {
 
+      /// Alignment of every block handed out by a Pool, a cache line so SIMD loads never straddle one
+      static const size_t kPoolAlignment = 64;
+
+      /// A size class pooled allocator for image memory.
+      ///
+      /// Requests are rounded up to a size class, with four classes per power of two so
+      /// at most a quarter of a block is wasted. Released blocks are kept on a free list
+      /// for their class and handed straight back out to the next request of that class,
+      /// which saves the page faults of fresh memory when plugins allocate the same
+      /// scratch buffers every frame. Once the bytes sitting in the free lists go over
+      /// the budget, the blocks released longest ago are given back to the system.
+      ///
+      /// All blocks are aligned to kPoolAlignment. Pools are MT safe.
+      class Pool {
+      public :
+        /// counters for a pool
+        struct Stats {
+          size_t hits;        ///< allocations served from a free list
+          size_t misses;      ///< allocations that had to go to the system
+          size_t evictions;   ///< free blocks given back to the system to stay in budget
+          size_t liveBytes;   ///< bytes in blocks currently handed out
+          size_t cachedBytes; ///< bytes in blocks sitting in the free lists
+          size_t peakBytes;   ///< high water mark of liveBytes + cachedBytes
+        };
+
+        /// ctor, budget is the most bytes kept in the free lists
+        explicit Pool(size_t budget);
+
+        /// dtor, frees everything in the free lists
+        ~Pool();
+
+        /// the pool Memory::Instance allocates from, its budget defaults to 256Mb
+        static Pool &getDefault();
+
+        /// allocate at least nBytes, the size actually reserved is returned in blockSize
+        void *allocate(size_t nBytes, size_t &blockSize);
+
+        /// give back a block, blockSize being what allocate returned for it
+        void release(void *ptr, size_t blockSize);
+
+        /// set the most bytes kept in the free lists, evicting straight away if need be
+        void setBudget(size_t budget);
+
+        /// get the budget
+        size_t getBudget() const;
+
+        /// give every free block back to the system
+        void purge();
+
+        /// get a snapshot of the counters
+        Stats getStats() const;
+
+        /// zero the hit, miss and eviction counters and reset the peak to the current total
+        void resetStats();
+
+        /// the size class nBytes rounds up to
+        static size_t sizeClass(size_t nBytes);
+
+      private :
+        /// a block on a free list
+        struct FreeBlock {
+          void   *ptr;
+          size_t  stamp;   ///< release order, used to find the oldest block to evict
+        };
+
+        typedef std::map<size_t, std::deque<FreeBlock> > FreeLists;
+
+        /// hide copying
+        Pool(const Pool &);
+        void operator=(const Pool &);
+
+        /// evict the oldest free blocks until we are within budget, called with _mutex held
+        void trimToBudget(size_t budget);
+
+        mutable std::mutex _mutex;
+        FreeLists          _free;    ///< free blocks by size class, most recently released at the back
+        size_t             _budget;
+        size_t             _stamp;   ///< bumped on each release
+        Stats              _stats;
+      };
+
       class Instance {
       public:
         Instance();
 
-        virtual ~Instance();        
+        virtual ~Instance();
         virtual bool alloc(size_t nBytes);
         virtual OfxImageMemoryHandle getHandle();
         virtual void freeMem();
@@ -27,6 +112,7 @@ namespace OFX {
 
       protected:
         char*   _ptr;
+        size_t  _size;  ///< size of the block _ptr points to, as reserved from the pool
         int     _locked;
       };
 
@@ -0,0 +1,117 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef OFX_MULTITHREAD_H
+#define OFX_MULTITHREAD_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ofxCore.h"
+#include "ofxMultiThread.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace MultiThread {
+
+      /// A recursive mutex with a lock count, as handed out by OfxMultiThreadSuiteV1::mutexCreate.
+      ///
+      /// The thread that holds the lock can lock it again, and it is released once
+      /// it has been unlocked as many times as it has been locked.
+      class Mutex {
+        static const int kMagic = 0x4d757478; ///< magic number for mutexes
+        const int _magic; ///< to check for handles being nice
+
+        std::mutex              _mutex;     ///< guards the members below
+        std::condition_variable _released;  ///< signalled when the lock count drops to zero
+        std::thread::id         _owner;     ///< thread holding the lock, if any
+        int                     _lockCount; ///< number of times the owner has locked us
+
+      public :
+        /// create a mutex, with lockCount > 0 the calling thread starts off holding it that many times
+        explicit Mutex(int lockCount = 0);
+
+        /// dtor
+        ~Mutex();
+
+        /// is my magic number valid?
+        bool verifyMagic() { return _magic == kMagic; }
+
+        /// blocking lock
+        void lock();
+
+        /// non blocking lock, returns false if another thread holds the lock
+        bool tryLock();
+
+        /// unlock, returns false if the calling thread does not hold the lock
+        bool unlock();
+      };
+
+      /// A persistent pool of worker threads used to implement OfxMultiThreadSuiteV1::multiThread.
+      ///
+      /// The workers are started on the first call to multiThread and then sleep
+      /// between calls, so there is no per call thread creation. The calling thread
+      /// runs a share of the work itself. A call made from inside a thread function
+      /// (a nested call) runs all its indices inline on the calling thread, as does a
+      /// call made while another thread is already using the pool.
+      class ThreadPool {
+      public :
+        /// ctor, nCPUs of 0 means use all the processors on the machine
+        explicit ThreadPool(unsigned int nCPUs = 0);
+
+        /// dtor, stops and joins the worker threads
+        ~ThreadPool();
+
+        /// number of threads that can run at once, including the calling thread
+        unsigned int getNumCPUs() const {return _nCPUs;}
+
+        /// call func nThreads times, with indices 0 to nThreads-1, and wait for them all to return
+        OfxStatus multiThread(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg);
+
+        /// index passed to the thread function running on the calling thread, 0 if there is none
+        static unsigned int threadIndex();
+
+        /// is the calling thread running a thread function for a multiThread call
+        static bool isSpawnedThread();
+
+      private :
+        struct Job;
+
+        /// hide copying
+        ThreadPool(const ThreadPool &);
+        void operator=(const ThreadPool &);
+
+        /// start the worker threads, called with _mutex held
+        void startWorkers();
+
+        /// what each worker thread sits in
+        void workerLoop();
+
+        /// run indices of the job on the calling thread until there are none left
+        static void runJob(Job &job);
+
+        /// run all indices of a call on the calling thread
+        static OfxStatus runInline(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg);
+
+        unsigned int                 _nCPUs;      ///< number of threads that can run at once
+        std::vector<std::thread>     _workers;    ///< the worker threads, started lazily
+        std::mutex                   _mutex;      ///< guards _job, _generation and _quit
+        std::condition_variable      _wake;       ///< signalled when there is a new job or we are quitting
+        std::shared_ptr<Job>         _job;        ///< the job currently being worked on
+        unsigned int                 _generation; ///< bumped for each new job
+        bool                         _quit;       ///< tells the workers to exit
+        std::mutex                   _busy;       ///< held by the thread whose job the pool is running
+      };
+
+    } // MultiThread
+
+  } // Host
+
+} // OFX
+
+#endif // OFX_MULTITHREAD_H
@@ -8,6 +8,10 @@
 #include <string>
 #include <map>
 #include <list>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
 #include <cstdarg>
 
 //ofx
@@ -26,6 +30,9 @@ namespace OFX {
       /// fetch the param suite
       const void *GetSuite(int version);
 
+      /// fetch the param batch suite
+      const void *GetBatchSuite(int version);
+
       bool isColourParam(const std::string &paramType);
 
       bool isIntParam(const std::string &paramType);
@@ -161,12 +168,19 @@ namespace OFX {
       // forward declare
       class SetInstance;
 
+      /// FNV-1a, 64 bit, of some bytes into a running hash, as getValueHash makes its hashes with
+      void hashBytes(unsigned long long &hash, const void *data, size_t n);
+
       /// the description of a plugin parameter
       class Instance : public Base, protected Property::NotifyHook {
         Instance();  
       protected:
         SetInstance*  _paramSetInstance;
         Instance*     _parentInstance;
+        std::atomic<unsigned int> _generation; ///< bumped each time our value or animation changes
+
+        /// bump our generation if stat says a change was made, and return it
+        OfxStatus bumpGenerationIfOK(OfxStatus stat) {if(stat == kOfxStatOK) bumpGeneration(); return stat;}
       public:
         virtual ~Instance();
 
@@ -188,6 +202,23 @@ namespace OFX {
         // copy one parameter to another, with a range (NULL means to copy all animation)
         virtual OfxStatus copyFrom(const Instance &instance, OfxTime offset, const OfxRangeD* range);
 
+        /// Bumped each time the value or animation of this param changes, through setV, which
+        /// the suite sets values with, through the key and copy calls of the suite or of the
+        /// animated params in ofxhParamAnimation.h, or by the host calling the instance changed
+        /// action. It may go up by more than one for a single change.
+        unsigned int getGeneration() const {return _generation;}
+
+        /// bump our generation and that of our set, call this when the value or animation
+        /// has been changed other than by the calls above, say by a host's own set
+        void bumpGeneration();
+
+        /// A hash of the values of this param from time1 to time2, which changes when any of
+        /// them do. The default hashes the values at both times and the times and values of
+        /// the keys between them and the nearest keys outside them, which params whose curves
+        /// depend on more than that, like the animated ones, add to. Params without values
+        /// hash to 0.
+        virtual unsigned long long getValueHash(OfxTime time1, OfxTime time2);
+
         // callback which should set enabled state as appropriate
         virtual void setEnabled();
 
@@ -230,6 +261,12 @@ namespace OFX {
         /// integrate a value, implemented by instances to deconstruct var args
         virtual OfxStatus integrateV(OfxTime time1, OfxTime time2, va_list arg);
 
+        /// Get the values at many times, laid out as OpenFXParameterBatchSuiteV1::paramGetValuesAtTimes
+        /// says. The default calls get for each time on the numeric, boolean and choice types,
+        /// and returns kOfxStatErrUnsupported for the others. Override it to walk an animation
+        /// curve once.
+        virtual OfxStatus getValuesAtTimes(int nTimes, const OfxTime *times, void *values);
+
         /// overridden from Property::NotifyHook
         virtual void notify(const std::string &name, bool single, int num);
       };
@@ -609,6 +646,85 @@ namespace OFX {
         CustomInstance(Descriptor& descriptor, Param::SetInstance* instance = 0) : StringInstance(descriptor,instance) {}
       };
 
+      /// The value of a bytes param, an immutable block of bytes shared by reference count.
+      ///
+      /// Copying a Bytes shares its block rather than the bytes in it, so a param can hold
+      /// the same value at many keys, and its values be kept for undo or copied to another
+      /// param, for the cost of a pointer each whatever their size.
+      class Bytes {
+      public :
+        /// no bytes
+        Bytes() {}
+
+        /// copy the bytes into a new block
+        Bytes(const unsigned char *data, size_t length);
+
+        /// a new block made from the vector's storage, without copying it
+        explicit Bytes(std::vector<unsigned char> &&data);
+
+        /// the bytes, NULL if there are none
+        const unsigned char *data() const {return _block ? _block->data.data() : 0;}
+
+        /// the number of bytes
+        size_t size() const {return _block ? _block->data.size() : 0;}
+
+        bool empty() const {return size() == 0;}
+
+        /// a hash of the bytes, worked out once as the block is made
+        unsigned long long getHash() const {return _block ? _block->hash : 0;}
+
+        /// the bytes as the param suite hands them out, valid while this or a copy holds them
+        OfxBytes getView() const;
+
+        /// do the two share a block
+        bool sharesWith(const Bytes &other) const {return _block == other._block;}
+
+        /// are the bytes the same
+        bool operator==(const Bytes &other) const;
+        bool operator!=(const Bytes &other) const {return !(*this == other);}
+
+      protected :
+        struct Block {
+          std::vector<unsigned char> data;
+          unsigned long long         hash;
+        };
+
+        /// make the block, which there is none of if there are no bytes
+        void makeBlock(std::vector<unsigned char> &&data);
+
+        std::shared_ptr<const Block> _block;
+      };
+
+      /// A bytes param, its values going to and from the plug-in as OfxBytes.
+      ///
+      /// The bytes a plug-in gets are those the param holds, not a copy, and stay valid till
+      /// its next call to get the value, as with strings. Those it sets are copied once, as
+      /// they belong to the plug-in.
+      class BytesInstance : public Instance, public KeyframeParam {
+        Bytes _returnValue; ///< holds the bytes last handed to the plug-in, so edits since do not free them
+      public:
+        BytesInstance(Descriptor& descriptor, Param::SetInstance* instance = 0) : Instance(descriptor,instance) {}
+
+        virtual OfxStatus get(Bytes &) = 0;
+        virtual OfxStatus get(OfxTime time, Bytes &) = 0;
+        virtual OfxStatus set(const Bytes &) = 0;
+        virtual OfxStatus set(OfxTime time, const Bytes &) = 0;
+
+        /// implementation of var args function
+        /// Be careful: the bytes are only valid until next API call
+        virtual OfxStatus getV(va_list arg);
+
+        /// implementation of var args function
+        /// Be careful: the bytes are only valid until next API call
+        virtual OfxStatus getV(OfxTime time, va_list arg);
+
+        /// implementation of var args function
+        virtual OfxStatus setV(va_list arg);
+
+        /// implementation of var args function
+        virtual OfxStatus setV(OfxTime time, va_list arg);
+      };
+
       class PushbuttonInstance : public Instance, public KeyframeParam {
       public:
         PushbuttonInstance(Descriptor& descriptor, Param::SetInstance* instance = 0) : Instance(descriptor,instance) {}
@@ -623,6 +739,15 @@ namespace OFX {
       protected:
         std::map<std::string, Instance*> _params;        ///< params by name
         std::list<Instance *>            _paramList;     ///< params list
+        std::atomic<unsigned int>        _generation;    ///< bumped each time any of our params change
+
+        /// the last value hash made, so asking again before anything changes is cheap
+        std::mutex                       _hashMutex;
+        unsigned int                     _hashGeneration;
+        OfxTime                          _hashTime1;
+        OfxTime                          _hashTime2;
+        unsigned long long               _hash;
+        bool                             _hashValid;
 
       public :
         /// ctor
@@ -656,6 +781,18 @@ namespace OFX {
         /// add a param
         virtual OfxStatus addParam(const std::string& name, Instance* instance);
 
+        /// bumped each time the value or animation of any of our params changes
+        unsigned int getGeneration() const {return _generation;}
+
+        /// bump our generation, called by our params as theirs are
+        void bumpGeneration() {++_generation;}
+
+        /// A hash of the names and value hashes of all our params from time1 to time2, made
+        /// afresh only when our generation or the times differ from the last asked for. Hash
+        /// from the time to itself for a render cache key of an effect that only looks at the
+        /// frame it renders.
+        unsigned long long getValueHash(OfxTime time1, OfxTime time2);
+
         /// make a parameter instance
         ///
         /// Client host code needs to implement this
@@ -0,0 +1,424 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef OFXH_PARAM_ANIMATION_H
+#define OFXH_PARAM_ANIMATION_H
+
+#include <math.h>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "ofxCore.h"
+#include "ofxParam.h"
+
+#include "ofxhParam.h"
+#include "ofxhTimeLine.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace Param {
+
+      /// how the value of a curve goes from one key to the next
+      enum InterpolationEnum {
+        eInterpolationConstant, ///< holds the value of the key till the next
+        eInterpolationLinear,   ///< a straight line to the next key
+        eInterpolationSmooth    ///< a cubic to the next key, through the keys either side with a continuous slope
+      };
+
+      /// An animation curve, keys of a value with one or more dimensions, held as flat
+      /// arrays sorted by time.
+      ///
+      /// Before its first key and after its last the value of the curve is that of the
+      /// nearest key, and with no keys it is the default. Smooth segments are cubic Hermite
+      /// curves, the slope at each key being that of the line through the keys either side
+      /// of it, and flat at the first and last keys.
+      ///
+      /// Values, derivatives and integrals are all exact and found in O(log n), integrals
+      /// coming from the integral up to each key, which, with the slopes, is worked out
+      /// afresh on each edit, an edit being O(n).
+      ///
+      /// Reading a curve from several threads at once is safe, editing it while doing so
+      /// is not.
+      class AnimationCurve {
+      public :
+        /// ctor, a curve whose values have the given number of dimensions, defaulting to 0
+        explicit AnimationCurve(int dimension = 1);
+
+        /// the number of values at each time
+        int getDimension() const {return _dimension;}
+
+        /// set the value of the curve when it has no keys
+        void setDefault(const double *values);
+
+        /// the value of the curve when it has no keys
+        void getDefault(double *values) const;
+
+        /// set a key, replacing any at the time, the interpolation being that to the next key
+        void setKey(OfxTime time, const double *values, InterpolationEnum interpolation = eInterpolationSmooth);
+
+        /// delete the key at the time, returns false if there is none
+        bool deleteKey(OfxTime time);
+
+        /// delete all the keys, leaving the default
+        void deleteAllKeys();
+
+        /// copy the keys of the other curve to this, which must be of the same dimension,
+        /// shifted by offset. With a range only those keys in it are copied, replacing the
+        /// keys in the range they are shifted to, otherwise they replace all our keys.
+        void copyFrom(const AnimationCurve &other, OfxTime offset, const OfxRangeD *range);
+
+        /// the number of keys
+        unsigned int getNumKeys() const {return (unsigned int) _times.size();}
+
+        /// the time of the nth key
+        OfxTime getKeyTime(unsigned int nth) const {return _times[nth];}
+
+        /// the values of the nth key
+        void getKeyValue(unsigned int nth, double *values) const;
+
+        /// the interpolation from the nth key to the next
+        InterpolationEnum getKeyInterpolation(unsigned int nth) const {return _interpolations[nth];}
+
+        /// Find a key as OfxParameterSuiteV1::paramGetKeyIndex does, the one at the time if
+        /// direction is 0, else the first after or last before it. Returns -1 if none.
+        int getKeyIndex(OfxTime time, int direction) const;
+
+        /// the value of the curve at the time
+        void getValue(OfxTime time, double *values) const;
+
+        /// the values of the curve at many times, one after another, quickest if the times are in order
+        void getValues(int nTimes, const OfxTime *times, double *values) const;
+
+        /// the derivative of the curve at the time, from the segment to the right at a key
+        void getDerivative(OfxTime time, double *values) const;
+
+        /// the integral of the curve from time1 to time2
+        void getIntegral(OfxTime time1, OfxTime time2, double *values) const;
+
+      protected :
+        /// the key starting the segment the time is in, -1 if it is before the first
+        int findSegment(OfxTime time) const;
+
+        /// the value of the curve at the time, which is in the segment starting at key i,
+        /// the curve having keys
+        void getValueIn(int i, OfxTime time, double *values) const;
+
+        /// the integral of the curve from the first key to the time, which is in the segment
+        /// starting at key i, or after the last key
+        double integralTo(int i, int d, OfxTime time) const;
+
+        /// work out the slopes and the integrals up to each key after an edit
+        void update();
+
+        int                            _dimension;
+        std::vector<double>            _defaults;       ///< _dimension values
+        std::vector<OfxTime>           _times;          ///< of the keys, ascending
+        std::vector<double>            _values;         ///< _dimension values per key
+        std::vector<InterpolationEnum> _interpolations; ///< per key, to the next
+        std::vector<double>            _slopes;         ///< _dimension per key, used by smooth segments
+        std::vector<double>            _integrals;      ///< _dimension per key, the integral from the first key to it
+      };
+
+      /// The parts of a param animated by an AnimationCurve that do not depend on its
+      /// type, its keyframe calls and copying. BASE is the param instance class it
+      /// implements and DIM the number of values it has.
+      template <class BASE, int DIM>
+      class AnimatedInstance : public BASE {
+      protected :
+        AnimationCurve _curve;
+
+        /// The time that values are got and set at when no time is given, which is the
+        /// time on the timeline of the param set if it has one, else 0.
+        OfxTime getCurrentTime() const
+        {
+          TimeLine::TimeLineI *timeLine = dynamic_cast<TimeLine::TimeLineI *>(this->_paramSetInstance);
+          return timeLine ? timeLine->timeLineGetTime() : 0;
+        }
+
+        /// do our values come back as ints
+        static bool isIntegerValued()
+        {
+          return std::is_base_of<IntegerInstance, BASE>::value || std::is_base_of<Integer2DInstance, BASE>::value ||
+            std::is_base_of<Integer3DInstance, BASE>::value;
+        }
+
+        /// get the values at a time
+        void getValues(OfxTime time, double *values) const {_curve.getValue(time, values);}
+
+        /// Set the values when no time is given, which sets a key at the current time if
+        /// the param has any keys, else its static value.
+        void setValues(const double *values, InterpolationEnum interpolation)
+        {
+          if(_curve.getNumKeys() == 0)
+            _curve.setDefault(values);
+          else
+            _curve.setKey(getCurrentTime(), values, interpolation);
+          this->bumpGeneration();
+        }
+
+      public :
+        AnimatedInstance(Descriptor &descriptor, SetInstance *instance)
+          : BASE(descriptor, instance)
+          , _curve(DIM)
+        {
+        }
+
+        /// the curve the values are held in, which is edited through the param so that its
+        /// generation is bumped
+        const AnimationCurve &getCurve() const {return _curve;}
+
+        /// set a key with the given interpolation, rather than the param's usual one
+        void setKey(OfxTime time, const double *values, InterpolationEnum interpolation)
+        {
+          _curve.setKey(time, values, interpolation);
+          this->bumpGeneration();
+        }
+
+        virtual OfxStatus getNumKeys(unsigned int &nKeys) const
+        {
+          nKeys = _curve.getNumKeys();
+          return kOfxStatOK;
+        }
+
+        virtual OfxStatus getKeyTime(int nth, OfxTime &time) const
+        {
+          if(nth < 0 || nth >= int(_curve.getNumKeys()))
+            return kOfxStatErrBadIndex;
+          time = _curve.getKeyTime(nth);
+          return kOfxStatOK;
+        }
+
+        virtual OfxStatus getKeyIndex(OfxTime time, int direction, int &index) const
+        {
+          index = _curve.getKeyIndex(time, direction);
+          return index < 0 ? kOfxStatFailed : kOfxStatOK;
+        }
+
+        virtual OfxStatus deleteKey(OfxTime time)
+        {
+          if(!_curve.deleteKey(time))
+            return kOfxStatFailed;
+          this->bumpGeneration();
+          return kOfxStatOK;
+        }
+
+        virtual OfxStatus deleteAllKeys()
+        {
+          _curve.deleteAllKeys();
+          this->bumpGeneration();
+          return kOfxStatOK;
+        }
+
+        /// The hash of the values and keys from BASE, with the time, values and interpolation
+        /// of every key the curve between the times depends on. Those are the keys starting
+        /// the segments from the last key before time1 to the first after time2, and one more
+        /// on each side, as the smooth slopes at those keys come from the keys either side.
+        virtual unsigned long long getValueHash(OfxTime time1, OfxTime time2)
+        {
+          unsigned long long hash = BASE::getValueHash(time1, time2);
+          int nKeys = int(_curve.getNumKeys());
+          if(nKeys == 0)
+            return hash;
+          int first = std::max(0, _curve.getKeyIndex(time1, -1) - 1);
+          int last = _curve.getKeyIndex(time2, 1);
+          last = last < 0 ? nKeys - 1 : std::min(nKeys - 1, last + 1);
+          double values[DIM];
+          for(int i = first; i <= last; ++i) {
+            OfxTime t = _curve.getKeyTime(i);
+            InterpolationEnum interpolation = _curve.getKeyInterpolation(i);
+            _curve.getKeyValue(i, values);
+            hashBytes(hash, &t, sizeof(t));
+            hashBytes(hash, values, sizeof(values));
+            hashBytes(hash, &interpolation, sizeof(interpolation));
+          }
+          return hash;
+        }
+
+        /// get the values at many times with one walk along the curve
+        virtual OfxStatus getValuesAtTimes(int nTimes, const OfxTime *times, void *values)
+        {
+          if(!isIntegerValued()) {
+            _curve.getValues(nTimes, times, static_cast<double *>(values));
+            return kOfxStatOK;
+          }
+          std::vector<double> v(size_t(nTimes) * DIM);
+          if(nTimes > 0)
+            _curve.getValues(nTimes, times, &v[0]);
+          int *n = static_cast<int *>(values);
+          for(size_t i = 0; i < v.size(); ++i)
+            n[i] = int(floor(v[i] + 0.5));
+          return kOfxStatOK;
+        }
+
+        virtual OfxStatus copyFrom(const Instance &instance, OfxTime offset, const OfxRangeD *range)
+        {
+          const AnimatedInstance *other = dynamic_cast<const AnimatedInstance *>(&instance);
+          if(!other)
+            return kOfxStatErrMissingHostFeature;
+          if(other != this) {
+            _curve.copyFrom(other->_curve, offset, range);
+            this->bumpGeneration();
+          }
+          return kOfxStatOK;
+        }
+      };
+
+      /// a double param whose values are held in an AnimationCurve with smooth keys
+      class AnimatedDoubleInstance : public AnimatedInstance<DoubleInstance, 1> {
+      public :
+        AnimatedDoubleInstance(Descriptor &descriptor, SetInstance *instance = 0);
+
+        virtual OfxStatus get(double &);
+        virtual OfxStatus get(OfxTime time, double &);
+        virtual OfxStatus set(double);
+        virtual OfxStatus set(OfxTime time, double);
+        virtual OfxStatus derive(OfxTime time, double &);
+        virtual OfxStatus integrate(OfxTime time1, OfxTime time2, double &);
+      };
+
+      /// a 2D double param whose values are held in an AnimationCurve with smooth keys
+      class AnimatedDouble2DInstance : public AnimatedInstance<Double2DInstance, 2> {
+      public :
+        AnimatedDouble2DInstance(Descriptor &descriptor, SetInstance *instance = 0);
+
+        virtual OfxStatus get(double &, double &);
+        virtual OfxStatus get(OfxTime time, double &, double &);
+        virtual OfxStatus set(double, double);
+        virtual OfxStatus set(OfxTime time, double, double);
+        virtual OfxStatus derive(OfxTime time, double &, double &);
+        virtual OfxStatus integrate(OfxTime time1, OfxTime time2, double &, double &);
+      };
+
+      /// a 3D double param whose values are held in an AnimationCurve with smooth keys
+      class AnimatedDouble3DInstance : public AnimatedInstance<Double3DInstance, 3> {
+      public :
+        AnimatedDouble3DInstance(Descriptor &descriptor, SetInstance *instance = 0);
+
+        virtual OfxStatus get(double &, double &, double &);
+        virtual OfxStatus get(OfxTime time, double &, double &, double &);
+        virtual OfxStatus set(double, double, double);
+        virtual OfxStatus set(OfxTime time, double, double, double);
+        virtual OfxStatus derive(OfxTime time, double &, double &, double &);
+        virtual OfxStatus integrate(OfxTime time1, OfxTime time2, double &, double &, double &);
+      };
+
+      /// an RGB param whose values are held in an AnimationCurve with smooth keys
+      class AnimatedRGBInstance : public AnimatedInstance<RGBInstance, 3> {
+      public :
+        AnimatedRGBInstance(Descriptor &descriptor, SetInstance *instance = 0);
+
+        virtual OfxStatus get(double &, double &, double &);
+        virtual OfxStatus get(OfxTime time, double &, double &, double &);
+        virtual OfxStatus set(double, double, double);
+        virtual OfxStatus set(OfxTime time, double, double, double);
+        virtual OfxStatus derive(OfxTime time, double &, double &, double &);
+        virtual OfxStatus integrate(OfxTime time1, OfxTime time2, double &, double &, double &);
+      };
+
+      /// an RGBA param whose values are held in an AnimationCurve with smooth keys
+      class AnimatedRGBAInstance : public AnimatedInstance<RGBAInstance, 4> {
+      public :
+        AnimatedRGBAInstance(Descriptor &descriptor, SetInstance *instance = 0);
+
+        virtual OfxStatus get(double &, double &, double &, double &);
+        virtual OfxStatus get(OfxTime time, double &, double &, double &, double &);
+        virtual OfxStatus set(double, double, double, double);
+        virtual OfxStatus set(OfxTime time, double, double, double, double);
+        virtual OfxStatus derive(OfxTime time, double &, double &, double &, double &);
+        virtual OfxStatus integrate(OfxTime time1, OfxTime time2, double &, double &, double &, double &);
+      };
+
+      /// An integer param whose values are held in an AnimationCurve with linear keys,
+      /// values, derivatives and integrals being rounded to the nearest integer.
+      class AnimatedIntegerInstance : public AnimatedInstance<IntegerInstance, 1> {
+      public :
+        AnimatedIntegerInstance(Descriptor &descriptor, SetInstance *instance = 0);
+
+        virtual OfxStatus get(int &);
+        virtual OfxStatus get(OfxTime time, int &);
+        virtual OfxStatus set(int);
+        virtual OfxStatus set(OfxTime time, int);
+        virtual OfxStatus derive(OfxTime time, int &);
+        virtual OfxStatus integrate(OfxTime time1, OfxTime time2, int &);
+      };
+
+      /// a 2D integer param whose values are held in an AnimationCurve, as AnimatedIntegerInstance
+      class AnimatedInteger2DInstance : public AnimatedInstance<Integer2DInstance, 2> {
+      public :
+        AnimatedInteger2DInstance(Descriptor &descriptor, SetInstance *instance = 0);
+
+        virtual OfxStatus get(int &, int &);
+        virtual OfxStatus get(OfxTime time, int &, int &);
+        virtual OfxStatus set(int, int);
+        virtual OfxStatus set(OfxTime time, int, int);
+        virtual OfxStatus derive(OfxTime time, int &, int &);
+        virtual OfxStatus integrate(OfxTime time1, OfxTime time2, int &, int &);
+      };
+
+      /// a 3D integer param whose values are held in an AnimationCurve, as AnimatedIntegerInstance
+      class AnimatedInteger3DInstance : public AnimatedInstance<Integer3DInstance, 3> {
+      public :
+        AnimatedInteger3DInstance(Descriptor &descriptor, SetInstance *instance = 0);
+
+        virtual OfxStatus get(int &, int &, int &);
+        virtual OfxStatus get(OfxTime time, int &, int &, int &);
+        virtual OfxStatus set(int, int, int);
+        virtual OfxStatus set(OfxTime time, int, int, int);
+        virtual OfxStatus derive(OfxTime time, int &, int &, int &);
+        virtual OfxStatus integrate(OfxTime time1, OfxTime time2, int &, int &, int &);
+      };
+
+      /// A bytes param whose values are held at keys, each holding till the next. Before
+      /// the first key the value is that of it, and with no keys it is the static value.
+      ///
+      /// As values are Bytes, setting the same value at many keys, copying the param, or
+      /// keeping its State for undo shares the bytes rather than copying them.
+      class AnimatedBytesInstance : public BytesInstance {
+      public :
+        /// all the param holds, cheap to copy whatever the size of its values
+        struct State {
+          Bytes                value;  ///< the static value, used when there are no keys
+          std::vector<OfxTime> times;  ///< of the keys, ascending
+          std::vector<Bytes>   values; ///< at the keys
+        };
+
+        AnimatedBytesInstance(Descriptor &descriptor, SetInstance *instance = 0);
+
+        /// what the param holds now, to put back with setState, say on undo
+        const State &getState() const {return _state;}
+
+        /// Put back what the param held. As with any edit by the host, the effect should
+        /// then be told with kOfxActionInstanceChanged.
+        void setState(const State &state) {_state = state;}
+
+        virtual OfxStatus get(Bytes &);
+        virtual OfxStatus get(OfxTime time, Bytes &);
+        virtual OfxStatus set(const Bytes &);
+        virtual OfxStatus set(OfxTime time, const Bytes &);
+
+        virtual OfxStatus getNumKeys(unsigned int &nKeys) const;
+        virtual OfxStatus getKeyTime(int nth, OfxTime &time) const;
+        virtual OfxStatus getKeyIndex(OfxTime time, int direction, int &index) const;
+        virtual OfxStatus deleteKey(OfxTime time);
+        virtual OfxStatus deleteAllKeys();
+
+        /// copy the values and keys of another bytes param, sharing their bytes
+        virtual OfxStatus copyFrom(const Instance &instance, OfxTime offset, const OfxRangeD *range);
+
+      protected :
+        /// the time on the timeline of the param set if it has one, else 0
+        OfxTime getCurrentTime() const;
+
+        State _state;
+      };
+
+    } // namespace Param
+
+  } // namespace Host
+
+} // namespace OFX
+
+#endif // OFXH_PARAM_ANIMATION_H
@@ -10,6 +10,7 @@
 #include <map>
 
 #include "ofxhPropertySuite.h"
+#include "ofxhBinaryCache.h"
 
 namespace OFX
 {
@@ -63,6 +64,15 @@ namespace OFX
         
         virtual void saveXML(Plugin *, std::ostream &) const = 0;
 
+        /// write the api specific data of a plugin to a binary cache, return false if this api has no binary form,
+        /// in which case the binary holding the plugin is described again whenever such a cache is read
+        virtual bool saveBinary(Plugin *, BinaryCache::Writer &) const { return false; }
+
+        /// hand over the api specific data of a plugin read from a binary cache, as written by saveBinary.
+        /// The blob keeps the cache file mapped, so it can be held on to and decoded when first needed.
+        /// Return false to have the binary holding the plugin described again.
+        virtual bool loadBinary(Plugin *, const BinaryCache::Blob &) { return false; }
+
         virtual void confirmPlugin(Plugin *) = 0;
 
         virtual bool pluginSupported(Plugin *, std::string &reason) const = 0;
@@ -79,6 +89,13 @@ namespace OFX
       /// helper function to write a single property from a set to XML. Really should be a member of the property set!!!
       void propertyXMLWrite(std::ostream &o, const Property::Set &set, const std::string &name, int indent=0);
 
+      /// helper function to write a property set to a binary cache, pointer properties are skipped as in the XML
+      void propertySetBinaryWrite(BinaryCache::Writer &w, const Property::Set &set);
+
+      /// helper function to read back a property set written by propertySetBinaryWrite, adding any properties
+      /// the set lacks. Returns false if the data was truncated or malformed.
+      bool propertySetBinaryRead(BinaryCache::Reader &r, Property::Set &set);
+
     }
   }
 }
@@ -25,6 +25,10 @@ namespace OFX {
 
     class Host;
 
+    namespace MultiThread {
+      class ThreadPool;
+    }
+
     // forward declarations
     class PluginDesc;   
     class Plugin;
@@ -193,6 +197,7 @@ namespace OFX {
       time_t _fileModificationTime;   ///< used as a time stamp to check modification times, used for caching
       off_t _fileSize;                ///< file size last time we check, used for caching
       bool _binaryChanged;            ///< whether the timestamp/filesize in this cache is different from that in the actual binary
+      bool _loadReference;            ///< whether loadPluginInfo() holds a reference on _binary
       
     public :
 
@@ -205,6 +210,7 @@ namespace OFX {
         , _fileModificationTime(mtime)
         , _fileSize(size)
         , _binaryChanged(false)
+        , _loadReference(false)
       {
         if (isInvalid()) {
           return;
@@ -222,6 +228,7 @@ namespace OFX {
         , _filePath(file)
         , _bundlePath(bundlePath)
         , _binaryChanged(false)
+        , _loadReference(false)
       {
         loadPluginInfo(cache);
       }
@@ -262,8 +269,13 @@ namespace OFX {
         _plugins.push_back(pe);
       }
 
+      /// load the binary and make Plugin objects for what it exports. The binary is kept
+      /// loaded until releaseLoadReference() is called, so the plugins can be described.
       void loadPluginInfo(PluginCache *);
 
+      /// drop the reference loadPluginInfo() took, unloading the binary unless a PluginHandle still needs it
+      void releaseLoadReference();
+
       /// how many plugins?
       int getNPlugins() const {return (int)_plugins.size(); }
 
@@ -330,13 +342,16 @@ namespace OFX {
 
       std::list<PluginCacheSupportedApi> _apiHandlers;
 
-      void scanDirectory(std::set<std::string> &foundBinFiles, const std::string &dir, bool recurse);
+      /// walk the plugin path for binaries, then load and describe those not in the cache and those
+      /// that have changed since it was written, adding the paths of all the binaries found to foundBinFiles
+      void scanDirectories(MultiThread::ThreadPool &pool, std::set<std::string> &foundBinFiles);
 
       bool _ignoreCache;
       std::string _cacheVersion;
 
       bool _dirty;
       bool _enablePluginSeek;       ///< Turn off to make all seekPluginFile() calls return an empty string
+      unsigned int _scanThreads;    ///< threads scanPluginFiles() uses, 0 for one per processor
 
       static PluginCache* gPluginCachePtr; ///< singleton plugin cache
 
@@ -392,6 +407,11 @@ namespace OFX {
       // populate the cache.  must call scanPluginFiles() after to check for changes.
       void readCache(std::istream &is);
 
+      /// populate the cache from a file written by writeBinaryCache. must call scanPluginFiles() after to check for changes.
+      /// returns false without reading anything if the file is missing, corrupt or was written with another cache
+      /// version, in which case the XML cache can be read instead.
+      bool readBinaryCache(const std::string &filename);
+
       // seek a particular file on the OFX plugin path
       std::string seekPluginFile(const std::string &baseName) const;
       
@@ -399,11 +419,22 @@ namespace OFX {
       /// Enable (the default): normal operation; disable: returns an empty string instead
       void setPluginSeekEnabled(bool enabled) { _enablePluginSeek = enabled; }
 
+      /// set how many threads scanPluginFiles() uses to walk the plugin path and to load and describe
+      /// binaries, 0 for one per processor. The default of 1 does everything on the calling thread.
+      /// With more, plugins in different binaries are described at the same time, so the host's
+      /// descriptor factories must be safe to call from several threads. Plugins are found and
+      /// ordered the same way whatever the number of threads.
+      void setScanThreads(unsigned int nThreads) { _scanThreads = nThreads; }
+
       /// scan for plugins
       void scanPluginFiles();
 
       // write the plugin cache output file to the given stream
       void writePluginCache(std::ostream &os) const;
+
+      /// write the plugin cache in binary form to the given file, returns false if it could not be written.
+      /// The file is written alongside and moved into place, as a cache read by readBinaryCache may still be in use.
+      bool writeBinaryCache(const std::string &filename) const;
       
       // callback function for the XML
       void elementBeginCallback(void *userData, const XML_Char *name, const XML_Char **attrs);
@@ -359,6 +359,85 @@ namespace OFX {
       /// A std::map of properties by name
       typedef std::map<std::string, Property *> PropertyMap;
 
+      /// An open addressing hash table of entries, keyed on their names, which ENTRY gives
+      /// as a std::string from getName().
+      ///
+      /// The hash of each name is computed once, when the entry goes in, and kept in
+      /// its slot. Lookups take a plain C string, so finding an entry by one of the
+      /// kOfx* names needs no std::string and no allocation, just its length, a hash
+      /// of a few of its bytes and a short linear probe.
+      template <class ENTRY> class NameIndex {
+        /// a slot in the table, empty if entry is null
+        struct Slot {
+          size_t  hash;
+          ENTRY  *entry;
+        };
+
+        std::vector<Slot> _slots; ///< size is zero or a power of two
+        size_t            _count; ///< number of slots in use
+
+        /// find the slot name is in, or the empty slot it would go in
+        size_t probe(const char *name, size_t length, size_t hash) const;
+
+        /// double the size of the table
+        void grow();
+
+      public :
+        /// ctor
+        NameIndex() : _count(0) {}
+
+        /// hash a name, also returning its length
+        static size_t hashName(const char *name, size_t &length);
+
+        /// find an entry by name, null if it is not there
+        ENTRY *find(const char *name) const;
+
+        /// add an entry, replacing any with the same name
+        void insert(ENTRY *entry);
+
+        /// empty the table, the entries are not deleted
+        void clear();
+      };
+
+      /// the index a Set keeps of its properties
+      typedef NameIndex<Property> PropertyIndex;
+
+      /// Maps a fixed set of property names to small integer ids.
+      ///
+      /// Get hooks that serve several properties use this to switch on the id of the
+      /// name they are handed, rather than compare it against each name in turn. The
+      /// table is built once, and looked up through the same NameIndex a Set uses.
+      class PropertyIdTable {
+      public :
+        /// an entry in the table handed to the ctor
+        struct Entry {
+          const char *name;
+          int         id;
+        };
+
+        /// a name and its id, as kept in the index
+        struct Id {
+          std::string name;
+          int         id;
+
+          const std::string &getName() const {return name;}
+        };
+
+        /// ctor, entries is terminated by one with a null name
+        explicit PropertyIdTable(const Entry *entries);
+
+        /// the id of name, or -1 if it is not in the table
+        int find(const std::string &name) const;
+
+      private :
+        std::vector<Id>       _ids;
+        NameIndex<const Id>   _index;
+
+        /// hide copying, the index points into _ids
+        PropertyIdTable(const PropertyIdTable &);
+        void operator=(const PropertyIdTable &);
+      };
+
 
       //................................................................................
       /// Class that holds a set of properties and manipulates them
@@ -370,7 +449,8 @@ namespace OFX {
         const int   _magic; ///< to check for handles being nice
 
       protected :
-        PropertyMap _props; ///< Our properties.
+        PropertyMap   _props; ///< Our properties.
+        PropertyIndex _index; ///< Our properties again, hashed for quick look up
 
         /// chained property set, which is read only
         /// these are searched on a get if not found 
@@ -442,12 +522,18 @@ namespace OFX {
         /// 'followChain' arg is not false.
         Property *fetchProperty(const std::string &name, bool followChain = false) const;
 
+        /// As above, but takes a C string, so no std::string need be made for the look up.
+        Property *fetchProperty(const char *name, bool followChain = false) const;
+
         /// get property with the particular name and type.  if the property is 
         /// missing or is of the wrong type, return an error status.  if this is a sloppy
         /// property set and the property is missing, a new one will be created of the right
         /// type
         template<class T> bool fetchTypedProperty(const std::string &name, T *&prop, bool followChain = false) const;
 
+        /// As above, but takes a C string, so no std::string need be made for the look up.
+        template<class T> bool fetchTypedProperty(const char *name, T *&prop, bool followChain = false) const;
+
         /// retrieve the nameed string property
         String *fetchStringProperty(const std::string &name,  bool followChain = false) const;
 
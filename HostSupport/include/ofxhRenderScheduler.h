@@ -0,0 +1,127 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef OFX_RENDER_SCHEDULER_H
+#define OFX_RENDER_SCHEDULER_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      // forward declare
+      class ImageEffectPlugin;
+      class Instance;
+
+      /// Renders a range of frames of an effect instance, running as many render actions at
+      /// once as the effect's kOfxImageEffectPluginRenderThreadSafety allows.
+      ///
+      ///   - unsafe effects render one frame at a time on the calling thread, and hold a lock
+      ///     shared by every scheduler rendering the same plugin while they do,
+      ///   - instance safe effects render a frame on each of a pool of instances at once, the
+      ///     extra instances being made by newRenderInstance and kept between renders,
+      ///   - fully safe effects render frames at once on the one instance, and if they ask
+      ///     for host frame threading and support tiles, split each frame into strips as well
+      ///     when there are fewer frames than threads.
+      ///
+      /// Effects that set kOfxImageEffectInstancePropSequentialRender to 1 have their frames
+      /// rendered in order, one after another, on the instance passed to the ctor, which is
+      /// then told the render is sequential. A fully safe one may still have each frame split
+      /// into strips.
+      ///
+      /// The work is run on the host's thread pool, so the effect's own multiThread calls run
+      /// inline while frames are rendering at once. When there is one frame at a time and no
+      /// strips, it is rendered on the calling thread, and the effect has the pool to itself.
+      ///
+      /// Rendering frames at once only works if the host's output clips hand out a separate
+      /// image for each time being rendered, or each instance in the pool has its own.
+      class RenderScheduler {
+      public :
+        /// ctor, maxThreads of 0 means use as many as the host's thread pool has
+        explicit RenderScheduler(Instance &instance, unsigned int maxThreads = 0);
+
+        /// dtor, deletes the instances made for the pool
+        virtual ~RenderScheduler();
+
+        /// the instance we render
+        Instance &getInstance() const {return _instance;}
+
+        /// Render the frames from startFrame to endFrame inclusive, every step frames.
+        ///
+        /// Calls beginRenderAction on each instance used before its first frame and
+        /// endRenderAction after its last, and frameRendered as each frame is done.
+        /// Returns the status of the first render action to fail, after which no more
+        /// frames are started, or kOfxStatOK.
+        OfxStatus render(OfxTime startFrame,
+                         OfxTime endFrame,
+                         OfxTime step,
+                         const OfxRectI &renderWindow,
+                         OfxPointD renderScale,
+                         const std::string &field = kOfxImageFieldNone,
+                         bool interactive = false,
+                         bool draft = false);
+
+        /// Make an instance for the pool of an instance safe effect, which must render the
+        /// same as the one passed to the ctor. Called on the thread calling render.
+        ///
+        /// The default creates an instance of the same plugin in the same context, copies
+        /// the params of the instance passed to the ctor onto it with Param::Instance::copyFrom,
+        /// then runs its create instance action and clip preferences. Params whose instances
+        /// do not implement copyFrom are left at their defaults. Override this to copy them
+        /// some other way and to wire up the clips. Return NULL to render with fewer instances.
+        virtual Instance *newRenderInstance();
+
+        /// Bring a pool instance up to date with the instance passed to the ctor, called by
+        /// render on a pool instance made or last synced when the state generation of that
+        /// instance was different. The default copies the params as newRenderInstance does
+        /// and runs the clip preferences again. Return false to have the pool instance
+        /// deleted and made afresh with newRenderInstance.
+        virtual bool syncRenderInstance(Instance &instance);
+
+        /// Called when a frame has been rendered, on the thread that rendered it, with the
+        /// instance that rendered it, before that instance renders anything else. With a
+        /// fully safe effect several calls may be made at once. The default does nothing.
+        virtual void frameRendered(Instance &instance, OfxTime time);
+
+        /// delete the instances made for the pool, so that the next render makes them afresh,
+        /// render itself only syncs them when the instance passed to the ctor changes
+        void clearRenderInstances();
+
+        /// the lock held while rendering an unsafe plugin, one per plugin, for anything else
+        /// rendering one to take as well
+        static std::mutex &getUnsafeRenderMutex(ImageEffectPlugin *plugin);
+
+      protected :
+        struct Job;
+
+        /// hide copying
+        RenderScheduler(const RenderScheduler &);
+        void operator=(const RenderScheduler &);
+
+        /// what each thread of a render runs
+        static void renderThread(unsigned int threadIndex, unsigned int threadMax, void *customArg);
+
+        /// render one strip of one frame of the job on the given instance
+        static OfxStatus renderItem(Job &job, Instance &instance, size_t item);
+
+        Instance               &_instance;     ///< the instance we render
+        unsigned int            _maxThreads;   ///< the most threads to render with
+        std::vector<Instance *> _poolInstances; ///< the extra instances of an instance safe effect
+        std::vector<unsigned int> _poolGenerations; ///< the state generation of _instance each of those was last synced to
+      };
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
+
+#endif // OFX_RENDER_SCHEDULER_H
@@ -0,0 +1,118 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef OFX_TILED_RENDER_H
+#define OFX_TILED_RENDER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      // forward declare
+      class ClipInstance;
+      class Instance;
+
+      /// one tile of a tiled render
+      struct RenderTile {
+        OfxRectI                            window; ///< the pixels of the output to render
+        std::map<ClipInstance *, OfxRectD>  rois;   ///< canonical region needed from each input, clipped to its RoD
+        size_t                              bytes;  ///< estimated memory of the output and input images of the tile
+      };
+
+      /// Renders a frame of an effect instance as tiles, so that a large frame can be
+      /// rendered with a bounded amount of image memory, and in parallel.
+      ///
+      /// The tiles are planned by asking the effect for the regions of interest of a tile in
+      /// the middle of the render window, and halving the tile until the output and input
+      /// images it needs fit in the memory budget shared out between the tiles rendering at
+      /// once, though tiles are not halved below 64 pixels on a side, so a very small budget
+      /// may be overrun. Effects that render fully safe, ask for host frame threading and
+      /// support tiles have their tiles rendered at once on the host's thread pool, and the
+      /// tiles are made small enough that each thread has at least one. Others have them
+      /// rendered one at a time, unsafe ones holding RenderScheduler::getUnsafeRenderMutex.
+      /// Effects or clips that do not support tiles are rendered as one tile, the whole
+      /// render window.
+      ///
+      /// The host fetches images for a tile in its clips' getImage, where getCurrentTile
+      /// gives the tile being rendered on that thread, the regions of interest of which are
+      /// the only parts of the inputs the effect needs.
+      ///
+      /// The render must be made between the instance's begin and end render actions.
+      class TiledRender {
+      public :
+        /// ctor, a memoryBudget of 0 bytes means no limit, maxThreads of 0 means use as many as the host's thread pool has
+        TiledRender(Instance &instance, size_t memoryBudget, unsigned int maxThreads = 0);
+
+        /// dtor
+        virtual ~TiledRender();
+
+        /// the instance we render
+        Instance &getInstance() const {return _instance;}
+
+        /// the memory budget, in bytes
+        size_t getMemoryBudget() const {return _memoryBudget;}
+
+        /// Work out the tiles to render the window in, which cover it without overlapping,
+        /// in rows from the bottom. Returns the status of the first region of interest
+        /// action to fail, or kOfxStatOK.
+        OfxStatus plan(OfxTime time,
+                       const OfxRectI &renderWindow,
+                       OfxPointD renderScale,
+                       std::vector<RenderTile> &tiles);
+
+        /// Plan the tiles of the window and render them, calling tileRendered as each is
+        /// done. Returns the status of the first action to fail, after which no more tiles
+        /// are started, or kOfxStatOK.
+        OfxStatus render(OfxTime time,
+                         const OfxRectI &renderWindow,
+                         OfxPointD renderScale,
+                         const std::string &field = kOfxImageFieldNone,
+                         bool sequential = false,
+                         bool interactive = false,
+                         bool draft = false);
+
+        /// Called when a tile has been rendered, on the thread that rendered it, so that the
+        /// host can copy it out and release the images it used. Several calls may be made
+        /// at once. The default does nothing.
+        virtual void tileRendered(const RenderTile &tile);
+
+        /// the tile being rendered on the calling thread, NULL if none is
+        static const RenderTile *getCurrentTile();
+
+      protected :
+        struct Job;
+
+        /// hide copying
+        TiledRender(const TiledRender &);
+        void operator=(const TiledRender &);
+
+        /// how many tiles we may render at once
+        unsigned int getConcurrency() const;
+
+        /// fill in the regions of interest and memory of a tile covering the given pixels
+        OfxStatus makeTile(OfxTime time, OfxPointD renderScale, const OfxRectI &window, RenderTile &tile);
+
+        /// what each thread of a render runs
+        static void renderThread(unsigned int threadIndex, unsigned int threadMax, void *customArg);
+
+        Instance               &_instance;     ///< the instance we render
+        size_t                  _memoryBudget; ///< bytes of images all the tiles rendering at once may use
+        unsigned int            _maxThreads;   ///< the most threads to render with
+      };
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
+
+#endif // OFX_TILED_RENDER_H
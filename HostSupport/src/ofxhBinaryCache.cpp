@@ -0,0 +1,153 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <string.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include "windows.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// ofx host
+#include "ofxhBinaryCache.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace BinaryCache {
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // Mapping
+
+      /// read the whole file into buffer
+      static bool readWholeFile(const std::string &path, std::vector<char> &buffer)
+      {
+        FILE *f = fopen(path.c_str(), "rb");
+        if(!f)
+          return false;
+
+        bool ok = false;
+        if(fseek(f, 0, SEEK_END) == 0) {
+          long size = ftell(f);
+          if(size > 0 && fseek(f, 0, SEEK_SET) == 0) {
+            buffer.resize(size_t(size));
+            ok = fread(&buffer[0], 1, buffer.size(), f) == buffer.size();
+          }
+        }
+        fclose(f);
+        return ok;
+      }
+
+#if defined(_WIN32)
+
+      // a file can't be replaced while a view of it is mapped, which would stop the cache being
+      // rewritten while plugins still hold undecoded blobs, so read the file into memory instead
+      Mapping::Mapping(const std::string &path)
+        : _data(0)
+        , _size(0)
+        , _mapped(false)
+      {
+        if(readWholeFile(path, _buffer)) {
+          _data = &_buffer[0];
+          _size = _buffer.size();
+        }
+      }
+
+      Mapping::~Mapping()
+      {
+      }
+
+#else
+
+      Mapping::Mapping(const std::string &path)
+        : _data(0)
+        , _size(0)
+        , _mapped(false)
+      {
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd >= 0) {
+          struct stat sb;
+          if(fstat(fd, &sb) == 0 && sb.st_size > 0) {
+            void *addr = mmap(0, size_t(sb.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if(addr != MAP_FAILED) {
+              _data = static_cast<const char *>(addr);
+              _size = size_t(sb.st_size);
+              _mapped = true;
+            }
+          }
+          // the mapping stays valid after the descriptor is closed
+          close(fd);
+          if(_mapped)
+            return;
+        }
+
+        if(readWholeFile(path, _buffer)) {
+          _data = &_buffer[0];
+          _size = _buffer.size();
+        }
+      }
+
+      Mapping::~Mapping()
+      {
+        if(_mapped)
+          munmap(const_cast<char *>(_data), _size);
+      }
+
+#endif
+
+      bool replaceFile(const std::string &from, const std::string &to)
+      {
+#if defined(_WIN32)
+        bool ok = MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        // rename is atomic, anyone with the old file mapped keeps seeing the old contents
+        bool ok = rename(from.c_str(), to.c_str()) == 0;
+#endif
+        if(!ok)
+          remove(from.c_str());
+        return ok;
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // Reader
+
+      std::string Reader::getString()
+      {
+        uint32_t size = getU32();
+        const char *data = skip(size);
+        if(!data)
+          return std::string();
+        return std::string(data, size);
+      }
+
+      const char *Reader::skip(size_t size)
+      {
+        if(!_good || size > getRemaining()) {
+          _good = false;
+          return 0;
+        }
+        const char *data = _pos;
+        _pos += size;
+        return data;
+      }
+
+      void Reader::getRaw(void *dst, size_t size)
+      {
+        // the file is packed, so go through memcpy rather than dereference a possibly unaligned pointer
+        const char *data = skip(size);
+        if(data)
+          memcpy(dst, data, size);
+      }
+
+    } // BinaryCache
+
+  } // Host
+
+} // OFX
@@ -3,6 +3,9 @@
 
 #include <assert.h>
 
+#include <mutex>
+#include <vector>
+
 // ofx
 #include "ofxCore.h"
 
@@ -162,7 +165,69 @@ namespace OFX {
       {
         _properties.setStringProperty(kOfxPropName,name);
       }
-      
+
+      ////////////////////////////////////////////////////////////////////////////////
+      /// free list of images for a clip instance to hand out again.
+      ///
+      /// Images hold the pool while they are out, so it outlives the clip if the plugin
+      /// hangs on to one. Once the clip is gone the pool is closed and anything released
+      /// back into it is deleted.
+      class ImagePool {
+        std::mutex           _mutex;
+        std::vector<Image *> _free;
+        bool                 _closed;
+
+        /// hide copying
+        ImagePool(const ImagePool &);
+        void operator=(const ImagePool &);
+
+      public :
+        /// most images kept on the list, enough for an effect holding a few frames per input
+        static const size_t kMaxFree = 16;
+
+        ImagePool() : _closed(false) {}
+
+        ~ImagePool()
+        {
+          close();
+        }
+
+        /// put a released image on the list, returns false if it should be deleted instead
+        bool put(ImageBase *image)
+        {
+          std::lock_guard<std::mutex> guard(_mutex);
+          if(_closed || _free.size() >= kMaxFree)
+            return false;
+          // only images go into a pool, see ClipInstance::setRecyclable
+          _free.push_back(static_cast<Image *>(image));
+          return true;
+        }
+
+        /// take an image off the list, NULL if there are none
+        Image *take()
+        {
+          std::lock_guard<std::mutex> guard(_mutex);
+          if(_free.empty())
+            return 0;
+          Image *image = _free.back();
+          _free.pop_back();
+          return image;
+        }
+
+        /// delete everything on the list and stop taking more
+        void close()
+        {
+          std::vector<Image *> images;
+          {
+            std::lock_guard<std::mutex> guard(_mutex);
+            _closed = true;
+            images.swap(_free);
+          }
+          for(size_t i = 0; i < images.size(); ++i)
+            delete images[i];
+        }
+      };
+
       /// extra properties for the instance, these are fetched from the host
       /// via a get hook and some virtuals
       static const Property::PropSpec clipInstanceStuffs[] = {
@@ -185,12 +250,54 @@ namespace OFX {
 
       ////////////////////////////////////////////////////////////////////////////////
       // instance
+      /// the properties served by the get hooks, so the hooks can switch on the name
+      enum ClipHookEnum {
+        eClipHookPixelDepth,
+        eClipHookComponents,
+        eClipHookUnmappedComponents,
+        eClipHookUnmappedPixelDepth,
+        eClipHookPreMultiplication,
+        eClipHookFieldOrder,
+        eClipHookPixelAspectRatio,
+        eClipHookFrameRate,
+        eClipHookFrameRange,
+        eClipHookUnmappedFrameRate,
+        eClipHookUnmappedFrameRange,
+        eClipHookConnected,
+        eClipHookContinuousSamples
+      };
+
+      static const Property::PropertyIdTable::Entry clipHookNames[] = {
+        { kOfxImageEffectPropPixelDepth, eClipHookPixelDepth },
+        { kOfxImageEffectPropComponents, eClipHookComponents },
+        { kOfxImageClipPropUnmappedComponents, eClipHookUnmappedComponents },
+        { kOfxImageClipPropUnmappedPixelDepth, eClipHookUnmappedPixelDepth },
+        { kOfxImageEffectPropPreMultiplication, eClipHookPreMultiplication },
+        { kOfxImageClipPropFieldOrder, eClipHookFieldOrder },
+        { kOfxImagePropPixelAspectRatio, eClipHookPixelAspectRatio },
+        { kOfxImageEffectPropFrameRate, eClipHookFrameRate },
+        { kOfxImageEffectPropFrameRange, eClipHookFrameRange },
+        { kOfxImageEffectPropUnmappedFrameRate, eClipHookUnmappedFrameRate },
+        { kOfxImageEffectPropUnmappedFrameRange, eClipHookUnmappedFrameRange },
+        { kOfxImageClipPropConnected, eClipHookConnected },
+        { kOfxImageClipPropContinuousSamples, eClipHookContinuousSamples },
+        { NULL, 0 }
+      };
+
+      /// which hooked property is name, -1 if none
+      static int findClipHook(const std::string &name)
+      {
+        static const Property::PropertyIdTable table(clipHookNames);
+        return table.find(name);
+      }
+
       ClipInstance::ClipInstance(ImageEffect::Instance* effectInstance, ClipDescriptor& desc) 
         : ClipBase(desc)
         , _effectInstance(effectInstance)
         , _isOutput(desc.isOutput())
         , _pixelDepth(kOfxBitDepthNone) 
         , _components(kOfxImageComponentNone)
+        , _imagePool(std::make_shared<ImagePool>())
       {
         // this will a parameters that are needed in an instance but not a 
         // Descriptor
@@ -213,6 +320,27 @@ namespace OFX {
         }
       }
 
+      ClipInstance::~ClipInstance()
+      {
+        _imagePool->close();
+      }
+
+      void ClipInstance::setRecyclable(Image *image)
+      {
+        image->_pool = _imagePool;
+      }
+
+      Image *ClipInstance::getRecycledImage()
+      {
+        Image *image = _imagePool->take();
+        if(image) {
+          image->_referenceCount.store(1, std::memory_order_relaxed);
+          image->_pool = _imagePool;
+          image->getClipBits(*this);
+        }
+        return image;
+      }
+
       // do nothing
       int ClipInstance::getDimension(const std::string &name) const 
       {
@@ -242,73 +370,74 @@ namespace OFX {
       // get the virtuals for viewport size, pixel scale, background colour
       void ClipInstance::getDoublePropertyN(const std::string &name, double *values, int n) const
       {
-        if(name==kOfxImagePropPixelAspectRatio){
+        switch (findClipHook(name)) {
+        case eClipHookPixelAspectRatio:
           if(n>1) throw Property::Exception(kOfxStatErrValue);
           *values = getAspectRatio();
-        }
-        else if(name==kOfxImageEffectPropFrameRate){
+          break;
+        case eClipHookFrameRate:
           if(n>1) throw Property::Exception(kOfxStatErrValue);
           *values = getFrameRate();
-        }
-        else if(name==kOfxImageEffectPropFrameRange){
+          break;
+        case eClipHookFrameRange:
           if(n>2) throw Property::Exception(kOfxStatErrValue);
           getFrameRange(values[0], values[1]);
-        }
-        else if(name==kOfxImageEffectPropUnmappedFrameRate){
+          break;
+        case eClipHookUnmappedFrameRate:
           if(n>1) throw Property::Exception(kOfxStatErrValue);
           *values =  getUnmappedFrameRate();
-        }
-        else if(name==kOfxImageEffectPropUnmappedFrameRange){
+          break;
+        case eClipHookUnmappedFrameRange:
           if(n>2) throw Property::Exception(kOfxStatErrValue);
           getUnmappedFrameRange(values[0], values[1]);
-        }
-        else
+          break;
+        default:
           throw Property::Exception(kOfxStatErrValue);
+        }
       }
 
       // get the virtuals for viewport size, pixel scale, background colour
       double ClipInstance::getDoubleProperty(const std::string &name, int n) const
       {
-        if(name==kOfxImagePropPixelAspectRatio){
+        switch (findClipHook(name)) {
+        case eClipHookPixelAspectRatio:
           if(n!=0) throw Property::Exception(kOfxStatErrValue);
           return getAspectRatio();
-        }
-        else if(name==kOfxImageEffectPropFrameRate){
+        case eClipHookFrameRate:
           if(n!=0) throw Property::Exception(kOfxStatErrValue);
           return getFrameRate();
-        }
-        else if(name==kOfxImageEffectPropFrameRange){
+        case eClipHookFrameRange: {
           if(n>1) throw Property::Exception(kOfxStatErrValue);
           double range[2];
           getFrameRange(range[0], range[1]);
           return range[n];
         }
-        else if(name==kOfxImageEffectPropUnmappedFrameRate){
+        case eClipHookUnmappedFrameRate:
           if(n>0) throw Property::Exception(kOfxStatErrValue);
           return getUnmappedFrameRate();
-        }
-        else if(name==kOfxImageEffectPropUnmappedFrameRange){
+        case eClipHookUnmappedFrameRange: {
           if(n>1) throw Property::Exception(kOfxStatErrValue);
           double range[2];
           getUnmappedFrameRange(range[0], range[1]);
           return range[n];
         }
-        else
+        default:
           throw Property::Exception(kOfxStatErrValue);
+        }
       }
 
       // get the virtuals for viewport size, pixel scale, background colour
       int ClipInstance::getIntProperty(const std::string &name, int n) const
       {
         if(n!=0) throw Property::Exception(kOfxStatErrValue);
-        if(name==kOfxImageClipPropConnected){
+        switch (findClipHook(name)) {
+        case eClipHookConnected:
           return getConnected();
-        }
-        else if(name==kOfxImageClipPropContinuousSamples){
+        case eClipHookContinuousSamples:
           return getContinuousSamples();
-        }
-        else
+        default:
           throw Property::Exception(kOfxStatErrValue);
+        }
       }
 
       // get the virtuals for viewport size, pixel scale, background colour
@@ -318,30 +447,32 @@ namespace OFX {
         *values = getIntProperty(name, 0);
       }
 
-      // get the virtuals for viewport size, pixel scale, background colour
-      const std::string &ClipInstance::getStringProperty(const std::string &name, int n) const
+      /// the string the given hook returns, shared by getStringProperty and getStringPropertyN
+      const std::string &ClipInstance::getHookedString(const std::string &name) const
       {
-        if(n!=0) throw Property::Exception(kOfxStatErrValue);
-        if(name==kOfxImageEffectPropPixelDepth){
+        switch (findClipHook(name)) {
+        case eClipHookPixelDepth:
           return getPixelDepth();
-        }
-        else if(name==kOfxImageEffectPropComponents){
+        case eClipHookComponents:
           return getComponents();
-        }
-        else if(name==kOfxImageClipPropUnmappedComponents){
+        case eClipHookUnmappedComponents:
           return getUnmappedComponents();
-        }
-        else if(name==kOfxImageClipPropUnmappedPixelDepth){
+        case eClipHookUnmappedPixelDepth:
           return getUnmappedBitDepth();
-        }
-        else if(name==kOfxImageEffectPropPreMultiplication){
+        case eClipHookPreMultiplication:
           return getPremult();
-        }
-        else if(name==kOfxImageClipPropFieldOrder){
+        case eClipHookFieldOrder:
           return getFieldOrder();
-        }
-        else
+        default:
           throw Property::Exception(kOfxStatErrValue);
+        }
+      }
+
+      // get the virtuals for viewport size, pixel scale, background colour
+      const std::string &ClipInstance::getStringProperty(const std::string &name, int n) const
+      {
+        if(n!=0) throw Property::Exception(kOfxStatErrValue);
+        return getHookedString(name);
       }
        
       // fetch  multiple values in a multi-dimension property
@@ -351,26 +482,7 @@ namespace OFX {
               return;
           }
           if(count!=1) throw Property::Exception(kOfxStatErrValue);
-          if(name==kOfxImageEffectPropPixelDepth){
-              values[0] = getPixelDepth().c_str();
-          }
-          else if(name==kOfxImageEffectPropComponents){
-              values[0] = getComponents().c_str();
-          }
-          else if(name==kOfxImageClipPropUnmappedComponents){
-              values[0] = getUnmappedComponents().c_str();
-          }
-          else if(name==kOfxImageClipPropUnmappedPixelDepth){
-              values[0] = getUnmappedBitDepth().c_str();
-          }
-          else if(name==kOfxImageEffectPropPreMultiplication){
-              values[0] = getPremult().c_str();
-          }
-          else if(name==kOfxImageClipPropFieldOrder){
-              values[0] = getFieldOrder().c_str();
-          }
-          else
-              throw Property::Exception(kOfxStatErrValue);
+          values[0] = getHookedString(name).c_str();
       }
 
       // notify override properties
@@ -475,6 +587,22 @@ namespace OFX {
         : Property::Set(imageBaseStuffs)
         , _referenceCount(1)
       {
+        bindProperties();
+      }
+
+      /// look up our property slots
+      void ImageBase::bindProperties()
+      {
+        _pixelDepthProp = fetchStringProperty(kOfxImageEffectPropPixelDepth);
+        _componentsProp = fetchStringProperty(kOfxImageEffectPropComponents);
+        _premultProp = fetchStringProperty(kOfxImageEffectPropPreMultiplication);
+        _renderScaleProp = fetchDoubleProperty(kOfxImageEffectPropRenderScale);
+        _pixelAspectRatioProp = fetchDoubleProperty(kOfxImagePropPixelAspectRatio);
+        _boundsProp = fetchIntProperty(kOfxImagePropBounds);
+        _rodProp = fetchIntProperty(kOfxImagePropRegionOfDefinition);
+        _rowBytesProp = fetchIntProperty(kOfxImagePropRowBytes);
+        _fieldProp = fetchStringProperty(kOfxImagePropField);
+        _uniqueIdentifierProp = fetchStringProperty(kOfxImagePropUniqueIdentifier);
       }
 
       /// called during ctor to get bits from the clip props into ours
@@ -483,18 +611,16 @@ namespace OFX {
         Property::Set& clipProperties = instance.getProps();
         
         // get and set the clip instance pixel depth
-        const std::string &depth = clipProperties.getStringProperty(kOfxImageEffectPropPixelDepth);
-        setStringProperty(kOfxImageEffectPropPixelDepth, depth); 
+        _pixelDepthProp->setValue(clipProperties.getStringProperty(kOfxImageEffectPropPixelDepth));
         
         // get and set the clip instance components
-        const std::string &comps = clipProperties.getStringProperty(kOfxImageEffectPropComponents);
-        setStringProperty(kOfxImageEffectPropComponents, comps);
+        _componentsProp->setValue(clipProperties.getStringProperty(kOfxImageEffectPropComponents));
         
         // get and set the clip instance premultiplication
-        setStringProperty(kOfxImageEffectPropPreMultiplication, clipProperties.getStringProperty(kOfxImageEffectPropPreMultiplication));
+        _premultProp->setValue(clipProperties.getStringProperty(kOfxImageEffectPropPreMultiplication));
 
         // get and set the clip instance pixel aspect ratio
-        setDoubleProperty(kOfxImagePropPixelAspectRatio, clipProperties.getDoubleProperty(kOfxImagePropPixelAspectRatio));
+        _pixelAspectRatioProp->setValue(clipProperties.getDoubleProperty(kOfxImagePropPixelAspectRatio));
       }
 
       /// make an image from a clip instance
@@ -502,6 +628,7 @@ namespace OFX {
         : Property::Set(imageBaseStuffs)
         , _referenceCount(1)
       {
+        bindProperties();
         getClipBits(instance);
       }      
 
@@ -517,37 +644,32 @@ namespace OFX {
         : Property::Set(imageBaseStuffs)
         , _referenceCount(1)
       {
+        bindProperties();
         getClipBits(instance);
 
         // set other data
-        setDoubleProperty(kOfxImageEffectPropRenderScale,renderScaleX, 0);    
-        setDoubleProperty(kOfxImageEffectPropRenderScale,renderScaleY, 1);        
-        setIntProperty(kOfxImagePropBounds,bounds.x1, 0);
-        setIntProperty(kOfxImagePropBounds,bounds.y1, 1);
-        setIntProperty(kOfxImagePropBounds,bounds.x2, 2);
-        setIntProperty(kOfxImagePropBounds,bounds.y2, 3);
-        setIntProperty(kOfxImagePropRegionOfDefinition,rod.x1, 0);
-        setIntProperty(kOfxImagePropRegionOfDefinition,rod.y1, 1);
-        setIntProperty(kOfxImagePropRegionOfDefinition,rod.x2, 2);
-        setIntProperty(kOfxImagePropRegionOfDefinition,rod.y2, 3);        
-        setIntProperty(kOfxImagePropRowBytes,rowBytes);
+        _renderScaleProp->setValue(renderScaleX, 0);
+        _renderScaleProp->setValue(renderScaleY, 1);
+        _boundsProp->setValueN(&bounds.x1, 4);
+        _rodProp->setValueN(&rod.x1, 4);
+        _rowBytesProp->setValue(rowBytes);
         
-        setStringProperty(kOfxImagePropField,field);
+        _fieldProp->setValue(field);
         setStringProperty(kOfxImageClipPropFieldOrder,field);
-        setStringProperty(kOfxImagePropUniqueIdentifier,uniqueIdentifier);
+        _uniqueIdentifierProp->setValue(uniqueIdentifier);
       }
 
       OfxRectI ImageBase::getBounds() const
       {
         OfxRectI bounds = {0, 0, 0, 0};
-        getIntPropertyN(kOfxImagePropBounds, &bounds.x1, 4);
+        _boundsProp->getValueN(&bounds.x1, 4);
         return bounds;
       }
 
       OfxRectI ImageBase::getROD() const
       {
         OfxRectI rod = {0, 0, 0, 0};
-        getIntPropertyN(kOfxImagePropRegionOfDefinition, &rod.x1, 4);
+        _rodProp->getValueN(&rod.x1, 4);
         return rod;
       }
 
@@ -558,9 +680,17 @@ namespace OFX {
       // release the reference 
       void ImageBase::releaseReference()
       {
-        _referenceCount -= 1;
-        if(_referenceCount <= 0)
-          delete this;
+        if(_referenceCount.fetch_sub(1, std::memory_order_acq_rel) > 1)
+          return;
+
+        if(_pool) {
+          // images on a free list must not hold their pool, or it would never be freed
+          std::shared_ptr<ImagePool> pool;
+          pool.swap(_pool);
+          if(pool->put(this))
+            return;
+        }
+        delete this;
       }
 
 
@@ -0,0 +1,249 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+// ofx host
+#include "ofxhBinary.h"
+#include "ofxhImageEffect.h"
+#include "ofxhPluginAPICache.h"
+#include "ofxhPluginCache.h"
+#include "ofxhImageEffectAPI.h"
+#include "ofxhImageCache.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      ImageCacheKey::ImageCacheKey()
+        : instance(0)
+        , clip(0)
+        , time(0)
+        , stateHash(0)
+      {
+        renderScale.x = renderScale.y = 1.0;
+        bounds.x1 = bounds.y1 = bounds.x2 = bounds.y2 = 0;
+      }
+
+      ImageCacheKey::ImageCacheKey(const Instance &inst,
+                                   const ClipInstance &clipInstance,
+                                   OfxTime t,
+                                   OfxPointD scale,
+                                   const OfxRectI &b)
+        : instance(&inst)
+        , clip(&clipInstance)
+        , time(t)
+        , renderScale(scale)
+        , bounds(b)
+        , stateHash(inst.getStateGeneration())
+      {
+      }
+
+      bool ImageCacheKey::operator<(const ImageCacheKey &other) const
+      {
+        if(instance != other.instance) return std::less<const Instance *>()(instance, other.instance);
+        if(clip != other.clip) return std::less<const ClipInstance *>()(clip, other.clip);
+        if(stateHash != other.stateHash) return stateHash < other.stateHash;
+        if(time != other.time) return time < other.time;
+        if(renderScale.x != other.renderScale.x) return renderScale.x < other.renderScale.x;
+        if(renderScale.y != other.renderScale.y) return renderScale.y < other.renderScale.y;
+        if(bounds.x1 != other.bounds.x1) return bounds.x1 < other.bounds.x1;
+        if(bounds.y1 != other.bounds.y1) return bounds.y1 < other.bounds.y1;
+        if(bounds.x2 != other.bounds.x2) return bounds.x2 < other.bounds.x2;
+        return bounds.y2 < other.bounds.y2;
+      }
+
+      std::string ImageCacheKey::getUniqueIdentifier() const
+      {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "%p/%p/%llx/%.17g/%.17g,%.17g/%d,%d,%d,%d",
+                 (const void *) instance, (const void *) clip, stateHash, time,
+                 renderScale.x, renderScale.y, bounds.x1, bounds.y1, bounds.x2, bounds.y2);
+        return buf;
+      }
+
+      /// does the key want the same image as the other, bar the bounds
+      static bool sameButBounds(const ImageCacheKey &a, const ImageCacheKey &b)
+      {
+        return a.instance == b.instance && a.clip == b.clip && a.stateHash == b.stateHash && a.time == b.time &&
+          a.renderScale.x == b.renderScale.x && a.renderScale.y == b.renderScale.y;
+      }
+
+      /// does a hold all of b
+      static bool contains(const OfxRectI &a, const OfxRectI &b)
+      {
+        return a.x1 <= b.x1 && a.y1 <= b.y1 && a.x2 >= b.x2 && a.y2 >= b.y2;
+      }
+
+      ImageCacheStats::ImageCacheStats()
+        : hits(0)
+        , misses(0)
+        , insertions(0)
+        , evictions(0)
+        , purges(0)
+        , bytes(0)
+        , peakBytes(0)
+        , nImages(0)
+      {
+      }
+
+      ImageCache::ImageCache(size_t memoryBudget)
+        : _memoryBudget(memoryBudget)
+      {
+      }
+
+      ImageCache::~ImageCache()
+      {
+        purge();
+      }
+
+      size_t ImageCache::getMemoryBudget() const
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _memoryBudget;
+      }
+
+      void ImageCache::setMemoryBudget(size_t memoryBudget)
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _memoryBudget = memoryBudget;
+        evict();
+      }
+
+      size_t ImageCache::getImageBytes(const Image &image)
+      {
+        OfxRectI bounds = image.getBounds();
+        int rowBytes = image.getIntProperty(kOfxImagePropRowBytes);
+        return size_t(abs(rowBytes)) * size_t(std::max(0, bounds.y2 - bounds.y1));
+      }
+
+      void ImageCache::erase(EntryMap::iterator i)
+      {
+        EntryList::iterator entry = i->second;
+        _stats.bytes -= entry->bytes;
+        --_stats.nImages;
+        entry->image->releaseReference();
+        _entries.erase(entry);
+        _index.erase(i);
+      }
+
+      void ImageCache::evict()
+      {
+        while(_stats.bytes > _memoryBudget && !_entries.empty()) {
+          erase(_index.find(_entries.back().key));
+          ++_stats.evictions;
+        }
+      }
+
+      Image *ImageCache::find(const ImageCacheKey &key)
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        // the exact key, else the first of those that differ only by bounds that holds them
+        EntryMap::iterator found = _index.find(key);
+        if(found == _index.end()) {
+          ImageCacheKey first = key;
+          first.bounds.x1 = first.bounds.y1 = first.bounds.x2 = first.bounds.y2 = INT_MIN;
+          for(EntryMap::iterator i = _index.lower_bound(first); i != _index.end() && sameButBounds(i->first, key); ++i) {
+            if(contains(i->first.bounds, key.bounds)) {
+              found = i;
+              break;
+            }
+          }
+        }
+
+        if(found == _index.end()) {
+          ++_stats.misses;
+          return 0;
+        }
+
+        ++_stats.hits;
+        _entries.splice(_entries.begin(), _entries, found->second);
+        Image *image = found->second->image;
+        image->addReference();
+        return image;
+      }
+
+      void ImageCache::insert(const ImageCacheKey &key, Image *image)
+      {
+        if(!image)
+          return;
+        size_t bytes = getImageBytes(*image);
+
+        std::lock_guard<std::mutex> guard(_mutex);
+        if(bytes > _memoryBudget)
+          return;
+
+        EntryMap::iterator old = _index.find(key);
+        if(old != _index.end()) {
+          if(old->second->image == image) {
+            _entries.splice(_entries.begin(), _entries, old->second);
+            return;
+          }
+          erase(old);
+        }
+
+        image->addReference();
+        image->setStringProperty(kOfxImagePropUniqueIdentifier, key.getUniqueIdentifier());
+
+        Entry entry;
+        entry.key = key;
+        entry.image = image;
+        entry.bytes = bytes;
+        _entries.push_front(entry);
+        _index[key] = _entries.begin();
+
+        ++_stats.insertions;
+        ++_stats.nImages;
+        _stats.bytes += bytes;
+        _stats.peakBytes = std::max(_stats.peakBytes, _stats.bytes);
+        evict();
+      }
+
+      void ImageCache::purge(const Instance *instance)
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        ImageCacheKey first;
+        first.instance = instance;
+        EntryMap::iterator i = _index.lower_bound(first);
+        while(i != _index.end() && i->first.instance == instance) {
+          erase(i++);
+          ++_stats.purges;
+        }
+      }
+
+      void ImageCache::purge()
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _stats.purges += _index.size();
+        while(!_index.empty())
+          erase(_index.begin());
+      }
+
+      ImageCacheStats ImageCache::getStats() const
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _stats;
+      }
+
+      void ImageCache::resetStats()
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _stats.hits = _stats.misses = _stats.insertions = _stats.evictions = _stats.purges = 0;
+        _stats.peakBytes = _stats.bytes;
+      }
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
@@ -2,10 +2,14 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include <math.h>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 // ofx
 #include "ofxCore.h"
 #include "ofxImageEffect.h"
+#include "openfxParamBatch.h"
 
 // ofx host
 #include "ofxhBinary.h"
@@ -328,6 +332,168 @@ namespace OFX {
         Property::propSpecEnd
       };
 
+      /// in args of the begin and end sequence render actions, the enum gives the index of each
+      static const Property::PropSpec sequenceRenderInArgStuff[] = {
+        { kOfxImageEffectPropFrameRange, Property::eDouble, 2, true, "0" },
+        { kOfxImageEffectPropFrameStep, Property::eDouble, 1, true, "0" }, 
+        { kOfxPropIsInteractive, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
+        { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
+        Property::propSpecEnd
+      };
+      enum {eSeqArgFrameRange, eSeqArgFrameStep, eSeqArgIsInteractive, eSeqArgRenderScale, eSeqArgSequential, eSeqArgInteractiveRender};
+
+      /// in args of the render action, the enum gives the index of each
+      static const Property::PropSpec renderInArgStuff[] = {
+        { kOfxPropTime, Property::eDouble, 1, true, "0" },
+        { kOfxImageEffectPropFieldToRender, Property::eString, 1, true, "" }, 
+        { kOfxImageEffectPropRenderWindow, Property::eInt, 4, true, "0" },
+        { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
+        { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
+        { kOfxImageEffectPropRenderQualityDraft, Property::eInt, 1, true, "0" },
+        Property::propSpecEnd
+      };
+      enum {eRenderArgTime, eRenderArgField, eRenderArgWindow, eRenderArgRenderScale, eRenderArgSequential, eRenderArgInteractiveRender, eRenderArgDraft};
+
+      /// in args of the get regions of interest action, the enum gives the index of each
+      static const Property::PropSpec roiInArgStuff[] = {
+        { kOfxPropTime, Property::eDouble, 1, true, "0" },
+        { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
+        { kOfxImageEffectPropRegionOfInterest , Property::eDouble, 4, true, 0 },
+        Property::propSpecEnd
+      };
+      enum {eRoIArgTime, eRoIArgRenderScale, eRoIArgRegionOfInterest};
+
+      ActionArgs::ActionArgs(const Property::PropSpec *spec)
+        : _spec(spec)
+        , _inUse(false)
+      {
+        build();
+      }
+
+      void ActionArgs::build()
+      {
+        _set.reset(new Property::Set(_spec));
+        _props.clear();
+        for(const Property::PropSpec *spec = _spec; spec->name; ++spec)
+          _props.push_back(_set->fetchProperty(spec->name));
+      }
+
+      bool ActionArgs::tryAcquire()
+      {
+        if(_inUse.exchange(true, std::memory_order_acquire))
+          return false;
+        // custom args from the last call would otherwise be ignored by createProperty
+        // and passed again, so start afresh if there are any
+        if(_set->getProperties().size() != _props.size())
+          build();
+        return true;
+      }
+
+      /// Borrows an instance's cached ActionArgs for the length of an action. If another
+      /// thread is in the same action on the same instance, a private set is made instead.
+      class ActionArgsUse {
+        ActionArgs  *_cached;
+        ActionArgs  *_local;
+      public :
+        ActionArgsUse(ActionArgs *cached, const Property::PropSpec *spec)
+          : _cached(cached && cached->tryAcquire() ? cached : 0)
+          , _local(_cached ? 0 : new ActionArgs(spec))
+        {
+        }
+
+        ~ActionArgsUse()
+        {
+          if(_cached)
+            _cached->release();
+          delete _local;
+        }
+
+        ActionArgs &get() {return _cached ? *_cached : *_local;}
+      };
+
+      /// The results of the actions an instance caches, each kept by the arguments of the
+      /// action. All of them are for one state generation of the instance, and are thrown
+      /// away when it moves on.
+      struct Instance::ActionCache {
+        /// a map is emptied rather than let grow past this
+        static const size_t kMaxEntries = 1024;
+
+        typedef std::tuple<OfxTime, double, double> RoDKey;
+        typedef std::tuple<OfxTime, double, double, double, double, double, double> RoIKey;
+        typedef std::tuple<OfxTime, std::string, int, int, int, int, double, double> IdentityKey;
+
+        struct RoDResult {
+          OfxStatus stat;
+          OfxRectD  rod;
+        };
+
+        struct RoIResult {
+          OfxStatus stat;
+          std::map<ClipInstance *, OfxRectD> rois;
+        };
+
+        struct FramesResult {
+          OfxStatus stat;
+          RangeMap  ranges;
+        };
+
+        struct IdentityResult {
+          OfxStatus   stat;
+          OfxTime     time;
+          std::string clip;
+        };
+
+        std::mutex                          mutex;      ///< guards everything below
+        unsigned int                        generation; ///< the state generation the results are for
+        std::map<RoDKey, RoDResult>         rods;
+        std::map<RoIKey, RoIResult>         rois;
+        std::map<OfxTime, FramesResult>     frames;
+        std::map<IdentityKey, IdentityResult> identities;
+
+        explicit ActionCache(unsigned int current) : generation(current) {}
+
+        /// empty the maps if they are for an older generation, called with the mutex held
+        void sync(unsigned int current)
+        {
+          if(generation != current) {
+            rods.clear();
+            rois.clear();
+            frames.clear();
+            identities.clear();
+            generation = current;
+          }
+        }
+
+        /// look up a result of the current generation
+        template <class K, class V>
+        bool find(std::map<K, V> &results, const K &key, V &value, unsigned int current)
+        {
+          std::lock_guard<std::mutex> guard(mutex);
+          sync(current);
+          typename std::map<K, V>::const_iterator i = results.find(key);
+          if(i == results.end())
+            return false;
+          value = i->second;
+          return true;
+        }
+
+        /// keep a result, unless the state changed while the action was being called
+        template <class K, class V>
+        void store(std::map<K, V> &results, const K &key, const V &value, unsigned int startedAt, unsigned int current)
+        {
+          if(startedAt != current)
+            return;
+          std::lock_guard<std::mutex> guard(mutex);
+          sync(current);
+          if(results.size() >= kMaxEntries)
+            results.clear();
+          results[key] = value;
+        }
+      };
+
       Instance::Instance(ImageEffectPlugin* plugin,
                          Descriptor         &other,
                          const std::string  &context,
@@ -342,17 +508,24 @@ namespace OFX {
         , _continuousSamples(false)
         , _frameVarying(false)
         , _outputFrameRate(24)
+        , _beginRenderArgs(sequenceRenderInArgStuff)
+        , _renderArgs(renderInArgStuff)
+        , _endRenderArgs(sequenceRenderInArgStuff)
+        , _roiInArgs(roiInArgStuff)
+        , _roiOutArgs(0)
+        , _stateGeneration(0)
       {
         int i = 0;
         _properties.setChainedSet(&other.getProps());
 
+        _plugin->instanceCreated();
         _properties.setPointerProperty(kOfxImageEffectPropPluginHandle, _plugin->getPluginHandle()->getOfxPlugin());
 
         _properties.setStringProperty(kOfxImageEffectPropContext,context);
         _properties.setIntProperty(kOfxPropIsInteractive,interactive);
 
-        // copy is sequential over
-        bool sequential = other.getProps().getIntProperty(kOfxImageEffectInstancePropSequentialRender) != 0;
+        // copy is sequential over, keeping 2 for effects that would rather be rendered in order but need not be
+        int sequential = other.getProps().getIntProperty(kOfxImageEffectInstancePropSequentialRender);
         _properties.setIntProperty(kOfxImageEffectInstancePropSequentialRender,sequential);
 
         while(effectInstanceStuff[i].name) {
@@ -401,6 +574,27 @@ namespace OFX {
             _clips[name] = instance;
           }        
 
+        // make the out args for get regions of interest, with one RoI for each input clip
+        _roiOutNames.clear();
+        _roiOutClips.clear();
+        _roiOutSpec.clear();
+        for(std::map<std::string, ClipInstance*>::iterator it=_clips.begin();
+            it!=_clips.end();
+            ++it) {
+          if(!it->second->isOutput() ||
+             getContext() == kOfxImageEffectContextGenerator) {
+            _roiOutNames.push_back("OfxImageClipPropRoI_"+it->first);
+            _roiOutClips.push_back(it->second);
+          }
+        }
+        for(size_t i = 0; i < _roiOutNames.size(); ++i) {
+          Property::PropSpec spec = { _roiOutNames[i].c_str(), Property::eDouble, 4, false, "" };
+          _roiOutSpec.push_back(spec);
+        }
+        _roiOutSpec.push_back(Property::propSpecEnd);
+        delete _roiOutArgs;
+        _roiOutArgs = new ActionArgs(&_roiOutSpec[0]);
+
         const std::list<Param::Descriptor*>& map = _descriptor->getParamList();
 
         std::map<std::string,std::vector<Param::Instance*> > parameters;
@@ -476,71 +670,94 @@ namespace OFX {
         throw Property::Exception(kOfxStatErrMissingHostFeature);
       }
 
+      /// the properties served by the get hook, so it can switch on the name
+      enum InstanceHookEnum {
+        eInstanceHookProjectSize,
+        eInstanceHookProjectOffset,
+        eInstanceHookProjectExtent,
+        eInstanceHookProjectPixelAspectRatio,
+        eInstanceHookEffectDuration,
+        eInstanceHookFrameRate
+      };
+
+      static const Property::PropertyIdTable::Entry instanceHookNames[] = {
+        { kOfxImageEffectPropProjectSize, eInstanceHookProjectSize },
+        { kOfxImageEffectPropProjectOffset, eInstanceHookProjectOffset },
+        { kOfxImageEffectPropProjectExtent, eInstanceHookProjectExtent },
+        { kOfxImageEffectPropProjectPixelAspectRatio, eInstanceHookProjectPixelAspectRatio },
+        { kOfxImageEffectInstancePropEffectDuration, eInstanceHookEffectDuration },
+        { kOfxImageEffectPropFrameRate, eInstanceHookFrameRate },
+        { NULL, 0 }
+      };
+
+      /// which hooked property is name, -1 if none
+      static int findInstanceHook(const std::string &name)
+      {
+        static const Property::PropertyIdTable table(instanceHookNames);
+        return table.find(name);
+      }
+
       // get the virtuals for viewport size, pixel scale, background colour
       double Instance::getDoubleProperty(const std::string &name, int index) const
       {
-        if(name==kOfxImageEffectPropProjectSize){
+        double values[2];
+        switch (findInstanceHook(name)) {
+        case eInstanceHookProjectSize:
           if(index>=2) throw Property::Exception(kOfxStatErrBadIndex);
-          double values[2];
           getProjectSize(values[0],values[1]);
           return values[index];
-        }
-        else if(name==kOfxImageEffectPropProjectOffset){
+        case eInstanceHookProjectOffset:
           if(index>=2) throw Property::Exception(kOfxStatErrBadIndex);
-          double values[2];
           getProjectOffset(values[0],values[1]);
           return values[index];
-        }
-        else if(name==kOfxImageEffectPropProjectExtent){
+        case eInstanceHookProjectExtent:
           if(index>=2) throw Property::Exception(kOfxStatErrBadIndex);
-          double values[2];
           getProjectExtent(values[0],values[1]);
           return values[index];
-        }
-        else if(name==kOfxImageEffectPropProjectPixelAspectRatio){
+        case eInstanceHookProjectPixelAspectRatio:
           if(index>=1) throw Property::Exception(kOfxStatErrBadIndex);
           return getProjectPixelAspectRatio();
-        }
-        else if(name==kOfxImageEffectInstancePropEffectDuration){
+        case eInstanceHookEffectDuration:
           if(index>=1) throw Property::Exception(kOfxStatErrBadIndex);
           return getEffectDuration();
-        }
-        else if(name==kOfxImageEffectPropFrameRate){
+        case eInstanceHookFrameRate:
           if(index>=1) throw Property::Exception(kOfxStatErrBadIndex);
           return getFrameRate();
-        }
-        else
+        default:
           throw Property::Exception(kOfxStatErrUnknown);        
+        }
       }
 
       void Instance::getDoublePropertyN(const std::string &name, double* first, int n) const
       {
-        if(name==kOfxImageEffectPropProjectSize){
+        switch (findInstanceHook(name)) {
+        case eInstanceHookProjectSize:
           if(n>2) throw Property::Exception(kOfxStatErrBadIndex);
           getProjectSize(first[0],first[1]);
-        }
-        else if(name==kOfxImageEffectPropProjectOffset){
+          break;
+        case eInstanceHookProjectOffset:
           if(n>2) throw Property::Exception(kOfxStatErrBadIndex);
           getProjectOffset(first[0],first[1]);
-        }
-        else if(name==kOfxImageEffectPropProjectExtent){
+          break;
+        case eInstanceHookProjectExtent:
           if(n>2) throw Property::Exception(kOfxStatErrBadIndex);
           getProjectExtent(first[0],first[1]);
-        }
-        else if(name==kOfxImageEffectPropProjectPixelAspectRatio){
+          break;
+        case eInstanceHookProjectPixelAspectRatio:
           if(n>1) throw Property::Exception(kOfxStatErrBadIndex);
           *first = getProjectPixelAspectRatio();
-        }
-        else if(name==kOfxImageEffectInstancePropEffectDuration){
+          break;
+        case eInstanceHookEffectDuration:
           if(n>1) throw Property::Exception(kOfxStatErrBadIndex);
           *first = getEffectDuration();
-        }
-        else if(name==kOfxImageEffectPropFrameRate){
+          break;
+        case eInstanceHookFrameRate:
           if(n>1) throw Property::Exception(kOfxStatErrBadIndex);
           *first = getFrameRate();
-        }
-        else
+          break;
+        default:
           throw Property::Exception(kOfxStatErrUnknown);
+        }
       }
 
       Instance::~Instance(){
@@ -555,6 +772,10 @@ namespace OFX {
 #       endif
           (void)st;
         }
+
+        // our images in the host's cache may hold on to our clips
+        if(gImageEffectHost)
+          gImageEffectHost->getImageCache().purge(this);
         
         /// clobber my clips
         std::map<std::string, ClipInstance*>::iterator i;
@@ -563,6 +784,10 @@ namespace OFX {
             delete i->second;
           i->second = NULL;
         }
+
+        delete _roiOutArgs;
+
+        _plugin->instanceDestroyed();
       }
 
       /// this is used to populate with any extra action in argumnents that may be needed
@@ -727,6 +952,11 @@ namespace OFX {
           return kOfxStatFailed;
         }
 
+        // the host has changed it, or the plugin has through the suite, which bumped it already
+        if(why != kOfxChangePluginEdited)
+          param->bumpGeneration();
+        invalidateActionCache();
+
         Property::PropSpec stuff[] = {
           { kOfxPropType, Property::eString, 1, true, kOfxTypeParameter },
           { kOfxPropName, Property::eString, 1, true, paramName.c_str() },
@@ -759,6 +989,7 @@ namespace OFX {
                                                     OfxPointD   renderScale)
       {
         _clipPrefsDirty = true;
+        invalidateActionCache();
         std::map<std::string,ClipInstance*>::iterator it=_clips.find(clipName);
         if(it!=_clips.end())
           return (it->second)->instanceChangedAction(why,time,renderScale);
@@ -790,6 +1021,8 @@ namespace OFX {
 #       ifdef OFX_DEBUG_ACTIONS
           std::cout << "OFX: "<<(void*)this<<"->"<<kOfxActionPurgeCaches<<"()"<<std::endl;
 #       endif
+        if(gImageEffectHost)
+          gImageEffectHost->getImageCache().purge(this);
         OfxStatus st = mainEntry(kOfxActionPurgeCaches ,this->getHandle(),0,0);
 #       ifdef OFX_DEBUG_ACTIONS
           std::cout << "OFX: "<<(void*)this<<"->"<<kOfxActionPurgeCaches<<"()->"<<StatStr(st)<<std::endl;
@@ -877,30 +1110,22 @@ namespace OFX {
                                             bool     interactiveRender
                                             )
       {
-        Property::PropSpec stuff[] = {
-          { kOfxImageEffectPropFrameRange, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropFrameStep, Property::eDouble, 1, true, "0" }, 
-          { kOfxPropIsInteractive, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
-          Property::propSpecEnd
-        };
-
-        Property::Set inArgs(stuff);
+        ActionArgsUse use(&_beginRenderArgs, sequenceRenderInArgStuff);
+        ActionArgs &args = use.get();
+        Property::Set &inArgs = args.getSet();
 
         // set up second dimension for frame range and render scale
-        inArgs.setDoubleProperty(kOfxImageEffectPropFrameRange,startFrame, 0);
-        inArgs.setDoubleProperty(kOfxImageEffectPropFrameRange,endFrame, 1);
+        args.getDouble(eSeqArgFrameRange).setValue(startFrame, 0);
+        args.getDouble(eSeqArgFrameRange).setValue(endFrame, 1);
 
-        inArgs.setDoubleProperty(kOfxImageEffectPropFrameStep,step);
+        args.getDouble(eSeqArgFrameStep).setValue(step);
 
-        inArgs.setIntProperty(kOfxPropIsInteractive,interactive);
+        args.getInt(eSeqArgIsInteractive).setValue(interactive);
 
-        inArgs.setDoublePropertyN(kOfxImageEffectPropRenderScale, &renderScale.x, 2);
+        args.getDouble(eSeqArgRenderScale).setValueN(&renderScale.x, 2);
 
-        inArgs.setIntProperty(kOfxImageEffectPropSequentialRenderStatus,sequentialRender);
-        inArgs.setIntProperty(kOfxImageEffectPropInteractiveRenderStatus,interactiveRender);
+        args.getInt(eSeqArgSequential).setValue(sequentialRender);
+        args.getInt(eSeqArgInteractiveRender).setValue(interactiveRender);
 
 #       ifdef OFX_DEBUG_ACTIONS
           std::cout << "OFX: "<<(void*)this<<"->"<<kOfxImageEffectActionBeginSequenceRender<<"(("<<startFrame<<","<<endFrame<<"),"<<step<<","<<interactive<<",("<<renderScale.x<<","<<renderScale.y<<"),"<<sequentialRender<<","<<interactiveRender
@@ -924,26 +1149,17 @@ namespace OFX {
                                        bool     draftRender
                                        )
       {
-        static const Property::PropSpec inStuff[] = {
-          { kOfxPropTime, Property::eDouble, 1, true, "0" },
-          { kOfxImageEffectPropFieldToRender, Property::eString, 1, true, "" }, 
-          { kOfxImageEffectPropRenderWindow, Property::eInt, 4, true, "0" },
-          { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropRenderQualityDraft, Property::eInt, 1, true, "0" },
-          Property::propSpecEnd
-        };
-
-        Property::Set inArgs(inStuff);
+        ActionArgsUse use(&_renderArgs, renderInArgStuff);
+        ActionArgs &args = use.get();
+        Property::Set &inArgs = args.getSet();
         
-        inArgs.setStringProperty(kOfxImageEffectPropFieldToRender,field);
-        inArgs.setDoubleProperty(kOfxPropTime,time);
-        inArgs.setIntPropertyN(kOfxImageEffectPropRenderWindow, &renderRoI.x1, 4);
-        inArgs.setDoublePropertyN(kOfxImageEffectPropRenderScale, &renderScale.x, 2);
-        inArgs.setIntProperty(kOfxImageEffectPropSequentialRenderStatus,sequentialRender);
-        inArgs.setIntProperty(kOfxImageEffectPropInteractiveRenderStatus,interactiveRender);
-        inArgs.setIntProperty(kOfxImageEffectPropRenderQualityDraft,draftRender);
+        args.getString(eRenderArgField).setValue(field);
+        args.getDouble(eRenderArgTime).setValue(time);
+        args.getInt(eRenderArgWindow).setValueN(&renderRoI.x1, 4);
+        args.getDouble(eRenderArgRenderScale).setValueN(&renderScale.x, 2);
+        args.getInt(eRenderArgSequential).setValue(sequentialRender);
+        args.getInt(eRenderArgInteractiveRender).setValue(interactiveRender);
+        args.getInt(eRenderArgDraft).setValue(draftRender);
 
 #       ifdef OFX_DEBUG_ACTIONS
           std::cout << "OFX: "<<(void*)this<<"->"<<kOfxImageEffectActionRender<<"("<<time<<","<<field<<",("<<renderRoI.x1<<","<<renderRoI.y1<<","<<renderRoI.x2<<","<<renderRoI.y2<<"),("<<renderScale.x<<","<<renderScale.y<<"),"<<sequentialRender<<","<<interactiveRender
@@ -967,26 +1183,18 @@ namespace OFX {
                                           bool     interactiveRender
                                           )
       {
-        static const Property::PropSpec inStuff[] = {
-          { kOfxImageEffectPropFrameRange, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropFrameStep, Property::eDouble, 1, true, "0" }, 
-          { kOfxPropIsInteractive, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
-          { kOfxImageEffectPropSequentialRenderStatus, Property::eInt, 1, true, "0" },
-          { kOfxImageEffectPropInteractiveRenderStatus, Property::eInt, 1, true, "0" },
-          Property::propSpecEnd
-        };
+        ActionArgsUse use(&_endRenderArgs, sequenceRenderInArgStuff);
+        ActionArgs &args = use.get();
+        Property::Set &inArgs = args.getSet();
 
-        Property::Set inArgs(inStuff);
+        args.getDouble(eSeqArgFrameStep).setValue(step);
 
-        inArgs.setDoubleProperty(kOfxImageEffectPropFrameStep,step);
-
-        inArgs.setDoubleProperty(kOfxImageEffectPropFrameRange,startFrame, 0);
-        inArgs.setDoubleProperty(kOfxImageEffectPropFrameRange,endFrame, 1);
-        inArgs.setIntProperty(kOfxPropIsInteractive,interactive);
-        inArgs.setDoublePropertyN(kOfxImageEffectPropRenderScale, &renderScale.x, 2);
-        inArgs.setIntProperty(kOfxImageEffectPropSequentialRenderStatus,sequentialRender);
-        inArgs.setIntProperty(kOfxImageEffectPropInteractiveRenderStatus,interactiveRender);
+        args.getDouble(eSeqArgFrameRange).setValue(startFrame, 0);
+        args.getDouble(eSeqArgFrameRange).setValue(endFrame, 1);
+        args.getInt(eSeqArgIsInteractive).setValue(interactive);
+        args.getDouble(eSeqArgRenderScale).setValueN(&renderScale.x, 2);
+        args.getInt(eSeqArgSequential).setValue(sequentialRender);
+        args.getInt(eSeqArgInteractiveRender).setValue(interactiveRender);
 #       ifdef OFX_DEBUG_ACTIONS
           std::cout << "OFX: "<<(void*)this<<"->"<<kOfxImageEffectActionEndSequenceRender<<"(("<<startFrame<<","<<endFrame<<"),"<<step<<","<<interactive<<",("<<renderScale.x<<","<<renderScale.y<<"),"<<sequentialRender<<","<<interactiveRender
           <<")"<<std::endl;
@@ -1087,6 +1295,15 @@ namespace OFX {
                                                       OfxPointD   renderScale,
                                                       OfxRectD &rod)
       {
+        unsigned int generation = getStateGeneration();
+        ActionCache::RoDKey key(time, renderScale.x, renderScale.y);
+        ActionCache::RoDResult cached;
+        if(_actionCache && _actionCache->find(_actionCache->rods, key, cached, generation)) {
+          if(cached.stat == kOfxStatOK || cached.stat == kOfxStatReplyDefault)
+            rod = cached.rod;
+          return cached.stat;
+        }
+
         static const Property::PropSpec inStuff[] = {
           { kOfxPropTime, Property::eDouble, 1, true, "0" },
           { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
@@ -1126,6 +1343,12 @@ namespace OFX {
           }
           std::cout << std::endl;
 #       endif
+
+        if(_actionCache && (stat == kOfxStatOK || stat == kOfxStatReplyDefault)) {
+          cached.stat = stat;
+          cached.rod = rod;
+          _actionCache->store(_actionCache->rods, key, cached, generation, getStateGeneration());
+        }
           
         return stat;
       }
@@ -1136,6 +1359,14 @@ namespace OFX {
                                                     const OfxRectD &roi,
                                                     std::map<ClipInstance *, OfxRectD>& rois) 
       {
+        unsigned int generation = getStateGeneration();
+        ActionCache::RoIKey key(time, renderScale.x, renderScale.y, roi.x1, roi.y1, roi.x2, roi.y2);
+        ActionCache::RoIResult cached;
+        if(_actionCache && _actionCache->find(_actionCache->rois, key, cached, generation)) {
+          rois.swap(cached.rois);
+          return cached.stat;
+        }
+
         OfxStatus stat = kOfxStatReplyDefault;
 
         // reset the map
@@ -1159,38 +1390,21 @@ namespace OFX {
         }
         else {
           /// set up the in args 
-          static const Property::PropSpec inStuff[] = {
-            { kOfxPropTime, Property::eDouble, 1, true, "0" },
-            { kOfxImageEffectPropRenderScale, Property::eDouble, 2, true, "0" },
-            { kOfxImageEffectPropRegionOfInterest , Property::eDouble, 4, true, 0 },
-            Property::propSpecEnd
-          };
-          Property::Set inArgs(inStuff);
-
-          inArgs.setDoublePropertyN(kOfxImageEffectPropRenderScale, &renderScale.x, 2);
-          inArgs.setDoubleProperty(kOfxPropTime,time);
-          inArgs.setDoublePropertyN(kOfxImageEffectPropRegionOfInterest, &roi.x1, 4);
-
-          Property::Set outArgs;
-          for(std::map<std::string, ClipInstance*>::iterator it=_clips.begin();
-              it!=_clips.end();
-              ++it) {
-            if(!it->second->isOutput() ||
-               getContext() == kOfxImageEffectContextGenerator) {
-              Property::PropSpec s;
-              std::string name = "OfxImageClipPropRoI_"+it->first;
-            
-              s.name = name.c_str();
-              s.type = Property::eDouble;
-              s.dimension = 4;
-              s.readonly = false;
-              s.defaultValue = "";
-              outArgs.createProperty(s);
-            
-              /// initialise to the default
-              outArgs.setDoublePropertyN(s.name, &roi.x1, 4);
-            }
-          }
+          ActionArgsUse inUse(&_roiInArgs, roiInArgStuff);
+          ActionArgs &in = inUse.get();
+          Property::Set &inArgs = in.getSet();
+
+          in.getDouble(eRoIArgRenderScale).setValueN(&renderScale.x, 2);
+          in.getDouble(eRoIArgTime).setValue(time);
+          in.getDouble(eRoIArgRegionOfInterest).setValueN(&roi.x1, 4);
+
+          /// and the out args, with each clip's RoI initialised to the default
+          static const Property::PropSpec noStuff[] = { Property::propSpecEnd };
+          ActionArgsUse outUse(_roiOutArgs, _roiOutArgs ? &_roiOutSpec[0] : noStuff);
+          ActionArgs &out = outUse.get();
+          Property::Set &outArgs = out.getSet();
+          for(size_t i = 0; i < _roiOutClips.size(); ++i)
+            out.getDouble(int(i)).setValueN(&roi.x1, 4);
 
 #         ifdef OFX_DEBUG_ACTIONS
             std::cout << "OFX: "<<(void*)this<<"->"<<kOfxImageEffectActionGetRegionsOfInterest<<"("<<time<<",("<<renderScale.x<<","<<renderScale.y<<"),("<<roi.x1<<","<<roi.y1<<","<<roi.x2<<","<<roi.y2<<"))"<<std::endl;
@@ -1205,64 +1419,76 @@ namespace OFX {
             std::cout << "OFX: "<<(void*)this<<"->"<<kOfxImageEffectActionGetRegionsOfInterest<<"("<<time<<",("<<renderScale.x<<","<<renderScale.y<<"),("<<roi.x1<<","<<roi.y1<<","<<roi.x2<<","<<roi.y2<<"))->"<<StatStr(stat);
             if (stat == kOfxStatOK) {
                 std::cout << ": ";
-                for(std::map<std::string, ClipInstance*>::iterator it=_clips.begin();
-                    it!=_clips.end();
-                    ++it) {
-                    std::string name = "OfxImageClipPropRoI_"+it->first;
+                for(size_t i = 0; i < _roiOutClips.size(); ++i) {
                     OfxRectD thisRoi;
-                    thisRoi.x1 = outArgs.getDoubleProperty(name,0);
-                    thisRoi.y1 = outArgs.getDoubleProperty(name,1);
-                    thisRoi.x2 = outArgs.getDoubleProperty(name,2);
-                    thisRoi.y2 = outArgs.getDoubleProperty(name,3);
-                    std::cout << it->first << "->("<<thisRoi.x1<<","<<thisRoi.y1<<","<<thisRoi.x2<<","<<thisRoi.y2<<") ";
+                    out.getDouble(int(i)).getValueN(&thisRoi.x1, 4);
+                    std::cout << _roiOutClips[i]->getName() << "->("<<thisRoi.x1<<","<<thisRoi.y1<<","<<thisRoi.x2<<","<<thisRoi.y2<<") ";
                 }
             }
             std::cout << std::endl;
 #           endif
           /// set the thing up
-          for(std::map<std::string, ClipInstance*>::iterator it=_clips.begin();
-              it!=_clips.end();
-              ++it) {
-              if(!it->second->isOutput() ||
-               getContext() == kOfxImageEffectContextGenerator) {
-                if (it->second->isOutput() || it->second->getConnected()) { // needed to be able to fetch the RoD
+          for(size_t i = 0; i < _roiOutClips.size(); ++i) {
+            ClipInstance *clip = _roiOutClips[i];
+            if (clip->isOutput() || clip->getConnected()) { // needed to be able to fetch the RoD
                   
-                  if(it->second->supportsTiles()) {
-                    std::string name = "OfxImageClipPropRoI_"+it->first;
-                    OfxRectD thisRoi;
-                    thisRoi.x1 = outArgs.getDoubleProperty(name,0);
-                    thisRoi.y1 = outArgs.getDoubleProperty(name,1);
-                    thisRoi.x2 = outArgs.getDoubleProperty(name,2);
-                    thisRoi.y2 = outArgs.getDoubleProperty(name,3);
+              if(clip->supportsTiles()) {
+                OfxRectD thisRoi;
+                out.getDouble(int(i)).getValueN(&thisRoi.x1, 4);
                   
-                    // and DON'T clamp it to the clip's rod
-                    // We cannot clip it against the RoD because the RoI may be used for frames
-                    // at different a time or view than the current time and view passed to this action
-                    // which would result in a wrong clipping. Unfortunately only the implementation of
-                    // the host can do the correct clipping.
-                    //thisRoi = Clamp(thisRoi, rod);
-                    rois[it->second] = thisRoi;
-                  }
-                  else {
-                    /// not supporting tiles on this input, so set it to the rod
-                    OfxRectD rod = it->second->getRegionOfDefinition(time
-                                                                       );
-                    rois[it->second] = rod;
-                  }
-                }
+                // and DON'T clamp it to the clip's rod
+                // We cannot clip it against the RoD because the RoI may be used for frames
+                // at different a time or view than the current time and view passed to this action
+                // which would result in a wrong clipping. Unfortunately only the implementation of
+                // the host can do the correct clipping.
+                //thisRoi = Clamp(thisRoi, rod);
+                rois[clip] = thisRoi;
+              }
+              else {
+                /// not supporting tiles on this input, so set it to the rod
+                OfxRectD rod = clip->getRegionOfDefinition(time
+                                                           );
+                rois[clip] = rod;
               }
             }
+          }
+        }
+
+        if(_actionCache && (stat == kOfxStatOK || stat == kOfxStatReplyDefault)) {
+          cached.stat = stat;
+          cached.rois = rois;
+          _actionCache->store(_actionCache->rois, key, cached, generation, getStateGeneration());
         }
   
         return stat;
       }
         
 
+      /// add the ranges of each clip in from to those in to
+      static void appendRanges(const RangeMap &from, RangeMap &to)
+      {
+        for(RangeMap::const_iterator i = from.begin(); i != from.end(); ++i) {
+          std::vector<OfxRangeD> &ranges = to[i->first];
+          ranges.insert(ranges.end(), i->second.begin(), i->second.end());
+        }
+      }
+
       ////////////////////////////////////////////////////////////////////////////////
       /// see how many frames are needed from each clip to render the indicated frame
       OfxStatus Instance::getFrameNeededAction(OfxTime time, 
                                                RangeMap &rangeMap)
       {
+        unsigned int generation = getStateGeneration();
+        ActionCache::FramesResult cached;
+        if(_actionCache && _actionCache->find(_actionCache->frames, time, cached, generation)) {
+          appendRanges(cached.ranges, rangeMap);
+          return cached.stat;
+        }
+
+        // with caching on, the ranges of this call are gathered separately so they can be kept
+        RangeMap fresh;
+        RangeMap &ranges = _actionCache ? fresh : rangeMap;
+
         OfxStatus stat = kOfxStatReplyDefault;
         Property::Set outArgs;
       
@@ -1343,7 +1569,7 @@ namespace OFX {
           
           if(!clip->isOutput()) {
             if(stat != kOfxStatOK) {
-              rangeMap[clip].push_back(defaultRange);
+              ranges[clip].push_back(defaultRange);
             }
             else {
               std::string name = "OfxImageClipPropFrameRange_"+it->first;
@@ -1353,7 +1579,7 @@ namespace OFX {
                 return kOfxStatFailed; // bad! needs to be divisible by 2
 
               if(nRanges == 0) {
-                rangeMap[clip].push_back(defaultRange);
+                ranges[clip].push_back(defaultRange);
               }
               else {
                 for(int r=0;r<nRanges;){
@@ -1364,13 +1590,22 @@ namespace OFX {
                   OfxRangeD range;
                   range.min = min;
                   range.max = max;
-                  rangeMap[clip].push_back(range);
+                  ranges[clip].push_back(range);
                 }
               }
             }
           }
         }
 
+        if(_actionCache) {
+          if(stat == kOfxStatOK || stat == kOfxStatReplyDefault) {
+            cached.stat = stat;
+            cached.ranges = fresh;
+            _actionCache->store(_actionCache->frames, time, cached, generation, getStateGeneration());
+          }
+          appendRanges(fresh, rangeMap);
+        }
+
         return stat;
       }
 
@@ -1380,6 +1615,17 @@ namespace OFX {
                                            OfxPointD   renderScale,
                                            std::string &clip)
       {
+        unsigned int generation = getStateGeneration();
+        ActionCache::IdentityKey key(time, field, renderRoI.x1, renderRoI.y1, renderRoI.x2, renderRoI.y2, renderScale.x, renderScale.y);
+        ActionCache::IdentityResult cached;
+        if(_actionCache && _actionCache->find(_actionCache->identities, key, cached, generation)) {
+          if(cached.stat == kOfxStatOK) {
+            time = cached.time;
+            clip = cached.clip;
+          }
+          return cached.stat;
+        }
+
         static const Property::PropSpec inStuff[] = {
           { kOfxPropTime, Property::eDouble, 1, true, "0" },
           { kOfxImageEffectPropFieldToRender, Property::eString, 1, true, "" }, 
@@ -1425,6 +1671,13 @@ namespace OFX {
           time = outArgs.getDoubleProperty(kOfxPropTime);
           clip = outArgs.getStringProperty(kOfxPropName);        
         }
+
+        if(_actionCache && (st == kOfxStatOK || st == kOfxStatReplyDefault)) {
+          cached.stat = st;
+          cached.time = time;
+          cached.clip = clip;
+          _actionCache->store(_actionCache->identities, key, cached, generation, getStateGeneration());
+        }
         
         return st;
       }
@@ -1742,6 +1995,9 @@ namespace OFX {
 
         _clipPrefsDirty  = false;
 
+        // the clips may now have different depths, components or aspect ratios
+        invalidateActionCache();
+
         return true;
       }
 
@@ -1850,9 +2106,23 @@ namespace OFX {
       }
 
       
+      void Instance::setActionCaching(bool on)
+      {
+        if(!on)
+          _actionCache.reset();
+        else if(!_actionCache)
+          _actionCache.reset(new ActionCache(getStateGeneration()));
+      }
+
+      void Instance::invalidateActionCache()
+      {
+        ++_stateGeneration;
+      }
+
       /// implemented for Param::SetInstance
       void Instance::paramChangedByPlugin(Param::Instance *param)
       {
+        invalidateActionCache();
         if (!_created) {
           // setValue() was probably called from kOfxActionCreateInstance 
           // this is legal according to http://openfx.sourceforge.net/Documentation/1.3/ofxProgrammingReference.html#SettingParams
@@ -2524,7 +2794,6 @@ namespace OFX {
       };
 
       ////////////////////////////////////////////////////////////////////////////////
-#ifdef OFX_SUPPORTS_MULTITHREAD
       // Forward all multithread suite calls to the host implementation.
  
       static OfxStatus multiThread(OfxThreadFunctionV1 func,
@@ -2568,75 +2837,6 @@ namespace OFX {
       static OfxStatus mutexTryLock(const OfxMutexHandle mutex){
         return gImageEffectHost->mutexTryLock(mutex);
       }
-#else // !OFX_SUPPORTS_MULTITHREAD
-      /// a simple multithread suite
-      static OfxStatus multiThread(OfxThreadFunctionV1 func,
-                                   unsigned int /*nThreads*/,
-                                   void *customArg)
-      {
-        if (!func)
-          return kOfxStatFailed;
-        func(0,1,customArg);
-        return kOfxStatOK;
-      }
-
-      static OfxStatus multiThreadNumCPUs(unsigned int *nCPUs)
-      {
-        if (!nCPUs)
-          return kOfxStatFailed;
-        *nCPUs = 1;
-        return kOfxStatOK;
-      }
-
-      static OfxStatus multiThreadIndex(unsigned int *threadIndex){
-        if (!threadIndex)
-          return kOfxStatFailed;
-        *threadIndex = 0;
-        return kOfxStatOK;
-      }
-
-      static int multiThreadIsSpawnedThread(void){
-        return false;
-      }
-
-      static OfxStatus mutexCreate(OfxMutexHandle *mutex, int /*lockCount*/)
-      {
-        if (!mutex)
-          return kOfxStatFailed;
-        // do nothing single threaded
-        *mutex = 0;
-        return kOfxStatOK;
-      }
-
-      static OfxStatus mutexDestroy(const OfxMutexHandle mutex)
-      {
-        if (mutex != 0)
-          return kOfxStatErrBadHandle;
-        // do nothing single threaded
-        return kOfxStatOK;
-      }
-
-      static OfxStatus mutexLock(const OfxMutexHandle mutex){
-        if (mutex != 0)
-          return kOfxStatErrBadHandle;
-        // do nothing single threaded
-        return kOfxStatOK;
-      }
-       
-      static OfxStatus mutexUnLock(const OfxMutexHandle mutex){
-        if (mutex != 0)
-          return kOfxStatErrBadHandle;
-        // do nothing single threaded
-        return kOfxStatOK;
-      }       
-
-      static OfxStatus mutexTryLock(const OfxMutexHandle mutex){
-        if (mutex != 0)
-          return kOfxStatErrBadHandle;
-        // do nothing single threaded
-        return kOfxStatOK;
-      }
-#endif // !OFX_SUPPORTS_MULTITHREAD
        
       static const struct OfxMultiThreadSuiteV1 gMultiThreadSuite = {
         multiThread,
@@ -2731,6 +2931,83 @@ namespace OFX {
         return 0;
       }
 
+      OfxStatus Host::multiThread(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg)
+      {
+        return _threadPool.multiThread(func, nThreads, customArg);
+      }
+
+      OfxStatus Host::multiThreadNumCPUS(unsigned int *nCPUs) const
+      {
+        if (!nCPUs)
+          return kOfxStatFailed;
+        *nCPUs = _threadPool.getNumCPUs();
+        return kOfxStatOK;
+      }
+
+      OfxStatus Host::multiThreadIndex(unsigned int *threadIndex) const
+      {
+        if (!threadIndex)
+          return kOfxStatFailed;
+        *threadIndex = MultiThread::ThreadPool::threadIndex();
+        return kOfxStatOK;
+      }
+
+      int Host::multiThreadIsSpawnedThread() const
+      {
+        return MultiThread::ThreadPool::isSpawnedThread() ? 1 : 0;
+      }
+
+      OfxStatus Host::mutexCreate(OfxMutexHandle *mutex, int lockCount)
+      {
+        if (!mutex)
+          return kOfxStatFailed;
+        *mutex = reinterpret_cast<OfxMutexHandle>(new MultiThread::Mutex(lockCount));
+        return kOfxStatOK;
+      }
+
+      /// turn a mutex handle back into a mutex, null if it is bad
+      static MultiThread::Mutex *mutexFromHandle(const OfxMutexHandle handle)
+      {
+        MultiThread::Mutex *mutex = reinterpret_cast<MultiThread::Mutex *>(handle);
+        if (!mutex || !mutex->verifyMagic())
+          return 0;
+        return mutex;
+      }
+
+      OfxStatus Host::mutexDestroy(const OfxMutexHandle handle)
+      {
+        MultiThread::Mutex *mutex = mutexFromHandle(handle);
+        if (!mutex)
+          return kOfxStatErrBadHandle;
+        delete mutex;
+        return kOfxStatOK;
+      }
+
+      OfxStatus Host::mutexLock(const OfxMutexHandle handle)
+      {
+        MultiThread::Mutex *mutex = mutexFromHandle(handle);
+        if (!mutex)
+          return kOfxStatErrBadHandle;
+        mutex->lock();
+        return kOfxStatOK;
+      }
+
+      OfxStatus Host::mutexUnLock(const OfxMutexHandle handle)
+      {
+        MultiThread::Mutex *mutex = mutexFromHandle(handle);
+        if (!mutex)
+          return kOfxStatErrBadHandle;
+        return mutex->unlock() ? kOfxStatOK : kOfxStatFailed;
+      }
+
+      OfxStatus Host::mutexTryLock(const OfxMutexHandle handle)
+      {
+        MultiThread::Mutex *mutex = mutexFromHandle(handle);
+        if (!mutex)
+          return kOfxStatErrBadHandle;
+        return mutex->tryLock() ? kOfxStatOK : kOfxStatFailed;
+      }
+
       // return an memory::instance calls makeMemoryInstance that can be overridden
       Memory::Instance* Host::imageMemoryAlloc(size_t nBytes){
         Memory::Instance* instance = newMemoryInstance(nBytes);
@@ -2755,6 +3032,9 @@ namespace OFX {
         else if (strcmp(suiteName, kOfxParameterSuite)==0) {
           return Param::GetSuite(suiteVersion);
         }
+        else if (strcmp(suiteName, kOpenFXParameterBatchSuite)==0) {
+          return Param::GetBatchSuite(suiteVersion);
+        }
         else if (strcmp(suiteName, kOfxMessageSuite)==0) {
           // version 2 is backward-compatible
           if(suiteVersion==1 || suiteVersion==2)
@@ -42,6 +42,9 @@ namespace OFX {
         , _pc(pc)
         , _baseDescriptor(NULL)
         , _madeKnownContexts(false)
+        , _nInstances(0)
+        , _lastUsed(std::chrono::steady_clock::now().time_since_epoch().count())
+        , _cacheBlobPending(false)
       {
         _baseDescriptor = gImageEffectHost->makeDescriptor(this);
       }
@@ -59,6 +62,9 @@ namespace OFX {
         , _pc(pc)
         , _baseDescriptor(NULL) 
         , _madeKnownContexts(false)
+        , _nInstances(0)
+        , _lastUsed(std::chrono::steady_clock::now().time_since_epoch().count())
+        , _cacheBlobPending(false)
       {        
         _baseDescriptor = gImageEffectHost->makeDescriptor(this);
       }
@@ -95,14 +101,44 @@ namespace OFX {
 
       /// get the image effect descriptor
       Descriptor &ImageEffectPlugin::getDescriptor() {
+        if (_cacheBlobPending) {
+          decodeCacheBlob();
+        }
         return *_baseDescriptor;
       }
 
       /// get the image effect descriptor const version
       const Descriptor &ImageEffectPlugin::getDescriptor() const {
+        if (_cacheBlobPending) {
+          decodeCacheBlob();
+        }
         return *_baseDescriptor;
       }
 
+      void ImageEffectPlugin::decodeCacheBlob() const
+      {
+        // another thread may have decoded it while we waited for the lock
+        std::lock_guard<std::mutex> guard(_cacheBlobMutex);
+        if (_cacheBlob.isEmpty()) {
+          return;
+        }
+
+        BinaryCache::Reader r(_cacheBlob);
+        if (!APICache::propertySetBinaryRead(r, _baseDescriptor->getProps())) {
+          std::cerr << "corrupt binary cache entry for plugin " << getIdentifier() << std::endl;
+        }
+        // done with it, this also lets go of the cache file once the last plugin is decoded
+        _cacheBlob.clear();
+        _cacheBlobPending = false;
+      }
+
+      void ImageEffectPlugin::setCacheBlob(const BinaryCache::Blob &blob)
+      {
+        std::lock_guard<std::mutex> guard(_cacheBlobMutex);
+        _cacheBlob = blob;
+        _cacheBlobPending = !_cacheBlob.isEmpty();
+      }
+
       void ImageEffectPlugin::addContext(const std::string &context, std::unique_ptr<Descriptor> ied)
       {
         _contexts[context] = std::move(ied);
@@ -127,6 +163,18 @@ namespace OFX {
         APICache::propertySetXMLWrite(os, getDescriptor().getProps(), 6);
       }
 
+      void ImageEffectPlugin::saveBinary(BinaryCache::Writer &w) const
+      {
+        std::lock_guard<std::mutex> guard(_cacheBlobMutex);
+        if (!_cacheBlob.isEmpty()) {
+          // never looked at since it was read, so copy it over as it is
+          w.putRaw(_cacheBlob.data, _cacheBlob.size);
+        }
+        else {
+          APICache::propertySetBinaryWrite(w, _baseDescriptor->getProps());
+        }
+      }
+
       const std::set<std::string> &ImageEffectPlugin::getContexts() const {
         if (_madeKnownContexts) {
           return _knownContexts;
@@ -144,7 +192,9 @@ namespace OFX {
 
       PluginHandle *ImageEffectPlugin::getPluginHandle() 
       {
+        std::lock_guard<std::recursive_mutex> guard(_loadMutex);
         if(!_pluginHandle) {
+          _lastUsed = std::chrono::steady_clock::now().time_since_epoch().count();
           _pluginHandle.reset(new OFX::Host::PluginHandle(this, _pc.getHost())); 
           
           OfxPlugin *op = _pluginHandle->getOfxPlugin();
@@ -191,6 +241,7 @@ namespace OFX {
 
       Descriptor *ImageEffectPlugin::getContext(const std::string &context) 
       {
+        std::lock_guard<std::recursive_mutex> guard(_loadMutex);
         std::map<std::string, std::unique_ptr<Descriptor>>::iterator it = _contexts.find(context);
 
         if (it != _contexts.end()) {
@@ -198,7 +249,9 @@ namespace OFX {
           return it->second.get();
         }
 
-        if (_knownContexts.find(context) == _knownContexts.end()) {
+        // go through getContexts(), as with a descriptor from the cache _knownContexts is only filled in on demand
+        const std::set<std::string> &contexts = getContexts();
+        if (contexts.find(context) == contexts.end()) {
           return nullptr;
         }
 
@@ -239,6 +292,8 @@ namespace OFX {
         /// (not because we are expecting the results to change, but because plugin
         /// might get confused otherwise), then a describe_in_context
 
+        // held until the instance has counted itself in, so unloadIfIdle cannot get in between
+        std::lock_guard<std::recursive_mutex> guard(_loadMutex);
         getPluginHandle();
 
         Descriptor *desc = getContext(context);
@@ -270,6 +325,38 @@ namespace OFX {
         }
       }
 
+      void ImageEffectPlugin::instanceCreated()
+      {
+        std::lock_guard<std::recursive_mutex> guard(_loadMutex);
+        ++_nInstances;
+      }
+
+      void ImageEffectPlugin::instanceDestroyed()
+      {
+        std::lock_guard<std::recursive_mutex> guard(_loadMutex);
+        if (--_nInstances == 0) {
+          _lastUsed = std::chrono::steady_clock::now().time_since_epoch().count();
+        }
+      }
+
+      bool ImageEffectPlugin::unloadIfIdle(double idleSeconds)
+      {
+        std::lock_guard<std::recursive_mutex> guard(_loadMutex);
+        if (!_pluginHandle || _nInstances > 0) {
+          return false;
+        }
+
+        std::chrono::steady_clock::duration idle = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::steady_clock::duration(_lastUsed);
+        if (std::chrono::duration<double>(idle).count() < idleSeconds) {
+          return false;
+        }
+
+        unload();
+        _pluginHandle.reset();
+        _contexts.clear();
+        return true;
+      }
+
       PluginCache::PluginCache(OFX::Host::ImageEffect::Host &host) 
         : PluginAPICacheI(kOfxImageEffectPluginApi, 1, 1)
         , _currentPlugin(0)
@@ -514,6 +601,24 @@ namespace OFX {
         }
       }
 
+      bool PluginCache::saveBinary(Plugin *ip, BinaryCache::Writer &w) const {
+        ImageEffectPlugin *p = dynamic_cast<ImageEffectPlugin*>(ip);
+        if (!p) {
+          return false;
+        }
+        p->saveBinary(w);
+        return true;
+      }
+
+      bool PluginCache::loadBinary(Plugin *ip, const BinaryCache::Blob &blob) {
+        ImageEffectPlugin *p = dynamic_cast<ImageEffectPlugin*>(ip);
+        if (!p) {
+          return false;
+        }
+        p->setCacheBlob(blob);
+        return true;
+      }
+
       void PluginCache::confirmPlugin(Plugin *p) {
         ImageEffectPlugin *plugin = dynamic_cast<ImageEffectPlugin*>(p);
         if (!plugin) {
@@ -562,6 +667,17 @@ namespace OFX {
         return plugin;
       }
 
+      int PluginCache::unloadIdlePlugins(double idleSeconds)
+      {
+        int nUnloaded = 0;
+        for (std::vector<ImageEffectPlugin *>::iterator i = _plugins.begin(); i != _plugins.end(); ++i) {
+          if ((*i)->unloadIfIdle(idleSeconds)) {
+            ++nUnloaded;
+          }
+        }
+        return nUnloaded;
+      }
+
       void PluginCache::dumpToStdOut()
       {
         if (_pluginsByID.empty())
@@ -1,7 +1,7 @@
 // Copyright OpenFX and contributors to the OpenFX project.
 // SPDX-License-Identifier: BSD-3-Clause
 
-// ofx host
+#include <new>
 
 // ofx
 #include "ofxCore.h"
@@ -16,17 +16,174 @@ namespace OFX {
 
     namespace Memory {
 
-      Instance::Instance() : _ptr(0), _locked(0) {}
+      ////////////////////////////////////////////////////////////////////////////////
+      // Pool
+
+      static void *systemAlloc(size_t nBytes)
+      {
+        return ::operator new(nBytes, std::align_val_t(kPoolAlignment));
+      }
+
+      static void systemFree(void *ptr)
+      {
+        ::operator delete(ptr, std::align_val_t(kPoolAlignment));
+      }
+
+      Pool::Pool(size_t budget)
+        : _budget(budget)
+        , _stamp(0)
+      {
+        _stats.hits = _stats.misses = _stats.evictions = 0;
+        _stats.liveBytes = _stats.cachedBytes = _stats.peakBytes = 0;
+      }
+
+      Pool::~Pool()
+      {
+        purge();
+      }
+
+      Pool &Pool::getDefault()
+      {
+        // never deleted, so Instances destroyed during static destruction can still release into it
+        static Pool *gPool = new Pool(size_t(256) * 1024 * 1024);
+        return *gPool;
+      }
+
+      size_t Pool::sizeClass(size_t nBytes)
+      {
+        if(nBytes <= kPoolAlignment)
+          return kPoolAlignment;
+
+        // find the power of two below nBytes and step up from it in quarters
+        size_t pow2 = 1;
+        while(pow2 <= (nBytes - 1) / 2)
+          pow2 *= 2;
+        size_t step = pow2 / 4;
+        if(step < kPoolAlignment)
+          step = kPoolAlignment;
+
+        size_t size = ((nBytes + step - 1) / step) * step;
+        if(size < nBytes)
+          throw std::bad_alloc();
+        return size;
+      }
+
+      void *Pool::allocate(size_t nBytes, size_t &blockSize)
+      {
+        blockSize = sizeClass(nBytes);
+        {
+          std::lock_guard<std::mutex> guard(_mutex);
+          FreeLists::iterator i = _free.find(blockSize);
+          if(i != _free.end() && !i->second.empty()) {
+            void *ptr = i->second.back().ptr;
+            i->second.pop_back();
+            _stats.cachedBytes -= blockSize;
+            _stats.liveBytes += blockSize;
+            ++_stats.hits;
+            return ptr;
+          }
+          ++_stats.misses;
+        }
+
+        // go to the system outside the lock, it can be slow
+        void *ptr = systemAlloc(blockSize);
+
+        std::lock_guard<std::mutex> guard(_mutex);
+        _stats.liveBytes += blockSize;
+        if(_stats.liveBytes + _stats.cachedBytes > _stats.peakBytes)
+          _stats.peakBytes = _stats.liveBytes + _stats.cachedBytes;
+        return ptr;
+      }
+
+      void Pool::release(void *ptr, size_t blockSize)
+      {
+        if(!ptr)
+          return;
+
+        std::lock_guard<std::mutex> guard(_mutex);
+        _stats.liveBytes -= blockSize;
+        if(blockSize > _budget) {
+          // would never fit, don't bother evicting everything else for it
+          ++_stats.evictions;
+          systemFree(ptr);
+          return;
+        }
+
+        FreeBlock block;
+        block.ptr = ptr;
+        block.stamp = _stamp++;
+        _free[blockSize].push_back(block);
+        _stats.cachedBytes += blockSize;
+        trimToBudget(_budget);
+      }
+
+      void Pool::trimToBudget(size_t budget)
+      {
+        while(_stats.cachedBytes > budget) {
+          // the oldest block of each class is at the front of its list, find the oldest of those
+          FreeLists::iterator oldest = _free.end();
+          for(FreeLists::iterator i = _free.begin(); i != _free.end(); ++i) {
+            if(!i->second.empty() && (oldest == _free.end() || i->second.front().stamp < oldest->second.front().stamp))
+              oldest = i;
+          }
+          if(oldest == _free.end())
+            break;
+
+          systemFree(oldest->second.front().ptr);
+          oldest->second.pop_front();
+          _stats.cachedBytes -= oldest->first;
+          ++_stats.evictions;
+          if(oldest->second.empty())
+            _free.erase(oldest);
+        }
+      }
+
+      void Pool::setBudget(size_t budget)
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _budget = budget;
+        trimToBudget(_budget);
+      }
+
+      size_t Pool::getBudget() const
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _budget;
+      }
+
+      void Pool::purge()
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        trimToBudget(0);
+      }
+
+      Pool::Stats Pool::getStats() const
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _stats;
+      }
+
+      void Pool::resetStats()
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _stats.hits = _stats.misses = _stats.evictions = 0;
+        _stats.peakBytes = _stats.liveBytes + _stats.cachedBytes;
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // Instance
+
+      Instance::Instance() : _ptr(0), _size(0), _locked(0) {}
 
       Instance::~Instance() {
-        delete [] _ptr;
+        Pool::getDefault().release(_ptr, _size);
       }
 
       bool Instance::alloc(size_t nBytes) {
         if(!_locked){
           if(_ptr)
             freeMem();
-          _ptr = new char[nBytes];
+          _ptr = static_cast<char *>(Pool::getDefault().allocate(nBytes, _size));
           return true;
         }
         else
@@ -38,8 +195,9 @@ namespace OFX {
       }
 
       void Instance::freeMem(){
-        delete [] _ptr;
+        Pool::getDefault().release(_ptr, _size);
         _ptr = 0;
+        _size = 0;
         _locked = 0;
       }
 
@@ -62,4 +220,3 @@ namespace OFX {
   } // Host
 
 } // OFX
-
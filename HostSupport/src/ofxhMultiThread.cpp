@@ -0,0 +1,250 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <atomic>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxMultiThread.h"
+
+// ofx host
+#include "ofxhMultiThread.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace MultiThread {
+
+      /// is the current thread running a thread function
+      static thread_local bool tIsSpawned = false;
+
+      /// index of the thread function the current thread is running
+      static thread_local unsigned int tThreadIndex = 0;
+
+      /// sets the thread locals for the duration of a thread function, and restores them after
+      class SpawnedScope {
+        bool         _wasSpawned;
+        unsigned int _oldIndex;
+      public :
+        SpawnedScope() : _wasSpawned(tIsSpawned), _oldIndex(tThreadIndex) { tIsSpawned = true; }
+        ~SpawnedScope() { tIsSpawned = _wasSpawned; tThreadIndex = _oldIndex; }
+      };
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // Mutex
+
+      Mutex::Mutex(int lockCount)
+        : _magic(kMagic)
+        , _owner()
+        , _lockCount(lockCount > 0 ? lockCount : 0)
+      {
+        if(_lockCount > 0)
+          _owner = std::this_thread::get_id();
+      }
+
+      Mutex::~Mutex()
+      {
+      }
+
+      void Mutex::lock()
+      {
+        std::thread::id me = std::this_thread::get_id();
+        std::unique_lock<std::mutex> guard(_mutex);
+        if(_lockCount > 0 && _owner == me) {
+          ++_lockCount;
+          return;
+        }
+        while(_lockCount > 0)
+          _released.wait(guard);
+        _owner = me;
+        _lockCount = 1;
+      }
+
+      bool Mutex::tryLock()
+      {
+        std::thread::id me = std::this_thread::get_id();
+        std::lock_guard<std::mutex> guard(_mutex);
+        if(_lockCount > 0 && _owner != me)
+          return false;
+        _owner = me;
+        ++_lockCount;
+        return true;
+      }
+
+      bool Mutex::unlock()
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if(_lockCount == 0 || _owner != std::this_thread::get_id())
+          return false;
+        if(--_lockCount == 0) {
+          _owner = std::thread::id();
+          _released.notify_one();
+        }
+        return true;
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // ThreadPool
+
+      /// one call to multiThread, shared between the threads working on it
+      struct ThreadPool::Job {
+        OfxThreadFunctionV1      *func;
+        void                     *customArg;
+        unsigned int              nThreads;
+        std::atomic<unsigned int> next;      ///< next index to hand out
+        std::atomic<unsigned int> remaining; ///< indices that have not returned yet
+        std::atomic<bool>         failed;    ///< did a thread function throw
+        std::mutex                doneMutex;
+        std::condition_variable   done;      ///< signalled when remaining hits zero
+
+        Job(OfxThreadFunctionV1 *f, unsigned int n, void *arg)
+          : func(f)
+          , customArg(arg)
+          , nThreads(n)
+          , next(0)
+          , remaining(n)
+          , failed(false)
+        {
+        }
+      };
+
+      ThreadPool::ThreadPool(unsigned int nCPUs)
+        : _nCPUs(nCPUs)
+        , _generation(0)
+        , _quit(false)
+      {
+        if(_nCPUs == 0)
+          _nCPUs = std::thread::hardware_concurrency();
+        if(_nCPUs == 0)
+          _nCPUs = 1;
+      }
+
+      ThreadPool::~ThreadPool()
+      {
+        {
+          std::lock_guard<std::mutex> guard(_mutex);
+          _quit = true;
+        }
+        _wake.notify_all();
+        for(std::vector<std::thread>::iterator i = _workers.begin(); i != _workers.end(); ++i)
+          i->join();
+      }
+
+      unsigned int ThreadPool::threadIndex()
+      {
+        return tIsSpawned ? tThreadIndex : 0;
+      }
+
+      bool ThreadPool::isSpawnedThread()
+      {
+        return tIsSpawned;
+      }
+
+      void ThreadPool::startWorkers()
+      {
+        // the thread calling multiThread does its share, so we need one less worker than CPUs
+        for(unsigned int i = 1; i < _nCPUs; ++i)
+          _workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+      }
+
+      void ThreadPool::workerLoop()
+      {
+        unsigned int seen = 0;
+        for(;;) {
+          std::shared_ptr<Job> job;
+          {
+            std::unique_lock<std::mutex> guard(_mutex);
+            while(!_quit && _generation == seen)
+              _wake.wait(guard);
+            if(_quit)
+              return;
+            seen = _generation;
+            job = _job;
+          }
+          if(job)
+            runJob(*job);
+        }
+      }
+
+      void ThreadPool::runJob(Job &job)
+      {
+        SpawnedScope scope;
+        for(;;) {
+          unsigned int index = job.next.fetch_add(1);
+          if(index >= job.nThreads)
+            break;
+
+          tThreadIndex = index;
+          try {
+            job.func(index, job.nThreads, job.customArg);
+          }
+          catch(...) {
+            job.failed = true;
+          }
+
+          if(job.remaining.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> guard(job.doneMutex);
+            job.done.notify_all();
+          }
+        }
+      }
+
+      OfxStatus ThreadPool::runInline(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg)
+      {
+        SpawnedScope scope;
+        for(unsigned int index = 0; index < nThreads; ++index) {
+          tThreadIndex = index;
+          try {
+            func(index, nThreads, customArg);
+          }
+          catch(...) {
+            return kOfxStatFailed;
+          }
+        }
+        return kOfxStatOK;
+      }
+
+      OfxStatus ThreadPool::multiThread(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg)
+      {
+        if(!func)
+          return kOfxStatFailed;
+        if(nThreads == 0)
+          return kOfxStatOK;
+
+        // nested calls, and calls made while the pool is busy with someone else's job, run on this thread
+        if(nThreads == 1 || _nCPUs == 1 || isSpawnedThread() || !_busy.try_lock())
+          return runInline(func, nThreads, customArg);
+
+        std::shared_ptr<Job> job(new Job(func, nThreads, customArg));
+        {
+          std::lock_guard<std::mutex> guard(_mutex);
+          if(_workers.empty())
+            startWorkers();
+          _job = job;
+          ++_generation;
+        }
+        _wake.notify_all();
+
+        runJob(*job);
+
+        {
+          std::unique_lock<std::mutex> guard(job->doneMutex);
+          while(job->remaining != 0)
+            job->done.wait(guard);
+        }
+
+        {
+          std::lock_guard<std::mutex> guard(_mutex);
+          _job.reset();
+        }
+        _busy.unlock();
+
+        return job->failed ? kOfxStatFailed : kOfxStatOK;
+      }
+
+    } // MultiThread
+
+  } // Host
+
+} // OFX
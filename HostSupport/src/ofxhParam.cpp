@@ -4,6 +4,7 @@
 // ofx
 #include "ofxCore.h"
 #include "ofxImageEffect.h"
+#include "openfxParamBatch.h"
 #ifdef OFX_SUPPORTS_PARAMETRIC
 #include "ofxParametricParam.h"
 #endif
@@ -20,6 +21,7 @@
 #include <float.h>
 #include <limits.h>
 #include <stdarg.h>
+#include <string.h>
 
 namespace OFX {
 
@@ -185,6 +187,7 @@ namespace OFX {
         { kOfxParamTypeInteger3D, Property::eInt,    3 },
         { kOfxParamTypeString,    Property::eString, 1 },
         { kOfxParamTypeCustom,    Property::eString, 1 },
+        { kOfxParamTypeBytes,     Property::ePointer,1 },
         { kOfxParamTypeGroup,     Property::eNone,   0 },
         { kOfxParamTypePage,      Property::eNone,   0 },
         { kOfxParamTypePushButton,Property::eNone,   0 },
@@ -373,13 +376,18 @@ namespace OFX {
         /// - kOfxParamTypeString
         /// - kOfxParamTypeBoolean
         /// - kOfxParamTypeChoice
+        /// - kOfxParamTypeBytes
         /// If host doesn't support animation on them, then setting kOfxParamPropIsAnimating to 0 or 1 doesn't matter
         /// so just set the kOfxParamPropIsAnimating property to 0 for all those "extra animating" params.
-        bool animates = type != kOfxParamTypeCustom && type != kOfxParamTypeString && type != kOfxParamTypeBoolean && type != kOfxParamTypeChoice;
+        bool animates = type != kOfxParamTypeCustom && type != kOfxParamTypeString && type != kOfxParamTypeBoolean && type != kOfxParamTypeChoice &&
+          type != kOfxParamTypeBytes;
+
+        // a bytes default is a pointer to an OfxBytes, NULL for none
+        const char *defaultValue = valueType == Property::eString ? "" : valueType == Property::ePointer ? 0 : "0";
           
         Property::PropSpec variantProps[] = {
           { kOfxParamPropAnimates,    Property::eInt, 1,       false, animates ? "1" : "0" },
-          { kOfxParamPropDefault,     valueType,               dim, false, valueType == Property::eString ? "" : "0" },
+          { kOfxParamPropDefault,     valueType,               dim, false, defaultValue },
           Property::propSpecEnd
         };
 
@@ -546,6 +554,7 @@ namespace OFX {
         : Base(descriptor.getName(), descriptor.getType(), descriptor.getProperties())
         , _paramSetInstance(paramSet)
         , _parentInstance(0)
+        , _generation(0)
       {
         _properties.addNotifyHook(kOfxParamPropEnabled, this);
         _properties.addNotifyHook(kOfxParamPropSecret, this);
@@ -623,6 +632,61 @@ namespace OFX {
         return kOfxStatErrUnsupported;
       }
 
+      OfxStatus Instance::getValuesAtTimes(int nTimes, const OfxTime *times, void *values)
+      {
+        double *d = static_cast<double *>(values);
+        int *n = static_cast<int *>(values);
+        OfxStatus st = kOfxStatOK;
+
+        if(IntegerInstance *p = dynamic_cast<IntegerInstance *>(this)) {
+          for(int i = 0; i < nTimes && st == kOfxStatOK; ++i)
+            st = p->get(times[i], n[i]);
+        }
+        else if(ChoiceInstance *p = dynamic_cast<ChoiceInstance *>(this)) {
+          for(int i = 0; i < nTimes && st == kOfxStatOK; ++i)
+            st = p->get(times[i], n[i]);
+        }
+        else if(BooleanInstance *p = dynamic_cast<BooleanInstance *>(this)) {
+          for(int i = 0; i < nTimes && st == kOfxStatOK; ++i) {
+            bool b = false;
+            st = p->get(times[i], b);
+            n[i] = b;
+          }
+        }
+        else if(DoubleInstance *p = dynamic_cast<DoubleInstance *>(this)) {
+          for(int i = 0; i < nTimes && st == kOfxStatOK; ++i)
+            st = p->get(times[i], d[i]);
+        }
+        else if(Double2DInstance *p = dynamic_cast<Double2DInstance *>(this)) {
+          for(int i = 0; i < nTimes && st == kOfxStatOK; ++i)
+            st = p->get(times[i], d[2*i], d[2*i+1]);
+        }
+        else if(Double3DInstance *p = dynamic_cast<Double3DInstance *>(this)) {
+          for(int i = 0; i < nTimes && st == kOfxStatOK; ++i)
+            st = p->get(times[i], d[3*i], d[3*i+1], d[3*i+2]);
+        }
+        else if(RGBInstance *p = dynamic_cast<RGBInstance *>(this)) {
+          for(int i = 0; i < nTimes && st == kOfxStatOK; ++i)
+            st = p->get(times[i], d[3*i], d[3*i+1], d[3*i+2]);
+        }
+        else if(RGBAInstance *p = dynamic_cast<RGBAInstance *>(this)) {
+          for(int i = 0; i < nTimes && st == kOfxStatOK; ++i)
+            st = p->get(times[i], d[4*i], d[4*i+1], d[4*i+2], d[4*i+3]);
+        }
+        else if(Integer2DInstance *p = dynamic_cast<Integer2DInstance *>(this)) {
+          for(int i = 0; i < nTimes && st == kOfxStatOK; ++i)
+            st = p->get(times[i], n[2*i], n[2*i+1]);
+        }
+        else if(Integer3DInstance *p = dynamic_cast<Integer3DInstance *>(this)) {
+          for(int i = 0; i < nTimes && st == kOfxStatOK; ++i)
+            st = p->get(times[i], n[3*i], n[3*i+1], n[3*i+2]);
+        }
+        else
+          st = kOfxStatErrUnsupported;
+
+        return st;
+      }
+
       /// overridden from Property::NotifyHook
       void Instance::notify(const std::string &name, bool /*single*/, int /*num*/)
       {
@@ -651,6 +715,182 @@ namespace OFX {
         return kOfxStatErrMissingHostFeature; 
       }
 
+      void Instance::bumpGeneration()
+      {
+        ++_generation;
+        if(_paramSetInstance)
+          _paramSetInstance->bumpGeneration();
+      }
+
+      void hashBytes(unsigned long long &hash, const void *data, size_t n)
+      {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for(size_t i = 0; i < n; ++i) {
+          hash ^= bytes[i];
+          hash *= 1099511628211ULL;
+        }
+      }
+
+      template <class T>
+      static void hashPOD(unsigned long long &hash, const T &value)
+      {
+        hashBytes(hash, &value, sizeof(T));
+      }
+
+      //
+      // Bytes
+      //
+
+      Bytes::Bytes(const unsigned char *data, size_t length)
+      {
+        if(data && length)
+          makeBlock(std::vector<unsigned char>(data, data + length));
+      }
+
+      Bytes::Bytes(std::vector<unsigned char> &&data)
+      {
+        makeBlock(std::move(data));
+      }
+
+      void Bytes::makeBlock(std::vector<unsigned char> &&data)
+      {
+        if(data.empty())
+          return;
+        std::shared_ptr<Block> block = std::make_shared<Block>();
+        block->data.swap(data);
+        block->hash = 14695981039346656037ULL;
+        hashBytes(block->hash, block->data.data(), block->data.size());
+        _block = block;
+      }
+
+      OfxBytes Bytes::getView() const
+      {
+        OfxBytes view;
+        view.data = data();
+        view.length = size();
+        return view;
+      }
+
+      bool Bytes::operator==(const Bytes &other) const
+      {
+        if(_block == other._block)
+          return true;
+        if(size() != other.size() || getHash() != other.getHash())
+          return false;
+        return memcmp(data(), other.data(), size()) == 0;
+      }
+
+      /// the value of the param at the time into a running hash, for the types that have one
+      static void hashValueAt(unsigned long long &hash, Instance &param, OfxTime time)
+      {
+        if(IntegerInstance *p = dynamic_cast<IntegerInstance *>(&param)) {
+          int v = 0;
+          p->get(time, v);
+          hashPOD(hash, v);
+        }
+        else if(ChoiceInstance *p = dynamic_cast<ChoiceInstance *>(&param)) {
+          int v = 0;
+          p->get(time, v);
+          hashPOD(hash, v);
+        }
+        else if(DoubleInstance *p = dynamic_cast<DoubleInstance *>(&param)) {
+          double v = 0;
+          p->get(time, v);
+          hashPOD(hash, v);
+        }
+        else if(BooleanInstance *p = dynamic_cast<BooleanInstance *>(&param)) {
+          bool v = false;
+          p->get(time, v);
+          hashPOD(hash, v);
+        }
+        else if(RGBAInstance *p = dynamic_cast<RGBAInstance *>(&param)) {
+          double v[4] = {0, 0, 0, 0};
+          p->get(time, v[0], v[1], v[2], v[3]);
+          hashPOD(hash, v);
+        }
+        else if(RGBInstance *p = dynamic_cast<RGBInstance *>(&param)) {
+          double v[3] = {0, 0, 0};
+          p->get(time, v[0], v[1], v[2]);
+          hashPOD(hash, v);
+        }
+        else if(Double2DInstance *p = dynamic_cast<Double2DInstance *>(&param)) {
+          double v[2] = {0, 0};
+          p->get(time, v[0], v[1]);
+          hashPOD(hash, v);
+        }
+        else if(Integer2DInstance *p = dynamic_cast<Integer2DInstance *>(&param)) {
+          int v[2] = {0, 0};
+          p->get(time, v[0], v[1]);
+          hashPOD(hash, v);
+        }
+        else if(Double3DInstance *p = dynamic_cast<Double3DInstance *>(&param)) {
+          double v[3] = {0, 0, 0};
+          p->get(time, v[0], v[1], v[2]);
+          hashPOD(hash, v);
+        }
+        else if(Integer3DInstance *p = dynamic_cast<Integer3DInstance *>(&param)) {
+          int v[3] = {0, 0, 0};
+          p->get(time, v[0], v[1], v[2]);
+          hashPOD(hash, v);
+        }
+        else if(StringInstance *p = dynamic_cast<StringInstance *>(&param)) {
+          std::string v;
+          p->get(time, v);
+          hashBytes(hash, v.data(), v.size());
+          hashPOD(hash, v.size());
+        }
+        else if(BytesInstance *p = dynamic_cast<BytesInstance *>(&param)) {
+          Bytes v;
+          p->get(time, v);
+          hashPOD(hash, v.getHash());
+          hashPOD(hash, v.size());
+        }
+      }
+
+      unsigned long long Instance::getValueHash(OfxTime time1, OfxTime time2)
+      {
+        if(dynamic_cast<GroupInstance *>(this) || dynamic_cast<PageInstance *>(this) ||
+           dynamic_cast<PushbuttonInstance *>(this))
+          return 0;
+
+        unsigned long long hash = 14695981039346656037ULL;
+        hashValueAt(hash, *this, time1);
+        if(time2 != time1)
+          hashValueAt(hash, *this, time2);
+
+        // the keys that shape the curve between the times
+        KeyframeParam *keys = dynamic_cast<KeyframeParam *>(this);
+        unsigned int nKeys = 0;
+        if(keys && keys->getNumKeys(nKeys) == kOfxStatOK) {
+          int before = -1, after = -1;
+          for(unsigned int i = 0; i < nKeys; ++i) {
+            OfxTime t;
+            if(keys->getKeyTime(int(i), t) != kOfxStatOK)
+              continue;
+            if(t < time1)
+              before = int(i);
+            else if(t > time2) {
+              if(after < 0)
+                after = int(i);
+            }
+            else {
+              hashPOD(hash, t);
+              hashValueAt(hash, *this, t);
+            }
+          }
+          OfxTime t;
+          if(before >= 0 && keys->getKeyTime(before, t) == kOfxStatOK) {
+            hashPOD(hash, t);
+            hashValueAt(hash, *this, t);
+          }
+          if(after >= 0 && keys->getKeyTime(after, t) == kOfxStatOK) {
+            hashPOD(hash, t);
+            hashValueAt(hash, *this, t);
+          }
+        }
+        return hash;
+      }
+
       void Instance::setParentInstance(Instance* instance){
         _parentInstance = instance;
       }
@@ -769,7 +1009,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << value;
 #       endif
-        return set(value);
+        return bumpGenerationIfOK(set(value));
       }
 
       /// implementation of var args function
@@ -779,7 +1019,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << value;
 #       endif
-        return set(time, value);
+        return bumpGenerationIfOK(set(time, value));
       }
       
       /// overridden from Instance
@@ -834,7 +1074,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << value;
 #       endif
-        return set(value);
+        return bumpGenerationIfOK(set(value));
       }
 
       /// implementation of var args function
@@ -844,7 +1084,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << value;
 #       endif
-        return set(time, value);
+        return bumpGenerationIfOK(set(time, value));
       }
       
       /// implementation of var args function
@@ -909,7 +1149,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << value;
 #       endif
-        return set(value);
+        return bumpGenerationIfOK(set(value));
       }
 
       /// implementation of var args function
@@ -919,7 +1159,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << value;
 #       endif
-        return set(time, value);
+        return bumpGenerationIfOK(set(time, value));
       }
       
       /// implementation of var args function
@@ -990,7 +1230,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << value;
 #       endif
-        return set(value);
+        return bumpGenerationIfOK(set(value));
       }
 
       /// implementation of var args function
@@ -1000,7 +1240,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << value;
 #       endif
-        return set(time, value);
+        return bumpGenerationIfOK(set(time, value));
       }
       
 
@@ -1058,7 +1298,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << r << ',' << g << ',' << b << ',' << a << ')';
 #       endif
-        return set(r, g, b, a);
+        return bumpGenerationIfOK(set(r, g, b, a));
       }
 
       /// implementation of var args function
@@ -1071,7 +1311,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << r << ',' << g << ',' << b << ',' << a << ')';
 #       endif
-        return set(time, r, g, b, a);
+        return bumpGenerationIfOK(set(time, r, g, b, a));
       }
       
       /// implementation of var args function
@@ -1156,7 +1396,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << r << ',' << g << ',' << b << ')';
 #       endif
-        return set(r, g, b);
+        return bumpGenerationIfOK(set(r, g, b));
       }
 
       /// implementation of var args function
@@ -1168,7 +1408,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << r << ',' << g << ',' << b << ')';
 #       endif
-        return set(time, r, g, b);
+        return bumpGenerationIfOK(set(time, r, g, b));
       }
       
       /// implementation of var args function
@@ -1248,7 +1488,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << value1 << ',' << value2 << ')';
 #       endif
-        return set(value1, value2);
+        return bumpGenerationIfOK(set(value1, value2));
       }
 
       /// implementation of var args function
@@ -1259,7 +1499,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << value1 << ',' << value2 << ')';
 #       endif
-        return set(time, value1, value2);
+        return bumpGenerationIfOK(set(time, value1, value2));
       }
       
       /// implementation of var args function
@@ -1337,7 +1577,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << value1 << ',' << value2 << ')';
 #       endif
-        return set(value1, value2);
+        return bumpGenerationIfOK(set(value1, value2));
       }
 
       /// implementation of var args function
@@ -1348,7 +1588,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << value1 << ',' << value2 << ')';
 #       endif
-        return set(time, value1, value2);
+        return bumpGenerationIfOK(set(time, value1, value2));
       }
       
       /// implementation of var args function
@@ -1429,7 +1669,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << value1 << ',' << value2 << ',' << value3 << ')';
 #       endif
-        return set(value1, value2, value3);
+        return bumpGenerationIfOK(set(value1, value2, value3));
       }
 
       /// implementation of var args function
@@ -1441,7 +1681,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << value1 << ',' << value2 << ',' << value3 << ')';
 #       endif
-        return set(time, value1, value2, value3);
+        return bumpGenerationIfOK(set(time, value1, value2, value3));
       }
       
       /// implementation of var args function
@@ -1523,7 +1763,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << value1 << ',' << value2 << ',' << value3 << ')';
 #       endif
-        return set(value1, value2, value3);
+        return bumpGenerationIfOK(set(value1, value2, value3));
       }
 
       /// implementation of var args function
@@ -1535,7 +1775,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << '(' << value1 << ',' << value2 << ',' << value3 << ')';
 #       endif
-        return set(time, value1, value2, value3);
+        return bumpGenerationIfOK(set(time, value1, value2, value3));
       }
       
       /// implementation of var args function
@@ -1606,7 +1846,7 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << value;
 #       endif
-        return set(value);
+        return bumpGenerationIfOK(set(value));
       }
 
       /// implementation of var args function
@@ -1616,7 +1856,60 @@ namespace OFX {
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << value;
 #       endif
-        return set(time, value);
+        return bumpGenerationIfOK(set(time, value));
+      }
+
+      ////////////////////////////////////////////////////////////////////////////////
+      // bytes param
+      OfxStatus BytesInstance::getV(va_list arg)
+      {
+        OfxBytes *value = va_arg(arg, OfxBytes *);
+
+        OfxStatus stat = get(_returnValue);
+        *value = _returnValue.getView();
+#       ifdef OFX_DEBUG_PARAMETERS
+        if (stat == kOfxStatOK) {
+          std::cout << ' ' << value->length << " bytes";
+        }
+#       endif
+        return stat;
+      }
+
+      /// implementation of var args function
+      OfxStatus BytesInstance::getV(OfxTime time, va_list arg)
+      {
+        OfxBytes *value = va_arg(arg, OfxBytes *);
+
+        OfxStatus stat = get(time, _returnValue);
+        *value = _returnValue.getView();
+#       ifdef OFX_DEBUG_PARAMETERS
+        if (stat == kOfxStatOK) {
+          std::cout << ' ' << value->length << " bytes";
+        }
+#       endif
+        return stat;
+      }
+
+      /// implementation of var args function
+      OfxStatus BytesInstance::setV(va_list arg)
+      {
+        const OfxBytes *value = va_arg(arg, const OfxBytes *);
+        Bytes bytes = value ? Bytes(value->data, value->length) : Bytes();
+#       ifdef OFX_DEBUG_PARAMETERS
+        std::cout << bytes.size() << " bytes";
+#       endif
+        return bumpGenerationIfOK(set(bytes));
+      }
+
+      /// implementation of var args function
+      OfxStatus BytesInstance::setV(OfxTime time, va_list arg)
+      {
+        const OfxBytes *value = va_arg(arg, const OfxBytes *);
+        Bytes bytes = value ? Bytes(value->data, value->length) : Bytes();
+#       ifdef OFX_DEBUG_PARAMETERS
+        std::cout << bytes.size() << " bytes";
+#       endif
+        return bumpGenerationIfOK(set(time, bytes));
       }
       
       //////////////////////////////////////////////////////////////////////////////////
@@ -1625,6 +1918,12 @@ namespace OFX {
 
       /// ctor
       SetInstance::SetInstance()
+        : _generation(0)
+        , _hashGeneration(0)
+        , _hashTime1(0)
+        , _hashTime2(0)
+        , _hash(0)
+        , _hashValid(false)
       {}
 
       /// dtor. 
@@ -1660,6 +1959,29 @@ namespace OFX {
         return kOfxStatOK;
       }
 
+      unsigned long long SetInstance::getValueHash(OfxTime time1, OfxTime time2)
+      {
+        std::lock_guard<std::mutex> guard(_hashMutex);
+        unsigned int generation = _generation;
+        if(_hashValid && _hashGeneration == generation && _hashTime1 == time1 && _hashTime2 == time2)
+          return _hash;
+
+        unsigned long long hash = 14695981039346656037ULL;
+        for(std::list<Instance *>::iterator i = _paramList.begin(); i != _paramList.end(); ++i) {
+          const std::string &name = (*i)->getName();
+          hashBytes(hash, name.data(), name.size());
+          hashPOD(hash, (*i)->getValueHash(time1, time2));
+        }
+
+        // stored under the generation from before we looked, so a change made meanwhile is not missed
+        _hashGeneration = generation;
+        _hashTime1 = time1;
+        _hashTime2 = time2;
+        _hash = hash;
+        _hashValid = true;
+        return hash;
+      }
+
       ////////////////////////////////////////////////////////////////////////////////
       // Suite functions below
 
@@ -2169,6 +2491,8 @@ namespace OFX {
           return kOfxStatErrBadHandle;
         }
         OfxStatus stat = paramInstance->deleteKey(time);
+        if(stat == kOfxStatOK)
+          pInstance->bumpGeneration();
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << ' ' << StatStr(stat) << std::endl;
 #       endif
@@ -2197,6 +2521,8 @@ namespace OFX {
           return kOfxStatErrBadHandle;
         }
         OfxStatus stat = paramInstance->deleteAllKeys();
+        if(stat == kOfxStatOK)
+          pInstance->bumpGeneration();
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << ' ' << StatStr(stat) << std::endl;
 #       endif
@@ -2222,6 +2548,8 @@ namespace OFX {
         }
 
         OfxStatus stat = paramInstanceTo->copyFrom(*paramInstanceFrom,dstOffset,frameRange);
+        if(stat == kOfxStatOK)
+          paramInstanceTo->bumpGeneration();
 #       ifdef OFX_DEBUG_PARAMETERS
         std::cout << ' ' << StatStr(stat) << std::endl;
 #       endif
@@ -2294,6 +2622,53 @@ namespace OFX {
         return NULL;
       }
 
+      /// get the values of a param at many times
+      static OfxStatus paramGetValuesAtTimes(OfxParamHandle paramHandle,
+                                             int nTimes,
+                                             const OfxTime *times,
+                                             void *values)
+      {
+#       ifdef OFX_DEBUG_PARAMETERS
+        std::cout << "OFX: paramGetValuesAtTimes - " << paramHandle << ' ' << nTimes << " ...";
+#       endif
+        Instance *paramInstance = reinterpret_cast<Instance*>(paramHandle);
+        if(!paramInstance || !paramInstance->verifyMagic()) {
+#         ifdef OFX_DEBUG_PARAMETERS
+          std::cout << ' ' << StatStr(kOfxStatErrBadHandle) << std::endl;
+#         endif
+          return kOfxStatErrBadHandle;
+        }
+
+        OfxStatus stat = kOfxStatOK;
+        if(nTimes > 0) {
+          if(!times || !values)
+            stat = kOfxStatErrValue;
+          else {
+            try {
+              stat = paramInstance->getValuesAtTimes(nTimes, times, values);
+            }
+            catch(...) {
+              stat = kOfxStatFailed;
+            }
+          }
+        }
+
+#       ifdef OFX_DEBUG_PARAMETERS
+        std::cout << ' ' << StatStr(stat) << std::endl;
+#       endif
+        return stat;
+      }
+
+      static OpenFXParameterBatchSuiteV1 gParamBatchSuiteV1 = {
+        paramGetValuesAtTimes
+      };
+
+      const void *GetBatchSuite(int version) {
+        if(version == 1)
+          return &gParamBatchSuiteV1;
+        return NULL;
+      }
+
     } // Param
 
   } // Host
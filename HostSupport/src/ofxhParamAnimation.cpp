@@ -0,0 +1,938 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <math.h>
+#include <algorithm>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxParam.h"
+
+// ofx host
+#include "ofxhPropertySuite.h"
+#include "ofxhParam.h"
+#include "ofxhParamAnimation.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace Param {
+
+      //
+      // AnimationCurve
+      //
+
+      AnimationCurve::AnimationCurve(int dimension)
+        : _dimension(dimension)
+        , _defaults(dimension, 0.0)
+      {
+      }
+
+      void AnimationCurve::setDefault(const double *values)
+      {
+        std::copy(values, values + _dimension, _defaults.begin());
+      }
+
+      void AnimationCurve::getDefault(double *values) const
+      {
+        std::copy(_defaults.begin(), _defaults.end(), values);
+      }
+
+      void AnimationCurve::getKeyValue(unsigned int nth, double *values) const
+      {
+        std::copy(_values.begin() + nth * _dimension, _values.begin() + (nth + 1) * _dimension, values);
+      }
+
+      void AnimationCurve::setKey(OfxTime time, const double *values, InterpolationEnum interpolation)
+      {
+        std::vector<OfxTime>::iterator t = std::lower_bound(_times.begin(), _times.end(), time);
+        size_t i = t - _times.begin();
+        if(t == _times.end() || *t != time) {
+          _times.insert(t, time);
+          _values.insert(_values.begin() + i * _dimension, values, values + _dimension);
+          _interpolations.insert(_interpolations.begin() + i, interpolation);
+        }
+        else {
+          std::copy(values, values + _dimension, _values.begin() + i * _dimension);
+          _interpolations[i] = interpolation;
+        }
+        update();
+      }
+
+      bool AnimationCurve::deleteKey(OfxTime time)
+      {
+        std::vector<OfxTime>::iterator t = std::lower_bound(_times.begin(), _times.end(), time);
+        if(t == _times.end() || *t != time)
+          return false;
+        size_t i = t - _times.begin();
+        _times.erase(t);
+        _values.erase(_values.begin() + i * _dimension, _values.begin() + (i + 1) * _dimension);
+        _interpolations.erase(_interpolations.begin() + i);
+        update();
+        return true;
+      }
+
+      void AnimationCurve::deleteAllKeys()
+      {
+        _times.clear();
+        _values.clear();
+        _interpolations.clear();
+        update();
+      }
+
+      void AnimationCurve::copyFrom(const AnimationCurve &other, OfxTime offset, const OfxRangeD *range)
+      {
+        if(other._dimension != _dimension)
+          return;
+
+        if(!range) {
+          _defaults = other._defaults;
+          _times = other._times;
+          _values = other._values;
+          _interpolations = other._interpolations;
+          for(std::vector<OfxTime>::iterator t = _times.begin(); t != _times.end(); ++t)
+            *t += offset;
+          update();
+          return;
+        }
+
+        // merge our keys outside the range shifted to with the other's inside the range
+        std::vector<OfxTime> times;
+        std::vector<double> values;
+        std::vector<InterpolationEnum> interpolations;
+        size_t i = 0, j = 0;
+        size_t n = _times.size(), m = other._times.size();
+        while(i < n || j < m) {
+          if(j < m && (other._times[j] < range->min || other._times[j] > range->max)) {
+            ++j;
+            continue;
+          }
+          if(i < n && _times[i] >= range->min + offset && _times[i] <= range->max + offset) {
+            ++i;
+            continue;
+          }
+          if(j < m && (i == n || other._times[j] + offset < _times[i])) {
+            times.push_back(other._times[j] + offset);
+            values.insert(values.end(), other._values.begin() + j * _dimension, other._values.begin() + (j + 1) * _dimension);
+            interpolations.push_back(other._interpolations[j]);
+            ++j;
+          }
+          else {
+            times.push_back(_times[i]);
+            values.insert(values.end(), _values.begin() + i * _dimension, _values.begin() + (i + 1) * _dimension);
+            interpolations.push_back(_interpolations[i]);
+            ++i;
+          }
+        }
+        _times.swap(times);
+        _values.swap(values);
+        _interpolations.swap(interpolations);
+        update();
+      }
+
+      int AnimationCurve::getKeyIndex(OfxTime time, int direction) const
+      {
+        if(direction == 0) {
+          std::vector<OfxTime>::const_iterator t = std::lower_bound(_times.begin(), _times.end(), time);
+          return (t != _times.end() && *t == time) ? int(t - _times.begin()) : -1;
+        }
+        if(direction > 0) {
+          std::vector<OfxTime>::const_iterator t = std::upper_bound(_times.begin(), _times.end(), time);
+          return t != _times.end() ? int(t - _times.begin()) : -1;
+        }
+        return int(std::lower_bound(_times.begin(), _times.end(), time) - _times.begin()) - 1;
+      }
+
+      int AnimationCurve::findSegment(OfxTime time) const
+      {
+        return int(std::upper_bound(_times.begin(), _times.end(), time) - _times.begin()) - 1;
+      }
+
+      /// the end points, slopes and length of the segment starting at key i, in dimension d
+      struct Segment {
+        double v0, v1, m0, m1, h;
+        InterpolationEnum interpolation;
+      };
+
+      /// the value of a segment at s, 0 to 1 along it
+      static double segmentValue(const Segment &seg, double s)
+      {
+        switch(seg.interpolation) {
+        case eInterpolationConstant :
+          return seg.v0;
+        case eInterpolationLinear :
+          return seg.v0 + (seg.v1 - seg.v0) * s;
+        default : {
+          double s2 = s * s, s3 = s2 * s;
+          return (2 * s3 - 3 * s2 + 1) * seg.v0 + (s3 - 2 * s2 + s) * seg.h * seg.m0 +
+            (-2 * s3 + 3 * s2) * seg.v1 + (s3 - s2) * seg.h * seg.m1;
+        }
+        }
+      }
+
+      /// the derivative with respect to time of a segment at s
+      static double segmentDerivative(const Segment &seg, double s)
+      {
+        switch(seg.interpolation) {
+        case eInterpolationConstant :
+          return 0;
+        case eInterpolationLinear :
+          return (seg.v1 - seg.v0) / seg.h;
+        default : {
+          double s2 = s * s;
+          return ((6 * s2 - 6 * s) * seg.v0 + (3 * s2 - 4 * s + 1) * seg.h * seg.m0 +
+                  (-6 * s2 + 6 * s) * seg.v1 + (3 * s2 - 2 * s) * seg.h * seg.m1) / seg.h;
+        }
+        }
+      }
+
+      /// the integral over time of a segment from its start to s
+      static double segmentIntegral(const Segment &seg, double s)
+      {
+        switch(seg.interpolation) {
+        case eInterpolationConstant :
+          return seg.h * seg.v0 * s;
+        case eInterpolationLinear :
+          return seg.h * (seg.v0 * s + (seg.v1 - seg.v0) * s * s / 2);
+        default : {
+          double s2 = s * s, s3 = s2 * s, s4 = s3 * s;
+          return seg.h * ((s4 / 2 - s3 + s) * seg.v0 + (s4 / 4 - 2 * s3 / 3 + s2 / 2) * seg.h * seg.m0 +
+                          (-s4 / 2 + s3) * seg.v1 + (s4 / 4 - s3 / 3) * seg.h * seg.m1);
+        }
+        }
+      }
+
+      void AnimationCurve::update()
+      {
+        size_t n = _times.size();
+        _slopes.assign(n * _dimension, 0.0);
+        _integrals.assign(n * _dimension, 0.0);
+
+        // smooth keys have the slope of the line through their neighbours, the first and last are flat
+        for(size_t i = 1; i + 1 < n; ++i) {
+          double dt = _times[i + 1] - _times[i - 1];
+          for(int d = 0; d < _dimension; ++d)
+            _slopes[i * _dimension + d] = (_values[(i + 1) * _dimension + d] - _values[(i - 1) * _dimension + d]) / dt;
+        }
+
+        for(size_t i = 0; i + 1 < n; ++i) {
+          Segment seg;
+          seg.h = _times[i + 1] - _times[i];
+          seg.interpolation = _interpolations[i];
+          for(int d = 0; d < _dimension; ++d) {
+            seg.v0 = _values[i * _dimension + d];
+            seg.v1 = _values[(i + 1) * _dimension + d];
+            seg.m0 = _slopes[i * _dimension + d];
+            seg.m1 = _slopes[(i + 1) * _dimension + d];
+            _integrals[(i + 1) * _dimension + d] = _integrals[i * _dimension + d] + segmentIntegral(seg, 1.0);
+          }
+        }
+      }
+
+      double AnimationCurve::integralTo(int i, int d, OfxTime time) const
+      {
+        int n = int(_times.size());
+        if(i < 0)
+          return _values[d] * (time - _times[0]);
+        if(i >= n - 1)
+          return _integrals[(n - 1) * _dimension + d] + _values[(n - 1) * _dimension + d] * (time - _times[n - 1]);
+
+        Segment seg;
+        seg.h = _times[i + 1] - _times[i];
+        seg.interpolation = _interpolations[i];
+        seg.v0 = _values[i * _dimension + d];
+        seg.v1 = _values[(i + 1) * _dimension + d];
+        seg.m0 = _slopes[i * _dimension + d];
+        seg.m1 = _slopes[(i + 1) * _dimension + d];
+        return _integrals[i * _dimension + d] + segmentIntegral(seg, (time - _times[i]) / seg.h);
+      }
+
+      void AnimationCurve::getValue(OfxTime time, double *values) const
+      {
+        if(_times.empty())
+          getDefault(values);
+        else
+          getValueIn(findSegment(time), time, values);
+      }
+
+      void AnimationCurve::getValues(int nTimes, const OfxTime *times, double *values) const
+      {
+        int n = int(_times.size());
+        int i = -2;
+        for(int k = 0; k < nTimes; ++k, values += _dimension) {
+          if(n == 0) {
+            getDefault(values);
+            continue;
+          }
+
+          // times close together and in order, as for motion blur, stay in the same
+          // segment or move to the next, so look there before searching
+          OfxTime t = times[k];
+          bool inSegment = i >= -1 && (i < 0 || t >= _times[i]) && (i + 1 >= n || t < _times[i + 1]);
+          if(!inSegment) {
+            if(i >= -1 && i + 2 < n && t >= _times[i + 1] && t < _times[i + 2])
+              ++i;
+            else
+              i = findSegment(t);
+          }
+          getValueIn(i, t, values);
+        }
+      }
+
+      void AnimationCurve::getValueIn(int i, OfxTime time, double *values) const
+      {
+        int n = int(_times.size());
+        if(i < 0 || i >= n - 1) {
+          getKeyValue(i < 0 ? 0 : n - 1, values);
+          return;
+        }
+
+        Segment seg;
+        seg.h = _times[i + 1] - _times[i];
+        seg.interpolation = _interpolations[i];
+        double s = (time - _times[i]) / seg.h;
+        for(int d = 0; d < _dimension; ++d) {
+          seg.v0 = _values[i * _dimension + d];
+          seg.v1 = _values[(i + 1) * _dimension + d];
+          seg.m0 = _slopes[i * _dimension + d];
+          seg.m1 = _slopes[(i + 1) * _dimension + d];
+          values[d] = segmentValue(seg, s);
+        }
+      }
+
+      void AnimationCurve::getDerivative(OfxTime time, double *values) const
+      {
+        int n = int(_times.size());
+        int i = findSegment(time);
+        if(i < 0 || i >= n - 1) {
+          std::fill(values, values + _dimension, 0.0);
+          return;
+        }
+
+        Segment seg;
+        seg.h = _times[i + 1] - _times[i];
+        seg.interpolation = _interpolations[i];
+        double s = (time - _times[i]) / seg.h;
+        for(int d = 0; d < _dimension; ++d) {
+          seg.v0 = _values[i * _dimension + d];
+          seg.v1 = _values[(i + 1) * _dimension + d];
+          seg.m0 = _slopes[i * _dimension + d];
+          seg.m1 = _slopes[(i + 1) * _dimension + d];
+          values[d] = segmentDerivative(seg, s);
+        }
+      }
+
+      void AnimationCurve::getIntegral(OfxTime time1, OfxTime time2, double *values) const
+      {
+        if(_times.empty()) {
+          for(int d = 0; d < _dimension; ++d)
+            values[d] = _defaults[d] * (time2 - time1);
+          return;
+        }
+
+        int i1 = findSegment(time1);
+        int i2 = findSegment(time2);
+        for(int d = 0; d < _dimension; ++d)
+          values[d] = integralTo(i2, d, time2) - integralTo(i1, d, time1);
+      }
+
+      //
+      // the animated params
+      //
+
+      /// the defaults of a double param from its descriptor
+      static void getDoubleDefaults(const Property::Set &props, double *values, int n)
+      {
+        for(int i = 0; i < n; ++i)
+          values[i] = props.getDoubleProperty(kOfxParamPropDefault, i);
+      }
+
+      /// the defaults of an integer param from its descriptor
+      static void getIntDefaults(const Property::Set &props, double *values, int n)
+      {
+        for(int i = 0; i < n; ++i)
+          values[i] = props.getIntProperty(kOfxParamPropDefault, i);
+      }
+
+      static int roundToInt(double v)
+      {
+        return int(floor(v + 0.5));
+      }
+
+      // AnimatedDoubleInstance
+
+      AnimatedDoubleInstance::AnimatedDoubleInstance(Descriptor &descriptor, SetInstance *instance)
+        : AnimatedInstance<DoubleInstance, 1>(descriptor, instance)
+      {
+        double v[1];
+        getDoubleDefaults(getProperties(), v, 1);
+        _curve.setDefault(v);
+      }
+
+      OfxStatus AnimatedDoubleInstance::get(double &v)
+      {
+        return get(getCurrentTime(), v);
+      }
+
+      OfxStatus AnimatedDoubleInstance::get(OfxTime time, double &v)
+      {
+        getValues(time, &v);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDoubleInstance::set(double v)
+      {
+        setValues(&v, eInterpolationSmooth);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDoubleInstance::set(OfxTime time, double v)
+      {
+        setKey(time, &v, eInterpolationSmooth);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDoubleInstance::derive(OfxTime time, double &v)
+      {
+        _curve.getDerivative(time, &v);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDoubleInstance::integrate(OfxTime time1, OfxTime time2, double &v)
+      {
+        _curve.getIntegral(time1, time2, &v);
+        return kOfxStatOK;
+      }
+
+      // AnimatedDouble2DInstance
+
+      AnimatedDouble2DInstance::AnimatedDouble2DInstance(Descriptor &descriptor, SetInstance *instance)
+        : AnimatedInstance<Double2DInstance, 2>(descriptor, instance)
+      {
+        double v[2];
+        getDoubleDefaults(getProperties(), v, 2);
+        _curve.setDefault(v);
+      }
+
+      OfxStatus AnimatedDouble2DInstance::get(double &x, double &y)
+      {
+        return get(getCurrentTime(), x, y);
+      }
+
+      OfxStatus AnimatedDouble2DInstance::get(OfxTime time, double &x, double &y)
+      {
+        double v[2];
+        getValues(time, v);
+        x = v[0]; y = v[1];
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDouble2DInstance::set(double x, double y)
+      {
+        double v[2] = {x, y};
+        setValues(v, eInterpolationSmooth);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDouble2DInstance::set(OfxTime time, double x, double y)
+      {
+        double v[2] = {x, y};
+        setKey(time, v, eInterpolationSmooth);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDouble2DInstance::derive(OfxTime time, double &x, double &y)
+      {
+        double v[2];
+        _curve.getDerivative(time, v);
+        x = v[0]; y = v[1];
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDouble2DInstance::integrate(OfxTime time1, OfxTime time2, double &x, double &y)
+      {
+        double v[2];
+        _curve.getIntegral(time1, time2, v);
+        x = v[0]; y = v[1];
+        return kOfxStatOK;
+      }
+
+      // AnimatedDouble3DInstance
+
+      AnimatedDouble3DInstance::AnimatedDouble3DInstance(Descriptor &descriptor, SetInstance *instance)
+        : AnimatedInstance<Double3DInstance, 3>(descriptor, instance)
+      {
+        double v[3];
+        getDoubleDefaults(getProperties(), v, 3);
+        _curve.setDefault(v);
+      }
+
+      OfxStatus AnimatedDouble3DInstance::get(double &x, double &y, double &z)
+      {
+        return get(getCurrentTime(), x, y, z);
+      }
+
+      OfxStatus AnimatedDouble3DInstance::get(OfxTime time, double &x, double &y, double &z)
+      {
+        double v[3];
+        getValues(time, v);
+        x = v[0]; y = v[1]; z = v[2];
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDouble3DInstance::set(double x, double y, double z)
+      {
+        double v[3] = {x, y, z};
+        setValues(v, eInterpolationSmooth);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDouble3DInstance::set(OfxTime time, double x, double y, double z)
+      {
+        double v[3] = {x, y, z};
+        setKey(time, v, eInterpolationSmooth);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDouble3DInstance::derive(OfxTime time, double &x, double &y, double &z)
+      {
+        double v[3];
+        _curve.getDerivative(time, v);
+        x = v[0]; y = v[1]; z = v[2];
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedDouble3DInstance::integrate(OfxTime time1, OfxTime time2, double &x, double &y, double &z)
+      {
+        double v[3];
+        _curve.getIntegral(time1, time2, v);
+        x = v[0]; y = v[1]; z = v[2];
+        return kOfxStatOK;
+      }
+
+      // AnimatedRGBInstance
+
+      AnimatedRGBInstance::AnimatedRGBInstance(Descriptor &descriptor, SetInstance *instance)
+        : AnimatedInstance<RGBInstance, 3>(descriptor, instance)
+      {
+        double v[3];
+        getDoubleDefaults(getProperties(), v, 3);
+        _curve.setDefault(v);
+      }
+
+      OfxStatus AnimatedRGBInstance::get(double &r, double &g, double &b)
+      {
+        return get(getCurrentTime(), r, g, b);
+      }
+
+      OfxStatus AnimatedRGBInstance::get(OfxTime time, double &r, double &g, double &b)
+      {
+        double v[3];
+        getValues(time, v);
+        r = v[0]; g = v[1]; b = v[2];
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedRGBInstance::set(double r, double g, double b)
+      {
+        double v[3] = {r, g, b};
+        setValues(v, eInterpolationSmooth);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedRGBInstance::set(OfxTime time, double r, double g, double b)
+      {
+        double v[3] = {r, g, b};
+        setKey(time, v, eInterpolationSmooth);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedRGBInstance::derive(OfxTime time, double &r, double &g, double &b)
+      {
+        double v[3];
+        _curve.getDerivative(time, v);
+        r = v[0]; g = v[1]; b = v[2];
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedRGBInstance::integrate(OfxTime time1, OfxTime time2, double &r, double &g, double &b)
+      {
+        double v[3];
+        _curve.getIntegral(time1, time2, v);
+        r = v[0]; g = v[1]; b = v[2];
+        return kOfxStatOK;
+      }
+
+      // AnimatedRGBAInstance
+
+      AnimatedRGBAInstance::AnimatedRGBAInstance(Descriptor &descriptor, SetInstance *instance)
+        : AnimatedInstance<RGBAInstance, 4>(descriptor, instance)
+      {
+        double v[4];
+        getDoubleDefaults(getProperties(), v, 4);
+        _curve.setDefault(v);
+      }
+
+      OfxStatus AnimatedRGBAInstance::get(double &r, double &g, double &b, double &a)
+      {
+        return get(getCurrentTime(), r, g, b, a);
+      }
+
+      OfxStatus AnimatedRGBAInstance::get(OfxTime time, double &r, double &g, double &b, double &a)
+      {
+        double v[4];
+        getValues(time, v);
+        r = v[0]; g = v[1]; b = v[2]; a = v[3];
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedRGBAInstance::set(double r, double g, double b, double a)
+      {
+        double v[4] = {r, g, b, a};
+        setValues(v, eInterpolationSmooth);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedRGBAInstance::set(OfxTime time, double r, double g, double b, double a)
+      {
+        double v[4] = {r, g, b, a};
+        setKey(time, v, eInterpolationSmooth);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedRGBAInstance::derive(OfxTime time, double &r, double &g, double &b, double &a)
+      {
+        double v[4];
+        _curve.getDerivative(time, v);
+        r = v[0]; g = v[1]; b = v[2]; a = v[3];
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedRGBAInstance::integrate(OfxTime time1, OfxTime time2, double &r, double &g, double &b, double &a)
+      {
+        double v[4];
+        _curve.getIntegral(time1, time2, v);
+        r = v[0]; g = v[1]; b = v[2]; a = v[3];
+        return kOfxStatOK;
+      }
+
+      // AnimatedIntegerInstance
+
+      AnimatedIntegerInstance::AnimatedIntegerInstance(Descriptor &descriptor, SetInstance *instance)
+        : AnimatedInstance<IntegerInstance, 1>(descriptor, instance)
+      {
+        double v[1];
+        getIntDefaults(getProperties(), v, 1);
+        _curve.setDefault(v);
+      }
+
+      OfxStatus AnimatedIntegerInstance::get(int &i)
+      {
+        return get(getCurrentTime(), i);
+      }
+
+      OfxStatus AnimatedIntegerInstance::get(OfxTime time, int &i)
+      {
+        double v;
+        getValues(time, &v);
+        i = roundToInt(v);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedIntegerInstance::set(int i)
+      {
+        double v = i;
+        setValues(&v, eInterpolationLinear);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedIntegerInstance::set(OfxTime time, int i)
+      {
+        double v = i;
+        setKey(time, &v, eInterpolationLinear);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedIntegerInstance::derive(OfxTime time, int &i)
+      {
+        double v;
+        _curve.getDerivative(time, &v);
+        i = roundToInt(v);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedIntegerInstance::integrate(OfxTime time1, OfxTime time2, int &i)
+      {
+        double v;
+        _curve.getIntegral(time1, time2, &v);
+        i = roundToInt(v);
+        return kOfxStatOK;
+      }
+
+      // AnimatedInteger2DInstance
+
+      AnimatedInteger2DInstance::AnimatedInteger2DInstance(Descriptor &descriptor, SetInstance *instance)
+        : AnimatedInstance<Integer2DInstance, 2>(descriptor, instance)
+      {
+        double v[2];
+        getIntDefaults(getProperties(), v, 2);
+        _curve.setDefault(v);
+      }
+
+      OfxStatus AnimatedInteger2DInstance::get(int &x, int &y)
+      {
+        return get(getCurrentTime(), x, y);
+      }
+
+      OfxStatus AnimatedInteger2DInstance::get(OfxTime time, int &x, int &y)
+      {
+        double v[2];
+        getValues(time, v);
+        x = roundToInt(v[0]); y = roundToInt(v[1]);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedInteger2DInstance::set(int x, int y)
+      {
+        double v[2] = {double(x), double(y)};
+        setValues(v, eInterpolationLinear);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedInteger2DInstance::set(OfxTime time, int x, int y)
+      {
+        double v[2] = {double(x), double(y)};
+        setKey(time, v, eInterpolationLinear);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedInteger2DInstance::derive(OfxTime time, int &x, int &y)
+      {
+        double v[2];
+        _curve.getDerivative(time, v);
+        x = roundToInt(v[0]); y = roundToInt(v[1]);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedInteger2DInstance::integrate(OfxTime time1, OfxTime time2, int &x, int &y)
+      {
+        double v[2];
+        _curve.getIntegral(time1, time2, v);
+        x = roundToInt(v[0]); y = roundToInt(v[1]);
+        return kOfxStatOK;
+      }
+
+      // AnimatedInteger3DInstance
+
+      AnimatedInteger3DInstance::AnimatedInteger3DInstance(Descriptor &descriptor, SetInstance *instance)
+        : AnimatedInstance<Integer3DInstance, 3>(descriptor, instance)
+      {
+        double v[3];
+        getIntDefaults(getProperties(), v, 3);
+        _curve.setDefault(v);
+      }
+
+      OfxStatus AnimatedInteger3DInstance::get(int &x, int &y, int &z)
+      {
+        return get(getCurrentTime(), x, y, z);
+      }
+
+      OfxStatus AnimatedInteger3DInstance::get(OfxTime time, int &x, int &y, int &z)
+      {
+        double v[3];
+        getValues(time, v);
+        x = roundToInt(v[0]); y = roundToInt(v[1]); z = roundToInt(v[2]);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedInteger3DInstance::set(int x, int y, int z)
+      {
+        double v[3] = {double(x), double(y), double(z)};
+        setValues(v, eInterpolationLinear);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedInteger3DInstance::set(OfxTime time, int x, int y, int z)
+      {
+        double v[3] = {double(x), double(y), double(z)};
+        setKey(time, v, eInterpolationLinear);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedInteger3DInstance::derive(OfxTime time, int &x, int &y, int &z)
+      {
+        double v[3];
+        _curve.getDerivative(time, v);
+        x = roundToInt(v[0]); y = roundToInt(v[1]); z = roundToInt(v[2]);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedInteger3DInstance::integrate(OfxTime time1, OfxTime time2, int &x, int &y, int &z)
+      {
+        double v[3];
+        _curve.getIntegral(time1, time2, v);
+        x = roundToInt(v[0]); y = roundToInt(v[1]); z = roundToInt(v[2]);
+        return kOfxStatOK;
+      }
+
+      // AnimatedBytesInstance
+
+      AnimatedBytesInstance::AnimatedBytesInstance(Descriptor &descriptor, SetInstance *instance)
+        : BytesInstance(descriptor, instance)
+      {
+        // the default points at the plug-in's bytes, so take a copy of them
+        const OfxBytes *v = static_cast<const OfxBytes *>(getProperties().getPointerProperty(kOfxParamPropDefault));
+        if(v)
+          _state.value = Bytes(v->data, v->length);
+      }
+
+      OfxTime AnimatedBytesInstance::getCurrentTime() const
+      {
+        TimeLine::TimeLineI *timeLine = dynamic_cast<TimeLine::TimeLineI *>(_paramSetInstance);
+        return timeLine ? timeLine->timeLineGetTime() : 0;
+      }
+
+      OfxStatus AnimatedBytesInstance::get(Bytes &v)
+      {
+        return get(getCurrentTime(), v);
+      }
+
+      OfxStatus AnimatedBytesInstance::get(OfxTime time, Bytes &v)
+      {
+        if(_state.times.empty()) {
+          v = _state.value;
+          return kOfxStatOK;
+        }
+        size_t i = std::upper_bound(_state.times.begin(), _state.times.end(), time) - _state.times.begin();
+        v = _state.values[i ? i - 1 : 0];
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedBytesInstance::set(const Bytes &v)
+      {
+        if(_state.times.empty()) {
+          _state.value = v;
+          bumpGeneration();
+        }
+        else
+          set(getCurrentTime(), v);
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedBytesInstance::set(OfxTime time, const Bytes &v)
+      {
+        std::vector<OfxTime>::iterator t = std::lower_bound(_state.times.begin(), _state.times.end(), time);
+        size_t i = t - _state.times.begin();
+        if(t != _state.times.end() && *t == time)
+          _state.values[i] = v;
+        else {
+          _state.times.insert(t, time);
+          _state.values.insert(_state.values.begin() + i, v);
+        }
+        bumpGeneration();
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedBytesInstance::getNumKeys(unsigned int &nKeys) const
+      {
+        nKeys = (unsigned int) _state.times.size();
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedBytesInstance::getKeyTime(int nth, OfxTime &time) const
+      {
+        if(nth < 0 || nth >= int(_state.times.size()))
+          return kOfxStatErrBadIndex;
+        time = _state.times[nth];
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedBytesInstance::getKeyIndex(OfxTime time, int direction, int &index) const
+      {
+        const std::vector<OfxTime> &times = _state.times;
+        if(direction == 0) {
+          std::vector<OfxTime>::const_iterator t = std::lower_bound(times.begin(), times.end(), time);
+          index = (t != times.end() && *t == time) ? int(t - times.begin()) : -1;
+        }
+        else if(direction > 0) {
+          std::vector<OfxTime>::const_iterator t = std::upper_bound(times.begin(), times.end(), time);
+          index = t != times.end() ? int(t - times.begin()) : -1;
+        }
+        else
+          index = int(std::lower_bound(times.begin(), times.end(), time) - times.begin()) - 1;
+        return index < 0 ? kOfxStatFailed : kOfxStatOK;
+      }
+
+      OfxStatus AnimatedBytesInstance::deleteKey(OfxTime time)
+      {
+        std::vector<OfxTime>::iterator t = std::lower_bound(_state.times.begin(), _state.times.end(), time);
+        if(t == _state.times.end() || *t != time)
+          return kOfxStatFailed;
+        _state.values.erase(_state.values.begin() + (t - _state.times.begin()));
+        _state.times.erase(t);
+        bumpGeneration();
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedBytesInstance::deleteAllKeys()
+      {
+        _state.times.clear();
+        _state.values.clear();
+        bumpGeneration();
+        return kOfxStatOK;
+      }
+
+      OfxStatus AnimatedBytesInstance::copyFrom(const Instance &instance, OfxTime offset, const OfxRangeD *range)
+      {
+        const AnimatedBytesInstance *other = dynamic_cast<const AnimatedBytesInstance *>(&instance);
+        if(!other)
+          return kOfxStatErrMissingHostFeature;
+        if(other == this)
+          return kOfxStatOK;
+
+        if(!range) {
+          _state = other->_state;
+          for(std::vector<OfxTime>::iterator t = _state.times.begin(); t != _state.times.end(); ++t)
+            *t += offset;
+          bumpGeneration();
+          return kOfxStatOK;
+        }
+
+        // merge our keys outside the range shifted to with the other's inside the range
+        State merged;
+        merged.value = _state.value;
+        const State &from = other->_state;
+        size_t i = 0, j = 0;
+        size_t n = _state.times.size(), m = from.times.size();
+        while(i < n || j < m) {
+          if(j < m && (from.times[j] < range->min || from.times[j] > range->max)) {
+            ++j;
+            continue;
+          }
+          if(i < n && _state.times[i] >= range->min + offset && _state.times[i] <= range->max + offset) {
+            ++i;
+            continue;
+          }
+          if(j < m && (i == n || from.times[j] + offset < _state.times[i])) {
+            merged.times.push_back(from.times[j] + offset);
+            merged.values.push_back(from.values[j]);
+            ++j;
+          }
+          else {
+            merged.times.push_back(_state.times[i]);
+            merged.values.push_back(_state.values[i]);
+            ++i;
+          }
+        }
+        _state.times.swap(merged.times);
+        _state.values.swap(merged.values);
+        bumpGeneration();
+        return kOfxStatOK;
+      }
+
+    } // namespace Param
+
+  } // namespace Host
+
+} // namespace OFX
@@ -131,6 +131,111 @@ namespace OFX
           }
       }
 
+      void propertySetBinaryWrite(BinaryCache::Writer &w, const Property::Set &set)
+      {
+        const Property::PropertyMap &props = set.getProperties();
+
+        uint32_t count = 0;
+        for (Property::PropertyMap::const_iterator i = props.begin(); i != props.end(); i++) {
+          if (i->second->getType() != Property::ePointer) {
+            count++;
+          }
+        }
+        w.putU32(count);
+
+        for (Property::PropertyMap::const_iterator i = props.begin(); i != props.end(); i++) {
+          Property::Property *prop = i->second;
+          Property::TypeEnum type = prop->getType();
+          if (type == Property::ePointer) {
+            continue;
+          }
+
+          int dimension = prop->getDimension();
+          w.putString(prop->getName());
+          w.putU8(uint8_t(type));
+          w.putI32(prop->getFixedDimension());
+          w.putU32(uint32_t(dimension));
+
+          for (int j = 0; j < dimension; j++) {
+            switch (type) {
+            case Property::eInt:
+              w.putI32(static_cast<Property::Int *>(prop)->getValueRaw(j));
+              break;
+            case Property::eDouble:
+              w.putDouble(static_cast<Property::Double *>(prop)->getValueRaw(j));
+              break;
+            case Property::eString:
+              w.putString(static_cast<Property::String *>(prop)->getValueRaw(j));
+              break;
+            default:
+              break;
+            }
+          }
+        }
+      }
+
+      bool propertySetBinaryRead(BinaryCache::Reader &r, Property::Set &set)
+      {
+        uint32_t count = r.getU32();
+
+        for (uint32_t i = 0; i < count && r.isGood(); i++) {
+          std::string propName = r.getString();
+          Property::TypeEnum propType = Property::TypeEnum(r.getU8());
+          int dimension = r.getI32();
+          uint32_t nValues = r.getU32();
+          if (!r.isGood()) {
+            break;
+          }
+
+          Property::Property *prop = set.fetchProperty(propName.c_str(), false);
+          if (!prop) {
+            if (propType == Property::eInt) {
+              prop = new Property::Int(propName, dimension, false, 0);
+            } else if (propType == Property::eString) {
+              prop = new Property::String(propName, dimension, false, "");
+            } else if (propType == Property::eDouble) {
+              prop = new Property::Double(propName, dimension, false, 0);
+            } else {
+              return false;
+            }
+            set.addProperty(prop);
+          }
+
+          // a property the host already has with another type keeps its values, we just read past ours
+          bool keep = prop->getType() == propType;
+
+          for (uint32_t j = 0; j < nValues; j++) {
+            try {
+              switch (propType) {
+              case Property::eInt: {
+                int v = r.getI32();
+                if (keep) static_cast<Property::Int *>(prop)->setValue(v, int(j));
+                break;
+              }
+              case Property::eDouble: {
+                double v = r.getDouble();
+                if (keep) static_cast<Property::Double *>(prop)->setValue(v, int(j));
+                break;
+              }
+              case Property::eString: {
+                std::string v = r.getString();
+                if (keep) static_cast<Property::String *>(prop)->setValue(v, int(j));
+                break;
+              }
+              default:
+                return false;
+              }
+            }
+            catch (Property::Exception &) {
+              // more values than the host's property has room for, drop the extra ones
+              keep = false;
+            }
+          }
+        }
+
+        return r.isGood();
+      }
+
     }
   }
 }
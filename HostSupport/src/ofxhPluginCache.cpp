@@ -3,7 +3,12 @@
 
 #include <assert.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <string>
 #include <iostream>
 #include <fstream>
@@ -20,8 +25,10 @@
 
 // ofx host
 #include "ofxhBinary.h"
+#include "ofxhBinaryCache.h"
 #include "ofxhPropertySuite.h"
 #include "ofxhMemory.h"
+#include "ofxhMultiThread.h"
 #include "ofxhPluginAPICache.h"
 #include "ofxhPluginCache.h"
 #include "ofxhHost.h"
@@ -95,11 +102,12 @@ void PluginBinary::loadPluginInfo(PluginCache *cache) {
   _fileSize = _binary.getSize();
   _binaryChanged = false;
   
-  // Take a reference to load the binary only once per session. It will
-  // eventually be unloaded in the destructor (see below).
-  // This avoid lots of useless calls to dlopen()/dlclose().
-  if (!_binary.isLoaded()) {
+  // Take a reference so the binary stays loaded while its plugins are
+  // described, rather than being opened again for each of them. It is
+  // dropped by releaseLoadReference(), or at the latest in the destructor.
+  if (!_loadReference) {
     _binary.ref();
+    _loadReference = true;
   }
 
   int (*getNo)(void) = (int(*)()) _binary.findSymbol("OfxGetNumberOfPlugins");
@@ -133,10 +141,15 @@ PluginBinary::~PluginBinary() {
   }
   // release the last reference to the binary, which should unload it
   // if this reference was taken by loadPluginInfo().
-  if (_binary.isLoaded()) {
+  releaseLoadReference();
+  assert(!_binary.isLoaded());
+}
+
+void PluginBinary::releaseLoadReference() {
+  if (_loadReference) {
+    _loadReference = false;
     _binary.unref();
   }
-  assert(!_binary.isLoaded());
 }
 
 PluginHandle::PluginHandle(Plugin *p, OFX::Host::Host *host)
@@ -219,6 +232,7 @@ PluginCache::PluginCache() : _hostSpec(0), _xmlCurrentBinary(0), _xmlCurrentPlug
   _ignoreCache = false;
   _dirty = false;
   _enablePluginSeek = true;
+  _scanThreads = 1;
   
   std::string s = OFXGetEnv("OFX_PLUGIN_PATH");
   
@@ -266,124 +280,294 @@ void PluginCache::setPluginHostPath(const std::string &hostId) {
 #endif
 }
 
-void PluginCache::scanDirectory(std::set<std::string> &foundBinFiles, const std::string &dir, bool recurse)
-{
-#ifdef CACHE_DEBUG
-  printf("looking in %s for plugins\n", dir.c_str());
-#endif
+namespace {
+
+  /// where something was found on the plugin path. Sorting these gives the order a serial,
+  /// depth first walk visiting each directory's entries by name would find things in,
+  /// whatever order the threads walking the path actually got to them.
+  struct ScanKey {
+    size_t root;                         ///< index of the plugin path entry it was found under
+    std::vector<std::string> components; ///< names of the entries leading to it from there
+
+    bool operator<(const ScanKey &other) const {
+      if (root != other.root) {
+        return root < other.root;
+      }
+      return components < other.components;
+    }
+  };
+
+  /// a directory found on the plugin path
+  struct ScanDir {
+    ScanKey key;
+    std::string path;
+    bool recurse;
+
+    bool operator<(const ScanDir &other) const { return key < other.key; }
+  };
+
+  /// a bundle found on the plugin path
+  struct ScanBundle {
+    ScanKey key;
+    std::string bundlePath;
+    std::string barename;
+
+    bool operator<(const ScanBundle &other) const { return key < other.key; }
+  };
+
+  /// shared state of the threads walking the plugin path
+  struct ScanWalk {
+    std::mutex mutex;
+    std::condition_variable changed; ///< signalled when a directory is queued or finished
+    std::deque<ScanDir> pending;     ///< directories waiting to be listed
+    unsigned int busy;               ///< directories being listed right now
+    std::vector<ScanDir> dirs;       ///< directories that could be listed
+    std::vector<ScanBundle> bundles; ///< bundles found in them
+
+    ScanWalk() : busy(0) {}
+  };
 
+  /// a binary found on the plugin path that was not in the cache, to be loaded and described
+  struct ScanNewBinary {
+    std::string binpath;
+    std::string binpathUniversal; ///< where to look if binpath is not there, empty if nowhere
+    std::string bundlePath;
+    PluginBinary *binary;
+  };
+
+  /// shared state of the threads loading binaries, each takes the next one until they run out
+  struct ScanLoad {
+    PluginCache *cache;
+    std::vector<ScanNewBinary> *newBinaries; ///< binaries to make
+    std::vector<PluginBinary *> *changed;    ///< binaries from the cache to reload
+    std::atomic<size_t> next;
+
+    ScanLoad() : cache(0), newBinaries(0), changed(0), next(0) {}
+  };
+
+}
+
+/// list the names of the entries of a directory, and whether they may be directories
+static bool listDirectory(const std::string &dir, std::vector<std::pair<std::string, bool> > &entries)
+{
 #if defined (_WIN32)
   WIN32_FIND_DATA findData;
-  HANDLE findHandle;
+  HANDLE findHandle = FindFirstFile((dir + "\\*").c_str(), &findData);
+  
+  if (findHandle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  
+  do {
+    bool isdir = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    entries.push_back(std::make_pair(std::string(findData.cFileName), isdir));
+  } while (FindNextFile(findHandle, &findData) != 0);
+  
+  FindClose(findHandle);
 #else
   DIR *d = opendir(dir.c_str());
   if (!d) {
-    return;
+    return false;
   }
-#endif
   
-  _pluginDirs.push_back(dir.c_str());
+  // anything may be a directory, those that aren't just fail to open when we get to them
+  while (dirent *de = readdir(d)) {
+    entries.push_back(std::make_pair(std::string(de->d_name), true));
+  }
   
-#if defined (UNIX)
-  while (dirent *de = readdir(d))
-#elif defined (_WIN32)
-    findHandle = FindFirstFile((dir + "\\*").c_str(), &findData);
+  closedir(d);
+#endif
+  return true;
+}
+
+/// thread function walking the plugin path, each thread lists queued directories until there are none left
+static void scanWalkThread(unsigned int /*threadIndex*/, unsigned int /*threadMax*/, void *arg)
+{
+  ScanWalk &walk = *static_cast<ScanWalk *>(arg);
   
-  if (findHandle == INVALID_HANDLE_VALUE) 
-    {
+  std::unique_lock<std::mutex> guard(walk.mutex);
+  for (;;) {
+    while (walk.pending.empty() && walk.busy > 0) {
+      walk.changed.wait(guard);
+    }
+    if (walk.pending.empty()) {
       return;
     }
-  
-  while (1)
-#endif
-    {
-#if defined (UNIX)
-      std::string name = de->d_name;
-      bool isdir = true;
-#else
-      std::string name = findData.cFileName;
-      bool isdir = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    
+    ScanDir dir = walk.pending.front();
+    walk.pending.pop_front();
+    ++walk.busy;
+    guard.unlock();
+    
+#ifdef CACHE_DEBUG
+    printf("looking in %s for plugins\n", dir.path.c_str());
 #endif
+    
+    std::vector<std::pair<std::string, bool> > entries;
+    bool listed = listDirectory(dir.path, entries);
+    
+    std::vector<ScanDir> subdirs;
+    std::vector<ScanBundle> bundles;
+    for (size_t i = 0; i < entries.size(); i++) {
+      const std::string &name = entries[i].first;
+      bool isdir = entries[i].second;
+      
       if (name.find(".ofx.bundle") != std::string::npos) {
-        std::string barename = name.substr(0, name.length() - strlen(".bundle"));
-        std::string bundlename = dir + DIRSEP + name;
-        std::string binpath = dir + DIRSEP + name + DIRSEP "Contents" DIRSEP + ARCHSTR + DIRSEP + barename;
-          
-        // don't insert binpath yet, do it later because of Mac OS X Universal stuff
-        //foundBinFiles.insert(binpath);
+        ScanBundle bundle;
+        bundle.key = dir.key;
+        bundle.key.components.push_back(name);
+        bundle.bundlePath = dir.path + DIRSEP + name;
+        bundle.barename = name.substr(0, name.length() - strlen(".bundle"));
+        bundles.push_back(bundle);
+      } 
+      else if (isdir && (dir.recurse && name[0] != '@' && name != "." && name != "..")) {
+        ScanDir subdir;
+        subdir.key = dir.key;
+        subdir.key.components.push_back(name);
+        subdir.path = dir.path + DIRSEP + name;
+        subdir.recurse = true;
+        subdirs.push_back(subdir);
+      }
+    }
+    
+    guard.lock();
+    if (listed) {
+      walk.dirs.push_back(dir);
+    }
+    walk.bundles.insert(walk.bundles.end(), bundles.begin(), bundles.end());
+    walk.pending.insert(walk.pending.end(), subdirs.begin(), subdirs.end());
+    --walk.busy;
+    walk.changed.notify_all();
+  }
+}
+
+/// thread function loading and describing binaries, each thread takes the next one until they run out
+static void scanLoadThread(unsigned int /*threadIndex*/, unsigned int /*threadMax*/, void *arg)
+{
+  ScanLoad &load = *static_cast<ScanLoad *>(arg);
+  size_t nNew = load.newBinaries->size();
+  size_t nTotal = nNew + load.changed->size();
+  
+  for (size_t i = load.next++; i < nTotal; i = load.next++) {
+    PluginBinary *pb = 0;
+    
+    if (i < nNew) {
+      ScanNewBinary &nb = (*load.newBinaries)[i];
+      pb = new PluginBinary(nb.binpath, nb.bundlePath, load.cache);
+      if (pb->isInvalid() && !nb.binpathUniversal.empty()) {
+        delete pb;
+        nb.binpath = nb.binpathUniversal;
+        pb = new PluginBinary(nb.binpath, nb.bundlePath, load.cache);
+      }
+      nb.binary = pb;
+    } 
+    else {
+      pb = (*load.changed)[i - nNew];
+      pb->loadPluginInfo(load.cache);
+    }
+    
+    for (int j=0;j<pb->getNPlugins();j++) {
+      Plugin *plug = &pb->getPlugin(j);
+      const APICache::PluginAPICacheI &api = plug->getApiHandler();
+      api.loadFromPlugin(plug);
+    }
+    
+    // everything we need is in the descriptors now, so as with binaries read from the
+    // cache, it is not loaded again until an instance of one of its plugins is made
+    pb->releaseLoadReference();
+  }
+}
 
+void PluginCache::scanDirectories(MultiThread::ThreadPool &pool, std::set<std::string> &foundBinFiles)
+{
+  // find all the bundles on the path
+  ScanWalk walk;
+  size_t root = 0;
+  for (std::list<std::string>::iterator paths= _pluginPath.begin();
+       paths != _pluginPath.end();
+       paths++, root++) {
+    ScanDir dir;
+    dir.key.root = root;
+    dir.path = *paths;
+    dir.recurse = _nonrecursePath.find(*paths) == _nonrecursePath.end();
+    walk.pending.push_back(dir);
+  }
+  
+  pool.multiThread(scanWalkThread, pool.getNumCPUs(), &walk);
+  
+  std::sort(walk.dirs.begin(), walk.dirs.end());
+  std::sort(walk.bundles.begin(), walk.bundles.end());
+  
+  for (std::vector<ScanDir>::iterator i = walk.dirs.begin(); i != walk.dirs.end(); i++) {
+    _pluginDirs.push_back(i->path);
+  }
+  
+  // sort out which of them hold binaries we need to describe
+  std::vector<ScanNewBinary> newBinaries;
+  std::set<std::string> newBinFiles;
+  for (std::vector<ScanBundle>::iterator i = walk.bundles.begin(); i != walk.bundles.end(); i++) {
+    std::string binpath = i->bundlePath + DIRSEP "Contents" DIRSEP + ARCHSTR + DIRSEP + i->barename;
+    std::string binpath_universal;
+    
 #if defined(__APPLE__) && (defined(__x86_64) || defined(__x86_64__))
-        /* From the OpenFX specification:
-           
-           MacOS-x86-64 - for Apple Macintosh OS X, specifically on
-           intel x86 CPUs running AMD's 64 bit extensions. 64 bit host
-           applications should check this first, and if it doesn't
-           exist or is empty, fall back to "MacOS" looking for a
-           universal binary.
-        */
-          
-        std::string binpath_universal = dir + DIRSEP + name + DIRSEP "Contents" DIRSEP + "MacOS" + DIRSEP + barename;
-        if (_knownBinFiles.find(binpath_universal) != _knownBinFiles.end()) {
-          binpath = binpath_universal;
-        }
+    /* From the OpenFX specification:
+       
+       MacOS-x86-64 - for Apple Macintosh OS X, specifically on
+       intel x86 CPUs running AMD's 64 bit extensions. 64 bit host
+       applications should check this first, and if it doesn't
+       exist or is empty, fall back to "MacOS" looking for a
+       universal binary.
+    */
+    
+    binpath_universal = i->bundlePath + DIRSEP "Contents" DIRSEP + "MacOS" + DIRSEP + i->barename;
+    if (_knownBinFiles.find(binpath_universal) != _knownBinFiles.end()) {
+      binpath = binpath_universal;
+    }
 #endif
-        if (_knownBinFiles.find(binpath) == _knownBinFiles.end()) {
+    
+    if (_knownBinFiles.find(binpath) == _knownBinFiles.end() && newBinFiles.find(binpath) == newBinFiles.end()) {
 #ifdef CACHE_DEBUG
-          printf("found non-cached binary %s\n", binpath.c_str());
+      printf("found non-cached binary %s\n", binpath.c_str());
 #endif
-          _dirty = true;
-          
-          // the binary was not in the cache
-          
-          PluginBinary *pb = 0;
-#if defined(__x86_64) || defined(__x86_64__)
-          pb = new PluginBinary(binpath, bundlename, this);
-#  if defined(__APPLE__)
-          if (pb->isInvalid()) {
-            // fallback to "MacOS"
-            delete pb;
-            binpath = binpath_universal;
-            pb = new PluginBinary(binpath, bundlename, this);
-          }
-#  endif
-#else
-          pb = new PluginBinary(binpath, bundlename, this);
-#endif
-          _binaries.push_back(pb);
-          _knownBinFiles.insert(binpath);
-          foundBinFiles.insert(binpath);
-
-          for (int j=0;j<pb->getNPlugins();j++) {
-            Plugin *plug = &pb->getPlugin(j);
-            const APICache::PluginAPICacheI &api = plug->getApiHandler();
-            api.loadFromPlugin(plug);
-          }
-        } else {
+      ScanNewBinary nb;
+      nb.binpath = binpath;
+      nb.binpathUniversal = binpath_universal;
+      nb.bundlePath = i->bundlePath;
+      nb.binary = 0;
+      newBinaries.push_back(nb);
+      newBinFiles.insert(binpath);
+    } 
+    else {
 #ifdef CACHE_DEBUG
-          printf("found cached binary %s\n", binpath.c_str());
-#endif
-        }
-        // insert final path (universal or not) in the list of found files
-        foundBinFiles.insert(binpath);
-      } else {
-        if (isdir && (recurse && name[0] != '@' && name != "." && name != "..")) {
-          scanDirectory(foundBinFiles, dir + DIRSEP + name, recurse);
-        }
-      }
-#if defined(_WIN32)
-      int rval = FindNextFile(findHandle, &findData);
-      
-      if (rval == 0) {
-        break;
-      }
+      printf("found cached binary %s\n", binpath.c_str());
 #endif
+      foundBinFiles.insert(binpath);
     }
+  }
   
-#if defined(UNIX)
-  closedir(d);
-#else
-  FindClose(findHandle);
-#endif
+  // binaries in the cache which have changed since it was written, and so need describing again
+  std::vector<PluginBinary *> changed;
+  for (std::list<PluginBinary *>::iterator i=_binaries.begin(); i != _binaries.end(); i++) {
+    if ((*i)->hasBinaryChanged() && foundBinFiles.find((*i)->getFilePath()) != foundBinFiles.end()) {
+      changed.push_back(*i);
+      _dirty = true;
+    }
+  }
+  
+  // load and describe them all, the binaries are independent of each other
+  ScanLoad load;
+  load.cache = this;
+  load.newBinaries = &newBinaries;
+  load.changed = &changed;
+  pool.multiThread(scanLoadThread, pool.getNumCPUs(), &load);
+  
+  // and add the new ones in the order they were found
+  for (std::vector<ScanNewBinary>::iterator i = newBinaries.begin(); i != newBinaries.end(); i++) {
+    _dirty = true;
+    _binaries.push_back(i->binary);
+    _knownBinFiles.insert(i->binpath);
+    foundBinFiles.insert(i->binpath);
+  }
 }
 
 std::string PluginCache::seekPluginFile(const std::string &baseName) const {
@@ -408,11 +592,8 @@ void PluginCache::scanPluginFiles()
 {
   std::set<std::string> foundBinFiles;
   
-  for (std::list<std::string>::iterator paths= _pluginPath.begin();
-       paths != _pluginPath.end();
-       paths++) {
-    scanDirectory(foundBinFiles, *paths, _nonrecursePath.find(*paths) == _nonrecursePath.end());
-  }
+  MultiThread::ThreadPool pool(_scanThreads);
+  scanDirectories(pool, foundBinFiles);
   
   std::list<PluginBinary *>::iterator i=_binaries.begin();
   while (i!=_binaries.end()) {
@@ -428,22 +609,10 @@ void PluginCache::scanPluginFiles()
       
     } else {
       
-      bool binChanged = pb->hasBinaryChanged();
-      
-      // the binary was in the cache, but the binary has changed and thus we need to reload
-      if (binChanged) {
-        pb->loadPluginInfo(this);
-        _dirty = true;
-      }
-      
       for (int j=0;j<pb->getNPlugins();j++) {
         Plugin *plug = &pb->getPlugin(j);
         APICache::PluginAPICacheI &api = plug->getApiHandler();
         
-        if (binChanged) {
-          api.loadFromPlugin(plug);
-        }
-        
         std::string reason;
         
         if (api.pluginSupported(plug, reason)) {
@@ -683,6 +852,197 @@ void PluginCache::writePluginCache(std::ostream &os) const {
   os << "</cache>\n";
 }
 
+/// an entry in the index of a binary cache
+struct BinaryCacheEntry {
+  std::string path;
+  std::string bundlePath;
+  int64_t mtime;
+  int64_t size;
+  uint32_t nPlugins;
+  uint64_t recordsOffset; ///< from the end of the index
+  uint64_t recordsSize;
+};
+
+/// make the plugins of a binary from its records in a binary cache, returns false if any could not be made
+static bool readBinaryCachePlugins(PluginCache *cache,
+                                   PluginBinary *pb,
+                                   const BinaryCacheEntry &entry,
+                                   const char *records,
+                                   const std::shared_ptr<const BinaryCache::Mapping> &mapping)
+{
+  BinaryCache::Reader r(records + entry.recordsOffset, size_t(entry.recordsSize));
+  
+  for (uint32_t i = 0; i < entry.nPlugins; i++) {
+    std::string api = r.getString();
+    std::string rawIdentifier = r.getString();
+    int idx = r.getI32();
+    int api_version = r.getI32();
+    int major_version = r.getI32();
+    int minor_version = r.getI32();
+    bool hasApiData = r.getU8() != 0;
+    uint64_t blobSize = r.getU64();
+    const char *blob = r.skip(size_t(blobSize));
+    
+    if (!r.isGood() || !hasApiData) {
+      return false;
+    }
+    
+    APICache::PluginAPICacheI *apiCache = cache->findApiHandler(api, api_version);
+    if (!apiCache) {
+      return false;
+    }
+    
+    Plugin *pe = apiCache->newPlugin(pb, idx, api, api_version, rawIdentifier, rawIdentifier, major_version, minor_version);
+    pb->addPlugin(pe);
+    if (!apiCache->loadBinary(pe, BinaryCache::Blob(mapping, blob, size_t(blobSize)))) {
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+bool PluginCache::readBinaryCache(const std::string &filename) {
+  std::shared_ptr<const BinaryCache::Mapping> mapping(new BinaryCache::Mapping(filename));
+  if (!mapping->isValid()) {
+    return false;
+  }
+  
+  BinaryCache::Reader r(mapping->getData(), mapping->getSize());
+  
+  const char *magic = r.skip(sizeof(BinaryCache::kMagic));
+  if (!magic || memcmp(magic, BinaryCache::kMagic, sizeof(BinaryCache::kMagic)) != 0) {
+    return false;
+  }
+  if (r.getU32() != BinaryCache::kFormatVersion || r.getU32() != BinaryCache::kByteOrderMark) {
+    return false;
+  }
+  
+  std::string cacheVersion = r.getString();
+  if (cacheVersion != _cacheVersion) {
+#ifdef CACHE_DEBUG
+    printf("mismatched version, ignoring binary cache (got '%s', wanted '%s')\n",
+           cacheVersion.c_str(),
+           _cacheVersion.c_str());
+#endif
+    return false;
+  }
+  
+  // read and check the whole index before making anything, so a bad file leaves us untouched
+  uint32_t nBinaries = r.getU32();
+  std::vector<BinaryCacheEntry> entries;
+  for (uint32_t i = 0; i < nBinaries && r.isGood(); i++) {
+    BinaryCacheEntry entry;
+    entry.path = r.getString();
+    entry.bundlePath = r.getString();
+    entry.mtime = r.getI64();
+    entry.size = r.getI64();
+    entry.nPlugins = r.getU32();
+    entry.recordsOffset = r.getU64();
+    entry.recordsSize = r.getU64();
+    entries.push_back(entry);
+  }
+  if (!r.isGood()) {
+    return false;
+  }
+  
+  const char *records = r.getPos();
+  uint64_t recordsSize = r.getRemaining();
+  for (std::vector<BinaryCacheEntry>::const_iterator i = entries.begin(); i != entries.end(); i++) {
+    if (i->recordsOffset > recordsSize || i->recordsSize > recordsSize - i->recordsOffset) {
+      return false;
+    }
+  }
+  
+  for (std::vector<BinaryCacheEntry>::const_iterator i = entries.begin(); i != entries.end(); i++) {
+    if (_knownBinFiles.find(i->path) != _knownBinFiles.end()) {
+      continue;
+    }
+    
+    PluginBinary *pb = new PluginBinary(i->path, i->bundlePath, time_t(i->mtime), off_t(i->size));
+    
+    // the records of binaries that have changed are never looked at, they get described again
+    if (!pb->isInvalid() && !pb->hasBinaryChanged() &&
+        !readBinaryCachePlugins(this, pb, *i, records, mapping)) {
+#ifdef CACHE_DEBUG
+      printf("bad binary cache records for %s, will describe it again\n", i->path.c_str());
+#endif
+      delete pb;
+      continue;
+    }
+    
+    _binaries.push_back(pb);
+    _knownBinFiles.insert(i->path);
+  }
+  
+  return true;
+}
+
+bool PluginCache::writeBinaryCache(const std::string &filename) const {
+#ifdef CACHE_DEBUG
+  printf("writing binary pluginCache with version = %s\n", _cacheVersion.c_str());
+#endif
+  
+  BinaryCache::Writer index;
+  BinaryCache::Writer records;
+  
+  index.putRaw(BinaryCache::kMagic, sizeof(BinaryCache::kMagic));
+  index.putU32(BinaryCache::kFormatVersion);
+  index.putU32(BinaryCache::kByteOrderMark);
+  index.putString(_cacheVersion);
+  index.putU32(uint32_t(_binaries.size()));
+  
+  for (std::list<PluginBinary *>::const_iterator i=_binaries.begin();i!=_binaries.end();i++) {
+    PluginBinary *b = *i;
+    size_t recordsStart = records.getSize();
+    
+    for (int j=0;j<b->getNPlugins();j++) {
+      Plugin *p = &b->getPlugin(j);
+      
+      records.putString(p->getPluginApi());
+      records.putString(p->getRawIdentifier());
+      records.putI32(p->getIndex());
+      records.putI32(p->getApiVersion());
+      records.putI32(p->getVersionMajor());
+      records.putI32(p->getVersionMinor());
+      
+      size_t hasApiDataPos = records.getSize();
+      records.putU8(0);
+      size_t blobSizePos = records.reserveU64();
+      size_t blobStart = records.getSize();
+      
+      const APICache::PluginAPICacheI &api = p->getApiHandler();
+      if (api.saveBinary(p, records)) {
+        records.patchU8(hasApiDataPos, 1);
+      }
+      records.patchU64(blobSizePos, records.getSize() - blobStart);
+    }
+    
+    index.putString(b->getFilePath());
+    index.putString(b->getBundlePath());
+    index.putI64(int64_t(b->getFileModificationTime()));
+    index.putI64(int64_t(b->getFileSize()));
+    index.putU32(uint32_t(b->getNPlugins()));
+    index.putU64(recordsStart);
+    index.putU64(records.getSize() - recordsStart);
+  }
+  
+  // plugins may still be holding blobs in the file we are replacing, so don't write over it
+  std::string tmpFilename = filename + ".tmp";
+  {
+    std::ofstream os(tmpFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    os.write(index.getBuffer().data(), std::streamsize(index.getSize()));
+    os.write(records.getBuffer().data(), std::streamsize(records.getSize()));
+    os.close();
+    if (os.fail()) {
+      remove(tmpFilename.c_str());
+      return false;
+    }
+  }
+  
+  return BinaryCache::replaceFile(tmpFilename, filename);
+}
+
 
 APICache::PluginAPICacheI *PluginCache::findApiHandler(const std::string &api, int version) {
   std::list<PluginCacheSupportedApi>::iterator i = _apiHandlers.begin();
@@ -12,6 +12,7 @@
 
 #include <iostream>
 #include <string.h>
+#include <stdint.h>
 
 namespace OFX {
   namespace Host {
@@ -392,19 +393,126 @@ namespace OFX {
         }
       }
 
-      Property *Set::fetchProperty(const std::string&name, bool followChain) const
+      template <class ENTRY> size_t NameIndex<ENTRY>::hashName(const char *name, size_t &length)
+      {
+        // the kOfx names share long prefixes and mostly differ towards the end, so rather
+        // than walk every character, mix the length with the first and last eight bytes
+        length = strlen(name);
+        uint64_t head = 0, tail = 0;
+        size_t n = length < sizeof(tail) ? length : sizeof(tail);
+        memcpy(&head, name, n);
+        memcpy(&tail, name + length - n, n);
+        uint64_t hash = (tail ^ (uint64_t(length) * 0x9e3779b97f4a7c15ull)) * 0xff51afd7ed558ccdull;
+        hash = (hash ^ (hash >> 32) ^ head) * 0xc4ceb9fe1a85ec53ull;
+        return size_t(hash ^ (hash >> 29));
+      }
+
+      template <class ENTRY> size_t NameIndex<ENTRY>::probe(const char *name, size_t length, size_t hash) const
+      {
+        size_t mask = _slots.size() - 1;
+        size_t i = hash & mask;
+        while(_slots[i].entry) {
+          if(_slots[i].hash == hash) {
+            const std::string &slotName = _slots[i].entry->getName();
+            if(slotName.size() == length && (slotName.c_str() == name || memcmp(slotName.c_str(), name, length) == 0))
+              return i;
+          }
+          i = (i + 1) & mask;
+        }
+        return i;
+      }
+
+      template <class ENTRY> void NameIndex<ENTRY>::grow()
       {
-        PropertyMap::const_iterator i = _props.find(name);
-        if (i == _props.end()) {
-          if(followChain && _chainedSet) {
-            return _chainedSet->fetchProperty(name, true);
+        std::vector<Slot> old;
+        old.swap(_slots);
+        Slot empty = {0, NULL};
+        _slots.resize(old.empty() ? 16 : old.size() * 2, empty);
+        size_t mask = _slots.size() - 1;
+        for(typename std::vector<Slot>::const_iterator s = old.begin(); s != old.end(); ++s) {
+          if(s->entry) {
+            size_t i = s->hash & mask;
+            while(_slots[i].entry)
+              i = (i + 1) & mask;
+            _slots[i] = *s;
           }
+        }
+      }
+
+      template <class ENTRY> ENTRY *NameIndex<ENTRY>::find(const char *name) const
+      {
+        if(_count == 0)
           return NULL;
+        size_t length;
+        size_t hash = hashName(name, length);
+        return _slots[probe(name, length, hash)].entry;
+      }
+
+      template <class ENTRY> void NameIndex<ENTRY>::insert(ENTRY *entry)
+      {
+        // keep the table at most half full, so probes stay short
+        if((_count + 1) * 2 > _slots.size())
+          grow();
+        size_t length;
+        size_t hash = hashName(entry->getName().c_str(), length);
+        Slot &slot = _slots[probe(entry->getName().c_str(), length, hash)];
+        if(!slot.entry)
+          ++_count;
+        slot.hash = hash;
+        slot.entry = entry;
+      }
+
+      template <class ENTRY> void NameIndex<ENTRY>::clear()
+      {
+        _slots.clear();
+        _count = 0;
+      }
+
+      template class NameIndex<Property>;
+      template class NameIndex<const PropertyIdTable::Id>;
+
+      PropertyIdTable::PropertyIdTable(const Entry *entries)
+      {
+        for(const Entry *e = entries; e->name; ++e) {
+          Id id;
+          id.name = e->name;
+          id.id = e->id;
+          _ids.push_back(id);
         }
-        return i->second;
+        // only index once _ids is full, so it won't move
+        for(size_t i = 0; i < _ids.size(); ++i)
+          _index.insert(&_ids[i]);
+      }
+
+      int PropertyIdTable::find(const std::string &name) const
+      {
+        const Id *id = _index.find(name.c_str());
+        return id ? id->id : -1;
+      }
+
+      Property *Set::fetchProperty(const std::string&name, bool followChain) const
+      {
+        return fetchProperty(name.c_str(), followChain);
+      }
+
+      Property *Set::fetchProperty(const char *name, bool followChain) const
+      {
+        const Set *set = this;
+        do {
+          Property *prop = set->_index.find(name);
+          if(prop)
+            return prop;
+          set = set->_chainedSet;
+        } while(followChain && set);
+        return NULL;
       }
 
       template<class T> bool Set::fetchTypedProperty(const std::string&name, T *&prop, bool followChain) const
+      {
+        return fetchTypedProperty(name.c_str(), prop, followChain);
+      }
+
+      template<class T> bool Set::fetchTypedProperty(const char *name, T *&prop, bool followChain) const
       {
         Property *myprop = fetchProperty(name, followChain);
 
@@ -453,29 +561,35 @@ namespace OFX {
       /// add one new property
       void Set::createProperty(const PropSpec &spec)
       {
-        if (_props.find(spec.name) != _props.end()) {
+        if (_index.find(spec.name)) {
 #         ifdef OFX_DEBUG_PROPERTIES
           std::cout << "OFX: Tried to add a duplicate property to a Property::Set: " << spec.name << std::endl;
 #         endif
           return;
         }
 
+        Property *prop = NULL;
         switch (spec.type) {
         case eInt: 
-          _props[spec.name] = new Int(spec.name, spec.dimension, spec.readonly, spec.defaultValue?atoi(spec.defaultValue):0);
+          prop = new Int(spec.name, spec.dimension, spec.readonly, spec.defaultValue?atoi(spec.defaultValue):0);
           break;
         case eDouble: 
-          _props[spec.name] = new Double(spec.name, spec.dimension, spec.readonly, spec.defaultValue?atof(spec.defaultValue):0);
+          prop = new Double(spec.name, spec.dimension, spec.readonly, spec.defaultValue?atof(spec.defaultValue):0);
           break;
         case eString: 
-          _props[spec.name] = new String(spec.name, spec.dimension, spec.readonly, spec.defaultValue?spec.defaultValue:"");
+          prop = new String(spec.name, spec.dimension, spec.readonly, spec.defaultValue?spec.defaultValue:"");
           break;
         case ePointer: 
-          _props[spec.name] = new Pointer(spec.name, spec.dimension, spec.readonly, (void*)spec.defaultValue);
+          prop = new Pointer(spec.name, spec.dimension, spec.readonly, (void*)spec.defaultValue);
           break;
         default: // XXX  error - unrecognised type
           break;
         }
+
+        if(prop) {
+          _props[spec.name] = prop;
+          _index.insert(prop);
+        }
       }
 
       void Set::addProperties(const PropSpec spec[]) 
@@ -493,6 +607,7 @@ namespace OFX {
         if(t != _props.end())
            delete t->second;
         _props[prop->getName()] = prop;
+        _index.insert(prop);
       }
 
       /// empty ctor
@@ -525,16 +640,18 @@ namespace OFX {
               break;
             }
             _props[i->first] = copyProp;
+            _index.insert(copyProp);
           }
         
-        if (failed)
-          
+        if (failed) {
           for (std::map<std::string, Property *>::iterator j = _props.begin();
                j != _props.end();
                j++) {
             delete j->second;
           }
-        
+          _props.clear();
+          _index.clear();
+        }
       }
 
       Set::~Set()
@@ -0,0 +1,323 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+// ofx host
+#include "ofxhBinary.h"
+#include "ofxhImageEffect.h"
+#include "ofxhPluginAPICache.h"
+#include "ofxhPluginCache.h"
+#include "ofxhImageEffectAPI.h"
+#include "ofxhRenderScheduler.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      /// strips are not made shorter than this, in pixels
+      static const int kMinStripHeight = 16;
+
+      std::mutex &RenderScheduler::getUnsafeRenderMutex(ImageEffectPlugin *plugin)
+      {
+        static std::mutex mapMutex;
+        static std::map<ImageEffectPlugin *, std::unique_ptr<std::mutex> > mutexes;
+
+        std::lock_guard<std::mutex> guard(mapMutex);
+        std::unique_ptr<std::mutex> &m = mutexes[plugin];
+        if(!m)
+          m.reset(new std::mutex);
+        return *m;
+      }
+
+      /// one run of frames, shared between the threads rendering them
+      struct RenderScheduler::Job {
+        RenderScheduler         *scheduler;
+        std::vector<Instance *>  instances;  ///< the instance each thread index renders on, one shared by all if there is only one
+        std::vector<OfxTime>     frames;
+        std::vector<OfxRectI>    strips;     ///< each frame is rendered as these
+        OfxPointD                renderScale;
+        std::string              field;
+        bool                     sequential;
+        bool                     interactive;
+        bool                     draft;
+        std::atomic<size_t>      next;       ///< next item to hand out, frame major
+        std::unique_ptr<std::atomic<size_t>[]> stripsLeft; ///< strips of each frame still to render
+        std::atomic<bool>        failed;
+        std::mutex               statusMutex;
+        OfxStatus                status;     ///< of the first render to fail
+
+        Job()
+          : scheduler(0)
+          , sequential(false)
+          , interactive(false)
+          , draft(false)
+          , next(0)
+          , failed(false)
+          , status(kOfxStatOK)
+        {
+        }
+
+        /// make the counters, once frames and strips are set
+        void reset()
+        {
+          next = 0;
+          stripsLeft.reset(new std::atomic<size_t>[frames.size()]);
+          for(size_t i = 0; i < frames.size(); ++i)
+            stripsLeft[i] = strips.size();
+        }
+
+        void fail(OfxStatus st)
+        {
+          std::lock_guard<std::mutex> guard(statusMutex);
+          if(!failed)
+            status = st;
+          failed = true;
+        }
+      };
+
+      RenderScheduler::RenderScheduler(Instance &instance, unsigned int maxThreads)
+        : _instance(instance)
+        , _maxThreads(maxThreads)
+      {
+      }
+
+      RenderScheduler::~RenderScheduler()
+      {
+        clearRenderInstances();
+      }
+
+      void RenderScheduler::clearRenderInstances()
+      {
+        for(std::vector<Instance *>::iterator i = _poolInstances.begin(); i != _poolInstances.end(); ++i)
+          delete *i;
+        _poolInstances.clear();
+        _poolGenerations.clear();
+      }
+
+      /// copy every param of one instance onto the same param of another of the same plugin,
+      /// skipping those whose instances cannot copy, false if a copy failed otherwise
+      static bool copyParams(const Instance &from, Instance &to)
+      {
+        const std::map<std::string, Param::Instance *> &params = from.getParams();
+        for(std::map<std::string, Param::Instance *>::const_iterator i = params.begin(); i != params.end(); ++i) {
+          Param::Instance *param = to.getParam(i->first);
+          if(!param)
+            return false;
+          OfxStatus stat = param->copyFrom(*i->second, 0, NULL);
+          if(stat != kOfxStatOK && stat != kOfxStatErrMissingHostFeature)
+            return false;
+        }
+        return true;
+      }
+
+      Instance *RenderScheduler::newRenderInstance()
+      {
+        std::unique_ptr<Instance> instance(_instance.getPlugin()->createInstance(_instance.getContext(), NULL));
+        if(!instance)
+          return 0;
+        // before the create instance action, which may look at them
+        if(!copyParams(_instance, *instance))
+          return 0;
+        OfxStatus stat = instance->createInstanceAction();
+        if(stat != kOfxStatOK && stat != kOfxStatReplyDefault)
+          return 0;
+        instance->getClipPreferences();
+        return instance.release();
+      }
+
+      bool RenderScheduler::syncRenderInstance(Instance &instance)
+      {
+        if(!copyParams(_instance, instance))
+          return false;
+        return instance.getClipPreferences();
+      }
+
+      void RenderScheduler::frameRendered(Instance &, OfxTime)
+      {
+      }
+
+      OfxStatus RenderScheduler::renderItem(Job &job, Instance &instance, size_t item)
+      {
+        size_t nStrips = job.strips.size();
+        OfxTime time = job.frames[item / nStrips];
+        return instance.renderAction(time, job.field, job.strips[item % nStrips], job.renderScale,
+                                     job.sequential, job.interactive, job.draft);
+      }
+
+      void RenderScheduler::renderThread(unsigned int threadIndex, unsigned int, void *customArg)
+      {
+        Job &job = *static_cast<Job *>(customArg);
+        Instance &instance = *job.instances[job.instances.size() == 1 ? 0 : threadIndex];
+        size_t nItems = job.frames.size() * job.strips.size();
+
+        while(!job.failed) {
+          size_t item = job.next.fetch_add(1);
+          if(item >= nItems)
+            break;
+
+          OfxStatus st = renderItem(job, instance, item);
+          if(st != kOfxStatOK) {
+            job.fail(st);
+            break;
+          }
+
+          size_t frame = item / job.strips.size();
+          if(job.stripsLeft[frame].fetch_sub(1) == 1)
+            job.scheduler->frameRendered(instance, job.frames[frame]);
+        }
+      }
+
+      OfxStatus RenderScheduler::render(OfxTime startFrame,
+                                        OfxTime endFrame,
+                                        OfxTime step,
+                                        const OfxRectI &renderWindow,
+                                        OfxPointD renderScale,
+                                        const std::string &field,
+                                        bool interactive,
+                                        bool draft)
+      {
+        MultiThread::ThreadPool &pool = gImageEffectHost->getThreadPool();
+
+        Job job;
+        job.scheduler = this;
+        job.renderScale = renderScale;
+        job.field = field;
+        job.interactive = interactive;
+        job.draft = draft;
+        for(OfxTime t = startFrame; t <= endFrame; t += step) {
+          job.frames.push_back(t);
+          if(step <= 0)
+            break;
+        }
+
+        const Descriptor &desc = _instance.getDescriptor();
+        const std::string &safety = desc.getRenderThreadSafety();
+        job.sequential = _instance.getProps().getIntProperty(kOfxImageEffectInstancePropSequentialRender) == 1;
+
+        unsigned int nThreads = pool.getNumCPUs();
+        if(_maxThreads != 0)
+          nThreads = std::min(nThreads, _maxThreads);
+        unsigned int framesAtOnce = job.sequential ? 1 : (unsigned int) std::min<size_t>(nThreads, job.frames.size());
+        int nStrips = 1;
+
+        std::unique_lock<std::mutex> unsafeLock;
+        job.instances.push_back(&_instance);
+
+        if(safety == kOfxImageEffectRenderFullySafe) {
+          // strips make up for there being fewer frames than threads
+          int height = renderWindow.y2 - renderWindow.y1;
+          if(desc.getHostFrameThreading() && desc.supportsTiles() && framesAtOnce > 0 && framesAtOnce < nThreads)
+            nStrips = std::max(1, std::min(int((nThreads + framesAtOnce - 1) / framesAtOnce), height / kMinStripHeight));
+          nThreads = std::min(nThreads, framesAtOnce * nStrips);
+        }
+        else if(safety == kOfxImageEffectRenderInstanceSafe) {
+          // an instance for each frame rendering at once, the first being the one we were given
+          nThreads = std::max(1u, framesAtOnce);
+          unsigned int generation = _instance.getStateGeneration();
+          for(size_t i = 0; i < _poolInstances.size() && i + 1 < nThreads; ++i) {
+            if(_poolGenerations[i] == generation)
+              continue;
+            if(syncRenderInstance(*_poolInstances[i])) {
+              _poolGenerations[i] = generation;
+              continue;
+            }
+            // could not be brought up to date, so make it afresh, or drop it and those after it
+            delete _poolInstances[i];
+            _poolInstances[i] = newRenderInstance();
+            if(!_poolInstances[i]) {
+              for(size_t j = i + 1; j < _poolInstances.size(); ++j)
+                delete _poolInstances[j];
+              _poolInstances.resize(i);
+              _poolGenerations.resize(i);
+              break;
+            }
+            _poolGenerations[i] = generation;
+          }
+          while(_poolInstances.size() + 1 < nThreads) {
+            Instance *instance = newRenderInstance();
+            if(!instance)
+              break;
+            _poolInstances.push_back(instance);
+            _poolGenerations.push_back(generation);
+          }
+          nThreads = std::min(nThreads, (unsigned int) _poolInstances.size() + 1);
+          job.instances.insert(job.instances.end(), _poolInstances.begin(), _poolInstances.begin() + (nThreads - 1));
+        }
+        else {
+          // unsafe, one render at a time among all instances of the plugin
+          nThreads = 1;
+          unsafeLock = std::unique_lock<std::mutex>(getUnsafeRenderMutex(_instance.getPlugin()));
+        }
+        nThreads = std::max(1u, nThreads);
+
+        // split the window into strips of whole rows
+        for(int i = 0; i < nStrips; ++i) {
+          OfxRectI strip = renderWindow;
+          int height = renderWindow.y2 - renderWindow.y1;
+          strip.y1 = renderWindow.y1 + int((long long) height * i / nStrips);
+          strip.y2 = renderWindow.y1 + int((long long) height * (i + 1) / nStrips);
+          job.strips.push_back(strip);
+        }
+
+        // begin the sequence on each instance we are rendering on
+        OfxStatus stat = kOfxStatOK;
+        size_t nBegun = 0;
+        for(; nBegun < job.instances.size(); ++nBegun) {
+          OfxStatus st = job.instances[nBegun]->beginRenderAction(startFrame, endFrame, step, interactive, renderScale,
+                                                                  job.sequential, interactive);
+          if(st != kOfxStatOK && st != kOfxStatReplyDefault) {
+            stat = st;
+            break;
+          }
+        }
+
+        if(stat == kOfxStatOK) {
+          // sequential renders do a frame at a time, in order, any strips of it at once
+          std::vector<OfxTime> frames;
+          if(job.sequential)
+            frames.swap(job.frames);
+          size_t nRuns = job.sequential ? frames.size() : 1;
+
+          for(size_t run = 0; run < nRuns && !job.failed; ++run) {
+            if(job.sequential)
+              job.frames.assign(1, frames[run]);
+            job.reset();
+
+            unsigned int n = (unsigned int) std::min<size_t>(nThreads, job.frames.size() * job.strips.size());
+            if(n <= 1) {
+              try {
+                renderThread(0, 1, &job);
+              }
+              catch(...) {
+                job.fail(kOfxStatFailed);
+              }
+            }
+            else if(pool.multiThread(renderThread, n, &job) != kOfxStatOK && !job.failed)
+              job.fail(kOfxStatFailed);
+          }
+          stat = job.status;
+        }
+
+        for(size_t i = 0; i < nBegun; ++i)
+          job.instances[i]->endRenderAction(startFrame, endFrame, step, interactive, renderScale,
+                                            job.sequential, interactive);
+
+        return stat;
+      }
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
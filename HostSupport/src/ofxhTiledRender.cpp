@@ -0,0 +1,318 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+// ofx
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+
+// ofx host
+#include "ofxhBinary.h"
+#include "ofxhImageEffect.h"
+#include "ofxhPluginAPICache.h"
+#include "ofxhPluginCache.h"
+#include "ofxhImageEffectAPI.h"
+#include "ofxhRenderScheduler.h"
+#include "ofxhTiledRender.h"
+
+namespace OFX {
+
+  namespace Host {
+
+    namespace ImageEffect {
+
+      /// tiles are not halved below this many pixels on a side
+      static const int kMinTileSize = 64;
+
+      /// the tile being rendered on each thread
+      static thread_local const RenderTile *tCurrentTile = 0;
+
+      /// bytes in a pixel of the given depth and components, for the ones we do not know, as if float RGBA
+      static size_t bytesPerPixel(const std::string &depth, const std::string &components)
+      {
+        size_t bytes = 4;
+        if(depth == kOfxBitDepthByte)
+          bytes = 1;
+        else if(depth == kOfxBitDepthShort || depth == kOfxBitDepthHalf)
+          bytes = 2;
+
+        if(components == kOfxImageComponentAlpha)
+          return bytes;
+        if(components == kOfxImageComponentRGB)
+          return bytes * 3;
+        return bytes * 4;
+      }
+
+      /// one render of a list of tiles, shared between the threads rendering them
+      struct TiledRender::Job {
+        TiledRender                   *renderer;
+        const std::vector<RenderTile> *tiles;
+        OfxTime                        time;
+        OfxPointD                      renderScale;
+        std::string                    field;
+        bool                           sequential;
+        bool                           interactive;
+        bool                           draft;
+        std::atomic<size_t>            next;   ///< next tile to hand out
+        std::atomic<bool>              failed;
+        std::mutex                     statusMutex;
+        OfxStatus                      status; ///< of the first render to fail
+
+        Job()
+          : renderer(0)
+          , tiles(0)
+          , time(0)
+          , sequential(false)
+          , interactive(false)
+          , draft(false)
+          , next(0)
+          , failed(false)
+          , status(kOfxStatOK)
+        {
+        }
+
+        void fail(OfxStatus st)
+        {
+          std::lock_guard<std::mutex> guard(statusMutex);
+          if(!failed)
+            status = st;
+          failed = true;
+        }
+      };
+
+      /// sets the current tile for the duration of its render
+      class CurrentTileScope {
+        const RenderTile *_old;
+      public :
+        explicit CurrentTileScope(const RenderTile *tile) : _old(tCurrentTile) { tCurrentTile = tile; }
+        ~CurrentTileScope() { tCurrentTile = _old; }
+      };
+
+      TiledRender::TiledRender(Instance &instance, size_t memoryBudget, unsigned int maxThreads)
+        : _instance(instance)
+        , _memoryBudget(memoryBudget)
+        , _maxThreads(maxThreads)
+      {
+      }
+
+      TiledRender::~TiledRender()
+      {
+      }
+
+      void TiledRender::tileRendered(const RenderTile &)
+      {
+      }
+
+      const RenderTile *TiledRender::getCurrentTile()
+      {
+        return tCurrentTile;
+      }
+
+      unsigned int TiledRender::getConcurrency() const
+      {
+        const Descriptor &desc = _instance.getDescriptor();
+        if(desc.getRenderThreadSafety() != kOfxImageEffectRenderFullySafe || !desc.getHostFrameThreading())
+          return 1;
+        unsigned int n = gImageEffectHost->getThreadPool().getNumCPUs();
+        if(_maxThreads != 0)
+          n = std::min(n, _maxThreads);
+        return std::max(1u, n);
+      }
+
+      OfxStatus TiledRender::makeTile(OfxTime time, OfxPointD renderScale, const OfxRectI &window, RenderTile &tile)
+      {
+        tile.window = window;
+        tile.rois.clear();
+        tile.bytes = 0;
+
+        ClipInstance *output = _instance.getClip(kOfxImageEffectOutputClipName);
+        double par = output ? output->getAspectRatio() : 1.0;
+        if(par <= 0)
+          par = 1.0;
+        if(output)
+          tile.bytes = size_t(window.x2 - window.x1) * size_t(window.y2 - window.y1) *
+            bytesPerPixel(output->getPixelDepth(), output->getComponents());
+
+        // the tile in canonical coordinates
+        OfxRectD roi;
+        roi.x1 = window.x1 * par / renderScale.x;
+        roi.x2 = window.x2 * par / renderScale.x;
+        roi.y1 = window.y1 / renderScale.y;
+        roi.y2 = window.y2 / renderScale.y;
+
+        std::map<ClipInstance *, OfxRectD> rois;
+        OfxStatus stat = _instance.getRegionOfInterestAction(time, renderScale, roi, rois);
+        if(stat != kOfxStatOK && stat != kOfxStatReplyDefault)
+          return stat;
+
+        // only what the inputs have is fetched, so clip each region to its input's RoD
+        for(std::map<ClipInstance *, OfxRectD>::iterator i = rois.begin(); i != rois.end(); ++i) {
+          ClipInstance *clip = i->first;
+          if(clip->isOutput() || !clip->getConnected())
+            continue;
+          OfxRectD rod = clip->getRegionOfDefinition(time);
+          OfxRectD r = i->second;
+          r.x1 = std::max(r.x1, rod.x1);
+          r.x2 = std::min(r.x2, rod.x2);
+          r.y1 = std::max(r.y1, rod.y1);
+          r.y2 = std::min(r.y2, rod.y2);
+          if(r.x2 < r.x1 || r.y2 < r.y1)
+            r.x2 = r.x1, r.y2 = r.y1;
+          tile.rois[clip] = r;
+
+          double clipPar = clip->getAspectRatio();
+          if(clipPar <= 0)
+            clipPar = 1.0;
+          double pixels = ((r.x2 - r.x1) * renderScale.x / clipPar + 1) * ((r.y2 - r.y1) * renderScale.y + 1);
+          tile.bytes += size_t(pixels) * bytesPerPixel(clip->getPixelDepth(), clip->getComponents());
+        }
+        return kOfxStatOK;
+      }
+
+      OfxStatus TiledRender::plan(OfxTime time,
+                                  const OfxRectI &renderWindow,
+                                  OfxPointD renderScale,
+                                  std::vector<RenderTile> &tiles)
+      {
+        tiles.clear();
+        int width = renderWindow.x2 - renderWindow.x1;
+        int height = renderWindow.y2 - renderWindow.y1;
+        if(width <= 0 || height <= 0)
+          return kOfxStatOK;
+
+        // can the effect and all its clips take part of a frame
+        const Descriptor &desc = _instance.getDescriptor();
+        bool tiled = desc.supportsTiles();
+        const std::vector<ClipDescriptor *> &clips = desc.getClipsByOrder();
+        for(std::vector<ClipDescriptor *>::const_iterator i = clips.begin(); tiled && i != clips.end(); ++i)
+          tiled = (*i)->supportsTiles();
+
+        int tileWidth = width, tileHeight = height;
+        if(tiled) {
+          unsigned int nThreads = getConcurrency();
+          size_t tileBudget = _memoryBudget / nThreads;
+
+          // halve the longer side of a tile in the middle of the window, whose regions of
+          // interest are not cut short by the edges of the inputs, until it fits in its
+          // share of the budget and there is a tile for each thread
+          for(;;) {
+            size_t nTiles = size_t((width + tileWidth - 1) / tileWidth) * size_t((height + tileHeight - 1) / tileHeight);
+            bool split = nTiles < nThreads;
+            if(!split && _memoryBudget != 0) {
+              OfxRectI middle;
+              middle.x1 = renderWindow.x1 + (width - tileWidth) / 2;
+              middle.y1 = renderWindow.y1 + (height - tileHeight) / 2;
+              middle.x2 = middle.x1 + tileWidth;
+              middle.y2 = middle.y1 + tileHeight;
+              RenderTile tile;
+              OfxStatus stat = makeTile(time, renderScale, middle, tile);
+              if(stat != kOfxStatOK)
+                return stat;
+              split = tile.bytes > tileBudget;
+            }
+            if(!split)
+              break;
+
+            bool canHalveWidth = tileWidth / 2 >= kMinTileSize;
+            bool canHalveHeight = tileHeight / 2 >= kMinTileSize;
+            if(canHalveWidth && (tileWidth >= tileHeight || !canHalveHeight))
+              tileWidth = (tileWidth + 1) / 2;
+            else if(canHalveHeight)
+              tileHeight = (tileHeight + 1) / 2;
+            else
+              break;
+          }
+        }
+
+        for(int y = renderWindow.y1; y < renderWindow.y2; y += tileHeight) {
+          for(int x = renderWindow.x1; x < renderWindow.x2; x += tileWidth) {
+            OfxRectI window;
+            window.x1 = x;
+            window.y1 = y;
+            window.x2 = std::min(x + tileWidth, renderWindow.x2);
+            window.y2 = std::min(y + tileHeight, renderWindow.y2);
+            tiles.push_back(RenderTile());
+            OfxStatus stat = makeTile(time, renderScale, window, tiles.back());
+            if(stat != kOfxStatOK)
+              return stat;
+          }
+        }
+        return kOfxStatOK;
+      }
+
+      void TiledRender::renderThread(unsigned int, unsigned int, void *customArg)
+      {
+        Job &job = *static_cast<Job *>(customArg);
+        Instance &instance = job.renderer->_instance;
+
+        while(!job.failed) {
+          size_t index = job.next.fetch_add(1);
+          if(index >= job.tiles->size())
+            break;
+
+          const RenderTile &tile = (*job.tiles)[index];
+          OfxStatus st;
+          {
+            CurrentTileScope scope(&tile);
+            st = instance.renderAction(job.time, job.field, tile.window, job.renderScale,
+                                       job.sequential, job.interactive, job.draft);
+          }
+          if(st != kOfxStatOK) {
+            job.fail(st);
+            break;
+          }
+          job.renderer->tileRendered(tile);
+        }
+      }
+
+      OfxStatus TiledRender::render(OfxTime time,
+                                    const OfxRectI &renderWindow,
+                                    OfxPointD renderScale,
+                                    const std::string &field,
+                                    bool sequential,
+                                    bool interactive,
+                                    bool draft)
+      {
+        std::vector<RenderTile> tiles;
+        OfxStatus stat = plan(time, renderWindow, renderScale, tiles);
+        if(stat != kOfxStatOK)
+          return stat;
+
+        Job job;
+        job.renderer = this;
+        job.tiles = &tiles;
+        job.time = time;
+        job.renderScale = renderScale;
+        job.field = field;
+        job.sequential = sequential;
+        job.interactive = interactive;
+        job.draft = draft;
+
+        std::unique_lock<std::mutex> unsafeLock;
+        if(_instance.getDescriptor().getRenderThreadSafety() != kOfxImageEffectRenderInstanceSafe &&
+           _instance.getDescriptor().getRenderThreadSafety() != kOfxImageEffectRenderFullySafe)
+          unsafeLock = std::unique_lock<std::mutex>(RenderScheduler::getUnsafeRenderMutex(_instance.getPlugin()));
+
+        unsigned int n = (unsigned int) std::min<size_t>(getConcurrency(), tiles.size());
+        if(n <= 1) {
+          try {
+            renderThread(0, 1, &job);
+          }
+          catch(...) {
+            job.fail(kOfxStatFailed);
+          }
+        }
+        else if(gImageEffectHost->getThreadPool().multiThread(renderThread, n, &job) != kOfxStatOK && !job.failed)
+          job.fail(kOfxStatFailed);
+
+        return job.status;
+      }
+
+    } // namespace ImageEffect
+
+  } // namespace Host
+
+} // namespace OFX
@@ -0,0 +1,118 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+  Times OFX::BitDepth::convertPixels for every pair of the standard bit depths, over an
+  RGBA image whose source and destination rows are padded differently, and reports the
+  rate at which each moves memory. Each pair is run with the scalar kernels and with the
+  best instruction set the CPU has, and the widening pairs are run in place as well.
+
+  usage : depthConversion [width height nRuns]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "ofxsBitDepth.h"
+#include "ofxsPixelKernels.h"
+
+// the support library's entry point asks the plugin for its factories, and we have none
+namespace OFX {
+  namespace Plugin {
+    void getPluginIDs(OFX::PluginFactoryArray &) {}
+  }
+}
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  using namespace OFX;
+
+  const BitDepthEnum kDepths[] = { eBitDepthUByte, eBitDepthUShort, eBitDepthHalf, eBitDepthFloat };
+  const char *kDepthNames[] = { "byte", "short", "half", "float" };
+
+  // median ms over the runs
+  double timeRuns(int nRuns, const std::function<void()> &fn)
+  {
+    std::vector<double> times;
+    fn(); // warm up
+    for(int i = 0; i < nRuns; ++i) {
+      Clock::time_point start = Clock::now();
+      fn();
+      times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int width = 1920, height = 1080, nRuns = 20;
+  if(argc > 1) width = atoi(argv[1]);
+  if(argc > 2) height = atoi(argv[2]);
+  if(argc > 3) nRuns = std::max(1, atoi(argv[3]));
+
+  const int nComponents = 4;
+  Kernels::InstructionSetEnum best = Kernels::getInstructionSet();
+
+  // rows padded by different amounts, as images from different sources would be
+  const ptrdiff_t srcPad = 64, dstPad = 192;
+  const size_t maxRowBytes = size_t(width) * nComponents * sizeof(float) + dstPad;
+  std::vector<char> src(maxRowBytes * height), dst(maxRowBytes * height), inPlace(maxRowBytes * height);
+  for(size_t i = 0; i < src.size(); ++i)
+    src[i] = char((i * 7) & 0x3f); // small values, so halves and floats are in range too
+
+  printf("%dx%d RGBA, %d runs, src rows padded by %d bytes and dst rows by %d\n",
+         width, height, nRuns, int(srcPad), int(dstPad));
+  printf("%-16s %24s %24s %24s\n", "", "scalar", Kernels::getInstructionSetName(best), "in place");
+
+  for(int s = 0; s < 4; ++s) {
+    for(int d = 0; d < 4; ++d) {
+      BitDepthEnum srcDepth = kDepths[s], dstDepth = kDepths[d];
+      size_t srcBytes = BitDepth::getBytesPerComponent(srcDepth), dstBytes = BitDepth::getBytesPerComponent(dstDepth);
+      ptrdiff_t srcRowBytes = ptrdiff_t(width * nComponents * srcBytes) + srcPad;
+      ptrdiff_t dstRowBytes = ptrdiff_t(width * nComponents * dstBytes) + dstPad;
+      double bytesMoved = double(width) * height * nComponents * (srcBytes + dstBytes);
+
+      double ms[3] = { 0, 0, 0 };
+      Kernels::InstructionSetEnum sets[2] = { Kernels::eInstructionSetScalar, best };
+      for(int k = 0; k < 2; ++k) {
+        Kernels::setInstructionSet(sets[k]);
+        ms[k] = timeRuns(nRuns, [&]() {
+            BitDepth::convertPixels(&src[0], srcRowBytes, srcDepth, &dst[0], dstRowBytes, dstDepth, width, height, nComponents);
+          });
+      }
+
+      // widening in place, the source is refreshed before each run, which is not timed
+      if(dstBytes > srcBytes) {
+        std::vector<double> times;
+        for(int i = 0; i < nRuns; ++i) {
+          std::copy(src.begin(), src.end(), inPlace.begin());
+          Clock::time_point start = Clock::now();
+          BitDepth::convertPixels(&inPlace[0], srcRowBytes, srcDepth, &inPlace[0], dstRowBytes, dstDepth, width, height, nComponents);
+          times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        std::sort(times.begin(), times.end());
+        ms[2] = times[times.size() / 2];
+      }
+
+      char name[32];
+      snprintf(name, sizeof(name), "%s to %s", kDepthNames[s], kDepthNames[d]);
+      printf("%-16s", name);
+      for(int k = 0; k < 3; ++k) {
+        if(ms[k] > 0)
+          printf("  %8.2f ms %7.2f GB/s", ms[k], bytesMoved / (ms[k] * 1.0e6));
+        else
+          printf("  %24s", "");
+      }
+      printf("\n");
+    }
+  }
+  return 0;
+}
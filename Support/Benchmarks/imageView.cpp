@@ -0,0 +1,145 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+  Compares a cross fade written the way the sample processors used to be, with a bounds
+  checked getPixelAddress for every pixel of every input, against the same fade over
+  OFX::ImageView row spans, where the clipping is done once per row. The second input
+  is offset so that rows have pieces inside and outside it.
+
+  usage : imageView [width height nRuns]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ofxsImageView.h"
+
+#if defined(_MSC_VER)
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE __attribute__((noinline))
+#endif
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  const int kComponents = 4;
+
+  // an RGBA float buffer with its bounds, like an OFX::Image
+  struct Buffer {
+    OfxRectI bounds;
+    int rowBytes;
+    std::vector<float> pixels;
+
+    Buffer(int x1, int y1, int x2, int y2)
+    {
+      bounds.x1 = x1; bounds.y1 = y1; bounds.x2 = x2; bounds.y2 = y2;
+      rowBytes = (x2 - x1) * kComponents * int(sizeof(float));
+      pixels.resize(size_t(x2 - x1) * (y2 - y1) * kComponents);
+      for(size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = float(i % 251) / 251.0f;
+    }
+
+    // what OFX::Image::getPixelAddress does, kept out of line as it is in the library
+    NOINLINE float *getPixelAddress(int x, int y)
+    {
+      if(x < bounds.x1 || x >= bounds.x2 || y < bounds.y1 || y >= bounds.y2)
+        return 0;
+      char *row = (char *) &pixels[0] + size_t(y - bounds.y1) * rowBytes;
+      return (float *) row + size_t(x - bounds.x1) * kComponents;
+    }
+  };
+
+  void fadePerPixel(Buffer &dst, Buffer &from, Buffer &to, float blend, const OfxRectI &win)
+  {
+    for(int y = win.y1; y < win.y2; ++y) {
+      float *dstPix = dst.getPixelAddress(win.x1, y);
+      for(int x = win.x1; x < win.x2; ++x) {
+        float *fromPix = from.getPixelAddress(x, y);
+        float *toPix = to.getPixelAddress(x, y);
+        for(int c = 0; c < kComponents; ++c) {
+          float f = fromPix ? fromPix[c] : 0.0f;
+          float t = toPix ? toPix[c] : 0.0f;
+          dstPix[c] = f + (t - f) * blend;
+        }
+        dstPix += kComponents;
+      }
+    }
+  }
+
+  void fadeRowSpans(Buffer &dst, Buffer &from, Buffer &to, float blend, const OfxRectI &win)
+  {
+    OFX::ImageView<float, kComponents> dstView(&dst.pixels[0], dst.bounds, dst.rowBytes);
+    OFX::ImageView<const float, kComponents> fromView(&from.pixels[0], from.bounds, from.rowBytes);
+    OFX::ImageView<const float, kComponents> toView(&to.pixels[0], to.bounds, to.rowBytes);
+
+    for(int y = win.y1; y < win.y2; ++y) {
+      float *dstRow = dstView.getPixelAddress(win.x1, y);
+      OFX::RowSpan<const float> fromRow = fromView.getRow(y, win.x1, win.x2);
+      OFX::RowSpan<const float> toRow = toView.getRow(y, win.x1, win.x2);
+      OFX::forEachRowPiece(win.x1, win.x2, fromRow, toRow,
+                           [&](int x1, int x2, bool inFrom, bool inTo) {
+        float *d = dstRow + (x1 - win.x1) * kComponents;
+        const float *f = inFrom ? fromRow.at(x1, kComponents) : 0;
+        const float *t = inTo ? toRow.at(x1, kComponents) : 0;
+        int n = (x2 - x1) * kComponents;
+        if(f && t)
+          for(int i = 0; i < n; ++i) d[i] = f[i] + (t[i] - f[i]) * blend;
+        else if(f)
+          for(int i = 0; i < n; ++i) d[i] = f[i] * (1.0f - blend);
+        else if(t)
+          for(int i = 0; i < n; ++i) d[i] = t[i] * blend;
+        else
+          for(int i = 0; i < n; ++i) d[i] = 0.0f;
+      });
+    }
+  }
+
+  template <class F>
+  double timeRuns(int nRuns, F fn)
+  {
+    std::vector<double> times;
+    for(int i = 0; i < nRuns; ++i) {
+      Clock::time_point start = Clock::now();
+      fn();
+      times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int width = 1920, height = 1080, nRuns = 20;
+  if(argc > 1) width = atoi(argv[1]);
+  if(argc > 2) height = atoi(argv[2]);
+  if(argc > 3) nRuns = std::max(1, atoi(argv[3]));
+
+  OfxRectI window = {0, 0, width, height};
+  Buffer dst(0, 0, width, height);
+  Buffer from(0, 0, width, height);
+  Buffer to(width / 4, height / 4, width + width / 4, height + height / 4);
+
+  // check both give the same picture before timing them
+  Buffer check(0, 0, width, height);
+  fadePerPixel(check, from, to, 0.3f, window);
+  fadeRowSpans(dst, from, to, 0.3f, window);
+  float worst = 0;
+  for(size_t i = 0; i < dst.pixels.size(); ++i)
+    worst = std::max(worst, std::abs(dst.pixels[i] - check.pixels[i]));
+
+  double perPixel = timeRuns(nRuns, [&]() { fadePerPixel(dst, from, to, 0.3f, window); });
+  double rowSpans = timeRuns(nRuns, [&]() { fadeRowSpans(dst, from, to, 0.3f, window); });
+
+  printf("%dx%d RGBA float, %d runs, largest difference %g\n", width, height, nRuns, worst);
+  printf("per pixel  median %8.2f ms\n", perPixel);
+  printf("row spans  median %8.2f ms  (%.1fx)\n", rowSpans, perPixel / rowSpans);
+  return 0;
+}
@@ -0,0 +1,144 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+  Compares the default one strip per thread split used by OFX::ImageProcessor against
+  the tiled mode driven by OFX::TileScheduler, on a synthetic workload whose cost per
+  pixel grows towards the top of the image, which is the case strips handle badly.
+
+  usage : tileScheduling [width height nThreads tileWidth tileHeight]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "ofxsProcessing.h"
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  // the fake image processing, rows near the top cost far more than rows near the bottom
+  struct SkewedWork {
+    int width, height;
+    std::vector<float> dst;
+
+    SkewedWork(int w, int h) : width(w), height(h), dst(size_t(w) * h) {}
+
+    void process(const OfxRectI &win)
+    {
+      for(int y = win.y1; y < win.y2; ++y) {
+        int iterations = 1 + int((32 * int64_t(y) * y) / (int64_t(height) * height));
+        float *row = &dst[size_t(y) * width];
+        for(int x = win.x1; x < win.x2; ++x) {
+          float v = float(x + y);
+          for(int i = 0; i < iterations; ++i)
+            v = std::sqrt(v * 1.0001f + 1.0f);
+          row[x] = v;
+        }
+      }
+    }
+  };
+
+  struct Result {
+    double wall;  // ms for the whole image
+    double slowest; // ms for the slowest thread
+    double fastest; // ms for the fastest thread
+  };
+
+  template <class F>
+  Result runThreads(unsigned int nThreads, F threadFunc)
+  {
+    std::vector<double> times(nThreads);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for(unsigned int t = 0; t < nThreads; ++t) {
+      threads.emplace_back([&, t]() {
+          Clock::time_point s = Clock::now();
+          threadFunc(t);
+          times[t] = std::chrono::duration<double, std::milli>(Clock::now() - s).count();
+        });
+    }
+    for(auto &th : threads) th.join();
+    Result r;
+    r.wall = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    r.slowest = *std::max_element(times.begin(), times.end());
+    r.fastest = *std::min_element(times.begin(), times.end());
+    return r;
+  }
+
+  // same split as ImageProcessor::multiThreadFunction
+  Result runStrips(SkewedWork &work, const OfxRectI &window, unsigned int nThreads)
+  {
+    return runThreads(nThreads, [&](unsigned int threadId) {
+        unsigned int dy = window.y2 - window.y1;
+        unsigned int h = (dy + nThreads - 1) / nThreads;
+        if(h == 0) h = 1;
+        OfxRectI win = window;
+        win.y1 = window.y1 + threadId * h;
+        win.y2 = std::min(win.y1 + int(h), window.y2);
+        if(win.y1 < win.y2)
+          work.process(win);
+      });
+  }
+
+  Result runTiles(SkewedWork &work, const OfxRectI &window, unsigned int nThreads, int tileW, int tileH)
+  {
+    OFX::TileScheduler tiles;
+    tiles.reset(window, tileW, tileH);
+    return runThreads(nThreads, [&](unsigned int) {
+        OfxRectI tile;
+        while(tiles.nextTile(tile))
+          work.process(tile);
+      });
+  }
+
+  void report(const char *name, const std::vector<Result> &results)
+  {
+    std::vector<double> walls;
+    double slowest = 0, imbalance = 0;
+    for(const Result &r : results) {
+      walls.push_back(r.wall);
+      slowest = std::max(slowest, r.slowest);
+      imbalance += r.slowest - r.fastest;
+    }
+    std::sort(walls.begin(), walls.end());
+    double p50 = walls[walls.size() / 2];
+    double p95 = walls[std::min(walls.size() - 1, (walls.size() * 95) / 100)];
+    printf("%-8s wall p50 %8.2f ms  p95 %8.2f ms  slowest thread %8.2f ms  mean idle gap %8.2f ms\n",
+           name, p50, p95, slowest, imbalance / results.size());
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int width = 1920, height = 1080;
+  unsigned int nThreads = std::max(1u, std::thread::hardware_concurrency());
+  int tileW = 256, tileH = 64;
+  if(argc > 1) width = atoi(argv[1]);
+  if(argc > 2) height = atoi(argv[2]);
+  if(argc > 3) nThreads = std::max(1, atoi(argv[3]));
+  if(argc > 4) tileW = atoi(argv[4]);
+  if(argc > 5) tileH = atoi(argv[5]);
+
+  const int nRuns = 20;
+  OfxRectI window = {0, 0, width, height};
+  SkewedWork work(width, height);
+
+  printf("%dx%d, %u threads, %dx%d tiles, %d runs\n", width, height, nThreads, tileW, tileH, nRuns);
+
+  std::vector<Result> strips, tiles;
+  for(int i = 0; i < nRuns; ++i) {
+    strips.push_back(runStrips(work, window, nThreads));
+    tiles.push_back(runTiles(work, window, nThreads, tileW, tileH));
+  }
+  report("strips", strips);
+  report("tiles", tiles);
+  return 0;
+}
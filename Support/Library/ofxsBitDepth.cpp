@@ -0,0 +1,155 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <string.h>
+#include <algorithm>
+
+#include "ofxsBitDepth.h"
+#include "ofxsPixelKernels.h"
+
+namespace OFX {
+
+  namespace BitDepth {
+
+    using Kernels::Half;
+
+    size_t getBytesPerComponent(BitDepthEnum depth)
+    {
+      switch(depth) {
+      case eBitDepthUByte :  return 1;
+      case eBitDepthUShort : return 2;
+      case eBitDepthHalf :   return 2;
+      case eBitDepthFloat :  return 4;
+      default :              return 0;
+      }
+    }
+
+    /** @brief the bytes per component, throwing if the depth is not one we convert */
+    static size_t checkedBytesPerComponent(BitDepthEnum depth)
+    {
+      size_t bytes = getBytesPerComponent(depth);
+      if(bytes == 0)
+        throw OFX::Exception::Suite(kOfxStatErrImageFormat);
+      return bytes;
+    }
+
+    /** @brief n components of any depth to floats */
+    static void toFloats(const void *src, BitDepthEnum depth, float *dst, size_t n)
+    {
+      switch(depth) {
+      case eBitDepthUByte :  Kernels::convert((const uint8_t *) src, dst, n); break;
+      case eBitDepthUShort : Kernels::convert((const uint16_t *) src, dst, n); break;
+      case eBitDepthHalf :   Kernels::convert((const Half *) src, dst, n); break;
+      default :              memcpy(dst, src, n * sizeof(float)); break;
+      }
+    }
+
+    /** @brief n floats to components of any depth */
+    static void fromFloats(const float *src, void *dst, BitDepthEnum depth, size_t n)
+    {
+      switch(depth) {
+      case eBitDepthUByte :  Kernels::convert(src, (uint8_t *) dst, n); break;
+      case eBitDepthUShort : Kernels::convert(src, (uint16_t *) dst, n); break;
+      case eBitDepthHalf :   Kernels::convert(src, (Half *) dst, n); break;
+      default :              memcpy(dst, src, n * sizeof(float)); break;
+      }
+    }
+
+    /** @brief convert n components, going through floats a block at a time.
+
+    Each block is read in full before any of it is written, so this is safe in place. When
+    dst lies at or after src, and its components are at least as wide, it is done from the
+    last block back, so nothing is overwritten before it is read, otherwise from the first
+    block on.
+    */
+    static void convertViaBlocks(const char *src, BitDepthEnum srcDepth, size_t srcBytes,
+                                 char *dst, BitDepthEnum dstDepth, size_t dstBytes,
+                                 size_t n)
+    {
+      float block[Kernels::kBlockSize];
+      size_t nBlocks = (n + Kernels::kBlockSize - 1) / Kernels::kBlockSize;
+      bool backwards = dst > src || (dst == src && dstBytes > srcBytes);
+      for(size_t k = 0; k < nBlocks; ++k) {
+        size_t b = backwards ? nBlocks - 1 - k : k;
+        size_t start = b * Kernels::kBlockSize;
+        size_t m = std::min(Kernels::kBlockSize, n - start);
+        toFloats(src + start * srcBytes, srcDepth, block, m);
+        fromFloats(block, dst + start * dstBytes, dstDepth, m);
+      }
+    }
+
+    /** @brief convert n components between buffers that do not overlap */
+    static void convertDirect(const void *src, BitDepthEnum srcDepth,
+                              void *dst, BitDepthEnum dstDepth,
+                              size_t n)
+    {
+      if(srcDepth == dstDepth)
+        memcpy(dst, src, n * getBytesPerComponent(srcDepth));
+      else if(dstDepth == eBitDepthFloat)
+        toFloats(src, srcDepth, (float *) dst, n);
+      else if(srcDepth == eBitDepthFloat)
+        fromFloats((const float *) src, dst, dstDepth, n);
+      else if(srcDepth == eBitDepthUByte && dstDepth == eBitDepthUShort) {
+        // 65535 is 255 * 257, so this is exact
+        const uint8_t *s = (const uint8_t *) src;
+        uint16_t *d = (uint16_t *) dst;
+        for(size_t i = 0; i < n; ++i)
+          d[i] = uint16_t(s[i] * 257);
+      }
+      else if(srcDepth == eBitDepthUShort && dstDepth == eBitDepthUByte) {
+        // round(v / 257), which is what going through floats gives, without a divide
+        const uint16_t *s = (const uint16_t *) src;
+        uint8_t *d = (uint8_t *) dst;
+        for(size_t i = 0; i < n; ++i)
+          d[i] = uint8_t((s[i] * 255u + 32895u) >> 16);
+      }
+      else
+        convertViaBlocks((const char *) src, srcDepth, getBytesPerComponent(srcDepth),
+                         (char *) dst, dstDepth, getBytesPerComponent(dstDepth), n);
+    }
+
+    void convertRow(const void *src, BitDepthEnum srcDepth,
+                    void *dst, BitDepthEnum dstDepth,
+                    size_t n)
+    {
+      size_t srcBytes = checkedBytesPerComponent(srcDepth);
+      size_t dstBytes = checkedBytesPerComponent(dstDepth);
+
+      if(src != dst)
+        convertDirect(src, srcDepth, dst, dstDepth, n);
+      else if(srcDepth != dstDepth)
+        convertViaBlocks((const char *) src, srcDepth, srcBytes, (char *) dst, dstDepth, dstBytes, n);
+    }
+
+    void convertPixels(const void *srcData, ptrdiff_t srcRowBytes, BitDepthEnum srcDepth,
+                       void *dstData, ptrdiff_t dstRowBytes, BitDepthEnum dstDepth,
+                       int width, int height, int nComponents)
+    {
+      size_t srcBytes = checkedBytesPerComponent(srcDepth);
+      size_t dstBytes = checkedBytesPerComponent(dstDepth);
+      if(width <= 0 || height <= 0)
+        return;
+      size_t n = size_t(width) * nComponents;
+
+      const char *src = (const char *) srcData;
+      char *dst = (char *) dstData;
+
+      if(src != dst) {
+        for(int y = 0; y < height; ++y)
+          convertDirect(src + y * srcRowBytes, srcDepth, dst + y * dstRowBytes, dstDepth, n);
+      }
+      else if(srcDepth != dstDepth || srcRowBytes != dstRowBytes) {
+        // in place, rows past the first may overlap their source without starting at the same
+        // address, so all go through the blocks, and when dst rows are longer they are done
+        // from the last back, as each then lies at or after its src row
+        bool backwards = dstRowBytes > srcRowBytes;
+        for(int k = 0; k < height; ++k) {
+          int y = backwards ? height - 1 - k : k;
+          convertViaBlocks(src + y * srcRowBytes, srcDepth, srcBytes, dst + y * dstRowBytes, dstDepth, dstBytes, n);
+        }
+      }
+    }
+
+  };
+
+};
@@ -10,6 +10,7 @@
 #include <iostream>
 #endif
 #include <stdexcept>
+#include <unordered_map>
 #include "ofxGPURender.h"
 #include "ofxsCore.h"
 
@@ -57,6 +58,11 @@ namespace OFX {
   typedef std::map<std::string, OfxPlugInfo> OfxPlugInfoMap;
   OfxPlugInfoMap plugInfoMap;
 
+  /** @brief the factories in plugInfoMap, keyed by the address of their UID's characters. That is
+      what FactoryMainEntryHelper passes to mainEntryStr, so it can find its factory without a string compare. */
+  typedef std::unordered_map<const char *, OFX::PluginFactory *> PluginFactoryByUIDMap;
+  PluginFactoryByUIDMap plugFactoryByUID;
+
   typedef std::vector<OfxPlugin*> OfxPluginArray;
   OfxPluginArray ofxPlugs;
 
@@ -121,6 +127,7 @@ namespace OFX {
     OfxProgressSuiteV2    *gProgressSuiteV2 = 0;
     OfxTimeLineSuiteV1    *gTimeLineSuite = 0;
     OfxParametricParameterSuiteV1 *gParametricParameterSuite = 0;
+    OpenFXParameterBatchSuiteV1 *gParameterBatchSuite = 0;
 #ifdef OFX_SUPPORTS_OPENGLRENDER
     OfxImageEffectOpenGLRenderSuiteV1 *gOpenGLRenderSuite = 0;
 #endif
@@ -1962,6 +1969,7 @@ namespace OFX {
         gProgressSuiteV2 = (OfxProgressSuiteV2 *)     fetchSuite(kOfxProgressSuite, 2, true);
         gTimeLineSuite   = (OfxTimeLineSuiteV1 *)     fetchSuite(kOfxTimeLineSuite, 1, true);
         gParametricParameterSuite = (OfxParametricParameterSuiteV1*) fetchSuite(kOfxParametricParameterSuite, 1, true);
+        gParameterBatchSuite = (OpenFXParameterBatchSuiteV1*) fetchSuite(kOpenFXParameterBatchSuite, 1, true);
 #ifdef OFX_SUPPORTS_OPENGLRENDER
         gOpenGLRenderSuite = (OfxImageEffectOpenGLRenderSuiteV1*) fetchSuite(kOfxOpenGLRenderSuite, 1, true);
 #endif
@@ -2009,6 +2017,7 @@ namespace OFX {
         gMessageSuiteV2 = 0;
         gInteractSuite = 0;
         gParametricParameterSuite = 0;
+        gParameterBatchSuite = 0;
       }
 
       {
@@ -2027,6 +2036,7 @@ namespace OFX {
         if (it2 != ofxPlugs.end()) {
           (*it2) = nullptr;
         }
+        OFX::plugFactoryByUID.erase(it->second._factory->getUID().c_str());
         OFX::plugInfoMap.erase(it);
       }
     }
@@ -2556,6 +2566,106 @@ namespace OFX {
     }
 
 
+    /** @brief The actions mainEntryStr knows how to handle */
+    enum ActionEnum {
+      eActionUnknown,
+      eActionLoad,
+      eActionUnload,
+      eActionDescribe,
+      eActionDescribeInContext,
+      eActionCreateInstance,
+      eActionDestroyInstance,
+      eActionRender,
+      eActionBeginSequenceRender,
+      eActionEndSequenceRender,
+      eActionIsIdentity,
+      eActionGetRegionOfDefinition,
+      eActionGetRegionsOfInterest,
+      eActionGetFramesNeeded,
+      eActionGetClipPreferences,
+      eActionPurgeCaches,
+      eActionSyncPrivateData,
+      eActionGetTimeDomain,
+      eActionBeginInstanceChanged,
+      eActionInstanceChanged,
+      eActionEndInstanceChanged,
+      eActionBeginInstanceEdit,
+      eActionEndInstanceEdit,
+      eActionOpenGLContextAttached,
+      eActionOpenGLContextDetached
+    };
+
+    /** @brief FNV-1a hash of an action name, constexpr so the known names can be used as case labels */
+    static constexpr unsigned int hashActionName(const char *name)
+    {
+      unsigned int hash = 2166136261u;
+      for(; *name; ++name)
+        hash = (hash ^ (unsigned char)(*name)) * 16777619u;
+      return hash;
+    }
+
+    /** @brief Map an action name to an enum, unknown and custom actions map to eActionUnknown
+
+    The name is hashed once and then compared against the single known action with that hash,
+    rather than against each known action in turn. As the hashes are case labels, two known
+    actions that collide fail to compile, so the hash is perfect over the set we know.
+    */
+    static ActionEnum mapActionToEnum(const char *action)
+    {
+      if(!action)
+        return eActionUnknown;
+
+#define mActionCase(NAME, ENUM) case hashActionName(NAME) : return strcmp(action, NAME) == 0 ? ENUM : eActionUnknown
+      switch (hashActionName(action)) {
+        mActionCase(kOfxActionLoad, eActionLoad);
+        mActionCase(kOfxActionUnload, eActionUnload);
+        mActionCase(kOfxActionDescribe, eActionDescribe);
+        mActionCase(kOfxImageEffectActionDescribeInContext, eActionDescribeInContext);
+        mActionCase(kOfxActionCreateInstance, eActionCreateInstance);
+        mActionCase(kOfxActionDestroyInstance, eActionDestroyInstance);
+        mActionCase(kOfxImageEffectActionRender, eActionRender);
+        mActionCase(kOfxImageEffectActionBeginSequenceRender, eActionBeginSequenceRender);
+        mActionCase(kOfxImageEffectActionEndSequenceRender, eActionEndSequenceRender);
+        mActionCase(kOfxImageEffectActionIsIdentity, eActionIsIdentity);
+        mActionCase(kOfxImageEffectActionGetRegionOfDefinition, eActionGetRegionOfDefinition);
+        mActionCase(kOfxImageEffectActionGetRegionsOfInterest, eActionGetRegionsOfInterest);
+        mActionCase(kOfxImageEffectActionGetFramesNeeded, eActionGetFramesNeeded);
+        mActionCase(kOfxImageEffectActionGetClipPreferences, eActionGetClipPreferences);
+        mActionCase(kOfxActionPurgeCaches, eActionPurgeCaches);
+        mActionCase(kOfxActionSyncPrivateData, eActionSyncPrivateData);
+        mActionCase(kOfxImageEffectActionGetTimeDomain, eActionGetTimeDomain);
+        mActionCase(kOfxActionBeginInstanceChanged, eActionBeginInstanceChanged);
+        mActionCase(kOfxActionInstanceChanged, eActionInstanceChanged);
+        mActionCase(kOfxActionEndInstanceChanged, eActionEndInstanceChanged);
+        mActionCase(kOfxActionBeginInstanceEdit, eActionBeginInstanceEdit);
+        mActionCase(kOfxActionEndInstanceEdit, eActionEndInstanceEdit);
+#ifdef OFX_SUPPORTS_OPENGLRENDER
+        mActionCase(kOfxActionOpenGLContextAttached, eActionOpenGLContextAttached);
+        mActionCase(kOfxActionOpenGLContextDetached, eActionOpenGLContextDetached);
+#endif
+        default :
+          return eActionUnknown;
+      }
+#undef mActionCase
+    }
+
+    /** @brief Find the factory of the plugin a call to mainEntryStr is for
+
+    PluginFactoryHelper passes its UID's own c_str() on every call, so look that pointer up
+    first and only fall back to looking up the name when someone passes us some other copy.
+    */
+    static OFX::PluginFactory *findPluginFactory(const char *plugname)
+    {
+      PluginFactoryByUIDMap::const_iterator cached = plugFactoryByUID.find(plugname);
+      if(cached != plugFactoryByUID.end())
+        return cached->second;
+
+      OfxPlugInfoMap::iterator it = plugInfoMap.find(plugname);
+      if(it == plugInfoMap.end())
+        return nullptr;
+      return it->second._factory;
+    }
+
     /** @brief The main entry point for the plugin
     */
     OfxStatus mainEntryStr(const char    *actionRaw,
@@ -2568,14 +2678,13 @@ namespace OFX {
       OFX::Log::print("START mainEntry (%s for %s)", actionRaw, plugname);
       OFX::Log::indent();
       OfxStatus stat = kOfxStatReplyDefault;
+      bool lastUnload = false;
       try {
 
-        OfxPlugInfoMap::iterator it = plugInfoMap.find(plugname);
-        if(it==plugInfoMap.end())
+        OFX::PluginFactory* factory = findPluginFactory(plugname);
+        if(!factory)
           throw;
 
-        OFX::PluginFactory* factory = it->second._factory;
-
         // Cast the raw handle to be an image effect handle, because that is what it is
         OfxImageEffectHandle handle = (OfxImageEffectHandle) handleRaw;
 
@@ -2583,250 +2692,274 @@ namespace OFX {
         OFX::PropertySet inArgs(inArgsRaw);
         OFX::PropertySet outArgs(outArgsRaw);
 
-        // turn the action into a std::string
-        std::string action(actionRaw);
-
-        // figure the actions
-        if (action == kOfxActionLoad) {
-          // call the support load function, param-less
-          OFX::Private::loadAction(); 
-
-          // call the plugin side load action, param-less
-          factory->load();
-
-          // got here, must be good
-          stat = kOfxStatOK;
-        }
+        // figure the actions, hashing the name once rather than comparing it against each in turn
+        switch (mapActionToEnum(actionRaw)) {
+          case eActionLoad: {
+            // call the support load function, param-less
+            OFX::Private::loadAction(); 
 
-        // figure the actions
-        else if (action == kOfxActionUnload) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, true, true, true);
+            // call the plugin side load action, param-less
+            factory->load();
 
-          // call the plugin side unload action, param-less, should be called, eve if the stat above failed!
-          factory->unload();
+            // got here, must be good
+            stat = kOfxStatOK;
+            break;
+          }
+          case eActionUnload: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, true, true, true);
 
-          // call the support unload function, param-less
-          OFX::Private::unloadAction(plugname); 
+            // call the plugin side unload action, param-less, should be called, eve if the stat above failed!
+            factory->unload();
 
-          // got here, must be good
-          stat = kOfxStatOK;
-        }
+            // call the support unload function, param-less
+            OFX::Private::unloadAction(plugname); 
+            lastUnload = gLoadCount == 0;
 
-        else if(action == kOfxActionDescribe) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
+            // got here, must be good
+            stat = kOfxStatOK;
+            break;
+          }
+          case eActionDescribe: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
-          // make the plugin descriptor
-          ImageEffectDescriptor *desc = new ImageEffectDescriptor(handle);
+            // make the plugin descriptor
+            ImageEffectDescriptor *desc = new ImageEffectDescriptor(handle);
 
-          // validate the host
-          OFX::Validation::validatePluginDescriptorProperties(fetchEffectProps(handle));
+            // validate the host
+            OFX::Validation::validatePluginDescriptorProperties(fetchEffectProps(handle));
 
-          //  and pass it to the plugin to do something with it
+            //  and pass it to the plugin to do something with it
 
-          factory->describe(*desc);
+            factory->describe(*desc);
 
-          // add it to our map
-          gEffectDescriptors[plugname][eContextNone] = desc;
+            // add it to our map
+            gEffectDescriptors[plugname][eContextNone] = desc;
 
-          // got here, must be good
-          stat = kOfxStatOK;
-        }
-        else if(action == kOfxImageEffectActionDescribeInContext) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
+            // got here, must be good
+            stat = kOfxStatOK;
+            break;
+          }
+          case eActionDescribeInContext: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
-          // make the plugin descriptor and pass it to the plugin to do something with it
-          ImageEffectDescriptor *desc = new ImageEffectDescriptor(handle);
+            // make the plugin descriptor and pass it to the plugin to do something with it
+            ImageEffectDescriptor *desc = new ImageEffectDescriptor(handle);
 
-          // figure the context and map it to an enum
-          std::string contextStr = inArgs.propGetString(kOfxImageEffectPropContext);
-          ContextEnum context = mapToContextEnum(contextStr);
+            // figure the context and map it to an enum
+            std::string contextStr = inArgs.propGetString(kOfxImageEffectPropContext);
+            ContextEnum context = mapToContextEnum(contextStr);
 
-          // validate the host
-          OFX::Validation::validatePluginDescriptorProperties(fetchEffectProps(handle));
+            // validate the host
+            OFX::Validation::validatePluginDescriptorProperties(fetchEffectProps(handle));
 
-          // call plugin describe in context
-          factory->describeInContext(*desc, context);
+            // call plugin describe in context
+            factory->describeInContext(*desc, context);
 
-          // add it to our map
-          gEffectDescriptors[plugname][context] = desc;
+            // add it to our map
+            gEffectDescriptors[plugname][context] = desc;
 
-          // got here, must be good
-          stat = kOfxStatOK;
-        }
-        else if(action == kOfxActionCreateInstance) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
+            // got here, must be good
+            stat = kOfxStatOK;
+            break;
+          }
+          case eActionCreateInstance: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
-          // fetch the effect props to figure the context
-          PropertySet effectProps = fetchEffectProps(handle);
+            // fetch the effect props to figure the context
+            PropertySet effectProps = fetchEffectProps(handle);
 
-          // get the context and turn it into an enum
-          std::string str = effectProps.propGetString(kOfxImageEffectPropContext);
-          ContextEnum context = mapToContextEnum(str);
+            // get the context and turn it into an enum
+            std::string str = effectProps.propGetString(kOfxImageEffectPropContext);
+            ContextEnum context = mapToContextEnum(str);
 
-          // make the image effect instance for this context
-          ImageEffect *instance = factory->createInstance(handle, context);
-          (void)instance;
+            // make the image effect instance for this context
+            ImageEffect *instance = factory->createInstance(handle, context);
+            (void)instance;
 
-          // validate the plugin handle's properties
-          OFX::Validation::validatePluginInstanceProperties(fetchEffectProps(handle));
+            // validate the plugin handle's properties
+            OFX::Validation::validatePluginInstanceProperties(fetchEffectProps(handle));
 
-          // got here, must be good
-          stat = kOfxStatOK;
-        }
-        else if(action == kOfxActionDestroyInstance) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
+            // got here, must be good
+            stat = kOfxStatOK;
+            break;
+          }
+          case eActionDestroyInstance: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
-          // fetch our pointer out of the props on the handle
-          ImageEffect *instance = retrieveImageEffectPointer(handle);
+            // fetch our pointer out of the props on the handle
+            ImageEffect *instance = retrieveImageEffectPointer(handle);
 
-          // kill it
-          delete instance;
+            // kill it
+            delete instance;
 
-          // got here, must be good
-          stat = kOfxStatOK;
-        }
-        else if(action == kOfxImageEffectActionRender) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
+            // got here, must be good
+            stat = kOfxStatOK;
+            break;
+          }
+          case eActionRender: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
-          // call the render action skin
-          renderAction(handle, inArgs);
+            // call the render action skin
+            renderAction(handle, inArgs);
 
-          // got here, must be good
-          stat = kOfxStatOK;
-        }
-        else if(action == kOfxImageEffectActionBeginSequenceRender) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
+            // got here, must be good
+            stat = kOfxStatOK;
+            break;
+          }
+          case eActionBeginSequenceRender: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
-          // call the begin render action skin
-          beginSequenceRenderAction(handle, inArgs);
-        }
-        else if(action == kOfxImageEffectActionEndSequenceRender) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
+            // call the begin render action skin
+            beginSequenceRenderAction(handle, inArgs);
+            break;
+          }
+          case eActionEndSequenceRender: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
-          // call the begin render action skin
-          endSequenceRenderAction(handle, inArgs);
-        }
-        else if(action == kOfxImageEffectActionIsIdentity) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
+            // call the begin render action skin
+            endSequenceRenderAction(handle, inArgs);
+            break;
+          }
+          case eActionIsIdentity: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
-          // call the identity action, if it is, return OK
-          if(isIdentityAction(handle, inArgs, outArgs))
-            stat = kOfxStatOK;
-        }
-        else if(action == kOfxImageEffectActionGetRegionOfDefinition) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
+            // call the identity action, if it is, return OK
+            if(isIdentityAction(handle, inArgs, outArgs))
+              stat = kOfxStatOK;
+            break;
+          }
+          case eActionGetRegionOfDefinition: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
-          // call the rod action, return OK if it does something
-          if(regionOfDefinitionAction(handle, inArgs, outArgs))
-            stat = kOfxStatOK;
-        }
-        else if(action == kOfxImageEffectActionGetRegionsOfInterest) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
+            // call the rod action, return OK if it does something
+            if(regionOfDefinitionAction(handle, inArgs, outArgs))
+              stat = kOfxStatOK;
+            break;
+          }
+          case eActionGetRegionsOfInterest: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
-          // call the RoI action, return OK if it does something
-          if(regionsOfInterestAction(handle, inArgs, outArgs, plugname))
-            stat = kOfxStatOK;
-        }
-        else if(action == kOfxImageEffectActionGetFramesNeeded) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
+            // call the RoI action, return OK if it does something
+            if(regionsOfInterestAction(handle, inArgs, outArgs, plugname))
+              stat = kOfxStatOK;
+            break;
+          }
+          case eActionGetFramesNeeded: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
-          // call the frames needed action, return OK if it does something
-          if(framesNeededAction(handle, inArgs, outArgs, plugname))
-            stat = kOfxStatOK;
-        }
-        else if(action == kOfxImageEffectActionGetClipPreferences) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, false);
+            // call the frames needed action, return OK if it does something
+            if(framesNeededAction(handle, inArgs, outArgs, plugname))
+              stat = kOfxStatOK;
+            break;
+          }
+          case eActionGetClipPreferences: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, false);
 
-          // call the frames needed action, return OK if it does something
-          if(clipPreferencesAction(handle, outArgs, plugname))
-            stat = kOfxStatOK;
-        }
-        else if(action == kOfxActionPurgeCaches) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
+            // call the frames needed action, return OK if it does something
+            if(clipPreferencesAction(handle, outArgs, plugname))
+              stat = kOfxStatOK;
+            break;
+          }
+          case eActionPurgeCaches: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
-          // fetch our pointer out of the props on the handle
-          ImageEffect *instance = retrieveImageEffectPointer(handle);
+            // fetch our pointer out of the props on the handle
+            ImageEffect *instance = retrieveImageEffectPointer(handle);
 
-          // purge 'em
-          instance->purgeCaches();
-        }
-        else if(action == kOfxActionSyncPrivateData) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
+            // purge 'em
+            instance->purgeCaches();
+            break;
+          }
+          case eActionSyncPrivateData: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
-          // fetch our pointer out of the props on the handle
-          ImageEffect *instance = retrieveImageEffectPointer(handle);
+            // fetch our pointer out of the props on the handle
+            ImageEffect *instance = retrieveImageEffectPointer(handle);
 
-          // and sync it
-          instance->syncPrivateData();
-        }
-        else if(action == kOfxImageEffectActionGetTimeDomain) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, false);
+            // and sync it
+            instance->syncPrivateData();
+            break;
+          }
+          case eActionGetTimeDomain: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, false);
 
-          // call the instance changed action
-          if(getTimeDomainAction(handle, outArgs))
-            stat = kOfxStatOK;
-        }
-        else if(action == kOfxActionBeginInstanceChanged) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
+            // call the instance changed action
+            if(getTimeDomainAction(handle, outArgs))
+              stat = kOfxStatOK;
+            break;
+          }
+          case eActionBeginInstanceChanged: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
-          // call the instance changed action
-          beginInstanceChangedAction(handle, inArgs);
-        }
-        else if(action == kOfxActionInstanceChanged) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
+            // call the instance changed action
+            beginInstanceChangedAction(handle, inArgs);
+            break;
+          }
+          case eActionInstanceChanged: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
-          // call the instance changed action
-          instanceChangedAction(handle, inArgs);
-        }
-        else if(action == kOfxActionEndInstanceChanged) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
+            // call the instance changed action
+            instanceChangedAction(handle, inArgs);
+            break;
+          }
+          case eActionEndInstanceChanged: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
-          // call the instance changed action
-          endInstanceChangedAction(handle, inArgs);
-        }
-        else if(action == kOfxActionBeginInstanceEdit) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
+            // call the instance changed action
+            endInstanceChangedAction(handle, inArgs);
+            break;
+          }
+          case eActionBeginInstanceEdit: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
-          // fetch our pointer out of the props on the handle
-          ImageEffect *instance = retrieveImageEffectPointer(handle);
+            // fetch our pointer out of the props on the handle
+            ImageEffect *instance = retrieveImageEffectPointer(handle);
 
-          // call the begin edit function
-          instance->beginEdit();
-        }
-        else if(action == kOfxActionEndInstanceEdit) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
+            // call the begin edit function
+            instance->beginEdit();
+            break;
+          }
+          case eActionEndInstanceEdit: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
-          // fetch our pointer out of the props on the handle
-          ImageEffect *instance = retrieveImageEffectPointer(handle);
+            // fetch our pointer out of the props on the handle
+            ImageEffect *instance = retrieveImageEffectPointer(handle);
 
-          // call the end edit function
-          instance->endEdit();
-        }
+            // call the end edit function
+            instance->endEdit();
+            break;
+          }
 #ifdef OFX_SUPPORTS_OPENGLRENDER
-        else if(action == kOfxActionOpenGLContextAttached) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
+          case eActionOpenGLContextAttached: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
-          // fetch our pointer out of the props on the handle
-          ImageEffect *instance = retrieveImageEffectPointer(handle);
+            // fetch our pointer out of the props on the handle
+            ImageEffect *instance = retrieveImageEffectPointer(handle);
 
-          // call the context attached function
-          instance->contextAttached();
-        }
-        else if(action == kOfxActionOpenGLContextDetached) {
-          checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
+            // call the context attached function
+            instance->contextAttached();
+            break;
+          }
+          case eActionOpenGLContextDetached: {
+            checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
-          // fetch our pointer out of the props on the handle
-          ImageEffect *instance = retrieveImageEffectPointer(handle);
+            // fetch our pointer out of the props on the handle
+            ImageEffect *instance = retrieveImageEffectPointer(handle);
 
-          // call the context detached function
-          instance->contextDetached();
-        }
+            // call the context detached function
+            instance->contextDetached();
+            break;
+          }
 #endif
-        else if(actionRaw) {
-          OFX::Log::error(true, "Unknown action '%s'.", actionRaw);
-        }
-        else {
-          OFX::Log::error(true, "Requested action was a null pointer.");
+          default:
+            // anything we don't know, including custom actions, ends up here
+            if(actionRaw) {
+              OFX::Log::error(true, "Unknown action '%s'.", actionRaw);
+            }
+            else {
+              OFX::Log::error(true, "Requested action was a null pointer.");
+            }
+            break;
         }
       }
 
@@ -2894,6 +3027,11 @@ namespace OFX {
       OFX::Log::outdent();
       OFX::Log::print("STOP mainEntry (%s for %s, returning %d=%s)\n", actionRaw, plugname,
                       stat, mapStatusToString(stat));
+
+      // stop the log's writer thread once the last plugin is unloaded, rather than leave
+      // it to static destruction, which can't join a thread on every platform
+      if(lastUnload)
+        OFX::Log::close();
       return stat;
     }      
 
@@ -3046,6 +3184,7 @@ void init()
     std::string newID;
     OFX::OfxPlugInfo info = generatePlugInfo(*it, newID);
     OFX::ofxPlugs[counter] = info._plug.get();
+    OFX::plugFactoryByUID[(*it)->getUID().c_str()] = *it;
     OFX::plugInfoMap[newID] = std::move(info);
   }
   gHasInit = true;
@@ -3073,6 +3212,7 @@ EXPORT OfxPlugin* OfxGetPlugin(int nth)
     std::string newID;
     OFX::OfxPlugInfo info = generatePlugInfo(OFX::plugIDs[nth], newID);
     OFX::ofxPlugs[nth] = info._plug.get();
+    OFX::plugFactoryByUID[OFX::plugIDs[nth]->getUID().c_str()] = OFX::plugIDs[nth];
     OFX::plugInfoMap[newID] = std::move(info);
   }
   return OFX::ofxPlugs[nth];
@@ -5,30 +5,443 @@
 
 The log file is written to using printf style functions, rather than via c++ iostreams.
 
+Each thread that logs formats its lines into a ring buffer of its own, which a
+background writer thread drains into the log file. So threads never contend on
+the file, or on each other, to log, and nothing waits on fflush. Lines from all
+threads carry a global sequence number and are written out in that order.
+
+A thread takes its sequence number before its line is in its buffer, so the
+writer only writes lines below the lowest number still on its way into a
+buffer, and holds any others back till the next time round.
+
 */
 
 #include <cassert>
 #include <cstdio>
 #include <cstdarg>
 #include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "ofxsLog.h"
 
 namespace OFX {
   namespace Log {
 
-    /** @brief log file */
-    static FILE *gLogFP = 0;
-
     /// environment variable for the log file
 #define kLogFileEnvVar "OFX_PLUGIN_LOGFILE"
 
+    /// environment variable for the log level, one of none, error, warning or info
+#define kLogLevelEnvVar "OFX_PLUGIN_LOGLEVEL"
+
     /** @brief the global logfile name */
     static std::string gLogFileName(getenv(kLogFileEnvVar) ? getenv(kLogFileEnvVar) : "ofxPluginLog.txt");
 
-    /** @brief global indent level, not MP sane */
-    static int gIndent = 0;
+    /** @brief read the initial level from the environment, everything is logged by default */
+    static LevelEnum levelFromEnvironment(void)
+    {
+      const char *v = getenv(kLogLevelEnvVar);
+      if(!v)
+        return eLevelInfo;
+      if(strcmp(v, "none") == 0 || strcmp(v, "0") == 0)
+        return eLevelNone;
+      if(strcmp(v, "error") == 0 || strcmp(v, "1") == 0)
+        return eLevelError;
+      if(strcmp(v, "warning") == 0 || strcmp(v, "2") == 0)
+        return eLevelWarning;
+      return eLevelInfo;
+    }
+
+    /** @brief the most verbose level that gets logged */
+    static std::atomic<int> gLevel(levelFromEnvironment());
+
+    /** @brief the per thread indent level */
+    static thread_local int tIndent = 0;
+
+    /** @brief bytes in each thread's ring buffer, a power of two */
+    static const size_t kRingSize = 64 * 1024;
+
+    /** @brief the longest line we log, anything longer is truncated */
+    static const size_t kMaxLine = 4096;
+
+    /** @brief A single producer, single consumer ring buffer of log lines.
+
+    The owning thread appends records, each a sequence number, a length and the
+    text, and the writer thread consumes them. Head and tail only ever increase
+    and are masked to index the buffer.
+    */
+    class ThreadLog {
+    public :
+      /** @brief a record header */
+      struct Header {
+        unsigned long long seq;
+        unsigned int       length;
+      };
+
+      explicit ThreadLog(int id)
+        : _id(id)
+        , _pending(0)
+        , _head(0)
+        , _tail(0)
+        , _finished(false)
+      {
+      }
+
+      /** @brief the number of the thread, in the order threads first logged */
+      int getId(void) const {return _id;}
+
+      /** @brief called by the owning thread as it exits */
+      void setFinished(void) {_finished.store(true, std::memory_order_release);}
+
+      /** @brief has the owning thread exited */
+      bool isFinished(void) const {return _finished.load(std::memory_order_acquire);}
+
+      /** @brief called by the owning thread before it takes a sequence number, with one no higher than it will get */
+      void setPending(unsigned long long seq) {_pending.store(seq);}
+
+      /** @brief called by the owning thread once its line is in the buffer, or was dropped */
+      void clearPending(void) {_pending.store(0);}
+
+      /** @brief the lowest sequence number the owning thread may yet push, 0 if none */
+      unsigned long long getPending(void) const {return _pending.load();}
+
+      /** @brief bytes in use, producer side */
+      size_t getUsed(void) const {return _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire);}
+
+      /** @brief append a record, returns false if there was no room for it */
+      bool push(unsigned long long seq, const char *text, unsigned int length)
+      {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t need = sizeof(Header) + length;
+        if(kRingSize - (head - _tail.load(std::memory_order_acquire)) < need)
+          return false;
+
+        Header h;
+        h.seq = seq;
+        h.length = length;
+        copyIn(head, &h, sizeof(h));
+        copyIn(head + sizeof(h), text, length);
+        _head.store(head + need, std::memory_order_release);
+        return true;
+      }
+
+      /** @brief consume every record, handing each to fn */
+      template <class FN> void drain(FN fn)
+      {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t head = _head.load(std::memory_order_acquire);
+        std::string text;
+        while(tail != head) {
+          Header h;
+          copyOut(tail, &h, sizeof(h));
+          text.resize(h.length);
+          if(h.length)
+            copyOut(tail + sizeof(h), &text[0], h.length);
+          tail += sizeof(h) + h.length;
+          fn(h.seq, text);
+        }
+        _tail.store(tail, std::memory_order_release);
+      }
+
+    private :
+      void copyIn(size_t pos, const void *src, size_t n)
+      {
+        size_t at = pos & (kRingSize - 1);
+        size_t first = std::min(n, kRingSize - at);
+        memcpy(_buffer + at, src, first);
+        memcpy(_buffer, static_cast<const char *>(src) + first, n - first);
+      }
+
+      void copyOut(size_t pos, void *dst, size_t n) const
+      {
+        size_t at = pos & (kRingSize - 1);
+        size_t first = std::min(n, kRingSize - at);
+        memcpy(dst, _buffer + at, first);
+        memcpy(static_cast<char *>(dst) + first, _buffer, n - first);
+      }
+
+      int                  _id;
+      std::atomic<unsigned long long> _pending; ///< written by the owning thread
+      std::atomic<size_t>  _head;     ///< written by the owning thread
+      std::atomic<size_t>  _tail;     ///< written by the writer thread
+      std::atomic<bool>    _finished;
+      char                 _buffer[kRingSize];
+    };
+
+    /** @brief owns the log file, the thread buffers and the thread that drains them */
+    class Writer {
+    public :
+      Writer()
+        : _fp(0)
+        , _running(false)
+        , _stop(false)
+        , _wakeRequested(false)
+        , _nDrains(0)
+        , _nextSeq(1)
+        , _writtenSeq(0)
+        , _nextId(1)
+      {
+      }
+
+      /** @brief dtor, also run when the plugin binary is unloaded, so the thread must be gone by then */
+      ~Writer()
+      {
+        close();
+      }
+
+      /** @brief open the file and start the writer thread, if we are not already going */
+      bool open(const std::string &fileName)
+      {
+        std::lock_guard<std::mutex> guard(_openMutex);
+        if(!_fp) {
+          _fp = fopen(fileName.c_str(), "a");
+          if(!_fp)
+            return false;
+          _stop = false;
+          _thread = std::thread(&Writer::run, this);
+          _running.store(true, std::memory_order_release);
+        }
+        return true;
+      }
+
+      /** @brief is the file open */
+      bool isOpen(void) const {return _running.load(std::memory_order_acquire);}
+
+      /** @brief drain everything, stop the thread and close the file */
+      void close(void)
+      {
+        std::lock_guard<std::mutex> guard(_openMutex);
+        if(!_fp)
+          return;
+
+        _running.store(false, std::memory_order_release);
+        {
+          std::lock_guard<std::mutex> lock(_wakeMutex);
+          _stop = true;
+        }
+        _wake.notify_one();
+        // let anyone waiting on the writer see it has gone
+        {
+          std::lock_guard<std::mutex> lock(_drainedMutex);
+        }
+        _drained.notify_all();
+        _thread.join();
+        fclose(_fp);
+        _fp = 0;
+      }
+
+      /** @brief get the calling thread's buffer, making it on first use */
+      ThreadLog &getThreadLog(void)
+      {
+        // the holder marks the buffer finished as the thread exits, the writer frees it once it is empty
+        struct Holder {
+          std::shared_ptr<ThreadLog> log;
+          ~Holder() {if(log) log->setFinished();}
+        };
+        static thread_local Holder tHolder;
+
+        if(!tHolder.log) {
+          std::lock_guard<std::mutex> guard(_threadsMutex);
+          tHolder.log = std::make_shared<ThreadLog>(_nextId++);
+          _threads.push_back(tHolder.log);
+        }
+        return *tHolder.log;
+      }
+
+      /** @brief queue a line from the calling thread, returns its sequence number */
+      unsigned long long push(const char *text, size_t length)
+      {
+        ThreadLog &log = getThreadLog();
+        unsigned int n = (unsigned int) std::min(length, kMaxLine);
+
+        // let the writer know a line is on its way before taking its number, so it can't
+        // write out any line numbered after it first
+        log.setPending(_nextSeq.load());
+        unsigned long long seq = _nextSeq.fetch_add(1);
+
+        // wait for the writer to make room, unless it has gone away
+        while(!log.push(seq, text, n)) {
+          if(!isOpen()) {
+            log.clearPending();
+            return 0;
+          }
+          waitForDrain();
+        }
+        log.clearPending();
+
+        // get the writer going early rather than let the buffer fill
+        if(log.getUsed() > kRingSize / 2)
+          _wake.notify_one();
+        return seq;
+      }
+
+      /** @brief wait until everything queued so far has been written and flushed */
+      void flush(void)
+      {
+        waitFor(_nextSeq.load() - 1);
+      }
+
+      /** @brief wait until the line with the given sequence number has been written and flushed */
+      void waitFor(unsigned long long seq)
+      {
+        while(isOpen() && _writtenSeq.load(std::memory_order_acquire) < seq)
+          waitForDrain();
+      }
+
+    private :
+      /** @brief a line taken out of a thread buffer */
+      struct Line {
+        unsigned long long seq;
+        int                id;
+        std::string        text;
+
+        bool operator<(const Line &other) const {return seq < other.seq;}
+      };
+
+      /** @brief get the writer to drain the buffers now, rather than when it next wakes by itself */
+      void wakeWriter(void)
+      {
+        {
+          std::lock_guard<std::mutex> lock(_wakeMutex);
+          _wakeRequested = true;
+        }
+        _wake.notify_one();
+      }
+
+      /** @brief wake the writer and sleep until it has drained the buffers once more, or gone away */
+      void waitForDrain(void)
+      {
+        std::unique_lock<std::mutex> lock(_drainedMutex);
+        unsigned long long drains = _nDrains;
+        lock.unlock();
+        wakeWriter();
+        lock.lock();
+        _drained.wait(lock, [this, drains]() {return _nDrains != drains || !isOpen();});
+      }
+
+      /** @brief the writer thread */
+      void run(void)
+      {
+        std::vector<Line> lines;
+        std::vector<Line> later;
+        for(;;) {
+          bool stop;
+          {
+            std::unique_lock<std::mutex> lock(_wakeMutex);
+            _wake.wait_for(lock, std::chrono::milliseconds(20), [this]() {return _stop || _wakeRequested;});
+            _wakeRequested = false;
+            stop = _stop;
+          }
+
+          drainAll(lines, later, stop);
+
+          // wake the threads waiting on room in their buffers or on their lines being written
+          {
+            std::lock_guard<std::mutex> lock(_drainedMutex);
+            ++_nDrains;
+          }
+          _drained.notify_all();
+
+          if(stop)
+            break;
+        }
+      }
+
+      /** @brief Write out everything queued so far that can go out in sequence order.
+
+      Lines numbered at or above the lowest number a thread has taken but not yet
+      pushed are held back in later, unless we are stopping, when everything goes.
+      */
+      void drainAll(std::vector<Line> &lines, std::vector<Line> &later, bool stop)
+      {
+        // find the limit before draining, so any line below it is in a buffer by the time we drain
+        unsigned long long limit = _nextSeq.load();
+        {
+          std::lock_guard<std::mutex> guard(_threadsMutex);
+          for(size_t i = 0; i < _threads.size(); ++i) {
+            unsigned long long pending = _threads[i]->getPending();
+            if(pending && pending < limit)
+              limit = pending;
+          }
+        }
+
+        lines.swap(later);
+        later.clear();
+        {
+          std::lock_guard<std::mutex> guard(_threadsMutex);
+          for(size_t i = 0; i < _threads.size();) {
+            ThreadLog &log = *_threads[i];
+            // check finished first, so a thread can't log between us draining it and dropping it
+            bool finished = log.isFinished();
+            int id = log.getId();
+            log.drain([&lines, id](unsigned long long seq, const std::string &text) {
+                Line l;
+                l.seq = seq;
+                l.id = id;
+                l.text = text;
+                lines.push_back(l);
+              });
+            if(finished) {
+              _threads[i] = _threads.back();
+              _threads.pop_back();
+            }
+            else
+              ++i;
+          }
+        }
+
+        std::sort(lines.begin(), lines.end());
+        size_t nReady = lines.size();
+        if(!stop) {
+          while(nReady > 0 && lines[nReady - 1].seq >= limit)
+            --nReady;
+          later.assign(lines.begin() + nReady, lines.end());
+        }
+
+        if(nReady > 0) {
+          for(size_t i = 0; i < nReady; ++i) {
+            // lines from the first thread to log go out untagged, as they always have
+            if(lines[i].id != 1)
+              fprintf(_fp, "[T%d] ", lines[i].id);
+            fwrite(lines[i].text.data(), 1, lines[i].text.size(), _fp);
+            fputc('\n', _fp);
+          }
+          fflush(_fp);
+        }
+
+        // everything numbered below the limit has now been written
+        if(limit - 1 > _writtenSeq.load(std::memory_order_relaxed))
+          _writtenSeq.store(limit - 1, std::memory_order_release);
+      }
+
+      FILE                        *_fp;
+      std::thread                  _thread;
+      std::mutex                   _openMutex;     ///< serialises open and close
+      std::atomic<bool>            _running;
+      std::mutex                   _wakeMutex;     ///< guards _stop and _wakeRequested
+      std::condition_variable      _wake;          ///< wakes the writer
+      bool                         _stop;
+      bool                         _wakeRequested; ///< someone is waiting on the writer, so drain now
+      std::mutex                   _drainedMutex;  ///< guards _nDrains
+      std::condition_variable      _drained;       ///< signalled by the writer after each drain
+      unsigned long long           _nDrains;
+      std::atomic<unsigned long long> _nextSeq;
+      std::atomic<unsigned long long> _writtenSeq; ///< every line numbered up to this one has been flushed
+      std::mutex                   _threadsMutex;  ///< guards _threads and _nextId, taken once per new thread
+      std::vector<std::shared_ptr<ThreadLog> > _threads;
+      int                          _nextId;
+    };
+
+    /** @brief the one writer */
+    static Writer gWriter;
 
     /** @brief Sets the name of the log file. */
     void setFileName(const std::string &value)
@@ -36,95 +449,112 @@ namespace OFX {
       gLogFileName = value;
     }
 
+    /** @brief Sets the most verbose level of message that gets logged. */
+    void setLevel(LevelEnum level)
+    {
+      gLevel.store(level, std::memory_order_relaxed);
+    }
+
+    /** @brief Gets the most verbose level of message that gets logged. */
+    LevelEnum getLevel(void)
+    {
+      return LevelEnum(gLevel.load(std::memory_order_relaxed));
+    }
+
+    /** @brief Would a message at the given level be logged. */
+    bool isEnabled(LevelEnum level)
+    {
+      return level <= gLevel.load(std::memory_order_relaxed) && open();
+    }
+
     /** @brief Opens the log file, returns whether this was successful or not. */
     bool open(void)
     {
 #ifdef DEBUG
-      if(!gLogFP) {
-        gLogFP = fopen(gLogFileName.c_str(), "a");
-        return gLogFP != 0;
-      }
+      if(!gWriter.isOpen())
+        return gWriter.open(gLogFileName);
 #endif
-      return gLogFP != 0;
+      return gWriter.isOpen();
     }
 
     /** @brief Closes the log file. */
     void close(void)
     {
-      if(gLogFP) {
-        fclose(gLogFP);
-      }
-      gLogFP = 0;
+      gWriter.close();
     }
 
-    /** @brief Indent it, not MP sane at the moment */
+    /** @brief Waits until everything logged so far is in the log file. */
+    void flush(void)
+    {
+      gWriter.flush();
+    }
+
+    /** @brief Indent it, for the calling thread only */
     void indent(void)
     {
-      ++gIndent;
+      ++tIndent;
     }
 
-    /** @brief Outdent it, not MP sane at the moment */
+    /** @brief Outdent it, for the calling thread only */
     void outdent(void)
     {
-      --gIndent;
+      --tIndent;
     }
 
-    /** @brief do the indenting */
-    static void doIndent(void)
+    /** @brief format a line with the calling thread's indent and queue it, returns its sequence number */
+    static unsigned long long vlog(const char *prefix, const char *format, va_list args)
     {
-      if(open()) {
-        for(int i = 0; i < gIndent; i++) {
-          fputs("    ", gLogFP);
-        }
+      char line[kMaxLine + 1];
+      size_t n = 0;
+      for(int i = 0; i < tIndent && n + 4 <= kMaxLine; i++) {
+        memcpy(line + n, "    ", 4);
+        n += 4;
+      }
+      if(prefix) {
+        size_t p = std::min(strlen(prefix), kMaxLine - n);
+        memcpy(line + n, prefix, p);
+        n += p;
       }
+      int written = vsnprintf(line + n, kMaxLine + 1 - n, format, args);
+      if(written > 0)
+        n = std::min(n + size_t(written), size_t(kMaxLine));
+      return gWriter.push(line, n);
     }
 
     /** @brief Prints to the log file. */
     void print(const char *format, ...)
     {
-      if(open()) {
-        doIndent();
+      if(eLevelInfo <= gLevel.load(std::memory_order_relaxed) && open()) {
         va_list args;
         va_start(args, format);
-        vfprintf(gLogFP, format, args);
-        fputc('\n', gLogFP);
-        fflush(gLogFP);
+        vlog(0, format, args);
         va_end(args);
-      }  
+      }
     }
 
     /** @brief Prints to the log file only if the condition is true and prepends a warning notice. */
     void warning(bool condition, const char *format, ...)
     {
-      if(condition && open()) {
-        doIndent();
-        fputs("WARNING : ", gLogFP);
-
+      if(condition && eLevelWarning <= gLevel.load(std::memory_order_relaxed) && open()) {
         va_list args;
         va_start(args, format);
-        vfprintf(gLogFP, format, args);
-        fputc('\n', gLogFP);
+        vlog("WARNING : ", format, args);
         va_end(args);
-
-        fflush(gLogFP);
-      }  
+      }
     }
 
     /** @brief Prints to the log file only if the condition is true and prepends an error notice. */
     void error(bool condition, const char *format, ...)
     {
-      if(condition && open()) {
-        doIndent();
-        fputs("ERROR : ", gLogFP);
-
+      if(condition && eLevelError <= gLevel.load(std::memory_order_relaxed) && open()) {
         va_list args;
         va_start(args, format);
-        vfprintf(gLogFP, format, args);
-        fputc('\n', gLogFP);
+        unsigned long long seq = vlog("ERROR : ", format, args);
         va_end(args);
 
-        fflush(gLogFP);
-      }  
+        // errors often come just before a crash, so make sure they land
+        gWriter.waitFor(seq);
+      }
     }
   };
 };
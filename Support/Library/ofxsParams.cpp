@@ -35,6 +35,7 @@ namespace OFX {
     case eChoiceParam : return kOfxParamTypeChoice ;
     case eStrChoiceParam : return kOfxParamTypeStrChoice;
     case eCustomParam : return kOfxParamTypeCustom ;
+    case eBytesParam : return kOfxParamTypeBytes ;
     case eGroupParam : return kOfxParamTypeGroup ;
     case ePageParam : return kOfxParamTypePage ;
     case ePushButtonParam : return kOfxParamTypePushButton ;
@@ -87,6 +88,8 @@ namespace OFX {
       return ePushButtonParam ;
     else if(isEqual(kOfxParamTypeParametric,v))
       return eParametricParam ;
+    else if(isEqual(kOfxParamTypeBytes,v))
+      return eBytesParam ;
     else
       assert(false);
     return ePushButtonParam ;
@@ -896,6 +899,26 @@ namespace OFX {
     _paramProps.propSetPointer(kOfxParamPropCustomInterpCallbackV1, v ? (void*)OFX::Private::customParamInterpolationV1Entry : NULL);
   }
 
+  ////////////////////////////////////////////////////////////////////////////////
+  // bytes param descriptor
+
+  /** @brief hidden ctor */
+  BytesParamDescriptor::BytesParamDescriptor(const std::string &name, OfxPropertySetHandle props)
+    : ValueParamDescriptor(name, eBytesParam, props)
+  {
+    _defaultBytes.data = NULL;
+    _defaultBytes.length = 0;
+  }
+
+  /** @brief set the default value, default is no bytes */
+  void BytesParamDescriptor::setDefault(const OfxBytes &v)
+  {
+    _defaultData.assign(v.data, v.data + (v.data ? v.length : 0));
+    _defaultBytes.data = _defaultData.empty() ? NULL : &_defaultData[0];
+    _defaultBytes.length = _defaultData.size();
+    _paramProps.propSetPointer(kOfxParamPropDefault, &_defaultBytes);
+  }
+
   ////////////////////////////////////////////////////////////////////////////////
   // group param descriptor
 
@@ -1219,6 +1242,14 @@ namespace OFX {
     return param;
   }
 
+  /** @brief Define a bytes param */
+  BytesParamDescriptor *ParamSetDescriptor::defineBytesParam(const std::string &name)
+  {
+    BytesParamDescriptor *param = NULL;
+    defineParamDescriptor(name, eBytesParam, param);
+    return param;
+  }
+
 
   ////////////////////////////////////////////////////////////////////////////////
   /** @brief Base class for all param instances */
@@ -1546,6 +1577,24 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  /** @brief Get the values of a param at n times from the host's parameter batch suite.
+
+  Returns false if the host has no batch suite or cannot batch this param, in which case
+  the caller gets them one at a time, throws if the host fails otherwise.
+  */
+  static bool getValuesAtTimesFromHost(OfxParamHandle handle, const double *times, void *values, int n)
+  {
+    if(n <= 0)
+      return true;
+    if(!OFX::Private::gParameterBatchSuite)
+      return false;
+    OfxStatus stat = OFX::Private::gParameterBatchSuite->paramGetValuesAtTimes(handle, n, times, values);
+    if(stat == kOfxStatErrUnsupported)
+      return false;
+    throwSuiteStatusException(stat);
+    return true;
+  }
+
   /** @brief get the value at a time */
   void IntParam::getValueAtTime(double t, int &v)
   {
@@ -1553,6 +1602,15 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+  void IntParam::getValuesAtTimes(const double *times, int *values, int n)
+  {
+    if(!getValuesAtTimesFromHost(_paramHandle, times, values, n)) {
+      for(int i = 0; i < n; ++i)
+        getValueAtTime(times[i], values[i]);
+    }
+  }
+
   /** @brief set value */
   void IntParam::setValue(int v)
   {
@@ -1650,6 +1708,15 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+  void Int2DParam::getValuesAtTimes(const double *times, OfxPointI *values, int n)
+  {
+    if(!getValuesAtTimesFromHost(_paramHandle, times, values, n)) {
+      for(int i = 0; i < n; ++i)
+        getValueAtTime(times[i], values[i].x, values[i].y);
+    }
+  }
+
   /** @brief set value */
   void Int2DParam::setValue(int x, int y)
   {
@@ -1758,6 +1825,15 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+  void Int3DParam::getValuesAtTimes(const double *times, Ofx3DPointI *values, int n)
+  {
+    if(!getValuesAtTimesFromHost(_paramHandle, times, values, n)) {
+      for(int i = 0; i < n; ++i)
+        getValueAtTime(times[i], values[i].x, values[i].y, values[i].z);
+    }
+  }
+
   /** @brief set value */
   void Int3DParam::setValue(int x, int y, int z)
   {
@@ -1925,6 +2001,15 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+  void DoubleParam::getValuesAtTimes(const double *times, double *values, int n)
+  {
+    if(!getValuesAtTimesFromHost(_paramHandle, times, values, n)) {
+      for(int i = 0; i < n; ++i)
+        getValueAtTime(times[i], values[i]);
+    }
+  }
+
   /** @brief set value */
   void DoubleParam::setValue(double v)
   {
@@ -2038,6 +2123,15 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+  void Double2DParam::getValuesAtTimes(const double *times, OfxPointD *values, int n)
+  {
+    if(!getValuesAtTimesFromHost(_paramHandle, times, values, n)) {
+      for(int i = 0; i < n; ++i)
+        getValueAtTime(times[i], values[i].x, values[i].y);
+    }
+  }
+
   /** @brief set value */
   void Double2DParam::setValue(double x, double y)
   {
@@ -2162,6 +2256,15 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+  void Double3DParam::getValuesAtTimes(const double *times, Ofx3DPointD *values, int n)
+  {
+    if(!getValuesAtTimesFromHost(_paramHandle, times, values, n)) {
+      for(int i = 0; i < n; ++i)
+        getValueAtTime(times[i], values[i].x, values[i].y, values[i].z);
+    }
+  }
+
   /** @brief set value */
   void Double3DParam::setValue(double x, double y, double z)
   {
@@ -2231,6 +2334,15 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+  void RGBParam::getValuesAtTimes(const double *times, OfxRGBColourD *values, int n)
+  {
+    if(!getValuesAtTimesFromHost(_paramHandle, times, values, n)) {
+      for(int i = 0; i < n; ++i)
+        getValueAtTime(times[i], values[i].r, values[i].g, values[i].b);
+    }
+  }
+
   /** @brief set value */
   void RGBParam::setValue(double r, double g, double b)
   {
@@ -2287,6 +2399,15 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+  void RGBAParam::getValuesAtTimes(const double *times, OfxRGBAColourD *values, int n)
+  {
+    if(!getValuesAtTimesFromHost(_paramHandle, times, values, n)) {
+      for(int i = 0; i < n; ++i)
+        getValueAtTime(times[i], values[i].r, values[i].g, values[i].b, values[i].a);
+    }
+  }
+
   /** @brief set value */
   void RGBAParam::setValue(double r, double g, double b, double a)
   {
@@ -2656,6 +2777,56 @@ namespace OFX {
     throwSuiteStatusException(stat);
   }
 
+  ////////////////////////////////////////////////////////////////////////////////
+  // Wraps up a bytes param
+
+  /** @brief hidden constructor */
+  BytesParam::BytesParam(const ParamSet *paramSet, const std::string &name, OfxParamHandle handle)
+    : ValueParam(paramSet, name, eBytesParam, handle)
+  {
+  }
+
+  /** @brief get the default value */
+  void BytesParam::getDefault(OfxBytes &v)
+  {
+    const OfxBytes *def = (const OfxBytes *) _paramProps.propGetPointer(kOfxParamPropDefault, false);
+    if(def)
+      v = *def;
+    else {
+      v.data = NULL;
+      v.length = 0;
+    }
+  }
+
+  /** @brief get value */
+  void BytesParam::getValue(OfxBytes &v)
+  {
+    OfxStatus stat = OFX::Private::gParamSuite->paramGetValue(_paramHandle, &v);
+    throwSuiteStatusException(stat);
+  }
+
+  /** @brief get the value at a time */
+  void BytesParam::getValueAtTime(double t, OfxBytes &v)
+  {
+    OfxStatus stat = OFX::Private::gParamSuite->paramGetValueAtTime(_paramHandle, t, &v);
+    throwSuiteStatusException(stat);
+  }
+
+  /** @brief set value */
+  void BytesParam::setValue(const OfxBytes &v)
+  {
+    OfxStatus stat = OFX::Private::gParamSuite->paramSetValue(_paramHandle, &v);
+    throwSuiteStatusException(stat);
+  }
+
+  /** @brief set the value at a time, implicitly adds a keyframe */
+  void BytesParam::setValueAtTime(double t, const OfxBytes &v)
+  {
+    if(!OFX::Private::gParamSuite->paramSetValueAtTime) throwHostMissingSuiteException("paramSetValueAtTime");
+    OfxStatus stat = OFX::Private::gParamSuite->paramSetValueAtTime(_paramHandle, t, &v);
+    throwSuiteStatusException(stat);
+  }
+
   ////////////////////////////////////////////////////////////////////////////////
   // Wraps up a group param
   /** @brief hidden constructor */
@@ -3054,6 +3225,12 @@ namespace OFX {
         fetchParam(name, t, ptr);
         return ptr;
       }
+    case eBytesParam :
+      {
+        BytesParam* ptr = 0;
+        fetchParam(name, t, ptr);
+        return ptr;
+      }
     default:
       assert(false);
     }
@@ -3202,6 +3379,14 @@ namespace OFX {
     return param;
   }
 
+  /** @brief Fetch a bytes param */
+  BytesParam *ParamSet::fetchBytesParam(const std::string &name) const
+  {
+    BytesParam *param = NULL;
+    fetchParam(name, eBytesParam, param);
+    return param;
+  }
+
   /** @brief Fetch a parametric param */
   ParametricParam *ParamSet::fetchParametricParam(const std::string &name) const
   {
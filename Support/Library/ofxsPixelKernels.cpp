@@ -0,0 +1,274 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+#include "ofxsPixelKernels.h"
+#include "ofxsPixelKernelsPrivate.h"
+
+namespace OFX {
+
+  namespace Kernels {
+
+    /** @brief environment variable that caps the instruction set the kernels use */
+    static const char *kInstructionSetEnvVar = "OFX_PIXEL_KERNELS";
+
+    namespace {
+
+      // one float at a time, the fall back everywhere
+      struct Scalar {
+        typedef float V;
+        static const int W = 1;
+
+        static V load(const float *p) { return *p; }
+        static void store(float *p, V v) { *p = v; }
+        static V set1(float v) { return v; }
+        static V add(V a, V b) { return a + b; }
+        static V sub(V a, V b) { return a - b; }
+        static V mul(V a, V b) { return a * b; }
+        static V div(V a, V b) { return a / b; }
+        static V min(V a, V b) { return scalarMin(a, b); }
+        static V max(V a, V b) { return scalarMax(a, b); }
+
+        static V loadBytes(const uint8_t *p) { return float(*p); }
+        static void storeBytes(uint8_t *p, V v) { *p = uint8_t(v); }
+        static V loadShorts(const uint16_t *p) { return float(*p); }
+        static void storeShorts(uint16_t *p, V v) { *p = uint16_t(v); }
+        static V loadHalves(const uint16_t *p) { return halfToFloat(*p); }
+        static void storeHalves(uint16_t *p, V v) { *p = floatToHalf(v); }
+      };
+
+    }
+
+    const KernelTable *getScalarKernels(void)
+    {
+      // premultiplying needs a whole pixel in a vector, so is done by hand here
+      static const KernelTable table = {
+        scaleOffsetKernel<Scalar>,
+        lerpKernel<Scalar>,
+        premultiplyPixels,
+        unpremultiplyPixels,
+        clampKernel<Scalar>,
+        fromBytesKernel<Scalar>,
+        toBytesKernel<Scalar>,
+        fromShortsKernel<Scalar>,
+        toShortsKernel<Scalar>,
+        fromHalvesKernel<Scalar>,
+        toHalvesKernel<Scalar>
+      };
+      return &table;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // picking an instruction set
+
+    /** @brief does the CPU we are running on, and the OS, support the instruction set */
+    static bool cpuSupports(InstructionSetEnum v)
+    {
+      switch(v) {
+      case eInstructionSetScalar :
+        return true;
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+      case eInstructionSetSSE4 :
+        return __builtin_cpu_supports("sse4.1");
+      case eInstructionSetAVX2 :
+        // the AVX2 build converts halves with F16C, which every AVX2 CPU has, but check anyway
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+      case eInstructionSetAVX512 :
+        return __builtin_cpu_supports("avx512f");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+      case eInstructionSetSSE4 :
+      case eInstructionSetAVX2 :
+      case eInstructionSetAVX512 : {
+        int info[4];
+        __cpuid(info, 1);
+        if(v == eInstructionSetSSE4)
+          return (info[2] & (1 << 19)) != 0;
+        // the OS has to save the AVX registers as well as the CPU having them
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if(!osxsave)
+          return false;
+        unsigned long long xcr0 = _xgetbv(0);
+        bool f16c = (info[2] & (1 << 29)) != 0;
+        __cpuidex(info, 7, 0);
+        if(v == eInstructionSetAVX2)
+          return (xcr0 & 0x6) == 0x6 && f16c && (info[1] & (1 << 5)) != 0;
+        return (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)) != 0;
+      }
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+      case eInstructionSetNEON :
+        return true;
+#endif
+      default :
+        return false;
+      }
+    }
+
+    /** @brief the build of the kernels for an instruction set, NULL if there is none */
+    static const KernelTable *tableFor(InstructionSetEnum v)
+    {
+      switch(v) {
+      case eInstructionSetScalar : return getScalarKernels();
+      case eInstructionSetSSE4 :   return getSSE4Kernels();
+      case eInstructionSetAVX2 :   return getAVX2Kernels();
+      case eInstructionSetAVX512 : return getAVX512Kernels();
+      case eInstructionSetNEON :   return getNEONKernels();
+      }
+      return 0;
+    }
+
+    bool isInstructionSetAvailable(InstructionSetEnum v)
+    {
+      return tableFor(v) != 0 && cpuSupports(v);
+    }
+
+    const char *getInstructionSetName(InstructionSetEnum v)
+    {
+      switch(v) {
+      case eInstructionSetScalar : return "scalar";
+      case eInstructionSetSSE4 :   return "sse4";
+      case eInstructionSetAVX2 :   return "avx2";
+      case eInstructionSetAVX512 : return "avx512";
+      case eInstructionSetNEON :   return "neon";
+      }
+      return "unknown";
+    }
+
+    /** @brief the best available instruction set, no better than any named in the environment */
+    static InstructionSetEnum pickInstructionSet(void)
+    {
+      static const InstructionSetEnum preferred[] = {
+        eInstructionSetAVX512, eInstructionSetAVX2, eInstructionSetSSE4, eInstructionSetNEON, eInstructionSetScalar
+      };
+      const size_t nPreferred = sizeof(preferred) / sizeof(preferred[0]);
+
+      // a name we do not know caps nothing
+      const char *cap = getenv(kInstructionSetEnvVar);
+      bool capped = false;
+      for(size_t i = 0; cap && i < nPreferred; ++i)
+        capped = capped || strcmp(cap, getInstructionSetName(preferred[i])) == 0;
+
+      for(size_t i = 0; i < nPreferred; ++i) {
+        InstructionSetEnum v = preferred[i];
+        if(capped) {
+          // skip everything better than the one asked for
+          if(strcmp(cap, getInstructionSetName(v)) != 0)
+            continue;
+          capped = false;
+        }
+        if(isInstructionSetAvailable(v))
+          return v;
+      }
+      return eInstructionSetScalar;
+    }
+
+    static InstructionSetEnum gInstructionSet = eInstructionSetScalar;
+    static const KernelTable *gKernels = 0;
+    static std::once_flag gPickOnce;
+
+    /** @brief the kernels to run, picked on the first call */
+    static const KernelTable &kernels(void)
+    {
+      std::call_once(gPickOnce, []() {
+        gInstructionSet = pickInstructionSet();
+        gKernels = tableFor(gInstructionSet);
+      });
+      return *gKernels;
+    }
+
+    InstructionSetEnum getInstructionSet(void)
+    {
+      kernels();
+      return gInstructionSet;
+    }
+
+    bool setInstructionSet(InstructionSetEnum v)
+    {
+      kernels();
+      if(!isInstructionSetAvailable(v))
+        return false;
+      gInstructionSet = v;
+      gKernels = tableFor(v);
+      return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // the kernels themselves
+
+    void scaleOffset(const float *src, float *dst, size_t nPixels, int nComponents, const float *scale, const float *offset)
+    {
+      kernels().scaleOffset(src, dst, nPixels, nComponents, scale, offset);
+    }
+
+    void lerp(const float *a, const float *b, float *dst, size_t n, float t)
+    {
+      kernels().lerp(a, b, dst, n, t);
+    }
+
+    void premultiply(const float *src, float *dst, size_t nPixels)
+    {
+      kernels().premultiply(src, dst, nPixels);
+    }
+
+    void unpremultiply(const float *src, float *dst, size_t nPixels)
+    {
+      kernels().unpremultiply(src, dst, nPixels);
+    }
+
+    void clamp(const float *src, float *dst, size_t n, float lo, float hi)
+    {
+      kernels().clamp(src, dst, n, lo, hi);
+    }
+
+    void convert(const uint8_t *src, float *dst, size_t n)
+    {
+      kernels().fromBytes(src, dst, n);
+    }
+
+    void convert(const float *src, uint8_t *dst, size_t n)
+    {
+      kernels().toBytes(src, dst, n);
+    }
+
+    void convert(const uint16_t *src, float *dst, size_t n)
+    {
+      kernels().fromShorts(src, dst, n);
+    }
+
+    void convert(const float *src, uint16_t *dst, size_t n)
+    {
+      kernels().toShorts(src, dst, n);
+    }
+
+    void convert(const Half *src, float *dst, size_t n)
+    {
+      kernels().fromHalves((const uint16_t *) src, dst, n);
+    }
+
+    void convert(const float *src, Half *dst, size_t n)
+    {
+      kernels().toHalves(src, (uint16_t *) dst, n);
+    }
+
+    float toFloat(Half v)
+    {
+      return halfToFloat(v.bits);
+    }
+
+    Half toHalf(float v)
+    {
+      Half h;
+      h.bits = floatToHalf(v);
+      return h;
+    }
+
+  };
+
+};
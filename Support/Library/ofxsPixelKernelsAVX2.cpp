@@ -0,0 +1,93 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+// the AVX2 build of the pixel kernels, compiled with -mavx2 -mf16c
+
+#include "ofxsPixelKernelsPrivate.h"
+
+#if defined(__AVX2__) && (defined(__F16C__) || defined(_MSC_VER))
+
+#include <immintrin.h>
+
+namespace OFX {
+
+  namespace Kernels {
+
+    namespace {
+
+      struct AVX2 {
+        typedef __m256 V;
+        static const int W = 8;
+
+        static V load(const float *p) { return _mm256_loadu_ps(p); }
+        static void store(float *p, V v) { _mm256_storeu_ps(p, v); }
+        static V set1(float v) { return _mm256_set1_ps(v); }
+        static V add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm256_div_ps(a, b); }
+        static V min(V a, V b) { return _mm256_min_ps(a, b); }
+        static V max(V a, V b) { return _mm256_max_ps(a, b); }
+
+        static V splatAlpha(V v) { return _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3)); }
+        static V blendAlpha(V c, V a) { return _mm256_blend_ps(c, a, 0x88); }
+        static V selectNonZero(V m, V a, V b) { return _mm256_blendv_ps(a, b, _mm256_cmp_ps(m, _mm256_setzero_ps(), _CMP_EQ_OQ)); }
+
+        static V loadBytes(const uint8_t *p)
+        {
+          return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) p)));
+        }
+
+        static void storeBytes(uint8_t *p, V v)
+        {
+          __m128i s = packShorts(v);
+          _mm_storel_epi64((__m128i *) p, _mm_packus_epi16(s, s));
+        }
+
+        static V loadShorts(const uint16_t *p)
+        {
+          return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) p)));
+        }
+
+        static void storeShorts(uint16_t *p, V v)
+        {
+          _mm_storeu_si128((__m128i *) p, packShorts(v));
+        }
+
+        static V loadHalves(const uint16_t *p)
+        {
+          return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *) p));
+        }
+
+        static void storeHalves(uint16_t *p, V v)
+        {
+          _mm_storeu_si128((__m128i *) p, _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+        }
+
+        // the packs work within 128 bit lanes, so split the vector rather than pack it whole
+        static __m128i packShorts(V v)
+        {
+          __m256i i = _mm256_cvttps_epi32(v);
+          return _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+        }
+      };
+
+    }
+
+    const KernelTable *getAVX2Kernels(void)
+    {
+      return makeKernelTable<AVX2>();
+    }
+
+  };
+
+};
+
+#else
+
+const OFX::Kernels::KernelTable *OFX::Kernels::getAVX2Kernels(void)
+{
+  return 0;
+}
+
+#endif
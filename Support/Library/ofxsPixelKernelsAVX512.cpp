@@ -0,0 +1,90 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+// the AVX-512 build of the pixel kernels, compiled with -mavx512f and needing no more than AVX-512F
+
+#include "ofxsPixelKernelsPrivate.h"
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+
+namespace OFX {
+
+  namespace Kernels {
+
+    namespace {
+
+      // GCC's unmasked AVX-512 intrinsics start from a deliberately uninitialised vector, which
+      // -Wmaybe-uninitialized reports wherever they are inlined, so every operation that would
+      // is written as its zero masked form, with all lanes on
+      const __mmask16 kAllLanes = 0xffff;
+
+      struct AVX512 {
+        typedef __m512 V;
+        static const int W = 16;
+
+        static V load(const float *p) { return _mm512_loadu_ps(p); }
+        static void store(float *p, V v) { _mm512_storeu_ps(p, v); }
+        static V set1(float v) { return _mm512_set1_ps(v); }
+        static V add(V a, V b) { return _mm512_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm512_div_ps(a, b); }
+        static V min(V a, V b) { return _mm512_maskz_min_ps(kAllLanes, a, b); }
+        static V max(V a, V b) { return _mm512_maskz_max_ps(kAllLanes, a, b); }
+
+        static V splatAlpha(V v) { return _mm512_maskz_permute_ps(kAllLanes, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+        static V blendAlpha(V c, V a) { return _mm512_mask_blend_ps(0x8888, c, a); }
+        static V selectNonZero(V m, V a, V b) { return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(m, _mm512_setzero_ps(), _CMP_EQ_OQ), a, b); }
+
+        static V loadBytes(const uint8_t *p)
+        {
+          return _mm512_maskz_cvtepi32_ps(kAllLanes, _mm512_maskz_cvtepu8_epi32(kAllLanes, _mm_loadu_si128((const __m128i *) p)));
+        }
+
+        static void storeBytes(uint8_t *p, V v)
+        {
+          _mm_storeu_si128((__m128i *) p, _mm512_mask_cvtusepi32_epi8(_mm_setzero_si128(), kAllLanes, _mm512_maskz_cvttps_epi32(kAllLanes, v)));
+        }
+
+        static V loadShorts(const uint16_t *p)
+        {
+          return _mm512_maskz_cvtepi32_ps(kAllLanes, _mm512_maskz_cvtepu16_epi32(kAllLanes, _mm256_loadu_si256((const __m256i *) p)));
+        }
+
+        static void storeShorts(uint16_t *p, V v)
+        {
+          _mm256_storeu_si256((__m256i *) p, _mm512_mask_cvtusepi32_epi16(_mm256_setzero_si256(), kAllLanes, _mm512_maskz_cvttps_epi32(kAllLanes, v)));
+        }
+
+        static V loadHalves(const uint16_t *p)
+        {
+          return _mm512_maskz_cvtph_ps(kAllLanes, _mm256_loadu_si256((const __m256i *) p));
+        }
+
+        static void storeHalves(uint16_t *p, V v)
+        {
+          _mm256_storeu_si256((__m256i *) p, _mm512_maskz_cvtps_ph(kAllLanes, v, _MM_FROUND_TO_NEAREST_INT));
+        }
+      };
+
+    }
+
+    const KernelTable *getAVX512Kernels(void)
+    {
+      return makeKernelTable<AVX512>();
+    }
+
+  };
+
+};
+
+#else
+
+const OFX::Kernels::KernelTable *OFX::Kernels::getAVX512Kernels(void)
+{
+  return 0;
+}
+
+#endif
@@ -0,0 +1,93 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+// the NEON build of the pixel kernels, on 64 bit ARM where NEON is always there and needs no flags
+
+#include "ofxsPixelKernelsPrivate.h"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+
+namespace OFX {
+
+  namespace Kernels {
+
+    namespace {
+
+      struct NEON {
+        typedef float32x4_t V;
+        static const int W = 4;
+
+        static V load(const float *p) { return vld1q_f32(p); }
+        static void store(float *p, V v) { vst1q_f32(p, v); }
+        static V set1(float v) { return vdupq_n_f32(v); }
+        static V add(V a, V b) { return vaddq_f32(a, b); }
+        static V sub(V a, V b) { return vsubq_f32(a, b); }
+        static V mul(V a, V b) { return vmulq_f32(a, b); }
+        static V div(V a, V b) { return vdivq_f32(a, b); }
+
+        // vminq and vmaxq give a NaN if either argument is one, do as SSE does instead
+        static V min(V a, V b) { return vbslq_f32(vcltq_f32(a, b), a, b); }
+        static V max(V a, V b) { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+
+        static V splatAlpha(V v) { return vdupq_laneq_f32(v, 3); }
+        static V blendAlpha(V c, V a) { return vcopyq_laneq_f32(c, 3, a, 3); }
+        static V selectNonZero(V m, V a, V b) { return vbslq_f32(vceqq_f32(m, vdupq_n_f32(0.0f)), b, a); }
+
+        static V loadBytes(const uint8_t *p)
+        {
+          uint32_t v;
+          copy4(&v, p);
+          uint16x8_t s = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(v)));
+          return vcvtq_f32_u32(vmovl_u16(vget_low_u16(s)));
+        }
+
+        static void storeBytes(uint8_t *p, V v)
+        {
+          uint16x4_t s = vmovn_u32(vcvtq_u32_f32(v));
+          uint8x8_t b = vmovn_u16(vcombine_u16(s, s));
+          uint32_t w = vget_lane_u32(vreinterpret_u32_u8(b), 0);
+          copy4(p, &w);
+        }
+
+        static V loadShorts(const uint16_t *p)
+        {
+          return vcvtq_f32_u32(vmovl_u16(vld1_u16(p)));
+        }
+
+        static void storeShorts(uint16_t *p, V v)
+        {
+          vst1_u16(p, vmovn_u32(vcvtq_u32_f32(v)));
+        }
+
+        static V loadHalves(const uint16_t *p)
+        {
+          return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(p)));
+        }
+
+        static void storeHalves(uint16_t *p, V v)
+        {
+          vst1_u16(p, vreinterpret_u16_f16(vcvt_f16_f32(v)));
+        }
+      };
+
+    }
+
+    const KernelTable *getNEONKernels(void)
+    {
+      return makeKernelTable<NEON>();
+    }
+
+  };
+
+};
+
+#else
+
+const OFX::Kernels::KernelTable *OFX::Kernels::getNEONKernels(void)
+{
+  return 0;
+}
+
+#endif
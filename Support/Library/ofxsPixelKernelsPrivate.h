@@ -0,0 +1,358 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _ofxsPixelKernelsPrivate_H_
+#define _ofxsPixelKernelsPrivate_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @file The kernels behind ofxsPixelKernels.h, written once over a vector type and built for each instruction set.
+
+Each ofxsPixelKernels<ISA>.cpp is compiled with the flags for its instruction set, defines
+a VEC class wrapping its intrinsics and hands makeKernelTable<VEC>() back to the dispatcher.
+Everything in those files, this one included, lives in an anonymous namespace and uses
+no inline functions from other headers, as the linker would be free to keep an AVX
+build of a shared inline function and have the scalar code call it.
+
+A VEC class provides
+   - W, the number of floats in a vector, a multiple of 4 unless it is the scalar one,
+   - V, the vector type,
+   - load, store, set1, add, sub, mul, div, min, max, where min and max give the second
+     argument if either is a NaN, as the SSE instructions do,
+   - loadBytes, storeBytes, loadShorts, storeShorts, which widen W unsigned integers to
+     floats, or narrow W floats already in range to unsigned integers, truncating,
+   - loadHalves, storeHalves, which widen W IEEE halves to floats, or narrow W floats to
+     halves, rounding to nearest even as F16C does,
+and for W >= 4
+   - splatAlpha, which copies the last float of each group of 4 across the group,
+   - blendAlpha(c, a), which is c with the last float of each group of 4 taken from a,
+   - selectNonZero(m, a, b), which is a where m is not zero and b elsewhere.
+*/
+
+namespace OFX {
+
+  namespace Kernels {
+
+    /** @brief one build of the kernels */
+    struct KernelTable {
+      void (*scaleOffset)(const float *src, float *dst, size_t nPixels, int nComponents, const float *scale, const float *offset);
+      void (*lerp)(const float *a, const float *b, float *dst, size_t n, float t);
+      void (*premultiply)(const float *src, float *dst, size_t nPixels);
+      void (*unpremultiply)(const float *src, float *dst, size_t nPixels);
+      void (*clamp)(const float *src, float *dst, size_t n, float lo, float hi);
+      void (*fromBytes)(const uint8_t *src, float *dst, size_t n);
+      void (*toBytes)(const float *src, uint8_t *dst, size_t n);
+      void (*fromShorts)(const uint16_t *src, float *dst, size_t n);
+      void (*toShorts)(const float *src, uint16_t *dst, size_t n);
+      void (*fromHalves)(const uint16_t *src, float *dst, size_t n);
+      void (*toHalves)(const float *src, uint16_t *dst, size_t n);
+    };
+
+    /** @brief the builds of the kernels, each returns NULL if the compiler was not asked to build it */
+    const KernelTable *getScalarKernels(void);
+    const KernelTable *getSSE4Kernels(void);
+    const KernelTable *getAVX2Kernels(void);
+    const KernelTable *getAVX512Kernels(void);
+    const KernelTable *getNEONKernels(void);
+
+    namespace {
+
+      // the scalar versions, used for the ends of rows that do not fill a vector
+      // four bytes that may not be aligned, without pulling memcpy in from a header
+      inline void copy4(void *dst, const void *src)
+      {
+        const uint8_t *s = (const uint8_t *) src;
+        uint8_t *d = (uint8_t *) dst;
+        d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = s[3];
+      }
+
+      inline float scalarMin(float a, float b) { return a < b ? a : b; }
+      inline float scalarMax(float a, float b) { return a > b ? a : b; }
+
+      // clamp to 0..1, scale and round to nearest, the same sums the vector code does
+      inline float toIntegerRange(float v, float max)
+      {
+        return scalarMin(scalarMax(v, 0.0f), 1.0f) * max + 0.5f;
+      }
+
+      union FloatBits {
+        float    f;
+        uint32_t u;
+      };
+
+      /** @brief IEEE half to float, giving the same bits F16C does */
+      inline float halfToFloat(uint16_t h)
+      {
+        const uint32_t shiftedExponent = 0x7c00 << 13;
+        FloatBits o;
+        o.u = uint32_t(h & 0x7fff) << 13;
+        uint32_t exponent = o.u & shiftedExponent;
+        o.u += (127 - 15) << 23;
+        if(exponent == shiftedExponent) {
+          // infinity or NaN, NaNs come out quiet
+          o.u += (128 - 16) << 23;
+          if(o.u & 0x7fffff)
+            o.u |= 0x400000;
+        }
+        else if(exponent == 0) {
+          // zero or a denormal, let the FPU normalise it
+          FloatBits magic;
+          magic.u = 113 << 23;
+          o.u += 1 << 23;
+          o.f -= magic.f;
+        }
+        o.u |= uint32_t(h & 0x8000) << 16;
+        return o.f;
+      }
+
+      /** @brief float to IEEE half, rounding to nearest even, giving the same bits F16C does */
+      inline uint16_t floatToHalf(float v)
+      {
+        FloatBits f;
+        f.f = v;
+        uint32_t sign = f.u & 0x80000000;
+        f.u ^= sign;
+
+        uint16_t o;
+        if(f.u >= (127 + 16) << 23) {
+          // too big becomes infinity, NaNs keep the top of their payload and come out quiet
+          o = f.u > (255u << 23) ? uint16_t(0x7e00 | ((f.u >> 13) & 0x3ff)) : uint16_t(0x7c00);
+        }
+        else if(f.u < 113 << 23) {
+          // a denormal or zero as a half, adding 0.5 has the FPU do the rounding
+          FloatBits magic;
+          magic.u = 126 << 23;
+          f.f += magic.f;
+          o = uint16_t(f.u - magic.u);
+        }
+        else {
+          // rebias the exponent, and round the mantissa to nearest even
+          uint32_t odd = (f.u >> 13) & 1;
+          f.u = f.u - (uint32_t(127 - 15) << 23) + 0xfff + odd;
+          o = uint16_t(f.u >> 13);
+        }
+        return uint16_t(o | (sign >> 16));
+      }
+
+      inline void premultiplyPixels(const float *src, float *dst, size_t nPixels)
+      {
+        for(size_t i = 0; i < nPixels; ++i, src += 4, dst += 4) {
+          float a = src[3];
+          dst[0] = src[0] * a;
+          dst[1] = src[1] * a;
+          dst[2] = src[2] * a;
+          dst[3] = a;
+        }
+      }
+
+      inline void unpremultiplyPixels(const float *src, float *dst, size_t nPixels)
+      {
+        for(size_t i = 0; i < nPixels; ++i, src += 4, dst += 4) {
+          float a = src[3];
+          if(a != 0.0f) {
+            dst[0] = src[0] / a;
+            dst[1] = src[1] / a;
+            dst[2] = src[2] / a;
+          }
+          else {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+          }
+          dst[3] = a;
+        }
+      }
+
+      template <class VEC>
+      void scaleOffsetKernel(const float *src, float *dst, size_t nPixels, int nComponents, const float *scale, const float *offset)
+      {
+        typedef typename VEC::V V;
+        const int W = VEC::W;
+        size_t n = nPixels * nComponents;
+
+        // a run of nComponents vectors starts on the first component again, so the
+        // scales and offsets need laying out across that many vectors and no more
+        float s[4 * W], o[4 * W];
+        for(int i = 0; i < nComponents * W; ++i) {
+          s[i] = scale[i % nComponents];
+          o[i] = offset[i % nComponents];
+        }
+        V sv[4], ov[4];
+        for(int k = 0; k < nComponents; ++k) {
+          sv[k] = VEC::load(s + k * W);
+          ov[k] = VEC::load(o + k * W);
+        }
+
+        size_t i = 0;
+        size_t run = size_t(nComponents) * W;
+        for(; i + run <= n; i += run) {
+          for(int k = 0; k < nComponents; ++k)
+            VEC::store(dst + i + k * W, VEC::add(VEC::mul(VEC::load(src + i + k * W), sv[k]), ov[k]));
+        }
+        for(; i < n; ++i)
+          dst[i] = src[i] * scale[i % nComponents] + offset[i % nComponents];
+      }
+
+      template <class VEC>
+      void lerpKernel(const float *a, const float *b, float *dst, size_t n, float t)
+      {
+        typedef typename VEC::V V;
+        const int W = VEC::W;
+        V tv = VEC::set1(t);
+        size_t i = 0;
+        for(; i + W <= n; i += W) {
+          V av = VEC::load(a + i);
+          VEC::store(dst + i, VEC::add(av, VEC::mul(VEC::sub(VEC::load(b + i), av), tv)));
+        }
+        for(; i < n; ++i)
+          dst[i] = a[i] + (b[i] - a[i]) * t;
+      }
+
+      template <class VEC>
+      void premultiplyKernel(const float *src, float *dst, size_t nPixels)
+      {
+        const int W = VEC::W;
+        size_t n = nPixels * 4;
+        size_t i = 0;
+        for(; i + W <= n; i += W) {
+          typename VEC::V v = VEC::load(src + i);
+          VEC::store(dst + i, VEC::blendAlpha(VEC::mul(v, VEC::splatAlpha(v)), v));
+        }
+        premultiplyPixels(src + i, dst + i, (n - i) / 4);
+      }
+
+      template <class VEC>
+      void unpremultiplyKernel(const float *src, float *dst, size_t nPixels)
+      {
+        typedef typename VEC::V V;
+        const int W = VEC::W;
+        size_t n = nPixels * 4;
+        size_t i = 0;
+        for(; i + W <= n; i += W) {
+          V v = VEC::load(src + i);
+          V a = VEC::splatAlpha(v);
+          // the lanes with no alpha divide by zero, which is harmless as they are thrown away
+          V c = VEC::selectNonZero(a, VEC::div(v, a), v);
+          VEC::store(dst + i, VEC::blendAlpha(c, v));
+        }
+        unpremultiplyPixels(src + i, dst + i, (n - i) / 4);
+      }
+
+      template <class VEC>
+      void clampKernel(const float *src, float *dst, size_t n, float lo, float hi)
+      {
+        typedef typename VEC::V V;
+        const int W = VEC::W;
+        V lov = VEC::set1(lo), hiv = VEC::set1(hi);
+        size_t i = 0;
+        for(; i + W <= n; i += W)
+          VEC::store(dst + i, VEC::min(VEC::max(VEC::load(src + i), lov), hiv));
+        for(; i < n; ++i)
+          dst[i] = scalarMin(scalarMax(src[i], lo), hi);
+      }
+
+      template <class VEC>
+      void fromBytesKernel(const uint8_t *src, float *dst, size_t n)
+      {
+        // divide rather than multiply by the reciprocal, so the result is the closest float
+        const int W = VEC::W;
+        typename VEC::V k = VEC::set1(255.0f);
+        size_t i = 0;
+        for(; i + W <= n; i += W)
+          VEC::store(dst + i, VEC::div(VEC::loadBytes(src + i), k));
+        for(; i < n; ++i)
+          dst[i] = float(src[i]) / 255.0f;
+      }
+
+      template <class VEC>
+      void toBytesKernel(const float *src, uint8_t *dst, size_t n)
+      {
+        typedef typename VEC::V V;
+        const int W = VEC::W;
+        V zero = VEC::set1(0.0f), one = VEC::set1(1.0f), max = VEC::set1(255.0f), half = VEC::set1(0.5f);
+        size_t i = 0;
+        for(; i + W <= n; i += W) {
+          V v = VEC::min(VEC::max(VEC::load(src + i), zero), one);
+          VEC::storeBytes(dst + i, VEC::add(VEC::mul(v, max), half));
+        }
+        for(; i < n; ++i)
+          dst[i] = uint8_t(toIntegerRange(src[i], 255.0f));
+      }
+
+      template <class VEC>
+      void fromShortsKernel(const uint16_t *src, float *dst, size_t n)
+      {
+        const int W = VEC::W;
+        typename VEC::V k = VEC::set1(65535.0f);
+        size_t i = 0;
+        for(; i + W <= n; i += W)
+          VEC::store(dst + i, VEC::div(VEC::loadShorts(src + i), k));
+        for(; i < n; ++i)
+          dst[i] = float(src[i]) / 65535.0f;
+      }
+
+      template <class VEC>
+      void toShortsKernel(const float *src, uint16_t *dst, size_t n)
+      {
+        typedef typename VEC::V V;
+        const int W = VEC::W;
+        V zero = VEC::set1(0.0f), one = VEC::set1(1.0f), max = VEC::set1(65535.0f), half = VEC::set1(0.5f);
+        size_t i = 0;
+        for(; i + W <= n; i += W) {
+          V v = VEC::min(VEC::max(VEC::load(src + i), zero), one);
+          VEC::storeShorts(dst + i, VEC::add(VEC::mul(v, max), half));
+        }
+        for(; i < n; ++i)
+          dst[i] = uint16_t(toIntegerRange(src[i], 65535.0f));
+      }
+
+      template <class VEC>
+      void fromHalvesKernel(const uint16_t *src, float *dst, size_t n)
+      {
+        const int W = VEC::W;
+        size_t i = 0;
+        for(; i + W <= n; i += W)
+          VEC::store(dst + i, VEC::loadHalves(src + i));
+        for(; i < n; ++i)
+          dst[i] = halfToFloat(src[i]);
+      }
+
+      template <class VEC>
+      void toHalvesKernel(const float *src, uint16_t *dst, size_t n)
+      {
+        const int W = VEC::W;
+        size_t i = 0;
+        for(; i + W <= n; i += W)
+          VEC::storeHalves(dst + i, VEC::load(src + i));
+        for(; i < n; ++i)
+          dst[i] = floatToHalf(src[i]);
+      }
+
+      /** @brief the table of kernels built over VEC */
+      template <class VEC>
+      const KernelTable *makeKernelTable(void)
+      {
+        static const KernelTable table = {
+          scaleOffsetKernel<VEC>,
+          lerpKernel<VEC>,
+          premultiplyKernel<VEC>,
+          unpremultiplyKernel<VEC>,
+          clampKernel<VEC>,
+          fromBytesKernel<VEC>,
+          toBytesKernel<VEC>,
+          fromShortsKernel<VEC>,
+          toShortsKernel<VEC>,
+          fromHalvesKernel<VEC>,
+          toHalvesKernel<VEC>
+        };
+        return &table;
+      }
+
+    }
+
+  };
+
+};
+
+#endif
@@ -0,0 +1,95 @@
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+// the SSE4.1 build of the pixel kernels, compiled with -msse4.1
+
+#include "ofxsPixelKernelsPrivate.h"
+
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && defined(_M_X64))
+
+#include <smmintrin.h>
+
+namespace OFX {
+
+  namespace Kernels {
+
+    namespace {
+
+      struct SSE4 {
+        typedef __m128 V;
+        static const int W = 4;
+
+        static V load(const float *p) { return _mm_loadu_ps(p); }
+        static void store(float *p, V v) { _mm_storeu_ps(p, v); }
+        static V set1(float v) { return _mm_set1_ps(v); }
+        static V add(V a, V b) { return _mm_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm_div_ps(a, b); }
+        static V min(V a, V b) { return _mm_min_ps(a, b); }
+        static V max(V a, V b) { return _mm_max_ps(a, b); }
+
+        static V splatAlpha(V v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+        static V blendAlpha(V c, V a) { return _mm_blend_ps(c, a, 0x8); }
+        static V selectNonZero(V m, V a, V b) { return _mm_blendv_ps(a, b, _mm_cmpeq_ps(m, _mm_setzero_ps())); }
+
+        static V loadBytes(const uint8_t *p)
+        {
+          int v;
+          copy4(&v, p);
+          return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));
+        }
+
+        static void storeBytes(uint8_t *p, V v)
+        {
+          __m128i i = _mm_cvttps_epi32(v);
+          i = _mm_packus_epi16(_mm_packus_epi32(i, i), i);
+          int b = _mm_cvtsi128_si32(i);
+          copy4(p, &b);
+        }
+
+        static V loadShorts(const uint16_t *p)
+        {
+          return _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) p)));
+        }
+
+        static void storeShorts(uint16_t *p, V v)
+        {
+          __m128i i = _mm_cvttps_epi32(v);
+          _mm_storel_epi64((__m128i *) p, _mm_packus_epi32(i, i));
+        }
+
+        // SSE4 CPUs need not have F16C, so halves are done one at a time
+        static V loadHalves(const uint16_t *p)
+        {
+          return _mm_setr_ps(halfToFloat(p[0]), halfToFloat(p[1]), halfToFloat(p[2]), halfToFloat(p[3]));
+        }
+
+        static void storeHalves(uint16_t *p, V v)
+        {
+          float f[4];
+          _mm_storeu_ps(f, v);
+          for(int i = 0; i < 4; ++i)
+            p[i] = floatToHalf(f[i]);
+        }
+      };
+
+    }
+
+    const KernelTable *getSSE4Kernels(void)
+    {
+      return makeKernelTable<SSE4>();
+    }
+
+  };
+
+};
+
+#else
+
+const OFX::Kernels::KernelTable *OFX::Kernels::getSSE4Kernels(void)
+{
+  return 0;
+}
+
+#endif
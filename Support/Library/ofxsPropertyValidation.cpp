@@ -761,6 +761,13 @@ namespace OFX {
       PropertyDescription(kOfxParamPropCustomInterpCallbackV1, OFX::ePointer, 1, eDescDefault, NULLPTR, eDescFinished),
     };
 
+    /** @brief values for a bytes param */
+    static PropertyDescription gBytesParamProps[ ] =
+    {
+      PropertyDescription(kOfxParamPropDefault,                OFX::ePointer, 1, eDescDefault, NULLPTR, eDescFinished),
+      PropertyDescription(kOfxParamPropAnimates,               OFX::eInt,     1, eDescDefault, 0, eDescFinished),
+    };
+
     /** @brief properties for an RGB colour param */
     static PropertyDescription gRGBColourParamProps[ ] =
     {
@@ -996,6 +1003,14 @@ namespace OFX {
       mPropDescriptionArg(gCustomParamProps),
       NULLPTR);
 
+    /** @brief Property set for bytes params */
+    static PropertySetDescription gBytesParamPropSet("Bytes parameter",
+      mPropDescriptionArg(gBasicParamProps),
+      mPropDescriptionArg(gInteractOverideParamProps),
+      mPropDescriptionArg(gValueHolderParamProps),
+      mPropDescriptionArg(gBytesParamProps),
+      NULLPTR);
+
     /** @brief Property set for boolean params */
     static PropertySetDescription gBooleanParamPropSet("Boolean parameter",
       mPropDescriptionArg(gBasicParamProps),
@@ -1256,6 +1271,9 @@ namespace OFX {
       case eParametricParam:
         gParametricParamPropSet.validate(paramProps, checkDefaults);
         break;
+      case eBytesParam :
+        gBytesParamPropSet.validate(paramProps, checkDefaults);
+        break;
       case eDummyParam:
       //default:
             break;
@@ -8,6 +8,7 @@
 #include "ofxsImageEffect.h"
 #include "ofxsLog.h"
 #include "ofxsMultiThread.h"
+#include "openfxParamBatch.h"
 
 /** @brief Namespace private to the ofx support library.
 */
@@ -53,6 +54,9 @@ namespace OFX {
     /** @brief Pointer to the parametric parameter suite */
     extern OfxParametricParameterSuiteV1* gParametricParameterSuite;
 
+    /** @brief Pointer to the optional parameter batch suite */
+    extern OpenFXParameterBatchSuiteV1 *gParameterBatchSuite;
+
     /** @brief Support lib function called on an ofx load action */
     void loadAction(void);
 
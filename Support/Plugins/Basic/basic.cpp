@@ -17,6 +17,8 @@
 #include "ofxsMultiThread.h"
 
 #include "../include/ofxsProcessing.H"
+#include "ofxsImageView.h"
+#include "ofxsPixelKernels.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // a dumb interact that just draw's a square you can drag
@@ -120,64 +122,74 @@ public :
   // and do some processing
   void multiThreadProcessImages(OfxRectI procWindow)
   {
+    // 8 and 16 bit results are rounded to the nearest value, they used to be truncated,
+    // so they can be 1 higher than those of earlier versions of this plugin
     float scales[4];
     scales[0] = nComponents == 1 ? (float)_aScale : (float)_rScale;
     scales[1] = (float)_gScale;
     scales[2] = (float)_bScale;
     scales[3] = (float)_aScale;
+    const float unitScales[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    const float noOffsets[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
-    float maskScale = 1.0f;
+    OFX::ImageView<PIX, nComponents> dst(_dstImg);
+    OFX::ImageView<const PIX, nComponents> src(_srcImg);
+    // the mask clip is always alpha, so it has one component whatever the source has
+    OFX::ImageView<const PIX, 1> mask(_doMasking ? _maskImg : 0);
+
+    // not masking, or masking with no mask image, scales everything fully
+    bool maskEverywhere = _doMasking && _maskImg;
+    OFX::RowSpan<const PIX> noMask = { 0, procWindow.x1, procWindow.x2 };
 
     for(int y = procWindow.y1; y < procWindow.y2; y++) {
       if(_effect.abort()) break;
 
-      PIX *dstPix = (PIX *) _dstImg->getPixelAddress(procWindow.x1, y);
-
-      for(int x = procWindow.x1; x < procWindow.x2; x++) {
+      PIX *dstRow = dst.getRowAddress(y);
+      OFX::RowSpan<const PIX> srcRow = src.getRow(y, procWindow.x1, procWindow.x2);
+      OFX::RowSpan<const PIX> maskRow = maskEverywhere ? mask.getRow(y, procWindow.x1, procWindow.x2) : noMask;
 
-        PIX *srcPix = (PIX *)  (_srcImg ? _srcImg->getPixelAddress(x, y) : 0);
+      // work out once per piece of the row whether there is source, and mask, there
+      OFX::forEachRowPiece(procWindow.x1, procWindow.x2, srcRow, maskRow,
+                           [&](int x1, int x2, bool inSrc, bool inMask) {
+        PIX *dstPix = dstRow + (ptrdiff_t)(x1 - dst.getBounds().x1) * nComponents;
 
-        // are we doing masking
-        if(_doMasking) {
-          // we do, get the pixel from the mask
-          if(!_maskImg)
-            maskScale = 1.0f;
-          else
-          {
-            PIX *maskPix = (PIX *)  (_maskImg ? _maskImg->getPixelAddress(x, y) : 0);
-            // figure the scale factor from that pixel
-            maskScale = maskPix != 0 ? float(*maskPix)/float(max) : 0.0f;
-          }
+        if(!inSrc) {
+          // no src pixel here, be black and transparent
+          for(int i = 0; i < (x2 - x1) * nComponents; i++)
+            dstPix[i] = 0;
         }
-
-        // do we have a source image to scale up
-        if(srcPix) {
-          for(int c = 0; c < nComponents; c++) {
-            float v;
-
-            // scale the component up by the scale factor, modulated by the maskScale
-            if(maskScale != 1.0f) 
-              v = srcPix[c] * (1.0f + (scales[c] - 1.0f) * maskScale);
-            else
-              v = srcPix[c] * scales[c];
-
-            if(max == 1)  // implies floating point and so no clamping
-              dstPix[c] = PIX(v);
-            else  // integer based and we need to clamp
-              dstPix[c] = PIX(Clamp(v, 0, max));
+        else if(maskEverywhere && inMask) {
+          // scale the component up by the scale factor, modulated by the mask, which differs per pixel
+          const PIX *srcPix = srcRow.at(x1, nComponents);
+          const PIX *maskPix = maskRow.at(x1, 1);
+          for(int x = x1; x < x2; x++) {
+            float maskScale = float(*maskPix)/float(max);
+            for(int c = 0; c < nComponents; c++) {
+              float k = maskScale != 1.0f ? 1.0f + (scales[c] - 1.0f) * maskScale : scales[c];
+              dstPix[c] = clampComponent(srcPix[c] * k);
+            }
+            srcPix += nComponents;
+            dstPix += nComponents;
+            maskPix++;
           }
         }
         else {
-          // no src pixel here, be black and transparent
-          for(int c = 0; c < nComponents; c++) {
-            dstPix[c] = 0;
-          }
+          // scale the component up by the scale factor, or leave it be off the mask image
+          const float *k = maskEverywhere ? unitScales : scales;
+          OFX::Kernels::scaleOffset(srcRow.at(x1, nComponents), dstPix, x2 - x1, nComponents, k, noOffsets);
         }
-        // increment the dst pixel
-        dstPix += nComponents;
-      }
+      });
     }
   }
+
+  /** @brief convert a scaled component back to our pixel type, rounding to nearest as the kernels do */
+  static PIX clampComponent(float v)
+  {
+    if(max == 1)  // implies floating point and so no clamping
+      return PIX(v);
+    else  // integer based and we need to clamp
+      return PIX(Clamp(v, 0, max) + 0.5f);
+  }
 };
 
 ////////////////////////////////////////////////////////////////////////////////
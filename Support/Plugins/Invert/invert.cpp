@@ -11,6 +11,8 @@
 #include "ofxsMultiThread.h"
 
 #include "../include/ofxsProcessing.H"
+#include "ofxsImageView.h"
+#include "ofxsPixelKernels.h"
 
 
 // Base class for the RGBA and the Alpha processor
@@ -41,31 +43,35 @@ public :
   // and do some processing
   void multiThreadProcessImages(OfxRectI procWindow)
   {
-    for(int y = procWindow.y1; y < procWindow.y2; y++) {
-      if(_effect.abort()) break;
+    // max - src, which in the kernels' normalised units is 1 - src. As the kernels round
+    // 8 and 16 bit results to nearest this is still exact, max - src is always an integer
+    const float scales[4] = { -1.0f, -1.0f, -1.0f, -1.0f };
+    const float offsets[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
 
-      PIX *dstPix = (PIX *) _dstImg->getPixelAddress(procWindow.x1, y);
+    OFX::ImageView<PIX, nComponents> dst(_dstImg);
+    OFX::ImageView<const PIX, nComponents> src(_srcImg);
 
-      for(int x = procWindow.x1; x < procWindow.x2; x++) {
+    for(int y = procWindow.y1; y < procWindow.y2; y++) {
+      if(_effect.abort()) break;
 
-        PIX *srcPix = (PIX *)  (_srcImg ? _srcImg->getPixelAddress(x, y) : 0);
+      PIX *dstPix = dst.getPixelAddress(procWindow.x1, y);
+      OFX::RowSpan<const PIX> srcRow = src.getRow(y, procWindow.x1, procWindow.x2);
 
-        // do we have a source image to scale up
-        if(srcPix) {
-          for(int c = 0; c < nComponents; c++) {
-            dstPix[c] = max - srcPix[c];
-          }
-        }
-        else {
-          // no src pixel here, be black and transparent
-          for(int c = 0; c < nComponents; c++) {
-            dstPix[c] = 0;
-          }
-        }
+      // no src pixel, be black and transparent
+      for(int x = procWindow.x1; x < srcRow.x1; x++)
+        for(int c = 0; c < nComponents; c++)
+          *dstPix++ = 0;
 
-        // increment the dst pixel
-        dstPix += nComponents;
+      // invert the pixels we do have
+      if(!srcRow.isEmpty()) {
+        int n = srcRow.x2 - srcRow.x1;
+        OFX::Kernels::scaleOffset(srcRow.pixels, dstPix, n, nComponents, scales, offsets);
+        dstPix += n * nComponents;
       }
+
+      for(int x = std::max(srcRow.x2, procWindow.x1); x < procWindow.x2; x++)
+        for(int c = 0; c < nComponents; c++)
+          *dstPix++ = 0;
     }
   }
 };
@@ -0,0 +1,112 @@
+#ifndef _ofxsBitDepth_H_
+#define _ofxsBitDepth_H_
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+
+#include "ofxsImageEffect.h"
+
+/** @file This file contains code to convert pixels between any two of the standard bit depths.
+
+Bytes and shorts are normalised, 0 to the largest value the type holds mapping to 0 to 1,
+half and float are taken as they are. Going to an integer depth clamps to 0 to 1 and
+rounds to the nearest value, NaNs going to 0, with the sums done in single precision,
+so a float within a hair of halfway between two shorts may round either way. Bytes to
+shorts and back are done exactly. Going to half rounds to nearest even, with
+anything too big becoming infinity, which is what F16C does and is used for where the
+CPU has it. The work is done with the kernels in ofxsPixelKernels.h.
+*/
+
+namespace OFX {
+
+  /** @brief Namespace for converting between pixel bit depths */
+  namespace BitDepth {
+
+    /** @brief the bytes in one component of the given depth, 0 for eBitDepthNone and eBitDepthCustom */
+    size_t getBytesPerComponent(BitDepthEnum depth);
+
+    /** @brief convert n components from one depth to another.
+
+    src and dst must not overlap, unless they are the same address, in which case the
+    components are converted in place, widened or narrowed.
+
+    Throws OFX::Exception::Suite with kOfxStatErrImageFormat if either depth is not one
+    of the four standard ones.
+    */
+    void convertRow(const void *src, BitDepthEnum srcDepth,
+                    void *dst, BitDepthEnum dstDepth,
+                    size_t n);
+
+    /** @brief convert a block of pixels from one depth to another.
+
+    \arg \e srcData, dstData     - the first pixel of the first row of each
+    \arg \e srcRowBytes, dstRowBytes - bytes from one row to the next of each, which may differ, and may be negative
+    \arg \e width, height        - the size of the block in pixels
+    \arg \e nComponents          - the components per pixel
+
+    If srcData and dstData are the same, the block is converted in place. Widening in
+    place needs dst rows no shorter than src rows, narrowing in place needs them no
+    longer, as is the case if the image is left with the row bytes it had, or each
+    row is packed. Otherwise the blocks must not overlap.
+
+    Throws as convertRow does.
+    */
+    void convertPixels(const void *srcData, ptrdiff_t srcRowBytes, BitDepthEnum srcDepth,
+                       void *dstData, ptrdiff_t dstRowBytes, BitDepthEnum dstDepth,
+                       int width, int height, int nComponents);
+
+    /** @brief convert the pixels of src in the window into dst, which must have the same components.
+
+    Pixels in the window that are outside the bounds of src, or all of them if src is
+    NULL, are set to zero. The window must be inside the bounds of dst.
+
+    Throws OFX::Exception::Suite with kOfxStatErrImageFormat if the components differ, or
+    as convertRow does.
+
+    This is inline so that code using only the functions above does not pull in the
+    image classes.
+    */
+    inline void convertImage(const Image *src, Image *dst, const OfxRectI &window)
+    {
+      int nComponents = dst->getPixelComponentCount();
+      if((src && src->getPixelComponents() != dst->getPixelComponents()) || getBytesPerComponent(dst->getPixelDepth()) == 0)
+        throw OFX::Exception::Suite(kOfxStatErrImageFormat);
+      BitDepthEnum srcDepth = src ? src->getPixelDepth() : eBitDepthNone;
+      BitDepthEnum dstDepth = dst->getPixelDepth();
+      size_t dstPixelBytes = getBytesPerComponent(dstDepth) * nComponents;
+
+      // the part of the window src has pixels for, worked out once rather than per row
+      OfxRectI srcWindow = window;
+      if(src) {
+        const OfxRectI &b = src->getBounds();
+        srcWindow.x1 = std::max(window.x1, b.x1);
+        srcWindow.x2 = std::min(window.x2, b.x2);
+        srcWindow.y1 = std::max(window.y1, b.y1);
+        srcWindow.y2 = std::min(window.y2, b.y2);
+      }
+      if(!src || srcWindow.x1 >= srcWindow.x2)
+        srcWindow.y1 = srcWindow.y2 = window.y1;
+
+      for(int y = window.y1; y < window.y2; ++y) {
+        char *dstRow = (char *) dst->getPixelAddress(window.x1, y);
+        size_t left = window.x2 - window.x1, middle = 0, right = 0;
+        if(y >= srcWindow.y1 && y < srcWindow.y2) {
+          left = srcWindow.x1 - window.x1;
+          middle = srcWindow.x2 - srcWindow.x1;
+          right = window.x2 - srcWindow.x2;
+          convertRow(src->getPixelAddress(srcWindow.x1, y), srcDepth,
+                     dstRow + left * dstPixelBytes, dstDepth, middle * nComponents);
+        }
+        memset(dstRow, 0, left * dstPixelBytes);
+        memset(dstRow + (left + middle) * dstPixelBytes, 0, right * dstPixelBytes);
+      }
+    }
+
+  };
+
+};
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef _ofxsImageView_h_
+#define _ofxsImageView_h_
+
+/*
+  OFX Support Library, a library that skins the OFX plug-in API with C++ classes.
+  Copyright OpenFX and contributors to the OpenFX project.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+#include "ofxsImageEffect.h"
+
+/** @file This file contains a typed view onto an image's pixels, for kernels that walk them a row at a time.
+
+Image::getPixelAddress checks the bounds and does a multiply for every pixel, which is
+fine for the odd look up but keeps an inner loop from being vectorised. An ImageView
+does the bounds work once per row instead, handing back a span of pixels a kernel can
+run straight along.
+*/
+
+namespace OFX {
+
+    /** @brief the bit depth of images with components of type PIX, eBitDepthNone for a type that isn't a standard depth */
+    template <class PIX> struct BitDepthOf { static const BitDepthEnum value = eBitDepthNone; };
+    template <> struct BitDepthOf<unsigned char> { static const BitDepthEnum value = eBitDepthUByte; };
+    template <> struct BitDepthOf<unsigned short> { static const BitDepthEnum value = eBitDepthUShort; };
+    template <> struct BitDepthOf<float> { static const BitDepthEnum value = eBitDepthFloat; };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /** @brief The part of a row of pixels that lies inside an image.
+
+    pixels points at the pixel at x1, and the span covers x1 <= X < x2. A span that
+    misses the image has x1 >= x2 and pixels set to NULL.
+    */
+    template <class PIX>
+    struct RowSpan {
+        PIX *pixels;
+        int  x1;
+        int  x2;
+
+        /** @brief is there nothing in the span */
+        bool isEmpty(void) const { return x1 >= x2; }
+
+        /** @brief does the span hold pixel x */
+        bool contains(int x) const { return x >= x1 && x < x2; }
+
+        /** @brief the pixels at x, which must be in the span */
+        PIX *at(int x, int nComponents) const { return pixels + (ptrdiff_t)(x - x1) * nComponents; }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /** @brief A typed, unowned view of an image's pixels.
+
+    PIX is the component type and nComponents the number per pixel, so
+    ImageView<float, 4> views an RGBA float image. Use a const PIX to view a source
+    image. Copying a view is cheap, it holds no more than the image's base address,
+    row bytes and bounds, and the image must outlive it.
+
+    A view of a NULL image is empty, every row span it hands out is empty, so kernels
+    can treat a missing input the same as pixels outside an input's bounds. A view of
+    an image asserts that the image has nComponents components of type PIX.
+    */
+    template <class PIX, int nComponents>
+    class ImageView {
+    protected :
+        char      *_data;      /**< @brief address of the pixel at (bounds.x1, bounds.y1) */
+        ptrdiff_t  _rowBytes;  /**< @brief bytes from one row to the next, may be negative */
+        OfxRectI   _bounds;    /**< @brief the pixels we can address */
+
+    public :
+        typedef PIX PixelType;
+
+        /** @brief ctor, an empty view */
+        ImageView()
+          : _data(0)
+          , _rowBytes(0)
+        {
+            _bounds.x1 = _bounds.y1 = _bounds.x2 = _bounds.y2 = 0;
+        }
+
+        /** @brief ctor, view raw pixels */
+        ImageView(PIX *data, const OfxRectI &bounds, int rowBytes)
+          : _data((char *) data)
+          , _rowBytes(rowBytes)
+          , _bounds(bounds)
+        {
+            if(!_data)
+                _bounds.x1 = _bounds.y1 = _bounds.x2 = _bounds.y2 = 0;
+        }
+
+        /** @brief ctor, view an image we may write to, which may be NULL */
+        explicit ImageView(Image *img)
+        {
+            set(img ? img->getPixelData() : 0, img);
+        }
+
+        /** @brief ctor, view an image we may only read, which may be NULL */
+        explicit ImageView(const Image *img)
+        {
+            static_assert(std::is_const<PIX>::value, "a view of a const Image needs a const pixel type");
+            set(img ? img->getPixelData() : 0, img);
+        }
+
+        /** @brief is there nothing to view */
+        bool isEmpty(void) const { return _data == 0; }
+
+        /** @brief the bounds of the pixels in the view */
+        const OfxRectI &getBounds(void) const { return _bounds; }
+
+        /** @brief bytes from one row to the next */
+        ptrdiff_t getRowBytes(void) const { return _rowBytes; }
+
+        /** @brief the pixel at the start of row y, which must be in bounds, no checks are done */
+        PIX *getRowAddress(int y) const
+        {
+            return (PIX *) (_data + (ptrdiff_t)(y - _bounds.y1) * _rowBytes);
+        }
+
+        /** @brief the pixel at (x, y), which must be in bounds, no checks are done */
+        PIX *getPixelAddress(int x, int y) const
+        {
+            return getRowAddress(y) + (ptrdiff_t)(x - _bounds.x1) * nComponents;
+        }
+
+        /** @brief the pixels of row y between x1 and x2 that are inside the view, clipped once here rather than per pixel */
+        RowSpan<PIX> getRow(int y, int x1, int x2) const
+        {
+            RowSpan<PIX> span;
+            span.x1 = std::max(x1, _bounds.x1);
+            span.x2 = std::min(x2, _bounds.x2);
+            if(y < _bounds.y1 || y >= _bounds.y2 || span.x1 >= span.x2) {
+                span.pixels = 0;
+                span.x1 = span.x2 = x1;
+            }
+            else
+                span.pixels = getPixelAddress(span.x1, y);
+            return span;
+        }
+
+        /** @brief Steps down a window of the view a row at a time.
+
+        Holds the address of the current row and adds the row bytes to move on,
+        so no multiply is done per row. The window must lie inside the view's bounds.
+        */
+        class RowIterator {
+            char      *_row;
+            ptrdiff_t  _rowBytes;
+            int        _y;
+
+        public :
+            RowIterator(const ImageView &view, int x, int y)
+              : _row((char *) view.getPixelAddress(x, y))
+              , _rowBytes(view.getRowBytes())
+              , _y(y)
+            {
+            }
+
+            /** @brief the pixels of the current row, from the window's left edge */
+            PIX *get(void) const { return (PIX *) _row; }
+
+            /** @brief the y of the current row */
+            int y(void) const { return _y; }
+
+            /** @brief move to the next row */
+            RowIterator &operator++() { _row += _rowBytes; ++_y; return *this; }
+        };
+
+        /** @brief an iterator at (x, y), which must be in bounds */
+        RowIterator rowIterator(int x, int y) const { return RowIterator(*this, x, y); }
+
+    private :
+        void set(const void *data, const ImageBase *img)
+        {
+            _data = (char *) data;
+            if(_data) {
+                assert(img->getPixelComponentCount() == nComponents);
+                assert(BitDepthOf<typename std::remove_const<PIX>::type>::value == eBitDepthNone ||
+                       BitDepthOf<typename std::remove_const<PIX>::type>::value == img->getPixelDepth());
+                _rowBytes = img->getRowBytes();
+                _bounds = img->getBounds();
+            }
+            else {
+                _rowBytes = 0;
+                _bounds.x1 = _bounds.y1 = _bounds.x2 = _bounds.y2 = 0;
+            }
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /** @brief Cuts x1 <= X < x2 into the pieces over which being inside spans a and b does not change.
+
+    Calls fn(xa, xb, inA, inB) for each piece in order, so a kernel with several inputs
+    can pick the right loop for a whole piece up front, rather than test every pixel
+    for whether its inputs have data there.
+    */
+    template <class SPAN_A, class SPAN_B, class FN>
+    void forEachRowPiece(int x1, int x2, const SPAN_A &a, const SPAN_B &b, FN fn)
+    {
+        // the edges of the spans that fall inside the row cut it up, kept in order as they
+        // go in, as there are at most four of them
+        int cuts[4];
+        int nCuts = 0;
+        const int edges[4] = { a.x1, a.x2, b.x1, b.x2 };
+        for(int i = 0; i < 4; i++) {
+            int edge = edges[i];
+            if(edge > x1 && edge < x2) {
+                int j = nCuts++;
+                for(; j > 0 && cuts[j - 1] > edge; j--)
+                    cuts[j] = cuts[j - 1];
+                cuts[j] = edge;
+            }
+        }
+
+        int start = x1;
+        for(int i = 0; i <= nCuts; i++) {
+            int end = i < nCuts ? cuts[i] : x2;
+            if(end > start) {
+                fn(start, end, a.contains(start), b.contains(start));
+                start = end;
+            }
+        }
+    }
+
+};
+
+#endif
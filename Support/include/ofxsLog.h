@@ -12,21 +12,50 @@ namespace OFX {
 
   /** @brief this namespace wraps up logging functionality */
   namespace Log {
-    /** @brief Indent it, not MP sane at the moment */
+    /** @brief Levels of message, each level includes the ones before it */
+    enum LevelEnum {
+      eLevelNone,     /**< @brief log nothing */
+      eLevelError,    /**< @brief log errors only */
+      eLevelWarning,  /**< @brief log errors and warnings */
+      eLevelInfo      /**< @brief log everything, the default */
+    };
+
+    /** @brief Indent it, for the calling thread only */
     void indent(void);
 
-    /** @brief Outdent it, not MP sane at the moment */
+    /** @brief Outdent it, for the calling thread only */
     void outdent(void);
 
+    /** @brief Sets the most verbose level of message that gets logged.
+
+    The initial level is taken from the OFX_PLUGIN_LOGLEVEL environment variable,
+    one of none, error, warning or info. Messages filtered out by the level return
+    before any formatting is done.
+    */
+    void setLevel(LevelEnum level);
+
+    /** @brief Gets the most verbose level of message that gets logged. */
+    LevelEnum getLevel(void);
+
+    /** @brief Would a message at the given level be logged, use this to skip building expensive log arguments. */
+    bool isEnabled(LevelEnum level);
+
     /** @brief Sets the name of the log file. */
     void setFileName(const std::string &value);
 
     /** @brief Opens the log file, returns whether this was successful or not. */
     bool open(void);
 
-    /** @brief Closes the log file. */
+    /** @brief Closes the log file, once everything logged so far has been written. */
     void close(void);
 
+    /** @brief Waits until everything logged so far is in the log file.
+
+    Messages are written by a background thread, so print and warning return before
+    their message is in the file. Errors are always waited for.
+    */
+    void flush(void);
+
     /** @brief Prints to the log file. */
     void print(const char *format, ...);
 
@@ -52,6 +52,7 @@ namespace OFX {
     class PageParamDescriptor;
     class PushButtonParamDescriptor;
     class CustomParamDescriptor;
+    class BytesParamDescriptor;
     class ParamSetDescriptor;
 
     /* forward class declarations of the instances */
@@ -70,6 +71,7 @@ namespace OFX {
     class ChoiceParam;
     class StrChoiceParam;
     class CustomParam;
+    class BytesParam;
     class GroupParam;
     class PageParam;
     class PushButtonParam;
@@ -95,6 +97,7 @@ namespace OFX {
                         ePageParam,
                         ePushButtonParam,
                         eParametricParam,
+                        eBytesParam,
                         };
 
     /** @brief Enumerates the different types of cache invalidation */
@@ -737,6 +740,27 @@ namespace OFX {
         void setCustomInterpolation(bool v);
     };
 
+    ////////////////////////////////////////////////////////////////////////////////
+    /** @brief Wraps up a bytes param, which holds a block of opaque data */
+    class BytesParamDescriptor : public ValueParamDescriptor {
+    protected :
+        mDeclareProtectedAssignAndCCBase(BytesParamDescriptor,ValueParamDescriptor);
+        BytesParamDescriptor(void) {assert(false);}
+
+        std::vector<unsigned char> _defaultData;  /**< @brief our copy of the default, which the host may read after describe returns */
+        OfxBytes                   _defaultBytes; /**< @brief what the default property points at */
+
+    protected :
+        /** @brief hidden constructor */
+        BytesParamDescriptor(const std::string &name, OfxPropertySetHandle props);
+
+        // so it can make one
+        friend class ParamSetDescriptor;
+    public :
+        /** @brief set the default value of the param, the bytes are copied, defaults to no bytes */
+        void setDefault(const OfxBytes &v);
+    };
+
     ////////////////////////////////////////////////////////////////////////////////
     /** @brief Describes a set of properties */
     class ParamSetDescriptor { 
@@ -857,6 +881,9 @@ namespace OFX {
 
         /** @brief Define a custom param */
         CustomParamDescriptor *defineCustomParam(const std::string &name);
+
+        /** @brief Define a bytes param */
+        BytesParamDescriptor *defineBytesParam(const std::string &name);
     };
 
     ////////////////////////////////////////////////////////////////////////////////
@@ -1037,6 +1064,9 @@ namespace OFX {
         /** @brief and a nicer one */
         int getValueAtTime(double t) {int v; getValueAtTime(t, v); return v;}
 
+        /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+        void getValuesAtTimes(const double *times, int *values, int n);
+
         /** @brief set value */
         void setValue(int v);
 
@@ -1094,6 +1124,9 @@ namespace OFX {
         /** @brief get the value at a time */
         void getValueAtTime(double t, int &x, int &y);
 
+        /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+        void getValuesAtTimes(const double *times, OfxPointI *values, int n);
+
         /** @brief get the  value */
         OfxPointI getValueAtTime(double t) {OfxPointI v; getValueAtTime(t, v.x, v.y); return v;}
 
@@ -1151,6 +1184,9 @@ namespace OFX {
         /** @brief get the value at a time */
         void getValueAtTime(double t, int &x, int &y, int &z);
 
+        /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+        void getValuesAtTimes(const double *times, Ofx3DPointI *values, int n);
+
         /** @brief set value */
         void setValue(int x, int y, int z);
 
@@ -1239,6 +1275,9 @@ namespace OFX {
         /** @brief get value */
         double getValueAtTime(double t) {double v; getValueAtTime(t, v); return v;}
 
+        /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+        void getValuesAtTimes(const double *times, double *values, int n);
+
         /** @brief set value */
         void setValue(double v);
 
@@ -1299,6 +1338,9 @@ namespace OFX {
         /** @brief get the value at a time */
         void getValueAtTime(double t, double &x, double &y);
 
+        /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+        void getValuesAtTimes(const double *times, OfxPointD *values, int n);
+
         /** @brief set value */
         void setValue(double x, double y);
 
@@ -1359,6 +1401,9 @@ namespace OFX {
         /** @brief get the value at a time */
         void getValueAtTime(double t, double &x, double &y, double &z);
 
+        /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+        void getValuesAtTimes(const double *times, Ofx3DPointD *values, int n);
+
         /** @brief set value */
         void setValue(double x, double y, double z);
 
@@ -1403,6 +1448,9 @@ namespace OFX {
         /** @brief get the value at a time */
         void getValueAtTime(double t, double &r, double &g, double &b);
 
+        /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+        void getValuesAtTimes(const double *times, OfxRGBColourD *values, int n);
+
         /** @brief set value */
         void setValue(double r, double g, double b);
 
@@ -1436,6 +1484,9 @@ namespace OFX {
         /** @brief get the value at a time */
         void getValueAtTime(double t, double &r, double &g, double &b, double &a);
 
+        /** @brief get the values at n times, in one call if the host has the parameter batch suite */
+        void getValuesAtTimes(const double *times, OfxRGBAColourD *values, int n);
+
         /** @brief set value */
         void setValue(double r, double g, double b, double a);
 
@@ -1668,6 +1719,40 @@ namespace OFX {
         void setValueAtTime(double t, const std::string &v);
     };
 
+    ////////////////////////////////////////////////////////////////////////////////
+    /** @brief Wraps up a bytes param
+
+    The bytes got are those held by the host, not a copy, and are only valid until the next call to get a value of the param.
+    The bytes set are copied by the host, so need only stay valid for the call.
+    */
+    class BytesParam : public ValueParam {
+    protected :
+        mDeclareProtectedAssignAndCCBase(BytesParam,ValueParam);
+        BytesParam(void) {assert(false);}
+
+    protected :
+        /** @brief hidden constructor */
+        BytesParam(const ParamSet *paramSet, const std::string &name, OfxParamHandle handle);
+
+        // so it can make one
+        friend class ParamSet;
+    public :
+        /** @brief get the default value of the param, no bytes if it has none */
+        void getDefault(OfxBytes &v);
+
+        /** @brief get value */
+        void getValue(OfxBytes &v);
+
+        /** @brief get the value at a time */
+        void getValueAtTime(double t, OfxBytes &v);
+
+        /** @brief set value */
+        void setValue(const OfxBytes &v);
+
+        /** @brief set the value at a time, implicitly adds a keyframe */
+        void setValueAtTime(double t, const OfxBytes &v);
+    };
+
     ////////////////////////////////////////////////////////////////////////////////
     /** @brief Wraps up a push button param, not much to it at all */
     class PushButtonParam : public Param {
@@ -1854,6 +1939,9 @@ namespace OFX {
         /** @brief Fetch a custom param */
         CustomParam *fetchCustomParam(const std::string &name) const;
 
+        /** @brief Fetch a bytes param */
+        BytesParam *fetchBytesParam(const std::string &name) const;
+
         /** @brief Fetch a parametric param */
         ParametricParam* fetchParametricParam(const std::string &name) const;
     };
@@ -0,0 +1,145 @@
+#ifndef _ofxsPixelKernels_H_
+#define _ofxsPixelKernels_H_
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @file This file contains vectorised kernels for the per pixel operations most processors are built from.
+
+Each kernel runs along a flat run of interleaved components, so the same call does
+RGBA, RGB or Alpha rows, a whole row span from an OFX::ImageView at a time. The float
+kernels are written once and built for each instruction set the library knows about,
+SSE4.1, AVX2 and AVX-512 on x86 and NEON on ARM, and the best one the CPU running the
+plugin supports is picked the first time a kernel is called. The scalar build is always
+there to fall back on, and the vector builds do the same sums in the same order.
+
+Integer pixels are handled as normalised floats, 0 to 1, so the same scales and offsets
+work whatever the depth. The templated overloads at the end of this file convert a
+block of an integer or half row to floats, run the float kernel and convert back,
+rounding to the nearest value and clamping integers to the range of the type.
+
+Unless said otherwise, src and dst may be the same array but must not otherwise overlap.
+*/
+
+namespace OFX {
+
+  /** @brief Namespace for the vectorised pixel kernels */
+  namespace Kernels {
+
+    /** @brief The instruction sets the kernels are built for, in order of preference on each architecture */
+    enum InstructionSetEnum {
+      eInstructionSetScalar,
+      eInstructionSetSSE4,
+      eInstructionSetAVX2,
+      eInstructionSetAVX512,
+      eInstructionSetNEON
+    };
+
+    /** @brief the instruction set the kernels are running with.
+
+    The first call picks the best one built in and supported by the CPU, which may be
+    capped by setting the environment variable OFX_PIXEL_KERNELS to one of "scalar",
+    "sse4", "avx2", "avx512" or "neon".
+    */
+    InstructionSetEnum getInstructionSet(void);
+
+    /** @brief is the instruction set built into the library and supported by the CPU we are running on */
+    bool isInstructionSetAvailable(InstructionSetEnum v);
+
+    /** @brief run the kernels with the given instruction set, returns false and changes nothing if it is not available.
+
+    Meant for tests and benchmarks, call it before any processing starts.
+    */
+    bool setInstructionSet(InstructionSetEnum v);
+
+    /** @brief a printable name for an instruction set */
+    const char *getInstructionSetName(InstructionSetEnum v);
+
+    /** @brief dst = src * scale + offset, where scale and offset have one value per component.
+
+    \arg \e nPixels      - the number of pixels in src and dst
+    \arg \e nComponents  - the components per pixel, 1 to 4
+    */
+    void scaleOffset(const float *src, float *dst, size_t nPixels, int nComponents, const float *scale, const float *offset);
+
+    /** @brief dst = a + (b - a) * t, for n values, dst may be a or b */
+    void lerp(const float *a, const float *b, float *dst, size_t n, float t);
+
+    /** @brief multiply the colour of RGBA pixels by their alpha */
+    void premultiply(const float *src, float *dst, size_t nPixels);
+
+    /** @brief divide the colour of RGBA pixels by their alpha, pixels with an alpha of zero are left as they are */
+    void unpremultiply(const float *src, float *dst, size_t nPixels);
+
+    /** @brief clamp n values to lo <= v <= hi, NaNs go to lo */
+    void clamp(const float *src, float *dst, size_t n, float lo, float hi);
+
+    /** @brief bytes to normalised floats */
+    void convert(const uint8_t *src, float *dst, size_t n);
+
+    /** @brief normalised floats to bytes, clamped and rounded to nearest */
+    void convert(const float *src, uint8_t *dst, size_t n);
+
+    /** @brief shorts to normalised floats */
+    void convert(const uint16_t *src, float *dst, size_t n);
+
+    /** @brief normalised floats to shorts, clamped and rounded to nearest */
+    void convert(const float *src, uint16_t *dst, size_t n);
+
+    /** @brief an IEEE 754 half, as stored in a half float image */
+    struct Half {
+      uint16_t bits;
+    };
+
+    /** @brief half to float */
+    float toFloat(Half v);
+
+    /** @brief float to half, rounded to nearest even, too big goes to infinity */
+    Half toHalf(float v);
+
+    /** @brief halves to floats, using F16C where the CPU has it */
+    void convert(const Half *src, float *dst, size_t n);
+
+    /** @brief floats to halves, rounded to nearest even, using F16C where the CPU has it */
+    void convert(const float *src, Half *dst, size_t n);
+
+    /** @brief the number of values the integer overloads below convert at a time, on the stack */
+    static const size_t kBlockSize = 512;
+
+    /** @brief dst = src * scale + offset on integer or half pixels, in normalised units */
+    template <class PIX>
+    void scaleOffset(const PIX *src, PIX *dst, size_t nPixels, int nComponents, const float *scale, const float *offset)
+    {
+      // blocks of whole pixels, so each starts on the first component
+      const size_t blockPixels = kBlockSize / 4;
+      float block[kBlockSize];
+      for(size_t i = 0; i < nPixels; i += blockPixels) {
+        size_t nPix = nPixels - i < blockPixels ? nPixels - i : blockPixels;
+        size_t n = nPix * nComponents;
+        convert(src + i * nComponents, block, n);
+        scaleOffset(block, block, nPix, nComponents, scale, offset);
+        convert(block, dst + i * nComponents, n);
+      }
+    }
+
+    /** @brief dst = a + (b - a) * t on integer or half components */
+    template <class PIX>
+    void lerp(const PIX *a, const PIX *b, PIX *dst, size_t n, float t)
+    {
+      float blockA[kBlockSize], blockB[kBlockSize];
+      for(size_t i = 0; i < n; i += kBlockSize) {
+        size_t m = n - i < kBlockSize ? n - i : kBlockSize;
+        convert(a + i, blockA, m);
+        convert(b + i, blockB, m);
+        lerp(blockA, blockB, blockA, m, t);
+        convert(blockA, dst + i, m);
+      }
+    }
+
+  };
+
+};
+
+#endif
@@ -10,6 +10,7 @@
 
 #include <cassert>
 #include <algorithm>
+#include <atomic>
 
 #include "ofxsImageEffect.h"
 #include "ofxsMultiThread.h"
@@ -23,6 +24,70 @@ specific image processing algorithms.
 
 namespace OFX {
 
+    ////////////////////////////////////////////////////////////////////////////////
+    /** @brief Cuts a window into a grid of tiles and hands them out to threads.
+
+    Tiles are numbered in row major order and claimed with an atomic increment, so any
+    number of threads can pull from the same scheduler without locking. A thread that
+    finishes early simply claims the next unprocessed tile, which keeps all the threads
+    busy when the cost per pixel is uneven across the window.
+    */
+    class TileScheduler {
+    protected :
+        OfxRectI                  _window;     /**< @brief window being cut up */
+        int                       _tileWidth;  /**< @brief width of a tile */
+        int                       _tileHeight; /**< @brief height of a tile */
+        unsigned int              _nTilesX;    /**< @brief number of tiles across the window */
+        unsigned int              _nTiles;     /**< @brief total number of tiles */
+        std::atomic<unsigned int> _nextTile;   /**< @brief index of the next tile to hand out */
+
+    public :
+        /** @brief ctor */
+        TileScheduler()
+          : _tileWidth(0)
+          , _tileHeight(0)
+          , _nTilesX(0)
+          , _nTiles(0)
+          , _nextTile(0)
+        {
+            _window.x1 = _window.y1 = _window.x2 = _window.y2 = 0;
+        }
+
+        /** @brief set the window and tile size, and rewind to the first tile. Not MT safe. */
+        void reset(const OfxRectI &window, int tileWidth, int tileHeight)
+        {
+            _window = window;
+            _tileWidth = std::max(1, tileWidth);
+            _tileHeight = std::max(1, tileHeight);
+            if (window.x2 <= window.x1 || window.y2 <= window.y1) {
+                _nTilesX = _nTiles = 0;
+            }
+            else {
+                _nTilesX = (window.x2 - window.x1 + _tileWidth - 1) / _tileWidth;
+                unsigned int nTilesY = (window.y2 - window.y1 + _tileHeight - 1) / _tileHeight;
+                _nTiles = _nTilesX * nTilesY;
+            }
+            _nextTile.store(0, std::memory_order_relaxed);
+        }
+
+        /** @brief the number of tiles the window was cut into */
+        unsigned int getNumTiles(void) const {return _nTiles;}
+
+        /** @brief claim the next unprocessed tile, returns false once they have all been handed out */
+        bool nextTile(OfxRectI &tile)
+        {
+            unsigned int t = _nextTile.fetch_add(1, std::memory_order_relaxed);
+            if (t >= _nTiles) {
+                return false;
+            }
+            tile.x1 = _window.x1 + int(t % _nTilesX) * _tileWidth;
+            tile.y1 = _window.y1 + int(t / _nTilesX) * _tileHeight;
+            tile.x2 = std::min(tile.x1 + _tileWidth, _window.x2);
+            tile.y2 = std::min(tile.y1 + _tileHeight, _window.y2);
+            return true;
+        }
+    };
+
     ////////////////////////////////////////////////////////////////////////////////
     // base class to process images with
     class ImageProcessor : public OFX::MultiThread::Processor {
@@ -30,6 +95,9 @@ namespace OFX {
         OFX::ImageEffect &_effect;      /**< @brief effect to render with */
         OFX::Image       *_dstImg;        /**< @brief image to process into */
         OfxRectI          _renderWindow;  /**< @brief render window to use */
+        int               _tileWidth;     /**< @brief width of the tiles in tiled mode, 0 to split into strips */
+        int               _tileHeight;    /**< @brief height of the tiles in tiled mode, 0 to split into strips */
+        TileScheduler     _tiles;         /**< @brief hands out tiles to the threads in tiled mode */
         bool             _isEnabledOpenCLRender; /**< @brief is OpenCL Render Enabled */
         bool             _isEnabledCudaRender;   /**< @brief is Cuda Render Enabled */
         bool             _isEnabledMetalRender;   /**< @brief is Metal Render Enabled */
@@ -42,6 +110,8 @@ namespace OFX {
         ImageProcessor(OFX::ImageEffect &effect)
           : _effect(effect)
           , _dstImg(0)
+          , _tileWidth(0)
+          , _tileHeight(0)
           , _isEnabledOpenCLRender(false)
           , _isEnabledCudaRender(false)
           , _isEnabledMetalRender(false)
@@ -79,9 +149,32 @@ namespace OFX {
         /** @brief reset the render window */
         void setRenderWindow(OfxRectI rect) {_renderWindow = rect;}
 
+        /** @brief switch on tiled processing.
+
+        The render window is cut into tiles of at most width x height pixels, which the
+        threads pull from a shared queue until none are left, rather than giving each thread
+        one fixed horizontal strip. Use this when the cost per pixel varies a lot across the
+        image. Something like 256x64 keeps a float RGBA tile within a typical L2 cache.
+        Pass zero to go back to the default of one strip per thread.
+        */
+        void setTileSize(int width, int height) {_tileWidth = width; _tileHeight = height;}
+
+        /** @brief are we cutting the render window into tiles rather than strips */
+        bool isTiled(void) const {return _tileWidth > 0 && _tileHeight > 0;}
+
         /** @brief overridden from OFX::MultiThread::Processor. This function is called once on each SMP thread by the base class */
         void multiThreadFunction(unsigned int threadId, unsigned int nThreads)
         {
+            if (isTiled()) {
+                // keep grabbing tiles until they have all gone
+                OfxRectI tile;
+                while (_tiles.nextTile(tile)) {
+                    if (_effect.abort()) break;
+                    multiThreadProcessImages(tile);
+                }
+                return;
+            }
+
             // slice the y range into the number of threads it has
             unsigned int dy = _renderWindow.y2 - _renderWindow.y1;
             // the following is equivalent to std::ceil(dy/(double)nThreads);
@@ -185,6 +278,12 @@ namespace OFX {
                 // make sure the number of CPUs is valid (and use at least 1 CPU)
                 nCPUs = std::max(1u, std::min(nCPUs, OFX::MultiThread::getNumCPUs()));
 
+                if (isTiled()) {
+                    // tiles balance themselves, so no point in having more threads than tiles
+                    _tiles.reset(_renderWindow, _tileWidth, _tileHeight);
+                    nCPUs = std::max(1u, std::min(nCPUs, _tiles.getNumTiles()));
+                }
+
                 // call the base multi threading code, should put a pre & post thread calls in too
                 multiThread(nCPUs);
             }
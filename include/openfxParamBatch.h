@@ -0,0 +1,69 @@
+#ifndef _openfxParamBatch_h_
+#define _openfxParamBatch_h_
+
+// Copyright OpenFX and contributors to the OpenFX project.
+// SPDX-License-Identifier: BSD-3-Clause
+
+/** @file openfxParamBatch.h
+
+This header file defines an optional extension to get the values of a parameter at many
+times in one call, supplied by hosts built on the OpenFX HostSupport library and used by
+plugins built on the OpenFX Support library.
+
+It is not part of the OFX standard, so its names are prefixed OpenFX rather than Ofx, and
+the suite is fetched under a reverse domain name, so that it cannot clash with a suite the
+standard defines later.
+
+Effects that motion blur or retime need a parameter's value at many times for each frame
+they render. Through OfxParameterSuiteV1::paramGetValueAtTime each of those is a call
+through a variable argument list, and for a host with animation curves, a search of the
+curve. This suite gets them all at once, letting the host unpack the call once and walk
+its curve once.
+
+*/
+
+#include "ofxParam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief the string that names the parameter batch suite, passed to OfxHost::fetchSuite */
+#define kOpenFXParameterBatchSuite "net.sf.openfx.ParameterBatchSuite"
+
+/** @brief The OFX suite used to get the values of a parameter at many times
+
+A host need not supply this suite, in which case the effect calls
+OfxParameterSuiteV1::paramGetValueAtTime for each time.
+*/
+typedef struct OpenFXParameterBatchSuiteV1 {
+
+  /** @brief Gets the values of a parameter at many times
+
+      \arg \c paramHandle   parameter handle to fetch the values of
+      \arg \c nTimes        the number of times
+      \arg \c times         the nTimes times to get the values at, in frames, they need not
+                            be in order, though hosts may be quicker if they are
+      \arg \c values        where to put the values, one after another, each value being
+                            as many doubles as the parameter has dimensions for double,
+                            2D and 3D double, RGB and RGBA parameters, and as many ints for
+                            integer, 2D and 3D integer, boolean and choice parameters
+
+      @returns
+        - ::kOfxStatOK                - all was fine
+        - ::kOfxStatErrBadHandle      - if the parameter handle was invalid
+        - ::kOfxStatErrValue          - if nTimes is more than 0 and times or values is NULL
+        - ::kOfxStatErrUnsupported    - if the host cannot batch parameters of this type,
+                                        in which case paramGetValueAtTime must be used
+  */
+  OfxStatus (*paramGetValuesAtTimes)(OfxParamHandle paramHandle,
+                                     int nTimes,
+                                     const OfxTime *times,
+                                     void *values);
+} OpenFXParameterBatchSuiteV1;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif